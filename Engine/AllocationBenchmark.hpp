@@ -0,0 +1,101 @@
+#pragma once
+#include "se_gameobject.hpp"
+#include "se_memory.hpp"
+#include "se_script_component.hpp"
+#include "se_script_manager.hpp"
+#include "se_scene.hpp"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace se {
+
+    // Stand in for a bullet, lives a few frames and carries a small script
+    class AllocationBenchmarkBulletScript : public ScriptComponent {
+    public:
+        void onUpdate(float dt) override {
+            owner->getTransform().translation.z += speed * dt;
+        }
+
+        ScriptAccess getAccess() const override { return ScriptAccess::OwnerOnly; }
+
+        std::string getName() const override { return "AllocationBenchmarkBulletScript"; }
+
+    private:
+        float speed = 20.0f;
+    };
+
+    // Spawns and despawns bullets through the deferred command buffer for a few hundred frames and
+    // counts global heap allocations once the pools have warmed up. Runs once on creation and prints to stdout.
+    // Names are unique and too long for the small string buffer, and there are enough OwnerOnly scripts for
+    // parallelFor to split them into jobs. What is still expected to hit the heap per spawn is the name: the
+    // desc string, its copy in the scene's names and the key, node and bucket of a new nameIndex entry.
+    class AllocationBenchmarkScript : public ScriptComponent {
+    public:
+
+        void onCreate() override {
+            const int warmupFrames = 50;
+            const int measuredFrames = 500;
+            const size_t spawnPerFrame = 200;
+            const size_t lifetime = 10;
+
+            Scene benchScene("AllocationBenchmark");
+            // Ring of live bullets, each frame replaces the batch spawned lifetime frames ago
+            std::vector<GameObjectHandle> ring(spawnPerFrame * lifetime);
+            size_t frameIndex = 0;
+            size_t spawnCount = 0;
+
+            auto frame = [&]() {
+                size_t first = (frameIndex++ % lifetime) * spawnPerFrame;
+
+                for (size_t i = first; i < first + spawnPerFrame; ++i) {
+                    benchScene.deferDestroyGameObject(ring[i]);
+
+                    GameObjectDesc desc;
+                    desc.name = "Projectile_Instance_" + std::to_string(spawnCount++);
+                    desc.transform.translation.x = static_cast<float>(i);
+                    ring[i] = benchScene.deferCreateGameObject(std::move(desc));
+                }
+
+                benchScene.onUpdate(0.016f);
+
+                // Scripts can only be attached once the deferred creates have been applied
+                for (size_t i = first; i < first + spawnPerFrame; ++i)
+                    ring[i]->addScript<AllocationBenchmarkBulletScript>();
+            };
+
+            for (int i = 0; i < warmupFrames; ++i)
+                frame();
+
+            memory::AllocationStats before = memory::getGlobalStats();
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < measuredFrames; ++i)
+                frame();
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            memory::AllocationStats after = memory::getGlobalStats();
+
+            uint64_t allocations = after.allocations - before.allocations;
+            std::cout << "[AllocationBenchmark] " << measuredFrames << " frames, " << spawnPerFrame << " spawns/despawns per frame | "
+                << ms / measuredFrames << " ms/frame | " << allocations << " global allocations ("
+                << static_cast<double>(allocations) / measuredFrames << " per frame, "
+                << static_cast<double>(allocations) / (measuredFrames * spawnPerFrame) << " per spawn)\n";
+
+            memory::forEachPool([](const PoolAllocator& pool) {
+                if (pool.getSlabCount() > 0) {
+                    std::cout << "[AllocationBenchmark] pool " << pool.getName() << " | live " << pool.getLiveBlocks()
+                        << " / " << pool.getCapacity() << " | " << pool.getTotalAllocations() << " allocations\n";
+                }
+            });
+
+            benchScene.onDestroy();
+        }
+
+        std::string getName() const override { return "AllocationBenchmarkScript"; }
+    };
+
+}
+
+namespace {
+    const bool registered_AllocationBenchmarkScript = se::registerScript<se::AllocationBenchmarkScript>("AllocationBenchmarkScript");
+}
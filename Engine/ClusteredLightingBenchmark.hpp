@@ -0,0 +1,72 @@
+#pragma once
+#include "RenderBenchmark.hpp"
+#include "se_script_manager.hpp"
+#include <random>
+#include <string>
+
+namespace se {
+
+    // Covers a floor with copies of the owner's mesh and material, scatters 1k and then 4k point lights over it
+    // and renders each count with clustered lighting and with every fragment looping over every light.
+    // Prints the averaged GPU time of the scene pass, which is dominated by the fragment shader here, and the frame time.
+    // Attach to an object that has a mesh and a material, with the camera looking at the floor.
+    class ClusteredLightingBenchmarkScript : public RenderBenchmarkScript {
+    public:
+        ClusteredLightingBenchmarkScript() : RenderBenchmarkScript("ClusteredLightingBenchmark", SCENE_GPU_TIME | FRAME_TIME) {}
+
+        std::string getName() const override { return "ClusteredLightingBenchmarkScript"; }
+
+    protected:
+        bool setUp() override {
+            if (!requireOwnerMesh()) return false;
+
+            scene->reserveGameObjects(scene->getObjectCount() + SIDE * SIDE + LIGHT_COUNTS[1]);
+            const float halfExtent = SIDE / 2 * SPACING;
+            spawnGrid("ClusterFloor_", SIDE, SPACING, 1.0f, glm::vec3(-halfExtent, 0.0f, -halfExtent));
+
+            for (int lights : LIGHT_COUNTS) {
+                const std::string count = std::to_string(lights) + " lights, ";
+                addPhase(count + "clustered", [this, lights]() {
+                    spawnLights(lights - spawnedLights);
+                    getRenderSettings().clusteredLighting = true;
+                });
+                addPhase(count + "brute force", []() { getRenderSettings().clusteredLighting = false; });
+            }
+            return true;
+        }
+
+        void finish() override { getRenderSettings().clusteredLighting = true; }
+
+    private:
+        static constexpr int SIDE = 64;
+        static constexpr int LIGHT_COUNTS[2] = { 1000, 4000 };
+        static constexpr float SPACING = 2.0f;
+
+        void spawnLights(int count)
+        {
+            const float halfExtent = SIDE / 2 * SPACING;
+            std::uniform_real_distribution<float> position(-halfExtent, halfExtent);
+            std::uniform_real_distribution<float> height(0.5f, 3.0f);
+            std::uniform_real_distribution<float> channel(0.2f, 1.0f);
+
+            for (int i = 0; i < count; ++i) {
+                GameObjectDesc desc;
+                desc.name = "ClusterLight_" + std::to_string(spawnedLights++);
+                desc.transform.translation = glm::vec3(position(rng), height(rng), position(rng));
+                desc.light.type = LightType::Point;
+                desc.light.color = glm::vec3(channel(rng), channel(rng), channel(rng));
+                desc.light.intensity = 5.0f;
+                desc.light.range = 4.0f;
+                scene->deferCreateGameObject(std::move(desc));
+            }
+        }
+
+        std::mt19937 rng{ 1234 };
+        int spawnedLights = 0;
+    };
+
+}
+
+namespace {
+    const bool registered_ClusteredLightingBenchmarkScript = se::registerScript<se::ClusteredLightingBenchmarkScript>("ClusteredLightingBenchmarkScript");
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include "se_gameobject.hpp"
+#include "se_script_component.hpp"
+#include "se_script_manager.hpp"
+#include "se_scene.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace se {
+
+    // Compares the update and render loops over the old list of heap allocated game objects
+    // against the dense component pools in Scene. Runs once on creation and prints to stdout.
+    class ComponentBenchmarkScript : public ScriptComponent {
+    public:
+
+        void onCreate() override {
+            std::cout << "[ComponentBenchmark] objects | list update (ms) | pool update (ms) | list render (ms) | pool render (ms)\n";
+            for (size_t count : { 1000, 10000, 100000 })
+                runBenchmark(count);
+        }
+
+        std::string getName() const override { return "ComponentBenchmarkScript"; }
+
+    private:
+        // Same members the game object used to carry before the component pools
+        struct LegacyObject {
+            std::string name;
+            std::shared_ptr<SEMesh> mesh{};
+            std::shared_ptr<SEMaterial> material{};
+            Light light{};
+            TransformComponent transform{};
+            std::unique_ptr<ScriptComponent> script{ nullptr };
+        };
+
+        void runBenchmark(size_t count)
+        {
+            using clock = std::chrono::high_resolution_clock;
+            const int iterations = 20;
+
+            // Shuffle the list nodes to mimic a scene that has seen creates and deletes
+            std::vector<std::unique_ptr<LegacyObject>> shuffled;
+            for (size_t i = 0; i < count; ++i) {
+                auto obj = std::make_unique<LegacyObject>();
+                obj->name = "Bench_" + std::to_string(i);
+                obj->transform.translation = glm::vec3(static_cast<float>(i), 0.0f, 0.0f);
+                if (i % 10 == 0) obj->light.type = LightType::Point;
+                shuffled.push_back(std::move(obj));
+            }
+            std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937{ 1234 });
+            std::list<std::unique_ptr<LegacyObject>> legacy;
+            for (auto& obj : shuffled) legacy.push_back(std::move(obj));
+
+            Scene benchScene("ComponentBenchmark");
+            for (size_t i = 0; i < count; ++i) {
+                auto& go = benchScene.createGameObjectRef("Bench_" + std::to_string(i));
+                go.getTransform().translation = glm::vec3(static_cast<float>(i), 0.0f, 0.0f);
+                if (i % 10 == 0) go.getLight().type = LightType::Point;
+            }
+
+            float sink = 0.0f;
+            auto elapsedMs = [](clock::time_point start) {
+                return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+            };
+
+            auto start = clock::now();
+            for (int it = 0; it < iterations; ++it) {
+                for (auto& obj : legacy) {
+                    if (obj->script) obj->script->onUpdate(0.016f);
+                    obj->transform.rotation.y += 0.016f;
+                }
+            }
+            double listUpdate = elapsedMs(start) / iterations;
+
+            start = clock::now();
+            for (int it = 0; it < iterations; ++it) {
+                benchScene.onUpdate(0.016f);
+                for (auto& transform : benchScene.editTransforms())
+                    transform.rotation.y += 0.016f;
+            }
+            double poolUpdate = elapsedMs(start) / iterations;
+
+            start = clock::now();
+            for (int it = 0; it < iterations; ++it) {
+                size_t lightCount = 0;
+                for (auto& obj : legacy) {
+                    if (obj->light.type != LightType::None) lightCount++;
+                    sink += obj->transform.mat4()[3][0];
+                }
+                sink += static_cast<float>(lightCount);
+            }
+            double listRender = elapsedMs(start) / iterations;
+
+            start = clock::now();
+            for (int it = 0; it < iterations; ++it) {
+                const auto& worldMatrices = benchScene.getWorldMatrices();
+                const auto& lights = benchScene.getLights();
+                size_t lightCount = 0;
+                for (size_t i = 0; i < benchScene.getObjectCount(); ++i) {
+                    if (lights[i].type != LightType::None) lightCount++;
+                    sink += worldMatrices[i][3][0];
+                }
+                sink += static_cast<float>(lightCount);
+            }
+            double poolRender = elapsedMs(start) / iterations;
+
+            std::cout << "[ComponentBenchmark] " << count << " | " << listUpdate << " | " << poolUpdate
+                << " | " << listRender << " | " << poolRender << " (checksum " << sink << ")\n";
+        }
+    };
+
+}
+
+namespace {
+    const bool registered_ComponentBenchmarkScript = se::registerScript<se::ComponentBenchmarkScript>("ComponentBenchmarkScript");
+}
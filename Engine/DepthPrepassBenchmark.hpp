@@ -0,0 +1,54 @@
+#pragma once
+#include "RenderBenchmark.hpp"
+#include "se_script_manager.hpp"
+#include <string>
+
+namespace se {
+
+    // Stacks copies of the owner's mesh and material in layers one behind the other, so most pixels are covered many
+    // times over, and renders them without and then with the depth pre-pass. Prints the averaged GPU time of the scene
+    // pass, which holds both passes, the CPU record time and the frame time of each.
+    // Attach to an object that has a mesh and a material, with the camera looking down -z at the stack.
+    class DepthPrepassBenchmarkScript : public RenderBenchmarkScript {
+    public:
+        DepthPrepassBenchmarkScript() : RenderBenchmarkScript("DepthPrepassBenchmark", SCENE_GPU_TIME | RECORD_TIME | FRAME_TIME | DRAW_CALLS) {}
+
+        std::string getName() const override { return "DepthPrepassBenchmarkScript"; }
+
+    protected:
+        bool setUp() override {
+            if (!requireOwnerMesh()) return false;
+
+            const int side = 24;
+            const int layers = 32;
+            scene->reserveGameObjects(scene->getObjectCount() + side * side * layers);
+            for (int layer = 0; layer < layers; ++layer) {
+                for (int i = 0; i < side; ++i) {
+                    for (int j = 0; j < side; ++j) {
+                        spawnCopy("PrepassInstance_" + std::to_string((layer * side + i) * side + j),
+                            glm::vec3((i - side / 2) * SPACING, (j - side / 2) * SPACING, -layer * SPACING));
+                    }
+                }
+            }
+
+            addPhase("without pre-pass", []() { getRenderSettings().depthPrepass = false; });
+            addPhase("with pre-pass", []() { getRenderSettings().depthPrepass = true; });
+            return true;
+        }
+
+        void finish() override {
+            // The renderer turns the setting back off when the pre-pass shaders are missing
+            if (!getRenderSettings().depthPrepass)
+                log() << "depth pre-pass unavailable, numbers above are without it\n";
+            getRenderSettings().depthPrepass = false;
+        }
+
+    private:
+        static constexpr float SPACING = 1.0f;
+    };
+
+}
+
+namespace {
+    const bool registered_DepthPrepassBenchmarkScript = se::registerScript<se::DepthPrepassBenchmarkScript>("DepthPrepassBenchmarkScript");
+}
@@ -52,6 +52,9 @@ namespace se {
             }
         }
 
+        // onUpdate only spins its owner
+        ScriptAccess getAccess() const override { return ScriptAccess::OwnerOnly; }
+
         std::string getName() const override { return "ExampleScript"; }
 
     private:
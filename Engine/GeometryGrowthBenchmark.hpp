@@ -0,0 +1,96 @@
+#pragma once
+#include "se_device.hpp"
+#include "se_geometry_arena.hpp"
+#include "se_resource_manager.hpp"
+#include "se_script_component.hpp"
+#include "se_script_manager.hpp"
+#include "se_scene_manager.hpp"
+#include "se_upload_manager.hpp"
+#include "se_vertex.hpp"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+namespace se {
+
+    // Fills the geometry arena inside one import until both its vertex and index buffers have grown, so the grows
+    // happen with that import's uploads still unsubmitted. Reads every range back afterwards and prints the time
+    // and how many ranges lost their contents. Runs once on creation, the ranges are freed again.
+    class GeometryGrowthBenchmarkScript : public ScriptComponent {
+    public:
+
+        void onCreate() override {
+            ResourceManager* resourceManager = SceneManager::getInstance().getResourceManager();
+            SEDevice& device = resourceManager->getTextureSystem()->getDevice();
+            GeometryArena& arena = device.getGeometryArena();
+            UploadManager& uploadManager = device.getUploadManager();
+            using clock = std::chrono::high_resolution_clock;
+
+            const uint32_t vertexCapacity = arena.getVertexCapacity();
+            const uint32_t indexCapacity = arena.getIndexCapacity();
+            const uint32_t batchesBefore = uploadManager.getBatchesSubmitted();
+
+            std::vector<GeometryRange> ranges;
+            std::vector<Vertex> vertices;
+            std::vector<uint32_t> indices;
+
+            auto start = clock::now();
+            {
+                UploadManager::ImportScope import(uploadManager);
+                while (arena.getVertexCapacity() == vertexCapacity || arena.getIndexCapacity() == indexCapacity) {
+                    if (ranges.size() >= MAX_RANGES)
+                        break;
+                    fill(static_cast<uint32_t>(ranges.size()), vertices, indices);
+                    ranges.push_back(arena.allocate(vertices, indices));
+                }
+            }
+            uploadManager.waitIdle();
+            double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+            size_t mismatches = 0;
+            std::vector<Vertex> readVertices;
+            std::vector<uint32_t> readIndices;
+            for (size_t i = 0; i < ranges.size(); i++) {
+                fill(static_cast<uint32_t>(i), vertices, indices);
+                arena.readBack(ranges[i], readVertices, readIndices);
+                if (readVertices != vertices || readIndices != indices)
+                    mismatches++;
+            }
+
+            std::cout << "[GeometryGrowthBenchmark] vertices " << vertexCapacity << " -> " << arena.getVertexCapacity()
+                << " | indices " << indexCapacity << " -> " << arena.getIndexCapacity() << " | " << ranges.size()
+                << " ranges in " << ms << " ms, " << uploadManager.getBatchesSubmitted() - batchesBefore << " batches | "
+                << mismatches << " mismatched\n";
+
+            for (GeometryRange& range : ranges)
+                arena.free(range);
+        }
+
+        std::string getName() const override { return "GeometryGrowthBenchmarkScript"; }
+
+    private:
+        static constexpr uint32_t VERTICES_PER_RANGE = 16 * 1024;
+        static constexpr uint32_t INDICES_PER_RANGE = 64 * 1024;
+        static constexpr size_t MAX_RANGES = 1024;
+
+        // Contents unique to the range, so data landing in the wrong place or missing shows up
+        static void fill(uint32_t rangeIndex, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+            vertices.resize(VERTICES_PER_RANGE);
+            for (uint32_t i = 0; i < VERTICES_PER_RANGE; i++) {
+                vertices[i] = Vertex{};
+                vertices[i].position = glm::vec3(static_cast<float>(rangeIndex), static_cast<float>(i), 1.0f);
+                vertices[i].normal = glm::vec3(0.0f, 1.0f, 0.0f);
+                vertices[i].texCoord = glm::vec2(static_cast<float>(i % 7), static_cast<float>(rangeIndex % 5));
+            }
+
+            indices.resize(INDICES_PER_RANGE);
+            for (uint32_t i = 0; i < INDICES_PER_RANGE; i++)
+                indices[i] = (i * 7 + rangeIndex) % VERTICES_PER_RANGE;
+        }
+    };
+
+}
+
+namespace {
+    const bool registered_GeometryGrowthBenchmarkScript = se::registerScript<se::GeometryGrowthBenchmarkScript>("GeometryGrowthBenchmarkScript");
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "RenderBenchmark.hpp"
+#include "se_script_manager.hpp"
+#include <string>
+
+namespace se {
+
+    // Fills the active scene with 262k copies of the owner's mesh and material, then renders it with CPU culling
+    // and instancing and afterwards GPU driven, printing the averaged frame time, CPU record time and draw count
+    // of each. Attach to an object that has an indexed mesh and a material.
+    class GpuDrivenBenchmarkScript : public RenderBenchmarkScript {
+    public:
+        GpuDrivenBenchmarkScript() : RenderBenchmarkScript("GpuDrivenBenchmark", FRAME_TIME | RECORD_TIME | DRAW_CALLS | INSTANCES) {}
+
+        std::string getName() const override { return "GpuDrivenBenchmarkScript"; }
+
+    protected:
+        bool setUp() override {
+            if (!requireOwnerMesh()) return false;
+
+            spawnGrid("GpuInstance_", 512, 1.5f, 0.5f);
+            addPhase("CPU culled", []() {
+                getRenderSettings().instancing = true;
+                getRenderSettings().gpuDriven = false;
+            });
+            addPhase("GPU driven", []() { getRenderSettings().gpuDriven = true; });
+            return true;
+        }
+
+        void finish() override {
+            // The renderer turns the setting back off when the device can't run the GPU path
+            if (!getRenderSettings().gpuDriven)
+                log() << "GPU driven path unavailable, numbers above are the CPU path\n";
+            getRenderSettings().gpuDriven = false;
+        }
+    };
+
+}
+
+namespace {
+    const bool registered_GpuDrivenBenchmarkScript = se::registerScript<se::GpuDrivenBenchmarkScript>("GpuDrivenBenchmarkScript");
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "se_gameobject.hpp"
+#include "se_script_component.hpp"
+#include "se_script_manager.hpp"
+#include "se_scene.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace se {
+
+    // Compares the old id lookup, a walk over the object list that the scene no longer offers, against generational
+    // handle resolution.
+    // Runs once on creation in a throwaway scene and prints the results to stdout.
+    class HandleBenchmarkScript : public ScriptComponent {
+    public:
+
+        void onCreate() override {
+            std::cout << "[HandleBenchmark] objects | id lookup (ns) | handle deref (ns) | speedup\n";
+            for (size_t count : { 1000, 10000, 100000 })
+                runBenchmark(count);
+        }
+
+        void runBenchmark(size_t count)
+        {
+            using clock = std::chrono::high_resolution_clock;
+
+            Scene benchScene("HandleBenchmark");
+            std::vector<GameObjectHandle> handles;
+            std::vector<SEGameObject::id_t> ids;
+            handles.reserve(count);
+            ids.reserve(count);
+
+            for (size_t i = 0; i < count; ++i) {
+                auto handle = benchScene.createGameObject("Bench_" + std::to_string(i));
+                handle->getTransform().translation.x = static_cast<float>(i);
+                handles.push_back(handle);
+                ids.push_back(handle->getId());
+            }
+
+            std::vector<size_t> order(count);
+            std::iota(order.begin(), order.end(), 0);
+            std::shuffle(order.begin(), order.end(), std::mt19937{ 1234 });
+
+            float sink = 0.0f;
+
+            // The list walk is quadratic over the whole set, so only sample it
+            size_t idLookups = std::min<size_t>(count, 1000);
+            auto start = clock::now();
+            for (size_t i = 0; i < idLookups; ++i)
+                sink += findById(benchScene, ids[order[i]])->getTransform().translation.x;
+            double idNs = std::chrono::duration<double, std::nano>(clock::now() - start).count() / idLookups;
+
+            size_t rounds = std::max<size_t>(1, 1000000 / count);
+            start = clock::now();
+            for (size_t r = 0; r < rounds; ++r) {
+                for (size_t i = 0; i < count; ++i)
+                    sink += handles[order[i]]->getTransform().translation.x;
+            }
+            double handleNs = std::chrono::duration<double, std::nano>(clock::now() - start).count() / (rounds * count);
+
+            std::cout << "[HandleBenchmark] " << count << " | " << idNs << " | " << handleNs
+                << " | " << idNs / handleNs << "x (checksum " << sink << ")\n";
+
+            // Destroyed handles must go stale and stay stale once their slots are recycled
+            for (size_t i = 0; i < count; i += 2)
+                handles[i].destroy();
+            for (size_t i = 0; i < count; i += 2)
+                benchScene.createGameObject("Reused_" + std::to_string(i));
+
+            size_t stale = 0;
+            for (size_t i = 0; i < count; i += 2) {
+                if (!handles[i]) stale++;
+            }
+            if (stale != (count + 1) / 2)
+                std::cerr << "[HandleBenchmark] " << (count + 1) / 2 - stale << " destroyed handles still resolve!\n";
+        }
+
+        std::string getName() const override { return "HandleBenchmarkScript"; }
+
+    private:
+        static SEGameObject* findById(const Scene& scene, SEGameObject::id_t id) {
+            for (const auto& obj : scene.getGameObjects()) {
+                if (obj->getId() == id)
+                    return obj.get();
+            }
+            return nullptr;
+        }
+    };
+
+}
+
+namespace {
+    const bool registered_HandleBenchmarkScript = se::registerScript<se::HandleBenchmarkScript>("HandleBenchmarkScript");
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "RenderBenchmark.hpp"
+#include "se_script_manager.hpp"
+#include <string>
+
+namespace se {
+
+    // Fills the active scene with 100k copies of the owner's mesh and material, then renders it instanced and with
+    // per object recording and prints the averaged record time and draw count of each.
+    // Attach to an object that has a mesh and material.
+    class InstancingBenchmarkScript : public RenderBenchmarkScript {
+    public:
+        InstancingBenchmarkScript() : RenderBenchmarkScript("InstancingBenchmark", RECORD_TIME | DRAW_CALLS | INSTANCES) {}
+
+        std::string getName() const override { return "InstancingBenchmarkScript"; }
+
+    protected:
+        bool setUp() override {
+            if (!requireOwnerMesh()) return false;
+
+            spawnGrid("Instance_", 317, 1.5f, 0.5f);
+            addPhase("instanced", []() { getRenderSettings().instancing = true; });
+            addPhase("per object", []() { getRenderSettings().instancing = false; });
+            return true;
+        }
+
+        void finish() override { getRenderSettings().instancing = true; }
+    };
+
+}
+
+namespace {
+    const bool registered_InstancingBenchmarkScript = se::registerScript<se::InstancingBenchmarkScript>("InstancingBenchmarkScript");
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "se_gameobject.hpp"
+#include "se_job_system.hpp"
+#include "se_memory.hpp"
+#include "se_script_component.hpp"
+#include "se_script_manager.hpp"
+#include "se_scene.hpp"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace se {
+
+    // Synthetic per object load, a few hundred transcendental ops that only touch the owner
+    class JobBenchmarkLoadScript : public ScriptComponent {
+    public:
+        void onUpdate(float dt) override {
+            auto& transform = owner->getTransform();
+            float angle = transform.rotation.y;
+            for (int i = 0; i < 256; ++i)
+                angle = std::sin(angle + dt) * std::cos(angle - dt) + 0.001f;
+            transform.rotation.y = angle;
+        }
+
+        ScriptAccess getAccess() const override { return ScriptAccess::OwnerOnly; }
+
+        std::string getName() const override { return "JobBenchmarkLoadScript"; }
+    };
+
+    // Times Scene::onUpdate over a script heavy scene from 1 to N threads (workers plus the main thread), and counts
+    // the global allocations of a warm parallelFor at each thread count, which should be zero.
+    // Runs once on creation and prints to stdout, the worker count is restored afterwards.
+    class JobBenchmarkScript : public ScriptComponent {
+    public:
+
+        void onCreate() override {
+            const size_t count = 20000;
+            const int iterations = 10;
+            using clock = std::chrono::high_resolution_clock;
+
+            Scene benchScene("JobBenchmark");
+            for (size_t i = 0; i < count; ++i) {
+                auto& go = benchScene.createGameObjectRef("Bench_" + std::to_string(i));
+                go.getTransform().rotation.y = static_cast<float>(i) * 0.001f;
+                go.addScript<JobBenchmarkLoadScript>();
+            }
+
+            JobSystem& jobs = JobSystem::getInstance();
+            size_t previousWorkers = jobs.getWorkerCount();
+            size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+            std::cout << "[JobBenchmark] " << count << " scripts | threads | update (ms) | speedup | parallelFor allocations\n";
+
+            double baseline = 0.0;
+            for (size_t threads = 1; threads <= maxThreads; ++threads) {
+                jobs.setWorkerCount(threads - 1);
+
+                benchScene.onUpdate(0.016f);
+                auto start = clock::now();
+                for (int it = 0; it < iterations; ++it)
+                    benchScene.onUpdate(0.016f);
+                double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count() / iterations;
+
+                // Same fan-out as the script update, measured on its own so the scripts' work doesn't count
+                std::atomic<size_t> touched{ 0 };
+                const std::function<void(size_t, size_t)> chunk = [&touched](size_t begin, size_t end) { touched.fetch_add(end - begin, std::memory_order_relaxed); };
+                jobs.parallelFor(count, 64, chunk);
+                uint64_t allocationsBefore = memory::getGlobalStats().allocations;
+                for (int it = 0; it < iterations; ++it)
+                    jobs.parallelFor(count, 64, chunk);
+                uint64_t allocations = memory::getGlobalStats().allocations - allocationsBefore;
+
+                if (threads == 1)
+                    baseline = ms;
+                std::cout << "[JobBenchmark] " << threads << " | " << ms << " | " << baseline / ms << "x | "
+                    << static_cast<double>(allocations) / iterations << " per call\n";
+            }
+
+            jobs.setWorkerCount(previousWorkers);
+            benchScene.onDestroy();
+        }
+
+        std::string getName() const override { return "JobBenchmarkScript"; }
+    };
+
+}
+
+namespace {
+    const bool registered_JobBenchmarkScript = se::registerScript<se::JobBenchmarkScript>("JobBenchmarkScript");
+}
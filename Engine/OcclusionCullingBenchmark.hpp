@@ -0,0 +1,48 @@
+#pragma once
+#include "RenderBenchmark.hpp"
+#include "se_script_manager.hpp"
+#include <string>
+
+namespace se {
+
+    // Renders sponza.json from its saved camera on the GPU driven path without and then with occlusion culling.
+    // Prints the averaged GPU time of the scene pass, which includes the pyramid build, the frame time, and the
+    // occluded and drawn counts. Culling tests whole objects, so the occluded count only moves once the scene holds
+    // more than the single sponza mesh. Load sponza.json and attach to any object in it.
+    class OcclusionCullingBenchmarkScript : public RenderBenchmarkScript {
+    public:
+        OcclusionCullingBenchmarkScript() : RenderBenchmarkScript("OcclusionCullingBenchmark", SCENE_GPU_TIME | FRAME_TIME | OCCLUDED | INSTANCES) {}
+
+        std::string getName() const override { return "OcclusionCullingBenchmarkScript"; }
+
+    protected:
+        bool setUp() override {
+            if (!scene->getGameObjectByName(SPONZA_OBJECT)) {
+                log() << "active scene isn't sponza.json, load it and attach the script there\n";
+                return false;
+            }
+
+            addPhase("frustum only", []() {
+                getRenderSettings().gpuDriven = true;
+                getRenderSettings().occlusionCulling = false;
+            });
+            addPhase("with occlusion culling", []() { getRenderSettings().occlusionCulling = true; });
+            return true;
+        }
+
+        void finish() override {
+            // The renderer turns the settings back off when the device or the shaders can't do it
+            if (!getRenderSettings().gpuDriven || !getRenderSettings().occlusionCulling)
+                log() << "occlusion culling unavailable, numbers above are without it\n";
+            getRenderSettings().occlusionCulling = false;
+        }
+
+    private:
+        static constexpr const char* SPONZA_OBJECT = "sponza";
+    };
+
+}
+
+namespace {
+    const bool registered_OcclusionCullingBenchmarkScript = se::registerScript<se::OcclusionCullingBenchmarkScript>("OcclusionCullingBenchmarkScript");
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "RenderBenchmark.hpp"
+#include "se_script_manager.hpp"
+#include "se_job_system.hpp"
+#include <string>
+
+namespace se {
+
+    // Fills the active scene with 40k copies of the owner's mesh and material and renders it without instancing,
+    // so every object is its own draw, once per recording thread count from 1 up to every job system thread.
+    // Prints the averaged frame time and CPU record time of each. Attach to an object that has a mesh and a material.
+    class RecordingBenchmarkScript : public RenderBenchmarkScript {
+    public:
+        RecordingBenchmarkScript() : RenderBenchmarkScript("RecordingBenchmark", FRAME_TIME | RECORD_TIME | DRAW_CALLS) {}
+
+        std::string getName() const override { return "RecordingBenchmarkScript"; }
+
+    protected:
+        bool setUp() override {
+            if (!requireOwnerMesh()) return false;
+
+            spawnGrid("RecordInstance_", 200, 1.5f, 0.5f);
+
+            previousInstancing = getRenderSettings().instancing;
+            previousThreads = getRenderSettings().recordThreads;
+            getRenderSettings().instancing = false;
+            getRenderSettings().gpuDriven = false;
+
+            const uint32_t maxThreads = static_cast<uint32_t>(JobSystem::getInstance().getWorkerCount()) + 1;
+            auto addThreadPhase = [this](uint32_t threads) {
+                addPhase(std::to_string(threads) + " thread(s)", [threads]() { getRenderSettings().recordThreads = threads; });
+            };
+            for (uint32_t threads = 1; threads < maxThreads; threads *= 2)
+                addThreadPhase(threads);
+            addThreadPhase(maxThreads);
+            return true;
+        }
+
+        void finish() override {
+            getRenderSettings().instancing = previousInstancing;
+            getRenderSettings().recordThreads = previousThreads;
+        }
+
+    private:
+        bool previousInstancing = true;
+        uint32_t previousThreads = 0;
+    };
+
+}
+
+namespace {
+    const bool registered_RecordingBenchmarkScript = se::registerScript<se::RecordingBenchmarkScript>("RecordingBenchmarkScript");
+}
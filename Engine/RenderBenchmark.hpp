@@ -0,0 +1,160 @@
+#pragma once
+#include "se_gameobject.hpp"
+#include "se_script_component.hpp"
+#include "se_scene_manager.hpp"
+#include "se_render_stats.hpp"
+#include "se_render_settings.hpp"
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace se {
+
+    // Shared driver of the renderer A/B benchmarks. A derived script fills the active scene in setUp and adds its
+    // phases, each a label and the settings to switch to. Every phase is warmed up, sampled for SAMPLE_FRAMES frames
+    // and printed as one line holding the averages of the metrics the script asked for, then the next one is applied.
+    class RenderBenchmarkScript : public ScriptComponent {
+    public:
+        enum Metric : uint32_t {
+            SCENE_GPU_TIME = 1 << 0,
+            RECORD_TIME = 1 << 1,
+            FRAME_TIME = 1 << 2,
+            // Pre-pass draws included
+            DRAW_CALLS = 1 << 3,
+            INSTANCES = 1 << 4,
+            OCCLUDED = 1 << 5,
+        };
+
+        void onCreate() override {
+            scene = SceneManager::getInstance().getActiveScene();
+            if (!scene || !setUp() || phases.empty())
+                return;
+
+            phases[0].apply();
+            running = true;
+        }
+
+        void onUpdate(float dt) override {
+            if (!running) return;
+
+            // Still holds the previous frame's numbers, stats are reset when the next frame begins
+            const RenderStats& stats = getRenderStats();
+            if (frame++ < WARMUP_FRAMES) return;
+
+            frameTimeMs += dt * 1000.0;
+            recordTimeMs += stats.recordTimeMs;
+            gpuTimeMs += stats.sceneGpuTimeMs;
+            drawCalls += stats.drawCalls + stats.prepassDrawCalls;
+            instances += stats.instances;
+            occluded += stats.objectsOccluded;
+            samples++;
+
+            if (samples < SAMPLE_FRAMES) return;
+
+            printPhase();
+            frameTimeMs = 0.0;
+            recordTimeMs = 0.0;
+            gpuTimeMs = 0.0;
+            drawCalls = 0;
+            instances = 0;
+            occluded = 0;
+            samples = 0;
+            frame = 0;
+
+            if (++phase < phases.size()) {
+                phases[phase].apply();
+                return;
+            }
+
+            running = false;
+            finish();
+        }
+
+    protected:
+        static constexpr int WARMUP_FRAMES = 30;
+        static constexpr int SAMPLE_FRAMES = 300;
+
+        RenderBenchmarkScript(std::string benchmarkName, uint32_t metrics)
+            : benchmarkName{ std::move(benchmarkName) }, metrics{ metrics } {}
+
+        // Fills the scene and adds the phases, returning false skips the benchmark
+        virtual bool setUp() = 0;
+        // After the last phase was printed, restores whatever the phases changed
+        virtual void finish() {}
+
+        void addPhase(std::string label, std::function<void()> apply) {
+            phases.push_back({ std::move(label), std::move(apply) });
+        }
+
+        std::ostream& log() const { return std::cout << "[" << benchmarkName << "] "; }
+
+        // The scene is filled with copies of the owner's, says so when there is nothing to copy
+        bool requireOwnerMesh() const {
+            if (owner->getMesh() && owner->getMaterial())
+                return true;
+            std::cerr << "[" << benchmarkName << "] owner needs a mesh and a material\n";
+            return false;
+        }
+
+        void spawnCopy(const std::string& name, const glm::vec3& translation, float scale = 1.0f) {
+            GameObjectDesc desc;
+            desc.name = name;
+            desc.mesh = owner->getMesh();
+            desc.material = owner->getMaterial();
+            desc.transform.translation = translation;
+            desc.transform.scale = glm::vec3(scale);
+            scene->deferCreateGameObject(std::move(desc));
+        }
+
+        // side * side copies on the xz plane, starting at origin
+        void spawnGrid(const std::string& prefix, int side, float spacing, float scale, const glm::vec3& origin = glm::vec3(0.0f)) {
+            scene->reserveGameObjects(scene->getObjectCount() + side * side);
+            for (int i = 0; i < side; ++i) {
+                for (int j = 0; j < side; ++j)
+                    spawnCopy(prefix + std::to_string(i * side + j), origin + glm::vec3(i * spacing, 0.0f, j * spacing), scale);
+            }
+        }
+
+        Scene* scene = nullptr;
+
+    private:
+        struct Phase {
+            std::string label;
+            std::function<void()> apply;
+        };
+
+        void printPhase() const {
+            std::ostream& out = log() << phases[phase].label << ":";
+            const char* separator = " ";
+            auto metric = [&](Metric flag, double value, const char* unit) {
+                if (!(metrics & flag)) return;
+                out << separator << value / samples << unit;
+                separator = ", ";
+            };
+            metric(SCENE_GPU_TIME, gpuTimeMs, " ms scene GPU");
+            metric(RECORD_TIME, recordTimeMs, " ms record");
+            metric(FRAME_TIME, frameTimeMs, " ms frame");
+            metric(DRAW_CALLS, static_cast<double>(drawCalls), " draws");
+            metric(INSTANCES, static_cast<double>(instances), " instances");
+            metric(OCCLUDED, static_cast<double>(occluded), " occluded");
+            out << "\n";
+        }
+
+        std::string benchmarkName;
+        uint32_t metrics;
+        std::vector<Phase> phases;
+        size_t phase = 0;
+        bool running = false;
+        int frame = 0;
+        int samples = 0;
+        double frameTimeMs = 0.0;
+        double recordTimeMs = 0.0;
+        double gpuTimeMs = 0.0;
+        uint64_t drawCalls = 0;
+        uint64_t instances = 0;
+        uint64_t occluded = 0;
+    };
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include "se_gameobject.hpp"
+#include "se_script_component.hpp"
+#include "se_script_manager.hpp"
+#include "se_simd.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace se {
+
+    // Times the batched transform kernels at every level the cpu supports against the scalar glm path
+    // over 100k transforms and reports the largest deviation. Runs once on creation and prints to stdout.
+    class SimdBenchmarkScript : public ScriptComponent {
+    public:
+
+        void onCreate() override {
+            const size_t count = 100000;
+
+            std::mt19937 rng{ 1234 };
+            std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+            std::uniform_real_distribution<float> angle(-glm::two_pi<float>(), glm::two_pi<float>());
+            std::uniform_real_distribution<float> scale(0.1f, 4.0f);
+
+            std::vector<TransformComponent> transforms(count);
+            for (auto& transform : transforms) {
+                transform.translation = glm::vec3(position(rng), position(rng), position(rng));
+                transform.rotation = glm::vec3(angle(rng), angle(rng), angle(rng));
+                transform.scale = glm::vec3(scale(rng), scale(rng), scale(rng));
+            }
+
+            std::vector<glm::vec3> points(count);
+            for (auto& point : points)
+                point = glm::vec3(position(rng), position(rng), position(rng));
+
+            glm::mat4 viewProjection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f)
+                * glm::lookAt(glm::vec3(0.0f, 50.0f, -200.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+            // Scalar reference straight from TransformComponent::mat4
+            std::vector<glm::mat4> reference(count);
+            std::vector<glm::mat4> referenceProduct(count);
+            std::vector<glm::vec4> referencePoints(count);
+            for (size_t i = 0; i < count; ++i)
+                reference[i] = transforms[i].mat4();
+            for (size_t i = 0; i < count; ++i)
+                referenceProduct[i] = reference[i] * reference[count - 1 - i];
+            for (size_t i = 0; i < count; ++i)
+                referencePoints[i] = viewProjection * glm::vec4(points[i], 1.0f);
+
+            std::vector<glm::mat4> reversed(reference.rbegin(), reference.rend());
+            std::vector<glm::mat4> matrices(count);
+            std::vector<glm::mat4> product(count);
+            std::vector<glm::vec4> projected(count);
+
+            simd::Level previous = simd::getLevel();
+            simd::Level supported = simd::getSupportedLevel();
+
+            std::cout << "[SimdBenchmark] " << count << " transforms, cpu supports " << simd::getLevelName(supported) << "\n";
+            std::cout << "[SimdBenchmark] level | compose (ms) | multiply (ms) | points (ms) | max compose error | max multiply error | max point error\n";
+
+            for (simd::Level level : { simd::Level::Scalar, simd::Level::SSE, simd::Level::AVX2 }) {
+                if (static_cast<int>(level) > static_cast<int>(supported))
+                    break;
+                simd::setLevel(level);
+
+                double composeMs = time([&]() { simd::composeTransforms(transforms.data(), matrices.data(), count); });
+                double multiplyMs = time([&]() { simd::multiplyMatrices(reference.data(), reversed.data(), product.data(), count); });
+                double pointsMs = time([&]() { simd::transformPoints(viewProjection, points.data(), projected.data(), count); });
+
+                float composeError = 0.0f;
+                float multiplyError = 0.0f;
+                float pointError = 0.0f;
+                for (size_t i = 0; i < count; ++i) {
+                    for (int c = 0; c < 4; ++c) {
+                        for (int r = 0; r < 4; ++r) {
+                            composeError = std::max(composeError, std::abs(matrices[i][c][r] - reference[i][c][r]));
+                            multiplyError = std::max(multiplyError, std::abs(product[i][c][r] - referenceProduct[i][c][r]));
+                        }
+                        // Clip space values scale with distance, compare relative to w
+                        pointError = std::max(pointError, std::abs(projected[i][c] - referencePoints[i][c]) / std::abs(referencePoints[i].w));
+                    }
+                }
+
+                std::cout << "[SimdBenchmark] " << simd::getLevelName(level) << " | " << composeMs << " | " << multiplyMs
+                    << " | " << pointsMs << " | " << composeError << " | " << multiplyError << " | " << pointError << "\n";
+
+                if (composeError > 1e-4f)
+                    std::cerr << "[SimdBenchmark] " << simd::getLevelName(level) << " compose deviates from TransformComponent::mat4!\n";
+            }
+
+            simd::setLevel(previous);
+        }
+
+        std::string getName() const override { return "SimdBenchmarkScript"; }
+
+    private:
+        template<typename Fn>
+        static double time(Fn&& fn)
+        {
+            using clock = std::chrono::high_resolution_clock;
+            const int iterations = 10;
+
+            fn();
+            auto start = clock::now();
+            for (int it = 0; it < iterations; ++it)
+                fn();
+            return std::chrono::duration<double, std::milli>(clock::now() - start).count() / iterations;
+        }
+    };
+
+}
+
+namespace {
+    const bool registered_SimdBenchmarkScript = se::registerScript<se::SimdBenchmarkScript>("SimdBenchmarkScript");
+}
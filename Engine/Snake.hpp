@@ -29,7 +29,7 @@ namespace se {
 
             dir = glm::vec3(0.0f);
 
-            body.push_back(GameObjectHandle(owner->getId(), scene));
+            body.push_back(scene->getHandle(*owner));
 
             apple = scene->getGameObjectByName("apple");
             if (!apple) {
@@ -142,11 +142,14 @@ namespace se {
         }
 
         void growBody() {
-            auto newSegment = scene->createGameObject("segment_" + std::to_string(body.size()));
-            newSegment->getTransform().translation = body.back()->getTransform().translation;
-            newSegment->setMesh(owner->getMesh());
-            newSegment->setMaterial(owner->getMaterial());
-            body.push_back(newSegment);
+            GameObjectDesc segment;
+            segment.name = "segment_" + std::to_string(body.size());
+            segment.transform.translation = body.back() ? body.back()->getTransform().translation : owner->getTransform().translation;
+            segment.mesh = owner->getMesh();
+            segment.material = owner->getMaterial();
+
+            // Resolves once the scene applies its deferred commands at the end of the update
+            body.push_back(scene->deferCreateGameObject(std::move(segment)));
         }
 
         glm::vec3 getRandomPosition() {
@@ -180,11 +183,8 @@ namespace se {
 
             GameObjectHandle head = body[0];
 
-            for (size_t i = 1; i < body.size(); ++i) {
-                if (body[i]) {
-                    body[i].destroy();
-                }
-            }
+            for (size_t i = 1; i < body.size(); ++i)
+                scene->deferDestroyGameObject(body[i]);
 
             body.clear();
             body.push_back(head);
@@ -0,0 +1,134 @@
+#pragma once
+#include "se_gameobject.hpp"
+#include "se_script_component.hpp"
+#include "se_script_manager.hpp"
+#include "se_scene.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace se {
+
+    // Insert, update and query throughput of the scene's dynamic AABB tree at 100k objects,
+    // with a linear scan over the world bounds for comparison. Runs once on creation and prints to stdout.
+    class SpatialBenchmarkScript : public ScriptComponent {
+    public:
+
+        void onCreate() override {
+            runBenchmark(100000);
+        }
+
+        std::string getName() const override { return "SpatialBenchmarkScript"; }
+
+    private:
+        void runBenchmark(size_t count)
+        {
+            using clock = std::chrono::high_resolution_clock;
+            auto elapsedMs = [](clock::time_point start) {
+                return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+            };
+
+            const float worldSize = 1000.0f;
+            const int queryCount = 10000;
+            std::mt19937 rng{ 1234 };
+            std::uniform_real_distribution<float> position(-worldSize * 0.5f, worldSize * 0.5f);
+            std::uniform_real_distribution<float> jitter(-0.5f, 0.5f);
+
+            Scene benchScene("SpatialBenchmark");
+            benchScene.reserveGameObjects(count);
+            std::vector<GameObjectHandle> handles;
+            handles.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                handles.push_back(benchScene.createGameObject("Spatial_" + std::to_string(i)));
+                handles.back()->getTransform().translation = glm::vec3(position(rng), position(rng), position(rng));
+            }
+
+            // The first update builds the world matrices and inserts every proxy
+            auto start = clock::now();
+            benchScene.updateTransforms();
+            double insertMs = elapsedMs(start);
+
+            // A tenth of the scene moving each frame
+            const int frames = 20;
+            start = clock::now();
+            for (int frame = 0; frame < frames; ++frame) {
+                for (size_t i = frame % 10; i < count; i += 10)
+                    handles[i]->getTransform().translation += glm::vec3(jitter(rng), jitter(rng), jitter(rng));
+                benchScene.updateTransforms();
+            }
+            double updateMs = elapsedMs(start) / frames;
+
+            std::vector<glm::vec3> points(queryCount);
+            for (auto& point : points)
+                point = glm::vec3(position(rng), position(rng), position(rng));
+
+            std::vector<GameObjectHandle> results;
+            size_t found = 0;
+
+            start = clock::now();
+            for (const auto& point : points)
+                found += benchScene.overlapSphere(point, 10.0f, results);
+            double sphereMs = elapsedMs(start);
+
+            // Same query as a scan over every object's bounds
+            const auto& bounds = benchScene.getWorldBounds();
+            size_t scanned = 0;
+            start = clock::now();
+            for (int q = 0; q < queryCount / 100; ++q) {
+                for (const auto& box : bounds) {
+                    if (box.distanceSquared(points[q]) <= 100.0f)
+                        scanned++;
+                }
+            }
+            double scanMs = elapsedMs(start) * 100.0;
+
+            start = clock::now();
+            for (const auto& point : points)
+                found += benchScene.findNearest(point, 8, results);
+            double nearestMs = elapsedMs(start);
+
+            start = clock::now();
+            size_t boxHits = 0;
+            for (const auto& point : points)
+                boxHits += benchScene.overlapBox(AABB::fromCenterExtents(point, glm::vec3(5.0f)), results);
+            double boxMs = elapsedMs(start);
+
+            // Scene objects without a mesh are points, so rays go against a bare tree of unit boxes instead
+            AABBTree tree;
+            tree.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                glm::vec3 center(position(rng), position(rng), position(rng));
+                tree.createProxy(AABB::fromCenterExtents(center, glm::vec3(1.0f)), static_cast<uint32_t>(i));
+            }
+
+            size_t rayHits = 0;
+            start = clock::now();
+            for (int q = 0; q < queryCount; ++q) {
+                glm::vec3 direction = glm::normalize(glm::vec3(jitter(rng), jitter(rng), jitter(rng)) + glm::vec3(0.0f, 0.0f, 1e-3f));
+                bool hit = false;
+                tree.raycast(points[q], direction, worldSize, [&](int32_t, float) {
+                    hit = true;
+                    return 0.0f;
+                });
+                rayHits += hit ? 1 : 0;
+            }
+            double rayMs = elapsedMs(start);
+
+            std::cout << "[SpatialBenchmark] " << count << " objects, tree height " << benchScene.getSpatialTree().getHeight() << "\n";
+            std::cout << "[SpatialBenchmark] insert: " << insertMs << " ms, update (10% moving): " << updateMs << " ms/frame\n";
+            std::cout << "[SpatialBenchmark] " << queryCount << " sphere overlaps: " << sphereMs << " ms (linear scan "
+                << scanMs << " ms)\n";
+            std::cout << "[SpatialBenchmark] " << queryCount << " box overlaps: " << boxMs << " ms, "
+                << queryCount << " 8-nearest: " << nearestMs << " ms\n";
+            std::cout << "[SpatialBenchmark] " << queryCount << " any-hit raycasts: " << rayMs << " ms, " << rayHits
+                << " hit (checksum " << found + boxHits + scanned << ")\n";
+        }
+    };
+
+}
+
+namespace {
+    const bool registered_SpatialBenchmarkScript = se::registerScript<se::SpatialBenchmarkScript>("SpatialBenchmarkScript");
+}
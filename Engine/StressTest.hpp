@@ -24,17 +24,19 @@ namespace se {
             auto mesh = owner->getMesh();
             auto mat = owner->getMaterial();
 
+            // Recorded now and created in one batch at the scene's next sync point
             for (int i = 0; i < count; ++i) {
                 for (int j = 0; j < count; ++j) {
-
-                    auto go = scene->createGameObject("Sphere_" + std::to_string(i) + "_" + std::to_string(j));
-
-                    go->setMesh(mesh);
-                    go->setMaterial(mat);
+                    GameObjectDesc desc;
+                    desc.name = "Sphere_" + std::to_string(i) + "_" + std::to_string(j);
+                    desc.mesh = mesh;
+                    desc.material = mat;
 
                     float spacing = 5.0f;
-                    go->getTransform().translation = glm::vec3(i * spacing, 0.0f, j * spacing);
-                    go->getTransform().scale = { 2.0, 2.0, 2.0 };
+                    desc.transform.translation = glm::vec3(i * spacing, 0.0f, j * spacing);
+                    desc.transform.scale = { 2.0, 2.0, 2.0 };
+
+                    scene->deferCreateGameObject(std::move(desc));
                 }
             }
         }
@@ -45,6 +47,9 @@ namespace se {
             }
         }
 
+        // Records creates against the active scene, keep it off the job system
+        ScriptAccess getAccess() const override { return ScriptAccess::Shared; }
+
         std::string getName() const override { return "StressScript"; }
     private:
         se::SceneManager* sceneManager{ nullptr };
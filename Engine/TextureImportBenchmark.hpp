@@ -0,0 +1,101 @@
+#pragma once
+#include "se_job_system.hpp"
+#include "se_resource_manager.hpp"
+#include "se_script_component.hpp"
+#include "se_script_manager.hpp"
+#include "se_scene_manager.hpp"
+#include "se_upload_manager.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace se {
+
+    // Imports a model from 1 to N threads (workers plus the main thread) and prints the wall time until every texture
+    // is decoded and created, uploads may still be in flight, and how many upload submissions the import took. Decodes run on the workers, with 1 thread there are
+    // none and they run inline on the main thread. The first import only warms the file cache. Each import
+    // is removed again before the next one. Runs once on creation, the worker count is restored afterwards.
+    class TextureImportBenchmarkScript : public ScriptComponent {
+    public:
+
+        void onCreate() override {
+            ResourceManager* resourceManager = SceneManager::getInstance().getResourceManager();
+            TextureSystem* textureSystem = resourceManager->getTextureSystem();
+            using clock = std::chrono::high_resolution_clock;
+
+            JobSystem& jobs = JobSystem::getInstance();
+            UploadManager& uploadManager = textureSystem->getDevice().getUploadManager();
+            textureSystem->finishDecoding();
+            size_t previousWorkers = jobs.getWorkerCount();
+            size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+            importModel(*resourceManager, *textureSystem);
+
+            std::cout << "[TextureImportBenchmark] " << MODEL_PATH << " | threads | import (ms) | speedup | upload submissions\n";
+
+            std::vector<size_t> threadCounts;
+            for (size_t threads = 1; threads < maxThreads; threads *= 2)
+                threadCounts.push_back(threads);
+            threadCounts.push_back(maxThreads);
+
+            double baseline = 0.0;
+            for (size_t threads : threadCounts) {
+                jobs.setWorkerCount(threads - 1);
+
+                const uint32_t batchesBefore = uploadManager.getBatchesSubmitted();
+                auto start = clock::now();
+                if (!importModel(*resourceManager, *textureSystem))
+                    break;
+                double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+                if (threads == 1)
+                    baseline = ms;
+                std::cout << "[TextureImportBenchmark] " << threads << " | " << ms << " | " << baseline / ms << "x | "
+                    << uploadManager.getBatchesSubmitted() - batchesBefore << "\n";
+            }
+
+            jobs.setWorkerCount(previousWorkers);
+        }
+
+        std::string getName() const override { return "TextureImportBenchmarkScript"; }
+
+    private:
+        static constexpr const char* MODEL_PATH = "models/sponza/sponza.obj";
+
+        bool importModel(ResourceManager& resourceManager, TextureSystem& textureSystem) {
+            auto mesh = resourceManager.loadMesh(MODEL_PATH);
+            if (!mesh) {
+                std::cerr << "[TextureImportBenchmark] could not import " << MODEL_PATH << "\n";
+                return false;
+            }
+            textureSystem.finishDecoding();
+
+            // Submeshes, materials and textures of the import all carry its guid as a prefix
+            const std::string guid = mesh->getGUID();
+            mesh.reset();
+            eraseWithPrefix(*resourceManager.getMeshes(), guid);
+            eraseWithPrefix(*resourceManager.getMaterials(), guid);
+            eraseWithPrefix(*resourceManager.getTextures(), guid);
+            return true;
+        }
+
+        template <typename T>
+        static void eraseWithPrefix(std::unordered_map<std::string, T>& resources, const std::string& prefix) {
+            for (auto it = resources.begin(); it != resources.end();) {
+                if (it->first.compare(0, prefix.size(), prefix) == 0)
+                    it = resources.erase(it);
+                else
+                    ++it;
+            }
+        }
+    };
+
+}
+
+namespace {
+    const bool registered_TextureImportBenchmarkScript = se::registerScript<se::TextureImportBenchmarkScript>("TextureImportBenchmarkScript");
+}
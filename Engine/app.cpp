@@ -1,10 +1,25 @@
 ﻿#include "app.hpp"
 #include "keyboard_movement_controller.hpp"
 #include "se_material_system.hpp"
+#include "se_render_stats.hpp"
 #include "ExampleScript.hpp"
 #include "TestScript.hpp"
 #include "Snake.hpp"
 #include "StressTest.hpp"
+#include "HandleBenchmark.hpp"
+#include "ComponentBenchmark.hpp"
+#include "SimdBenchmark.hpp"
+#include "JobBenchmark.hpp"
+#include "AllocationBenchmark.hpp"
+#include "SpatialBenchmark.hpp"
+#include "InstancingBenchmark.hpp"
+#include "GpuDrivenBenchmark.hpp"
+#include "RecordingBenchmark.hpp"
+#include "ClusteredLightingBenchmark.hpp"
+#include "DepthPrepassBenchmark.hpp"
+#include "OcclusionCullingBenchmark.hpp"
+#include "TextureImportBenchmark.hpp"
+#include "GeometryGrowthBenchmark.hpp"
 
 void App::mainLoop()
 {
@@ -49,22 +64,25 @@ void App::mainLoop()
         ubo.view = sceneManager->getCamera().getView();
         ubo.cameraPos = sceneManager->getCamera().getTransform().translation;
 
-        seDevice.updateUniformBuffers(ubo);
-
         auto* scene = sceneManager->getActiveScene();
         if (!scene) {
             printf("[ERROR]: SCENE EMPTY!");
             return;
         }
 
-        auto& gameObjects = scene->getGameObjects();
         scene->onUpdate(frameTime);
+        // Textures decoded since the last frame start uploading, finished uploads replace their placeholders
+        TextureSystem->update();
 
         if (auto commandBuffer = seRenderer.beginFrame())
         {
+            se::getRenderStats().reset();
+            seDevice.updateCameraUniform(ubo);
+            PBR->prepareFrame(seRenderer, commandBuffer, *scene, seRenderer.getFrameIndex());
             seRenderer.beginSwapChainRenderPass(commandBuffer);
 
-            PBR->renderGameObjects(commandBuffer, gameObjects, seRenderer.getFrameIndex());
+            PBR->renderGameObjects(seRenderer, commandBuffer, *scene, seRenderer.getFrameIndex());
+            seRenderer.nextSwapChainSubpass(commandBuffer);
             PBR->renderCubeMap(commandBuffer);
 
             imguiManager.newFrame();
@@ -1,5 +1,11 @@
 #include "imgui_manager.hpp"
 #include "se_pbr.hpp"
+#include "se_memory.hpp"
+#include "se_render_stats.hpp"
+#include "se_render_settings.hpp"
+
+#include <iostream>
+#include <utility>
 
 void se::ImGuiManager::renderSceneHierarchy()
 {
@@ -8,7 +14,7 @@ void se::ImGuiManager::renderSceneHierarchy()
     static int lightCount = 0;
     bool itemHovered = false;
     auto scene = sceneManager->getActiveScene();
-    std::list<std::unique_ptr<SEGameObject>>& gameobjects = scene->getGameObjects();
+    const std::vector<std::unique_ptr<SEGameObject>>& gameobjects = scene->getGameObjects();
 
     if (!showSceneHierarchy) return;
 
@@ -27,11 +33,12 @@ void se::ImGuiManager::renderSceneHierarchy()
     ImGui::Text("Game Objects (%d)", gameobjects.size());
     ImGui::Separator();
 
-    for (int i = 0; i < gameobjects.size(); i++)
+    // Creation order, the dense order of gameobjects changes whenever something is destroyed
+    bool deleted = false;
+    for (uint32_t dense : scene->getCreationOrder())
     {
-        auto it = gameobjects.begin();
-        std::advance(it, i);
-        auto& gameObject = *it;
+        int i = static_cast<int>(dense);
+        auto& gameObject = gameobjects[i];
         ImGuiSelectableFlags flags = ImGuiSelectableFlags_None;
         bool isSelected = (selectedGameObjectIndex == i);
 
@@ -48,14 +55,16 @@ void se::ImGuiManager::renderSceneHierarchy()
         {
             if (ImGui::MenuItem("Delete"))
             {
-                auto it = gameobjects.begin();
-                std::advance(it, i);
-                gameobjects.erase(it);
-                if (selectedGameObjectIndex == i) selectedGameObjectIndex = -1;
-                else if (selectedGameObjectIndex > i) selectedGameObjectIndex--;
+                // Children go with their parent and the pools get reordered, so drop the selection
+                scene->destroyGameObject(scene->getHandle(*gameObject));
+                selectedGameObjectIndex = -1;
+                deleted = true;
             }
             ImGui::EndPopup();
         }
+
+        if (deleted)
+            break;
     }
 
     if (!itemHovered && ImGui::BeginPopupContextWindow()) {
@@ -296,8 +305,11 @@ void se::ImGuiManager::renderAssetViewer()
 
             ImVec2 cursor = ImGui::GetCursorScreenPos();
 
-            // Draw the texture thumbnail
-            ImGui::Image((ImTextureID)texture->getTextureDescriptorSet(), { thumbnailSize, thumbnailSize });
+            // Draw the texture thumbnail, an empty slot while it is still uploading
+            if (texture->isReady())
+                ImGui::Image((ImTextureID)texture->getTextureDescriptorSet(), { thumbnailSize, thumbnailSize });
+            else
+                ImGui::Dummy({ thumbnailSize, thumbnailSize });
 
             // Draw hover highlight
             if (ImGui::IsItemHovered())
@@ -366,7 +378,7 @@ void se::ImGuiManager::renderPropertiesPanel()
     if (!showProperties) return;
 
     auto scene = sceneManager->getActiveScene();
-    std::list<std::unique_ptr<SEGameObject>>& gameobjects = scene->getGameObjects();
+    const std::vector<std::unique_ptr<SEGameObject>>& gameobjects = scene->getGameObjects();
 
     auto* viewport = ImGui::GetMainViewport();
     ImVec2 workPos = viewport->WorkPos;
@@ -407,15 +419,122 @@ void se::ImGuiManager::renderPropertiesPanel()
     ImGui::End();
 }
 
+void se::ImGuiManager::renderStats()
+{
+    if (!showStats) return;
+
+    memory::AllocationStats stats = memory::getGlobalStats();
+    uint64_t frameAllocations = stats.allocations - lastAllocationCount;
+    lastAllocationCount = stats.allocations;
+
+    auto* viewport = ImGui::GetMainViewport();
+    ImVec2 workPos = viewport->WorkPos;
+
+    // Floating, starts next to the Scene Hierarchy
+    ImGui::SetNextWindowPos(ImVec2(workPos.x + 310, workPos.y + 10), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(320, 0), ImGuiCond_FirstUseEver);
+
+    ImGui::Begin("Stats", &showStats, ImGuiWindowFlags_NoCollapse);
+
+    ImGui::Text("Frame: %.2f ms (%.0f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+    ImGui::Separator();
+
+    const RenderStats& renderStats = getRenderStats();
+    ImGui::Text("Objects: %u submitted, %u culled, %u occluded",
+        renderStats.objectsSubmitted, renderStats.objectsCulled, renderStats.objectsOccluded);
+    ImGui::Text("Submeshes: %u tested, %u culled", renderStats.submeshesTested, renderStats.submeshesCulled);
+    ImGui::Text("Draw calls: %u (%u instances), %u pre-pass", renderStats.drawCalls, renderStats.instances, renderStats.prepassDrawCalls);
+    ImGui::Text("Binds: %u pipeline, %u descriptor set, %u vertex buffer",
+        renderStats.pipelineBinds, renderStats.descriptorSetBinds, renderStats.vertexBufferBinds);
+    ImGui::Text("Scene record: %.3f ms, GPU: %.3f ms", renderStats.recordTimeMs, renderStats.sceneGpuTimeMs);
+    ImGui::Text("Lights: %u (%u uploaded)", renderStats.lights, renderStats.lightsUploaded);
+    ImGui::Checkbox("Instancing", &getRenderSettings().instancing);
+    ImGui::SameLine();
+    ImGui::Checkbox("GPU driven", &getRenderSettings().gpuDriven);
+    ImGui::SameLine();
+    ImGui::Checkbox("Clustered lights", &getRenderSettings().clusteredLighting);
+    ImGui::Checkbox("Depth pre-pass", &getRenderSettings().depthPrepass);
+    ImGui::SameLine();
+    ImGui::Checkbox("Occlusion culling", &getRenderSettings().occlusionCulling);
+    int recordThreads = static_cast<int>(getRenderSettings().recordThreads);
+    if (ImGui::SliderInt("Record threads (0 = all)", &recordThreads, 0, 16))
+        getRenderSettings().recordThreads = static_cast<uint32_t>(recordThreads);
+    ImGui::Separator();
+
+    RenderSettings& settings = getRenderSettings();
+    ImGui::Checkbox("Shadows", &settings.shadows);
+    static const char* shadowResolutionNames[] = { "512", "1024", "2048", "4096" };
+    static const uint32_t shadowResolutions[] = { 512, 1024, 2048, 4096 };
+    auto shadowResolutionCombo = [](const char* label, uint32_t& resolution) {
+        int index = 0;
+        for (int i = 0; i < IM_ARRAYSIZE(shadowResolutions); i++)
+            if (shadowResolutions[i] == resolution) index = i;
+        if (ImGui::Combo(label, &index, shadowResolutionNames, IM_ARRAYSIZE(shadowResolutionNames)))
+            resolution = shadowResolutions[index];
+    };
+    shadowResolutionCombo("Cascade resolution", settings.shadowCascadeResolution);
+    shadowResolutionCombo("Atlas resolution", settings.shadowAtlasResolution);
+    ImGui::SliderFloat("Shadow distance", &settings.shadowDistance, 5.0f, 500.0f, "%.0f");
+    for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+    {
+        ImGui::Text("Cascade %u: %.3f ms GPU, %.3f ms record", i, renderStats.shadowCascadeGpuMs[i], renderStats.shadowCascadeRecordMs[i]);
+        int interval = static_cast<int>(settings.shadowCascadeUpdateInterval[i]);
+        if (ImGui::SliderInt(("Update every##cascade" + std::to_string(i)).c_str(), &interval, 1, 16, "%d frames"))
+            settings.shadowCascadeUpdateInterval[i] = static_cast<uint32_t>(interval);
+    }
+    ImGui::Text("Atlas: %.3f ms GPU, %.3f ms record", renderStats.shadowAtlasGpuMs, renderStats.shadowAtlasRecordMs);
+    int atlasInterval = static_cast<int>(settings.shadowAtlasUpdateInterval);
+    if (ImGui::SliderInt("Update every##atlas", &atlasInterval, 1, 16, "%d frames"))
+        settings.shadowAtlasUpdateInterval = static_cast<uint32_t>(atlasInterval);
+    ImGui::Text("Shadow casters: %u, static redraws: %u", renderStats.shadowCasters, renderStats.shadowStaticRedraws);
+    ImGui::Separator();
+
+    ImGui::Text("Heap allocations this frame: %llu", static_cast<unsigned long long>(frameAllocations));
+    ImGui::Text("Heap allocations total: %llu", static_cast<unsigned long long>(stats.allocations));
+    ImGui::Text("Live heap allocations: %llu", static_cast<unsigned long long>(stats.allocations - stats.frees));
+    ImGui::Text("Heap bytes requested: %.1f MB", static_cast<double>(stats.bytesAllocated) / (1024.0 * 1024.0));
+    ImGui::Separator();
+
+    ImGui::Text("Pools");
+    memory::forEachPool([](const PoolAllocator& pool) {
+        if (pool.getSlabCount() == 0) return;
+        ImGui::BulletText("%s: %zu / %zu live, %zu B blocks", pool.getName().c_str(),
+            pool.getLiveBlocks(), pool.getCapacity(), pool.getBlockSize());
+    });
+    ImGui::Separator();
+
+    ImGui::Text("Device memory");
+    const MemoryAllocator& memoryAllocator = seDevice->getMemoryAllocator();
+    std::vector<MemoryAllocator::HeapStats> heaps = memoryAllocator.getHeapStats();
+    for (size_t i = 0; i < heaps.size(); i++)
+    {
+        const MemoryAllocator::HeapStats& heap = heaps[i];
+        if (heap.blockCount == 0 && heap.dedicatedCount == 0) continue;
+        ImGui::BulletText("Heap %zu: %.1f / %.1f MB, %u blocks, %u dedicated, %u allocations", i,
+            static_cast<double>(heap.used) / (1024.0 * 1024.0), static_cast<double>(heap.reserved) / (1024.0 * 1024.0),
+            heap.blockCount, heap.dedicatedCount, heap.allocationCount);
+    }
+    if (ImGui::Button("Dump device memory"))
+        memoryAllocator.dumpStats(std::cout);
+
+    const GeometryArena& geometryArena = seDevice->getGeometryArena();
+    ImGui::Text("Geometry: %u / %u vertices, %u / %u indices",
+        geometryArena.getVerticesUsed(), geometryArena.getVertexCapacity(),
+        geometryArena.getIndicesUsed(), geometryArena.getIndexCapacity());
+
+    const se::UploadManager& uploadManager = seDevice->getUploadManager();
+    ImGui::Text("Uploads: %.1f MB in %u batches",
+        uploadManager.getBytesUploaded() / (1024.0 * 1024.0), uploadManager.getBatchesSubmitted());
+
+    ImGui::End();
+}
+
 void se::ImGuiManager::renderGameObjectProperties()
 {
     auto scene = sceneManager->getActiveScene();
-    std::list<std::unique_ptr<SEGameObject>>& gameobjects = scene->getGameObjects();
-
-    auto it = gameobjects.begin();
-    std::advance(it, selectedGameObjectIndex);
+    const std::vector<std::unique_ptr<SEGameObject>>& gameobjects = scene->getGameObjects();
 
-    auto& gameObject = *it;
+    auto& gameObject = gameobjects[selectedGameObjectIndex];
 
     static char nameBuffer[128] = { 0 };
 
@@ -441,11 +560,12 @@ void se::ImGuiManager::renderGameObjectProperties()
     renderScriptComponent(gameObject);
 }
 
-void se::ImGuiManager::renderTransformComponent(std::unique_ptr<se::SEGameObject>& gameObject)
+void se::ImGuiManager::renderTransformComponent(const std::unique_ptr<se::SEGameObject>& gameObject)
 {
     if (ImGui::CollapsingHeader("Transform", ImGuiTreeNodeFlags_DefaultOpen))
     {
-        auto transform = gameObject->getTransform();
+        // Read through the const overload so an open panel doesn't dirty the transform every frame
+        auto transform = std::as_const(*gameObject).getTransform();
 
         float position[3] = { transform.translation.x, transform.translation.y, transform.translation.z };
         float rotation[3] = { transform.rotation.x, transform.rotation.y, transform.rotation.z };
@@ -471,10 +591,30 @@ void se::ImGuiManager::renderTransformComponent(std::unique_ptr<se::SEGameObject
             gameObject->setTransform(newTransform);
         }
 
+        // Static objects are drawn once into the cached shadow maps instead of every shadow update
+        bool isStatic = gameObject->isStatic();
+        if (ImGui::Checkbox("Static", &isStatic))
+            gameObject->setStatic(isStatic);
+
+        auto* parent = gameObject->getParent();
+        std::string parentName = parent ? parent->getName() : "None";
+        if (ImGui::BeginCombo("Parent", parentName.c_str()))
+        {
+            if (ImGui::Selectable("None", parent == nullptr))
+                gameObject->setParent(nullptr);
+
+            for (auto& other : sceneManager->getActiveScene()->getGameObjects())
+            {
+                if (other.get() == gameObject.get()) continue;
+                if (ImGui::Selectable((other->getName() + "##" + std::to_string(other->getId())).c_str(), other.get() == parent))
+                    gameObject->setParent(other.get());
+            }
+            ImGui::EndCombo();
+        }
     }
 }
 
-void se::ImGuiManager::renderMeshComponent(std::unique_ptr<se::SEGameObject>& gameObject)
+void se::ImGuiManager::renderMeshComponent(const std::unique_ptr<se::SEGameObject>& gameObject)
 {
     if (ImGui::CollapsingHeader("Mesh"))
     {
@@ -498,7 +638,7 @@ void se::ImGuiManager::renderMeshComponent(std::unique_ptr<se::SEGameObject>& ga
     }
 }
 
-void se::ImGuiManager::renderMaterialComponent(std::unique_ptr<se::SEGameObject>& gameObject)
+void se::ImGuiManager::renderMaterialComponent(const std::unique_ptr<se::SEGameObject>& gameObject)
 {
     if (ImGui::CollapsingHeader("Material"))
     {
@@ -518,7 +658,7 @@ void se::ImGuiManager::renderMaterialComponent(std::unique_ptr<se::SEGameObject>
     }
 }
 
-void se::ImGuiManager::renderLightComponent(std::unique_ptr<se::SEGameObject>& gameObject)
+void se::ImGuiManager::renderLightComponent(const std::unique_ptr<se::SEGameObject>& gameObject)
 {
     if (!gameObject->hasLight()) return;
 
@@ -546,10 +686,15 @@ void se::ImGuiManager::renderLightComponent(std::unique_ptr<se::SEGameObject>& g
         // Intensity slider
         ImGui::SliderFloat("Intensity", &light.intensity, 0.0f, 10.0f, "%.2f");
 
+        if (light.type != se::LightType::Directional)
+        {
+            ImGui::SliderFloat("Range", &light.range, 0.1f, 100.0f, "%.1f");
+        }
+
         // Direction (for Directional and Spot lights)
         if (light.type == se::LightType::Directional || light.type == se::LightType::Spot)
         {
-            ImGui::DragFloat3("Direction", &light.direction.x, 0.1f, -1.0f, 1.0f);
+            ImGui::TextDisabled("Shines along the object's +z, rotate it to aim");
         }
 
         // Spot angle (for Spot lights)
@@ -557,10 +702,14 @@ void se::ImGuiManager::renderLightComponent(std::unique_ptr<se::SEGameObject>& g
         {
             ImGui::SliderFloat("Spot Angle", &light.spotAngle, 0.0f, 90.0f, "%.1f deg");
         }
+
+        bool castShadows = light.castShadows != 0;
+        if (ImGui::Checkbox("Cast shadows", &castShadows))
+            light.castShadows = castShadows ? 1u : 0u;
     }
 }
 
-void se::ImGuiManager::renderScriptComponent(std::unique_ptr<se::SEGameObject>& gameObject)
+void se::ImGuiManager::renderScriptComponent(const std::unique_ptr<se::SEGameObject>& gameObject)
 {
     //if (!gameObject->hasScript()) return;
 
@@ -661,7 +810,10 @@ void se::ImGuiManager::renderTextureProperties()
         ImGui::Text("Filter Mode: Linear");
         ImGui::Text("Wrap Mode: Repeat");
 
-        ImGui::Image((ImTextureID)texture->getTextureDescriptorSet(), ImVec2(128, 128));
+        if (texture->isReady())
+            ImGui::Image((ImTextureID)texture->getTextureDescriptorSet(), ImVec2(128, 128));
+        else
+            ImGui::Text("Uploading...");
     }
 }
 
@@ -748,7 +900,12 @@ void se::ImGuiManager::renderTextureSelector(const std::string& label,
     ImGui::BeginGroup();
 
     // Thumbnail image
-    if (currentTexture) {
+    if (currentTexture && !currentTexture->isReady()) {
+        if (ImGui::Button(("...##" + label).c_str(), imageSize)) {
+            openPopup = true;
+        }
+    }
+    else if (currentTexture) {
         ImTextureID descriptor = (ImTextureID)currentTexture->getTextureDescriptorSet();
         if (ImGui::ImageButton(("##" + label).c_str(), descriptor, imageSize)) {
             openPopup = true;
@@ -807,7 +964,10 @@ void se::ImGuiManager::renderTextureSelector(const std::string& label,
             ImGui::PushID(texture.get());
 
             ImVec2 imagePos = ImGui::GetCursorScreenPos();
-            ImGui::Image((ImTextureID)texture->getTextureDescriptorSet(), { thumbnailSize, thumbnailSize });
+            if (texture->isReady())
+                ImGui::Image((ImTextureID)texture->getTextureDescriptorSet(), { thumbnailSize, thumbnailSize });
+            else
+                ImGui::Dummy({ thumbnailSize, thumbnailSize });
 
             if (ImGui::IsItemHovered())
             {
@@ -981,7 +1141,7 @@ void se::ImGuiManager::renderMeshSelector(
 }
 
 void se::ImGuiManager::renderScriptSelector(
-    std::unique_ptr<se::ScriptComponent>& currentScript,
+    const std::unique_ptr<se::ScriptComponent>& currentScript,
     std::function<void(std::unique_ptr<se::ScriptComponent>)> onScriptSelected)
 {
     std::string label = currentScript ? currentScript->getName() : "No Script";
@@ -1050,6 +1210,7 @@ void se::ImGuiManager::init(SEDevice& seDevice, VkRenderPass renderPass, GLFWwin
     this->window = window;
     this->renderPass = renderPass;
     this->resourceManager = resourceManager;
+    this->seDevice = &seDevice;
     // Create ImGui context
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -1065,6 +1226,7 @@ void se::ImGuiManager::init(SEDevice& seDevice, VkRenderPass renderPass, GLFWwin
     initInfo.QueueFamily = seDevice.findPhysicalQueueFamilies().graphicsFamily.value();
     initInfo.Queue = seDevice.graphicsQueue();;
     initInfo.RenderPass = renderPass;
+    initInfo.Subpass = se::SESwapChain::OVERLAY_SUBPASS;
     initInfo.PipelineCache = VK_NULL_HANDLE;
     initInfo.DescriptorPool = seDevice.getDescriptorPool();
     initInfo.MinImageCount = 2;
@@ -1089,6 +1251,7 @@ void se::ImGuiManager::render(VkCommandBuffer commandBuffer)
     renderAssetBrowser();
     renderAssetViewer();
     renderPropertiesPanel();
+    renderStats();
 
     // Render ImGui
     ImGui::Render();
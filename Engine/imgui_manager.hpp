@@ -32,14 +32,15 @@ namespace se
         void renderAssetContextMenu();
         void renderAssetViewer();
         void renderPropertiesPanel();
+        void renderStats();
 
         // GameObject properties
         void renderGameObjectProperties();
-        void renderTransformComponent(std::unique_ptr<se::SEGameObject>& gameObject);
-        void renderMeshComponent(std::unique_ptr<se::SEGameObject>& gameObject);
-        void renderMaterialComponent(std::unique_ptr<se::SEGameObject>& gameObject);
-        void renderLightComponent(std::unique_ptr<se::SEGameObject>& gameObject);
-        void renderScriptComponent(std::unique_ptr<se::SEGameObject>& gameObject);
+        void renderTransformComponent(const std::unique_ptr<se::SEGameObject>& gameObject);
+        void renderMeshComponent(const std::unique_ptr<se::SEGameObject>& gameObject);
+        void renderMaterialComponent(const std::unique_ptr<se::SEGameObject>& gameObject);
+        void renderLightComponent(const std::unique_ptr<se::SEGameObject>& gameObject);
+        void renderScriptComponent(const std::unique_ptr<se::SEGameObject>& gameObject);
 
 
         // Asset properties
@@ -55,7 +56,7 @@ namespace se
 
         void renderMeshSelector(std::shared_ptr<se::SEMesh> currentMesh, std::function<void(std::shared_ptr<se::SEMesh>)> onMeshSelected);
 
-        void renderScriptSelector(std::unique_ptr<se::ScriptComponent>& currentScript, std::function<void(std::unique_ptr<se::ScriptComponent>)> onScriptSelected);
+        void renderScriptSelector(const std::unique_ptr<se::ScriptComponent>& currentScript, std::function<void(std::unique_ptr<se::ScriptComponent>)> onScriptSelected);
 
         // Vulkan/ImGui setup
         GLFWwindow* window{ nullptr };
@@ -67,6 +68,7 @@ namespace se
         VkDescriptorPool descriptorPool{ VK_NULL_HANDLE };
         VkRenderPass renderPass{ VK_NULL_HANDLE };
         uint32_t imageCount{ 0 };
+        se::SEDevice* seDevice{ nullptr };
 
         // Data references
         se::ResourceManager* resourceManager{ nullptr };
@@ -85,5 +87,9 @@ namespace se
         bool showAssetBrowser = true;
         bool showAssetViewer = true;
         bool showProperties = true;
+        bool showStats = true;
+
+        // Global allocation count at the previous stats update, for the per frame delta
+        uint64_t lastAllocationCount = 0;
     };
 }
\ No newline at end of file
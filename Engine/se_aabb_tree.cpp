@@ -0,0 +1,292 @@
+#include "se_aabb_tree.hpp"
+
+#include <cassert>
+
+namespace se {
+
+    namespace {
+        AABB fatten(const AABB& box, float margin)
+        {
+            AABB fat;
+            fat.min = box.min - glm::vec3(margin);
+            fat.max = box.max + glm::vec3(margin);
+            return fat;
+        }
+    }
+
+    int32_t AABBTree::createProxy(const AABB& box, uint32_t userData)
+    {
+        int32_t proxyId = allocateNode();
+        Node& node = nodes[proxyId];
+        node.box = fatten(box, margin);
+        node.userData = userData;
+        node.height = 0;
+
+        insertLeaf(proxyId);
+        proxyCount++;
+        return proxyId;
+    }
+
+    void AABBTree::destroyProxy(int32_t proxyId)
+    {
+        assert(nodes[proxyId].isLeaf() && "Only leaves are proxies");
+
+        removeLeaf(proxyId);
+        freeNode(proxyId);
+        proxyCount--;
+    }
+
+    bool AABBTree::moveProxy(int32_t proxyId, const AABB& box)
+    {
+        // Still inside the fat box, and the fat box isn't oversized after the object shrank
+        const AABB& fat = nodes[proxyId].box;
+        if (fat.contains(box) && fatten(box, 4.0f * margin).contains(fat))
+            return false;
+
+        removeLeaf(proxyId);
+        nodes[proxyId].box = fatten(box, margin);
+        insertLeaf(proxyId);
+        return true;
+    }
+
+    void AABBTree::clear()
+    {
+        nodes.clear();
+        root = NULL_NODE;
+        freeList = NULL_NODE;
+        proxyCount = 0;
+    }
+
+    void AABBTree::reserve(size_t count)
+    {
+        // A tree over n leaves has n - 1 internal nodes
+        nodes.reserve(count * 2);
+    }
+
+    int32_t AABBTree::allocateNode()
+    {
+        if (freeList == NULL_NODE) {
+            nodes.emplace_back();
+            return static_cast<int32_t>(nodes.size() - 1);
+        }
+
+        int32_t index = freeList;
+        freeList = nodes[index].parent;
+        nodes[index] = Node{};
+        return index;
+    }
+
+    void AABBTree::freeNode(int32_t node)
+    {
+        nodes[node].parent = freeList;
+        nodes[node].height = -1;
+        freeList = node;
+    }
+
+    void AABBTree::insertLeaf(int32_t leaf)
+    {
+        if (root == NULL_NODE) {
+            root = leaf;
+            nodes[root].parent = NULL_NODE;
+            return;
+        }
+
+        // Walk down towards the sibling that grows the tree's total surface area the least
+        const AABB leafBox = nodes[leaf].box;
+        int32_t index = root;
+        while (!nodes[index].isLeaf()) {
+            const Node& node = nodes[index];
+            float area = node.box.getSurfaceArea();
+            float combinedArea = AABB::merge(node.box, leafBox).getSurfaceArea();
+
+            // Pairing with this node creates a parent around both
+            float cost = 2.0f * combinedArea;
+            // Descending further still grows every ancestor by this much
+            float inheritanceCost = 2.0f * (combinedArea - area);
+
+            auto descendCost = [&](int32_t child) {
+                const Node& childNode = nodes[child];
+                float merged = AABB::merge(leafBox, childNode.box).getSurfaceArea();
+                if (childNode.isLeaf())
+                    return merged + inheritanceCost;
+                return merged - childNode.box.getSurfaceArea() + inheritanceCost;
+            };
+
+            float cost1 = descendCost(node.child1);
+            float cost2 = descendCost(node.child2);
+
+            if (cost < cost1 && cost < cost2)
+                break;
+
+            index = cost1 < cost2 ? node.child1 : node.child2;
+        }
+
+        int32_t sibling = index;
+        int32_t oldParent = nodes[sibling].parent;
+        int32_t newParent = allocateNode();
+
+        nodes[newParent].parent = oldParent;
+        nodes[newParent].box = AABB::merge(leafBox, nodes[sibling].box);
+        nodes[newParent].height = nodes[sibling].height + 1;
+        nodes[newParent].child1 = sibling;
+        nodes[newParent].child2 = leaf;
+        nodes[sibling].parent = newParent;
+        nodes[leaf].parent = newParent;
+
+        if (oldParent == NULL_NODE) {
+            root = newParent;
+        }
+        else if (nodes[oldParent].child1 == sibling) {
+            nodes[oldParent].child1 = newParent;
+        }
+        else {
+            nodes[oldParent].child2 = newParent;
+        }
+
+        refitUpwards(nodes[leaf].parent);
+    }
+
+    void AABBTree::removeLeaf(int32_t leaf)
+    {
+        if (leaf == root) {
+            root = NULL_NODE;
+            return;
+        }
+
+        int32_t parent = nodes[leaf].parent;
+        int32_t grandParent = nodes[parent].parent;
+        int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+        // The parent goes away and the sibling takes its place
+        if (grandParent == NULL_NODE) {
+            root = sibling;
+            nodes[sibling].parent = NULL_NODE;
+            freeNode(parent);
+            return;
+        }
+
+        if (nodes[grandParent].child1 == parent)
+            nodes[grandParent].child1 = sibling;
+        else
+            nodes[grandParent].child2 = sibling;
+        nodes[sibling].parent = grandParent;
+        freeNode(parent);
+
+        refitUpwards(grandParent);
+    }
+
+    void AABBTree::refitUpwards(int32_t index)
+    {
+        while (index != NULL_NODE) {
+            index = balance(index);
+
+            Node& node = nodes[index];
+            const Node& child1 = nodes[node.child1];
+            const Node& child2 = nodes[node.child2];
+            node.height = 1 + std::max(child1.height, child2.height);
+            node.box = AABB::merge(child1.box, child2.box);
+
+            index = node.parent;
+        }
+    }
+
+    // Rotates the taller grandchild up when a's subtrees differ in height by more than one,
+    // returns the node now sitting where a was
+    int32_t AABBTree::balance(int32_t a)
+    {
+        Node& nodeA = nodes[a];
+        if (nodeA.isLeaf() || nodeA.height < 2)
+            return a;
+
+        int32_t b = nodeA.child1;
+        int32_t c = nodeA.child2;
+        Node& nodeB = nodes[b];
+        Node& nodeC = nodes[c];
+
+        int32_t heightDifference = nodeC.height - nodeB.height;
+
+        // Lift c
+        if (heightDifference > 1) {
+            int32_t f = nodeC.child1;
+            int32_t g = nodeC.child2;
+            Node& nodeF = nodes[f];
+            Node& nodeG = nodes[g];
+
+            nodeC.child1 = a;
+            nodeC.parent = nodeA.parent;
+            nodeA.parent = c;
+
+            if (nodeC.parent == NULL_NODE)
+                root = c;
+            else if (nodes[nodeC.parent].child1 == a)
+                nodes[nodeC.parent].child1 = c;
+            else
+                nodes[nodeC.parent].child2 = c;
+
+            // The taller of f and g stays under c, the other moves under a
+            if (nodeF.height > nodeG.height) {
+                nodeC.child2 = f;
+                nodeA.child2 = g;
+                nodeG.parent = a;
+                nodeA.box = AABB::merge(nodeB.box, nodeG.box);
+                nodeC.box = AABB::merge(nodeA.box, nodeF.box);
+                nodeA.height = 1 + std::max(nodeB.height, nodeG.height);
+                nodeC.height = 1 + std::max(nodeA.height, nodeF.height);
+            }
+            else {
+                nodeC.child2 = g;
+                nodeA.child2 = f;
+                nodeF.parent = a;
+                nodeA.box = AABB::merge(nodeB.box, nodeF.box);
+                nodeC.box = AABB::merge(nodeA.box, nodeG.box);
+                nodeA.height = 1 + std::max(nodeB.height, nodeF.height);
+                nodeC.height = 1 + std::max(nodeA.height, nodeG.height);
+            }
+
+            return c;
+        }
+
+        // Lift b
+        if (heightDifference < -1) {
+            int32_t d = nodeB.child1;
+            int32_t e = nodeB.child2;
+            Node& nodeD = nodes[d];
+            Node& nodeE = nodes[e];
+
+            nodeB.child1 = a;
+            nodeB.parent = nodeA.parent;
+            nodeA.parent = b;
+
+            if (nodeB.parent == NULL_NODE)
+                root = b;
+            else if (nodes[nodeB.parent].child1 == a)
+                nodes[nodeB.parent].child1 = b;
+            else
+                nodes[nodeB.parent].child2 = b;
+
+            if (nodeD.height > nodeE.height) {
+                nodeB.child2 = d;
+                nodeA.child1 = e;
+                nodeE.parent = a;
+                nodeA.box = AABB::merge(nodeC.box, nodeE.box);
+                nodeB.box = AABB::merge(nodeA.box, nodeD.box);
+                nodeA.height = 1 + std::max(nodeC.height, nodeE.height);
+                nodeB.height = 1 + std::max(nodeA.height, nodeD.height);
+            }
+            else {
+                nodeB.child2 = e;
+                nodeA.child1 = d;
+                nodeD.parent = a;
+                nodeA.box = AABB::merge(nodeC.box, nodeD.box);
+                nodeB.box = AABB::merge(nodeA.box, nodeE.box);
+                nodeA.height = 1 + std::max(nodeC.height, nodeD.height);
+                nodeB.height = 1 + std::max(nodeA.height, nodeE.height);
+            }
+
+            return b;
+        }
+
+        return a;
+    }
+
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "se_bounds.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace se {
+
+    // Dynamic bounding volume hierarchy. Leaves hold fattened boxes so objects moving a little only
+    // have to be checked, anything that leaves its fat box is removed and reinserted. Insertion picks
+    // the sibling with the lowest surface area cost and the tree is kept balanced with rotations.
+    class AABBTree {
+    public:
+        static constexpr int32_t NULL_NODE = -1;
+
+        explicit AABBTree(float margin = 0.1f) : margin{ margin } {}
+
+        AABBTree(const AABBTree&) = delete;
+        AABBTree& operator=(const AABBTree&) = delete;
+
+        int32_t createProxy(const AABB& box, uint32_t userData);
+        void destroyProxy(int32_t proxyId);
+        // Returns true when the proxy had to be reinserted
+        bool moveProxy(int32_t proxyId, const AABB& box);
+        void clear();
+        void reserve(size_t proxyCount);
+
+        uint32_t getUserData(int32_t proxyId) const { return nodes[proxyId].userData; }
+        const AABB& getFatAABB(int32_t proxyId) const { return nodes[proxyId].box; }
+        size_t getProxyCount() const { return proxyCount; }
+        int getHeight() const { return root == NULL_NODE ? 0 : nodes[root].height; }
+
+        // fn(proxyId) for every fat box overlapping box, return false to stop
+        template<typename Fn>
+        void query(const AABB& box, Fn&& fn) const;
+
+        // fn(proxyId, maxDistance) for every fat box the ray passes through, direction must be normalized.
+        // Return maxDistance to carry on, a smaller value to clip the ray or 0 to stop.
+        template<typename Fn>
+        void raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Fn&& fn) const;
+
+        // fn(proxyId) for fat boxes within the current search radius, nearer subtrees first.
+        // fn returns the new squared search radius, e.g. the distance to the kth best result so far.
+        template<typename Fn>
+        void nearest(const glm::vec3& point, float maxDistanceSquared, Fn&& fn) const;
+
+    private:
+        struct Node {
+            AABB box;
+            uint32_t userData = 0;
+            // Next free node while the node is on the free list
+            int32_t parent = NULL_NODE;
+            int32_t child1 = NULL_NODE;
+            int32_t child2 = NULL_NODE;
+            // Leaves are 0, free nodes -1
+            int32_t height = -1;
+
+            bool isLeaf() const { return child1 == NULL_NODE; }
+        };
+
+        // Traversal stack, the inline part covers any balanced tree and deeper ones spill to the heap.
+        // Local to each query so several threads can read the tree at once.
+        class NodeStack {
+        public:
+            void push(int32_t node)
+            {
+                if (count < INLINE_CAPACITY)
+                    inlineNodes[count] = node;
+                else
+                    overflow.push_back(node);
+                count++;
+            }
+
+            int32_t pop()
+            {
+                count--;
+                if (count < INLINE_CAPACITY)
+                    return inlineNodes[count];
+                int32_t node = overflow.back();
+                overflow.pop_back();
+                return node;
+            }
+
+            bool empty() const { return count == 0; }
+
+        private:
+            static constexpr int INLINE_CAPACITY = 256;
+            int32_t inlineNodes[INLINE_CAPACITY];
+            std::vector<int32_t> overflow;
+            int count = 0;
+        };
+
+        int32_t allocateNode();
+        void freeNode(int32_t node);
+        void insertLeaf(int32_t leaf);
+        void removeLeaf(int32_t leaf);
+        int32_t balance(int32_t node);
+        void refitUpwards(int32_t node);
+
+        float margin;
+        std::vector<Node> nodes;
+        int32_t root = NULL_NODE;
+        int32_t freeList = NULL_NODE;
+        size_t proxyCount = 0;
+    };
+
+    template<typename Fn>
+    void AABBTree::query(const AABB& box, Fn&& fn) const
+    {
+        NodeStack stack;
+        stack.push(root);
+
+        while (!stack.empty()) {
+            int32_t index = stack.pop();
+            if (index == NULL_NODE)
+                continue;
+
+            const Node& node = nodes[index];
+            if (!node.box.overlaps(box))
+                continue;
+
+            if (node.isLeaf()) {
+                if (!fn(index))
+                    return;
+            }
+            else {
+                stack.push(node.child1);
+                stack.push(node.child2);
+            }
+        }
+    }
+
+    template<typename Fn>
+    void AABBTree::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Fn&& fn) const
+    {
+        const glm::vec3 inverseDirection = 1.0f / direction;
+
+        NodeStack stack;
+        stack.push(root);
+
+        while (!stack.empty()) {
+            int32_t index = stack.pop();
+            if (index == NULL_NODE)
+                continue;
+
+            const Node& node = nodes[index];
+            float distance;
+            if (!node.box.intersectsRay(origin, inverseDirection, maxDistance, distance))
+                continue;
+
+            if (node.isLeaf()) {
+                float clipped = fn(index, maxDistance);
+                if (clipped <= 0.0f)
+                    return;
+                maxDistance = std::min(maxDistance, clipped);
+            }
+            else {
+                stack.push(node.child1);
+                stack.push(node.child2);
+            }
+        }
+    }
+
+    template<typename Fn>
+    void AABBTree::nearest(const glm::vec3& point, float maxDistanceSquared, Fn&& fn) const
+    {
+        NodeStack stack;
+        stack.push(root);
+
+        while (!stack.empty()) {
+            int32_t index = stack.pop();
+            if (index == NULL_NODE)
+                continue;
+
+            const Node& node = nodes[index];
+            if (node.box.distanceSquared(point) > maxDistanceSquared)
+                continue;
+
+            if (node.isLeaf()) {
+                maxDistanceSquared = fn(index);
+                continue;
+            }
+
+            // Pushed last is popped first, so the nearer child tightens the radius before the other is tested
+            float distance1 = nodes[node.child1].box.distanceSquared(point);
+            float distance2 = nodes[node.child2].box.distanceSquared(point);
+            if (distance1 < distance2) {
+                stack.push(node.child2);
+                stack.push(node.child1);
+            }
+            else {
+                stack.push(node.child1);
+                stack.push(node.child2);
+            }
+        }
+    }
+
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cfloat>
+
+namespace se
+{
+    struct AABB
+    {
+        glm::vec3 min{ FLT_MAX };
+        glm::vec3 max{ -FLT_MAX };
+
+        bool isValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+
+        void expand(const glm::vec3& point)
+        {
+            min = glm::min(min, point);
+            max = glm::max(max, point);
+        }
+
+        void expand(const AABB& other)
+        {
+            min = glm::min(min, other.min);
+            max = glm::max(max, other.max);
+        }
+
+        glm::vec3 getCenter() const { return (min + max) * 0.5f; }
+        glm::vec3 getExtents() const { return (max - min) * 0.5f; }
+
+        float getSurfaceArea() const
+        {
+            glm::vec3 size = max - min;
+            return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+        }
+
+        bool contains(const AABB& other) const
+        {
+            return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z
+                && other.max.x <= max.x && other.max.y <= max.y && other.max.z <= max.z;
+        }
+
+        bool overlaps(const AABB& other) const
+        {
+            return min.x <= other.max.x && other.min.x <= max.x
+                && min.y <= other.max.y && other.min.y <= max.y
+                && min.z <= other.max.z && other.min.z <= max.z;
+        }
+
+        // Zero when the point is inside
+        float distanceSquared(const glm::vec3& point) const
+        {
+            glm::vec3 offset = glm::max(glm::max(min - point, point - max), glm::vec3(0.0f));
+            return glm::dot(offset, offset);
+        }
+
+        // Slab test, inverseDirection is 1 / direction. distance is where the ray enters, 0 if it starts inside.
+        bool intersectsRay(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& distance) const
+        {
+            glm::vec3 t1 = (min - origin) * inverseDirection;
+            glm::vec3 t2 = (max - origin) * inverseDirection;
+            glm::vec3 tNear = glm::min(t1, t2);
+            glm::vec3 tFar = glm::max(t1, t2);
+
+            float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+            float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+            distance = enter;
+            return enter <= exit;
+        }
+
+        static AABB fromCenterExtents(const glm::vec3& center, const glm::vec3& extents)
+        {
+            AABB box;
+            box.min = center - extents;
+            box.max = center + extents;
+            return box;
+        }
+
+        static AABB merge(const AABB& a, const AABB& b)
+        {
+            AABB box;
+            box.min = glm::min(a.min, b.min);
+            box.max = glm::max(a.max, b.max);
+            return box;
+        }
+
+        // Box around this one after transformation, as center and half extents (Arvo's method)
+        void transform(const glm::mat4& matrix, glm::vec3& outCenter, glm::vec3& outExtents) const
+        {
+            glm::vec3 center = getCenter();
+            glm::vec3 extents = getExtents();
+
+            outCenter = glm::vec3(matrix * glm::vec4(center, 1.0f));
+            outExtents = glm::abs(glm::vec3(matrix[0])) * extents.x
+                + glm::abs(glm::vec3(matrix[1])) * extents.y
+                + glm::abs(glm::vec3(matrix[2])) * extents.z;
+        }
+    };
+
+    struct BoundingSphere
+    {
+        glm::vec3 center{ 0.0f };
+        float radius = 0.0f;
+    };
+
+    // Six planes with inward facing normals, xyz is the normal and w the distance.
+    // Built from a Vulkan style projection with depth in [0, 1].
+    struct Frustum
+    {
+        enum Plane { Left = 0, Right, Bottom, Top, Near, Far, Count };
+
+        glm::vec4 planes[Count];
+
+        Frustum() = default;
+
+        explicit Frustum(const glm::mat4& viewProjection)
+        {
+            auto row = [&viewProjection](int i) {
+                return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+            };
+
+            planes[Left] = row(3) + row(0);
+            planes[Right] = row(3) - row(0);
+            planes[Bottom] = row(3) + row(1);
+            planes[Top] = row(3) - row(1);
+            planes[Near] = row(2);
+            planes[Far] = row(3) - row(2);
+
+            for (auto& plane : planes)
+                plane /= glm::length(glm::vec3(plane));
+        }
+
+        bool intersects(const glm::vec3& center, const glm::vec3& extents) const
+        {
+            for (const auto& plane : planes) {
+                glm::vec3 normal(plane);
+                float distance = glm::dot(normal, center) + plane.w;
+                float radius = glm::dot(glm::abs(normal), extents);
+                if (distance + radius < 0.0f)
+                    return false;
+            }
+            return true;
+        }
+
+        bool intersects(const BoundingSphere& sphere) const
+        {
+            for (const auto& plane : planes) {
+                if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius)
+                    return false;
+            }
+            return true;
+        }
+    };
+}
@@ -40,9 +40,14 @@ namespace se
         const glm::mat4 &getProjection() const { return projectionMatrix; }
         const glm::mat4 &getView() const { return viewMatrix; }
         const TransformComponent& getTransform() const { return transform; }
+        // Clip planes of the last set*Projection call
+        float getNear() const { return nearPlane; }
+        float getFar() const { return farPlane; }
 
     private:
         glm::mat4 projectionMatrix{1.f};
+        float nearPlane = 0.1f;
+        float farPlane = 100.f;
         glm::mat4 viewMatrix{1.f};
         TransformComponent transform;
     };
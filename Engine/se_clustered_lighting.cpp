@@ -0,0 +1,271 @@
+#include "se_clustered_lighting.hpp"
+#include "se_pipeline.hpp"
+#include "se_swap_chain.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace se
+{
+    static_assert(sizeof(Light) == 64, "clusterLights.comp and pbrFrag.frag read lights as 64 byte std430 structs");
+
+    ClusteredLighting::ClusteredLighting(SEDevice& device) : seDevice{ device }
+    {
+        createDescriptorSetLayout();
+        createPipelineLayout();
+        createFrameResources();
+    }
+
+    ClusteredLighting::~ClusteredLighting()
+    {
+        for (auto& frame : frames)
+        {
+            destroyBuffer(frame.lights);
+            destroyBuffer(frame.lightCounts);
+            destroyBuffer(frame.lightIndices);
+        }
+
+        vkDestroyPipeline(seDevice.device(), pipeline, nullptr);
+        vkDestroyPipelineLayout(seDevice.device(), pipelineLayout, nullptr);
+        vkDestroyDescriptorSetLayout(seDevice.device(), descriptorSetLayout, nullptr);
+    }
+
+    ClusterParams ClusteredLighting::makeParams(const SECamera& camera, VkExtent2D extent, uint32_t lightCount, bool clustered)
+    {
+        const float near = camera.getNear();
+        const float far = camera.getFar();
+        const float logDepthRange = std::log(far / near);
+
+        ClusterParams params{};
+        params.view = camera.getView();
+        params.inverseProjection = glm::inverse(camera.getProjection());
+        params.gridSize = glm::uvec4(GRID_X, GRID_Y, GRID_Z, clustered ? 1u : 0u);
+        params.screen = glm::vec4(
+            static_cast<float>(extent.width),
+            static_cast<float>(extent.height),
+            std::ceil(static_cast<float>(extent.width) / GRID_X),
+            std::ceil(static_cast<float>(extent.height) / GRID_Y));
+        // slice = log(depth / near) / log(far / near) * GRID_Z
+        params.depth = glm::vec4(near, far, GRID_Z / logDepthRange, -GRID_Z * std::log(near) / logDepthRange);
+        params.lights = glm::uvec4(lightCount, MAX_LIGHTS_PER_CLUSTER, 0, 0);
+        return params;
+    }
+
+    void ClusteredLighting::createDescriptorSetLayout()
+    {
+        // 0 cluster params, 1 lights, 2 light counts, 3 light indices
+        std::array<VkDescriptorSetLayoutBinding, 4> bindings{};
+        for (uint32_t i = 0; i < bindings.size(); i++)
+        {
+            bindings[i].binding = i;
+            bindings[i].descriptorCount = 1;
+            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+
+        if (vkCreateDescriptorSetLayout(seDevice.device(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create cluster descriptor set layout!");
+        }
+    }
+
+    void ClusteredLighting::createPipelineLayout()
+    {
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+
+        if (vkCreatePipelineLayout(seDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create cluster pipeline layout!");
+        }
+    }
+
+    void ClusteredLighting::createPipeline()
+    {
+        auto code = SEPipeline::readFile("shaders/clusterLights.spv");
+
+        VkShaderModuleCreateInfo moduleInfo{};
+        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = code.size();
+        moduleInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+        VkShaderModule shaderModule;
+        if (vkCreateShaderModule(seDevice.device(), &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create cluster shader module!");
+        }
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = shaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+
+        VkResult result = vkCreateComputePipelines(seDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+        vkDestroyShaderModule(seDevice.device(), shaderModule, nullptr);
+
+        if (result != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create cluster pipeline!");
+        }
+    }
+
+    void ClusteredLighting::createFrameResources()
+    {
+        frames.resize(SESwapChain::MAX_FRAMES_IN_FLIGHT);
+
+        for (auto& frame : frames)
+        {
+            seDevice.createBuffer(
+                sizeof(Light) * MAX_LIGHTS,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                frame.lights.buffer,
+                frame.lights.allocation);
+            frame.lights.mapped = frame.lights.allocation.mapped;
+
+            createBuffer(frame.lightCounts, sizeof(uint32_t) * CLUSTER_COUNT);
+            createBuffer(frame.lightIndices, sizeof(uint32_t) * CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER);
+
+            VkDescriptorSetAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            allocInfo.descriptorPool = seDevice.getDescriptorPool();
+            allocInfo.descriptorSetCount = 1;
+            allocInfo.pSetLayouts = &descriptorSetLayout;
+
+            if (vkAllocateDescriptorSets(seDevice.device(), &allocInfo, &frame.descriptorSet) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate cluster descriptor sets!");
+            }
+
+            // None of these buffers ever move, so the set is written once
+            std::array<VkDescriptorBufferInfo, 4> bufferInfos{};
+            bufferInfos[0] = { seDevice.getFrameAllocator().getBuffer(), 0, sizeof(ClusterParams) };
+            bufferInfos[1] = { frame.lights.buffer, 0, VK_WHOLE_SIZE };
+            bufferInfos[2] = { frame.lightCounts.buffer, 0, VK_WHOLE_SIZE };
+            bufferInfos[3] = { frame.lightIndices.buffer, 0, VK_WHOLE_SIZE };
+
+            const std::array<VkDescriptorType, 4> types = {
+                VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                VK_DESCRIPTOR_TYPE_STORAGE_BUFFER };
+
+            std::array<VkWriteDescriptorSet, 4> descriptorWrites{};
+            for (uint32_t i = 0; i < descriptorWrites.size(); i++)
+            {
+                descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                descriptorWrites[i].dstSet = frame.descriptorSet;
+                descriptorWrites[i].dstBinding = i;
+                descriptorWrites[i].descriptorType = types[i];
+                descriptorWrites[i].descriptorCount = 1;
+                descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+            }
+
+            vkUpdateDescriptorSets(seDevice.device(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+        }
+    }
+
+    void ClusteredLighting::createBuffer(Buffer& buffer, VkDeviceSize size)
+    {
+        // Only ever touched by the GPU
+        seDevice.createBuffer(
+            size,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            buffer.buffer,
+            buffer.allocation);
+        buffer.mapped = nullptr;
+    }
+
+    void ClusteredLighting::destroyBuffer(Buffer& buffer)
+    {
+        if (buffer.buffer == VK_NULL_HANDLE)
+            return;
+
+        seDevice.destroyBuffer(buffer.buffer, buffer.allocation);
+        buffer = Buffer{};
+    }
+
+    void ClusteredLighting::markLightsDirty(const std::vector<LightRange>& ranges)
+    {
+        for (auto& frame : frames)
+        {
+            frame.pendingLights.insert(frame.pendingLights.end(), ranges.begin(), ranges.end());
+
+            // A frame that keeps missing out collects ranges, past a point one copy of the hull is cheaper
+            if (frame.pendingLights.size() > MAX_PENDING_RANGES)
+            {
+                LightRange merged = frame.pendingLights.front();
+                for (const LightRange& range : frame.pendingLights)
+                {
+                    merged.begin = std::min(merged.begin, range.begin);
+                    merged.end = std::max(merged.end, range.end);
+                }
+                frame.pendingLights.assign(1, merged);
+            }
+        }
+    }
+
+    void ClusteredLighting::markAllLightsDirty()
+    {
+        for (auto& frame : frames)
+            frame.pendingLights.assign(1, LightRange{ 0, MAX_LIGHTS });
+    }
+
+    uint32_t ClusteredLighting::uploadLights(int frameIndex, const std::vector<Light>& lights)
+    {
+        FrameResources& frame = frames[frameIndex];
+        const uint32_t count = static_cast<uint32_t>(std::min<size_t>(lights.size(), MAX_LIGHTS));
+        auto* mapped = static_cast<Light*>(frame.lights.mapped);
+
+        uint32_t written = 0;
+        for (const LightRange& range : frame.pendingLights)
+        {
+            // Ranges past the end belong to lights removed since, the light count hides them
+            const uint32_t end = std::min(range.end, count);
+            if (range.begin >= end)
+                continue;
+            std::memcpy(mapped + range.begin, lights.data() + range.begin, sizeof(Light) * (end - range.begin));
+            written += end - range.begin;
+        }
+        frame.pendingLights.clear();
+        return written;
+    }
+
+    void ClusteredLighting::dispatch(VkCommandBuffer commandBuffer, int frameIndex, uint32_t paramsOffset)
+    {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &frames[frameIndex].descriptorSet, 1, &paramsOffset);
+        vkCmdDispatch(commandBuffer, (CLUSTER_COUNT + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr);
+    }
+}
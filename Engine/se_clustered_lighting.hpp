@@ -0,0 +1,97 @@
+#pragma once
+
+#include "se_device.hpp"
+#include "se_camera.hpp"
+#include "se_scene.hpp"
+
+// std
+#include <vector>
+
+namespace se
+{
+    // Capacity of each frame's light buffer, further lights are not shaded
+    constexpr uint32_t MAX_LIGHTS = 8192;
+
+    // Matches the CLUSTERS block of clusterLights.comp and pbrFrag.frag
+    struct ClusterParams
+    {
+        glm::mat4 view;
+        glm::mat4 inverseProjection;
+        glm::uvec4 gridSize;    // xyz clusters, w 1 when the fragment shader reads the clusters
+        glm::vec4 screen;       // xy framebuffer size, zw tile size, in pixels
+        glm::vec4 depth;        // x near, y far, zw scale and bias turning log(view depth) into a slice
+        glm::uvec4 lights;      // x light count, y max lights per cluster
+    };
+
+    // Clustered forward light culling. The view frustum is cut into a froxel grid, GRID_X by GRID_Y tiles on screen
+    // and GRID_Z exponential slices in depth. Every frame a compute pass tests each light's bounding sphere against
+    // each cluster and writes the indices of the lights reaching it, pbrFrag then only shades its own cluster's lights.
+    // Directional lights reach every cluster.
+    // It also owns the per frame light buffers both passes read, which mirror the scene's packed lights.
+    class ClusteredLighting
+    {
+    public:
+        static constexpr uint32_t GRID_X = 16;
+        static constexpr uint32_t GRID_Y = 9;
+        static constexpr uint32_t GRID_Z = 24;
+        static constexpr uint32_t CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+        // Further lights touching a full cluster are dropped from it
+        static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 128;
+
+        // Buffers and layouts only, the compute pipeline comes from createPipeline
+        ClusteredLighting(SEDevice& device);
+        ~ClusteredLighting();
+
+        ClusteredLighting(const ClusteredLighting&) = delete;
+        ClusteredLighting& operator=(const ClusteredLighting&) = delete;
+
+        // Throws when the compute shader is missing, dispatch needs it
+        void createPipeline();
+        bool hasPipeline() const { return pipeline != VK_NULL_HANDLE; }
+
+        static ClusterParams makeParams(const SECamera& camera, VkExtent2D extent, uint32_t lightCount, bool clustered);
+
+        // Packed light ranges every frame's buffer has to rewrite before it is next used
+        void markLightsDirty(const std::vector<LightRange>& ranges);
+        void markAllLightsDirty();
+        // Copies this frame's pending ranges out of the packed lights, returns how many lights were written.
+        // The frame's fence has been waited on, so its buffer is free to write.
+        uint32_t uploadLights(int frameIndex, const std::vector<Light>& lights);
+
+        // Bins the frame's lights, paramsOffset points into the device's frame allocator. Records the barrier
+        // in front of the fragment shader reads too, so it has to go outside a render pass.
+        void dispatch(VkCommandBuffer commandBuffer, int frameIndex, uint32_t paramsOffset);
+
+        VkBuffer getLightBuffer(int frameIndex) const { return frames[frameIndex].lights.buffer; }
+        // Light count by cluster, and MAX_LIGHTS_PER_CLUSTER light indices by cluster
+        VkBuffer getLightCountBuffer(int frameIndex) const { return frames[frameIndex].lightCounts.buffer; }
+        VkBuffer getLightIndexBuffer(int frameIndex) const { return frames[frameIndex].lightIndices.buffer; }
+
+    private:
+        struct FrameResources {
+            // Host visible and persistently mapped
+            Buffer lights{};
+            std::vector<LightRange> pendingLights;
+            Buffer lightCounts{};
+            Buffer lightIndices{};
+            VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        };
+
+        static constexpr uint32_t WORKGROUP_SIZE = 64;
+        static constexpr size_t MAX_PENDING_RANGES = 32;
+
+        void createDescriptorSetLayout();
+        void createPipelineLayout();
+        void createFrameResources();
+
+        void createBuffer(Buffer& buffer, VkDeviceSize size);
+        void destroyBuffer(Buffer& buffer);
+
+        SEDevice& seDevice;
+        VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        VkPipeline pipeline = VK_NULL_HANDLE;
+
+        std::vector<FrameResources> frames;
+    };
+}
@@ -66,6 +66,7 @@ namespace se
 		PipelineConfigInfo pipelineConfig{};
 		SEPipeline::defaultPipelineConfigInfo(pipelineConfig);
 		pipelineConfig.renderPass = renderPass;
+		pipelineConfig.subpass = SESwapChain::OVERLAY_SUBPASS;
 		pipelineConfig.pipelineLayout = pipelineLayout;
 		pipelineConfig.depthStencilInfo = depthStencil;
 		sePipeline = std::make_unique<SEPipeline>(
@@ -96,9 +97,8 @@ namespace se
 		// glm::mat4 view;
 		// glm::mat4 proj;
 		// glm::vec3 cameraPos;
-		std::vector<VkBuffer> uniformBuffers = seDevice.getUniformBuffers();
 		VkDescriptorBufferInfo bufferInfo{};
-		bufferInfo.buffer = uniformBuffers[0];
+		bufferInfo.buffer = seDevice.getFrameAllocator().getBuffer();
 		bufferInfo.offset = 0;
 		bufferInfo.range = sizeof(UniformBufferObject);
 
@@ -114,7 +114,7 @@ namespace se
 		descriptorWrites[0].dstSet = descriptorSet;
 		descriptorWrites[0].dstBinding = 0;
 		descriptorWrites[0].dstArrayElement = 0;
-		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		descriptorWrites[0].descriptorCount = 1;
 		descriptorWrites[0].pBufferInfo = &bufferInfo;
 
@@ -139,7 +139,7 @@ namespace se
 		VkDescriptorSetLayoutBinding uboLayoutBinding{};
 		uboLayoutBinding.binding = 0;
 		uboLayoutBinding.descriptorCount = 1;
-		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		uboLayoutBinding.pImmutableSamplers = nullptr;
 		uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 		bindings.push_back(uboLayoutBinding);
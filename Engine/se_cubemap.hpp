@@ -57,6 +57,7 @@ namespace se
 		{
 			sePipeline->bind(commandBuffer);
 
+			uint32_t cameraOffset = seDevice.getCameraUniformOffset();
 			vkCmdBindDescriptorSets(
 				commandBuffer,
 				VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -64,8 +65,8 @@ namespace se
 				0,
 				1,
 				&descriptorSet,
-				0,
-				nullptr);
+				1,
+				&cameraOffset);
 		}
 
 		void draw(VkCommandBuffer commandBuffer);
@@ -61,9 +61,8 @@ namespace se
 		// glm::mat4 view;
 		// glm::mat4 proj;
 		// glm::vec3 cameraPos;
-		std::vector<VkBuffer> uniformBuffers = seDevice.getUniformBuffers();
 		VkDescriptorBufferInfo bufferInfo{};
-		bufferInfo.buffer = uniformBuffers[0];
+		bufferInfo.buffer = seDevice.getFrameAllocator().getBuffer();
 		bufferInfo.offset = 0;
 		bufferInfo.range = sizeof(UniformBufferObject);
 
@@ -72,7 +71,7 @@ namespace se
 		descriptorWrites[0].dstSet = descriptorSet;
 		descriptorWrites[0].dstBinding = 0;
 		descriptorWrites[0].dstArrayElement = 0;
-		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		descriptorWrites[0].descriptorCount = 1;
 		descriptorWrites[0].pBufferInfo = &bufferInfo;
 
@@ -88,7 +87,7 @@ namespace se
 		VkDescriptorSetLayoutBinding uboLayoutBinding{};
 		uboLayoutBinding.binding = 0;
 		uboLayoutBinding.descriptorCount = 1;
-		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		uboLayoutBinding.pImmutableSamplers = nullptr;
 		uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 		bindings.push_back(uboLayoutBinding);
@@ -162,19 +161,19 @@ namespace se
 		createBRDFImage();
 
 		se::SECamera camera{};
-		auto viewerObject = se::SEGameObject::createGameObject();
+		se::TransformComponent viewerTransform{};
 		
 		float aspect = 1.0f; // Square images for cubemap faces
 		camera.setPerspectiveProjection(glm::radians(90.f), aspect, 0.01f, 1000.f);
 
-		camera.setViewDirection(viewerObject.getTransform().translation, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}); // Front
+		camera.setViewDirection(viewerTransform.translation, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}); // Front
 
 		UniformBufferObject ubo{};
 		ubo.proj = camera.getProjection();
 		ubo.view = camera.getView();
-		ubo.cameraPos = viewerObject.getTransform().translation;
+		ubo.cameraPos = viewerTransform.translation;
 
-		seDevice.updateUniformBuffers(ubo);
+		seDevice.updateCameraUniform(ubo);
 		if (auto commandBuffer = seRenderer.beginOffscreenFrame())
 		{
 			seRenderer.beginOffscreenRenderPass(commandBuffer);
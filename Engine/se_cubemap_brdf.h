@@ -19,7 +19,7 @@ namespace se
 		VkSampler getSampler() { return BRDFSampler; }
 		VkImage getImage() { return BRDFImage; }
 		VkImageView getImageView() { return BRDFImageView; }
-		VkDeviceMemory getImageMemory() { return BRDFImageMemory; }
+		const DeviceAllocation& getImageMemory() const { return BRDFImageMemory; }
 
 		void generate();
 
@@ -37,6 +37,7 @@ namespace se
 		{
 			sePipeline->bind(commandBuffer);
 
+			uint32_t cameraOffset = seDevice.getCameraUniformOffset();
 			vkCmdBindDescriptorSets(
 				commandBuffer,
 				VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -44,8 +45,8 @@ namespace se
 				0,
 				1,
 				&descriptorSet,
-				0,
-				nullptr);
+				1,
+				&cameraOffset);
 		}
 		void draw(VkCommandBuffer commandBuffer);
 
@@ -64,7 +65,7 @@ namespace se
 
 		VkImage BRDFImage;
 		VkImageView BRDFImageView;
-		VkDeviceMemory BRDFImageMemory;
+		DeviceAllocation BRDFImageMemory;
 		VkSampler BRDFSampler;
 
 		std::unique_ptr<se::SESubMesh> cubeMesh;
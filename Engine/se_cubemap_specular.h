@@ -19,7 +19,7 @@ namespace se
 		VkSampler getSampler() { return irradianceSampler; }
 		VkImage getImage() { return irradianceImage; }
 		VkImageView getImageView() { return irradianceImageView; }
-		VkDeviceMemory getImageMemory() { return irradianceImageMemory; }
+		const DeviceAllocation& getImageMemory() const { return irradianceImageMemory; }
 
 		void convert();
 
@@ -37,6 +37,7 @@ namespace se
 		{
 			sePipeline->bind(commandBuffer);
 
+			uint32_t cameraOffset = seDevice.getCameraUniformOffset();
 			vkCmdBindDescriptorSets(
 				commandBuffer,
 				VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -44,8 +45,8 @@ namespace se
 				0,
 				1,
 				&descriptorSet,
-				0,
-				nullptr);
+				1,
+				&cameraOffset);
 		}
 		void draw(VkCommandBuffer commandBuffer);
 
@@ -64,7 +65,7 @@ namespace se
 
 		VkImage irradianceImage;
 		VkImageView irradianceImageView;
-		VkDeviceMemory irradianceImageMemory;
+		DeviceAllocation irradianceImageMemory;
 		VkSampler irradianceSampler;
 
 		VkImageView cubeMapImageView;
@@ -34,9 +34,12 @@ namespace se
         createSurface(instance, &surface_);
         pickPhysicalDevice();
         createLogicalDevice();
+        createMemoryAllocator();
         createCommandPool();
+        createUploadManager();
         createDescriptorPool();
-        createUniformBuffers();
+        createFrameAllocator();
+        createGeometryArena();
 
         VkDescriptorSetLayoutBinding binding{};
         binding.binding = 0;
@@ -69,7 +72,7 @@ namespace se
         appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
         appInfo.pEngineName = "Shark Engine";
         appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        appInfo.apiVersion = VK_API_VERSION_1_0;
+        appInfo.apiVersion = VK_API_VERSION_1_2;
 
         VkInstanceCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -124,11 +127,17 @@ namespace se
 
     void SEDevice::createDescriptorPool()
     {
-        std::array<VkDescriptorPoolSize, 2> poolSizes{};
+        std::array<VkDescriptorPoolSize, 5> poolSizes{};
         poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         poolSizes[0].descriptorCount = static_cast<uint32_t>(5000);
         poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         poolSizes[1].descriptorCount = static_cast<uint32_t>(5000);
+        poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSizes[2].descriptorCount = static_cast<uint32_t>(100);
+        poolSizes[3].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        poolSizes[3].descriptorCount = static_cast<uint32_t>(5000);
+        poolSizes[4].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        poolSizes[4].descriptorCount = static_cast<uint32_t>(100);
 
         VkDescriptorPoolCreateInfo poolInfo{};
         poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -144,31 +153,42 @@ namespace se
         }
     }
 
-    void SEDevice::createUniformBuffers()
+    void SEDevice::createMemoryAllocator()
     {
-        VkDeviceSize bufferSize = sizeof(UniformBufferObject);
-
-        uniformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
-        uniformBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
-        uniformBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
+        memoryAllocator = std::make_unique<MemoryAllocator>(device_, physicalDevice);
+    }
 
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    void SEDevice::createUploadManager()
+    {
+        QueueFamilyIndices indices = findPhysicalQueueFamilies();
+        if (indices.transferFamily.has_value())
         {
-            createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uniformBuffers[i], uniformBuffersMemory[i]);
-
-            vkMapMemory(device_, uniformBuffersMemory[i], 0, bufferSize, 0, &uniformBuffersMapped[i]);
+            uploadManager = std::make_unique<UploadManager>(
+                *this, transferQueue_, indices.transferFamily.value(), indices.graphicsFamily.value(), timelineSemaphores);
+        }
+        else
+        {
+            uploadManager = std::make_unique<UploadManager>(
+                *this, graphicsQueue_, indices.graphicsFamily.value(), indices.graphicsFamily.value(), timelineSemaphores);
         }
     }
 
-    void SEDevice::updateUniformBuffers(UniformBufferObject bufferObject)
+    void SEDevice::createFrameAllocator()
     {
-        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
-        {
-            memcpy(uniformBuffersMapped[i], &bufferObject, sizeof(bufferObject));
-        }
+        frameAllocator = std::make_unique<FrameAllocator>(*this, MAX_FRAMES_IN_FLIGHT, FRAME_ALLOCATOR_SLICE_SIZE);
     }
 
-    void SEDevice::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, VkDeviceMemory &bufferMemory)
+    void SEDevice::createGeometryArena()
+    {
+        geometryArena = std::make_unique<GeometryArena>(*this, GEOMETRY_VERTEX_CAPACITY, GEOMETRY_INDEX_CAPACITY);
+    }
+
+    void SEDevice::updateCameraUniform(const UniformBufferObject& bufferObject)
+    {
+        cameraUniformOffset = frameAllocator->upload(bufferObject);
+    }
+
+    void SEDevice::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, DeviceAllocation &bufferMemory, MemoryAllocator::Strategy strategy)
     {
         // Describe the buffer
         VkBufferCreateInfo bufferInfo{};
@@ -187,25 +207,23 @@ namespace se
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-        // Set up memory allocation info
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-        // Allocate memory for the buffer
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
-        {
-            throw std::runtime_error("Failed to allocate buffer memory!");
-        }
+        // Sub-allocate memory for the buffer
+        bufferMemory = memoryAllocator->allocate(memRequirements, properties, MemoryAllocator::ResourceType::Buffer, strategy);
 
         // Bind the memory to the buffer
-        if (vkBindBufferMemory(device_, buffer, bufferMemory, 0) != VK_SUCCESS)
+        if (vkBindBufferMemory(device_, buffer, bufferMemory.memory, bufferMemory.offset) != VK_SUCCESS)
         {
             throw std::runtime_error("Failed to bind buffer memory!");
         }
     }
 
+    void SEDevice::destroyBuffer(VkBuffer &buffer, DeviceAllocation &bufferMemory)
+    {
+        vkDestroyBuffer(device_, buffer, nullptr);
+        memoryAllocator->free(bufferMemory);
+        buffer = VK_NULL_HANDLE;
+    }
+
     void SEDevice::createSurface(VkInstance instance, VkSurfaceKHR *surface)
     {
         window.createWindowSurface(instance, surface);
@@ -229,6 +247,7 @@ namespace se
             if (isDeviceSuitable(device))
             {
                 physicalDevice = device;
+                vkGetPhysicalDeviceProperties(physicalDevice, &properties);
                 msaaSamples = getMaxUsableSampleCount();
                 break;
             }
@@ -246,6 +265,10 @@ namespace se
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
         std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+        if (indices.transferFamily.has_value())
+        {
+            uniqueQueueFamilies.insert(indices.transferFamily.value());
+        }
 
         float queuePriority = 1.0f;
         for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -258,19 +281,62 @@ namespace se
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
         VkPhysicalDeviceFeatures deviceFeatures{};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        // Indirect draws starting at a non zero instance, used by the GPU driven path
+        deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+        indirectFirstInstance = supportedFeatures.drawIndirectFirstInstance == VK_TRUE;
+        deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+        multiDrawIndirect = supportedFeatures.multiDrawIndirect == VK_TRUE;
+
+        // Indirect count draws are core in 1.2, older drivers may still have the KHR extension
+        std::vector<const char *> enabledExtensions(deviceExtensions.begin(), deviceExtensions.end());
+        VkPhysicalDeviceProperties deviceProperties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+
+        VkPhysicalDeviceVulkan12Features vulkan12Features{};
+        vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_12_FEATURES;
+        bool coreDrawIndirectCount = false;
+        bool extensionDrawIndirectCount = false;
+
+        if (deviceProperties.apiVersion >= VK_API_VERSION_1_2)
+        {
+            VkPhysicalDeviceFeatures2 features2{};
+            features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features2.pNext = &vulkan12Features;
+            vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+
+            coreDrawIndirectCount = vulkan12Features.drawIndirectCount == VK_TRUE;
+            // Upload completion is tracked with a timeline semaphore, without one every upload batch waits
+            timelineSemaphores = vulkan12Features.timelineSemaphore == VK_TRUE;
+            vulkan12Features = {};
+            vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_12_FEATURES;
+            vulkan12Features.drawIndirectCount = coreDrawIndirectCount ? VK_TRUE : VK_FALSE;
+            vulkan12Features.timelineSemaphore = timelineSemaphores ? VK_TRUE : VK_FALSE;
+        }
+        if (!coreDrawIndirectCount && hasDeviceExtension(physicalDevice, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME))
+        {
+            enabledExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+            extensionDrawIndirectCount = true;
+        }
 
         VkDeviceCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        if (coreDrawIndirectCount || timelineSemaphores)
+        {
+            createInfo.pNext = &vulkan12Features;
+        }
 
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
         createInfo.pEnabledFeatures = &deviceFeatures;
 
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         if (enableValidationLayers)
         {
@@ -289,6 +355,21 @@ namespace se
 
         vkGetDeviceQueue(device_, indices.graphicsFamily.value(), 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily.value(), 0, &presentQueue_);
+        if (indices.transferFamily.has_value())
+        {
+            vkGetDeviceQueue(device_, indices.transferFamily.value(), 0, &transferQueue_);
+        }
+
+        if (coreDrawIndirectCount)
+        {
+            drawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCount>(
+                vkGetDeviceProcAddr(device_, "vkCmdDrawIndexedIndirectCount"));
+        }
+        else if (extensionDrawIndirectCount)
+        {
+            drawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCount>(
+                vkGetDeviceProcAddr(device_, "vkCmdDrawIndexedIndirectCountKHR"));
+        }
     }
 
     SwapChainSupportDetails SEDevice::querySwapChainSupport(VkPhysicalDevice device)
@@ -355,6 +436,22 @@ namespace se
         return requiredExtensions.empty();
     }
 
+    bool SEDevice::hasDeviceExtension(VkPhysicalDevice device, const char *extensionName)
+    {
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+        for (const auto &extension : availableExtensions)
+        {
+            if (strcmp(extension.extensionName, extensionName) == 0)
+                return true;
+        }
+        return false;
+    }
+
     QueueFamilyIndices SEDevice::findQueueFamilies(VkPhysicalDevice device)
     {
         QueueFamilyIndices indices;
@@ -389,6 +486,25 @@ namespace se
             i++;
         }
 
+        // Prefer the DMA only family, then any copy family that does not draw
+        for (uint32_t family = 0; family < queueFamilyCount; family++)
+        {
+            VkQueueFlags flags = queueFamilies[family].queueFlags;
+            if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+            {
+                indices.transferFamily = family;
+                break;
+            }
+        }
+        for (uint32_t family = 0; family < queueFamilyCount && !indices.transferFamily.has_value(); family++)
+        {
+            VkQueueFlags flags = queueFamilies[family].queueFlags;
+            if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT))
+            {
+                indices.transferFamily = family;
+            }
+        }
+
         return indices;
     }
 
@@ -498,6 +614,9 @@ namespace se
 
     VkCommandBuffer SEDevice::beginSingleTimeCommands()
     {
+        // Whatever is recorded next may read earlier uploads, so they finish first
+        uploadManager->waitIdle();
+
         VkCommandBufferAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
@@ -512,6 +631,7 @@ namespace se
         beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
         vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        uploadManager->recordAcquires(commandBuffer);
 
         return commandBuffer;
     }
@@ -525,6 +645,21 @@ namespace se
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &commandBuffer;
 
+        VkSemaphore uploadSemaphore = uploadManager->getSemaphore();
+        uint64_t uploadValue = uploadManager->getReadyValue();
+        VkPipelineStageFlags uploadStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        if (uploadSemaphore != VK_NULL_HANDLE)
+        {
+            timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            timelineInfo.waitSemaphoreValueCount = 1;
+            timelineInfo.pWaitSemaphoreValues = &uploadValue;
+            submitInfo.pNext = &timelineInfo;
+            submitInfo.waitSemaphoreCount = 1;
+            submitInfo.pWaitSemaphores = &uploadSemaphore;
+            submitInfo.pWaitDstStageMask = &uploadStage;
+        }
+
         vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
         vkQueueWaitIdle(graphicsQueue_);
 
@@ -565,7 +700,7 @@ namespace se
         endSingleTimeCommands(commandBuffer);
     }
 
-    void SEDevice::createImageWithInfo(const VkImageCreateInfo &imageInfo, VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &imageMemory)
+    void SEDevice::createImageWithInfo(const VkImageCreateInfo &imageInfo, VkMemoryPropertyFlags properties, VkImage &image, DeviceAllocation &imageMemory)
     {
         if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS)
         {
@@ -575,22 +710,24 @@ namespace se
         VkMemoryRequirements memRequirements;
         vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        MemoryAllocator::ResourceType resourceType = imageInfo.tiling == VK_IMAGE_TILING_OPTIMAL
+            ? MemoryAllocator::ResourceType::OptimalImage
+            : MemoryAllocator::ResourceType::LinearImage;
+        imageMemory = memoryAllocator->allocate(memRequirements, properties, resourceType);
 
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
-        {
-            throw std::runtime_error("failed to allocate image memory!");
-        }
-
-        if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS)
+        if (vkBindImageMemory(device_, image, imageMemory.memory, imageMemory.offset) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to bind image memory!");
         }
     }
 
+    void SEDevice::destroyImage(VkImage &image, DeviceAllocation &imageMemory)
+    {
+        vkDestroyImage(device_, image, nullptr);
+        memoryAllocator->free(imageMemory);
+        image = VK_NULL_HANDLE;
+    }
+
     uint32_t SEDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
     {
         VkPhysicalDeviceMemoryProperties memProperties;
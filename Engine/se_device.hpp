@@ -1,12 +1,17 @@
 #pragma once
 
 #include "se_window.hpp"
+#include "se_frame_allocator.hpp"
+#include "se_geometry_arena.hpp"
+#include "se_memory_allocator.hpp"
+#include "se_upload_manager.hpp"
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
 #include <string.h>
 #include <vector>
+#include <memory>
 #include <optional>
 #include <stdexcept>
 #include <set>
@@ -38,6 +43,8 @@ struct QueueFamilyIndices
 {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    // A family that copies but does not draw, empty when the GPU only has graphics families
+    std::optional<uint32_t> transferFamily;
 
     bool isComplete()
     {
@@ -61,6 +68,13 @@ namespace se
         std::vector<VkPresentModeKHR> presentModes;
     };
 
+    // Host visible buffer that stays mapped for its whole life
+    struct Buffer {
+        VkBuffer buffer;
+        DeviceAllocation allocation;
+        void* mapped;
+    };
+
     class SEDevice
     {
     public:
@@ -75,7 +89,6 @@ namespace se
         
         VkCommandPool getCommandPool() { return commandPool; }
         VkDescriptorPool getDescriptorPool() { return descriptorPool; }
-        std::vector<VkBuffer> getUniformBuffers() { return uniformBuffers; }
         VkDevice device() { return device_; }
         VkPhysicalDevice physicaldevice() { return physicalDevice; }
         VkSurfaceKHR surface() { return surface_; }
@@ -83,9 +96,27 @@ namespace se
         VkQueue graphicsQueue() { return graphicsQueue_; }
         VkQueue presentQueue() { return presentQueue_; }
 
+        // Optional features, enabled at device creation when the GPU has them
+        bool supportsIndirectFirstInstance() const { return indirectFirstInstance; }
+        // More than one draw per vkCmdDrawIndexedIndirect
+        bool supportsMultiDrawIndirect() const { return multiDrawIndirect; }
+        // vkCmdDrawIndexedIndirectCount from Vulkan 1.2 or VK_KHR_draw_indirect_count, null when neither is available
+        PFN_vkCmdDrawIndexedIndirectCount getDrawIndexedIndirectCount() const { return drawIndexedIndirectCount; }
+
 		VkDescriptorSetLayout getImGuiDescriptorSetLayout() { return imGuiDescriptorSetLayout; }
 
-        void updateUniformBuffers(UniformBufferObject bufferObject);
+        // Backs every buffer and image the engine creates
+        MemoryAllocator& getMemoryAllocator() { return *memoryAllocator; }
+        // Asynchronous buffer and image uploads, see UploadManager
+        UploadManager& getUploadManager() { return *uploadManager; }
+        // Transient per frame uniform and storage data, rewound by the renderer when a frame begins
+        FrameAllocator& getFrameAllocator() { return *frameAllocator; }
+        // Vertex and index buffers shared by every submesh
+        GeometryArena& getGeometryArena() { return *geometryArena; }
+        // Writes the camera block into the current frame's slice. Bound with getCameraUniformOffset() as the
+        // dynamic offset by everything that reads the camera, so call it before recording those draws.
+        void updateCameraUniform(const UniformBufferObject& bufferObject);
+        uint32_t getCameraUniformOffset() const { return cameraUniformOffset; }
 
         SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -93,13 +124,17 @@ namespace se
         VkFormat findSupportedFormat(
             const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
         VkFormat findDepthFormat();
-        // Buffer Helper Functions
+        // Buffer Helper Functions. Memory comes from the memory allocator, host visible allocations are already mapped.
+        // Staging buffers that are freed right after their copy pass MemoryAllocator::Strategy::Linear.
         void createBuffer(
             VkDeviceSize size,
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer &buffer,
-            VkDeviceMemory &bufferMemory);
+            DeviceAllocation &bufferMemory,
+            MemoryAllocator::Strategy strategy = MemoryAllocator::Strategy::TLSF);
+        // Destroys the buffer and frees its memory, both are reset
+        void destroyBuffer(VkBuffer &buffer, DeviceAllocation &bufferMemory);
         VkCommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
         void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -110,7 +145,8 @@ namespace se
             const VkImageCreateInfo &imageInfo,
             VkMemoryPropertyFlags properties,
             VkImage &image,
-            VkDeviceMemory &imageMemory);
+            DeviceAllocation &imageMemory);
+        void destroyImage(VkImage &image, DeviceAllocation &imageMemory);
 
         VkPhysicalDeviceProperties properties;
 
@@ -128,14 +164,29 @@ namespace se
         VkQueue graphicsQueue_;
         VkQueue presentQueue_; 
 
+        bool indirectFirstInstance = false;
+        bool multiDrawIndirect = false;
+        bool timelineSemaphores = false;
+        VkQueue transferQueue_ = VK_NULL_HANDLE;
+        PFN_vkCmdDrawIndexedIndirectCount drawIndexedIndirectCount = nullptr;
+
         VkDescriptorPool descriptorPool;
         std::vector<VkDescriptorSet> descriptorSets;
         
 		VkDescriptorSetLayout imGuiDescriptorSetLayout;
 
-        std::vector<VkBuffer> uniformBuffers;
-        std::vector<VkDeviceMemory> uniformBuffersMemory;
-        std::vector<void *> uniformBuffersMapped;
+        // Declared before the frame allocator, whose buffer it backs, so it is destroyed after it
+        std::unique_ptr<MemoryAllocator> memoryAllocator;
+
+        std::unique_ptr<UploadManager> uploadManager;
+
+        static constexpr VkDeviceSize FRAME_ALLOCATOR_SLICE_SIZE = 4 * 1024 * 1024;
+        std::unique_ptr<FrameAllocator> frameAllocator;
+        uint32_t cameraUniformOffset = 0;
+
+        static constexpr uint32_t GEOMETRY_VERTEX_CAPACITY = 256 * 1024;
+        static constexpr uint32_t GEOMETRY_INDEX_CAPACITY = 1024 * 1024;
+        std::unique_ptr<GeometryArena> geometryArena;
         
 
         VkCommandPool commandPool;
@@ -150,7 +201,10 @@ namespace se
         void createCommandPool();
         void createDescriptorPool();
 
-		void createUniformBuffers();
+		void createMemoryAllocator();
+		void createUploadManager();
+		void createFrameAllocator();
+		void createGeometryArena();
 
 		bool isDeviceSuitable(VkPhysicalDevice device);
         std::vector<const char *> getRequiredExtensions();
@@ -159,6 +213,7 @@ namespace se
         void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
 
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+        bool hasDeviceExtension(VkPhysicalDevice device, const char *extensionName);
         void hasGflwRequiredInstanceExtensions();
 		uint32_t findMemoryType(VkDevice device, uint32_t typeFilter, VkMemoryPropertyFlags properties);
 		VkSampleCountFlagBits getMaxUsableSampleCount();
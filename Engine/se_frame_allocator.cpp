@@ -0,0 +1,56 @@
+#include "se_frame_allocator.hpp"
+#include "se_device.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace se
+{
+    FrameAllocator::FrameAllocator(SEDevice& device, uint32_t frameCount, VkDeviceSize sliceSize)
+        : seDevice{ device }, frameCount{ frameCount }
+    {
+        const VkPhysicalDeviceLimits& limits = seDevice.properties.limits;
+        alignment = std::max<VkDeviceSize>({ limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment, 16 });
+        this->sliceSize = (sliceSize + alignment - 1) / alignment * alignment;
+
+        VkDeviceSize bufferSize = this->sliceSize * frameCount;
+        seDevice.createBuffer(
+            bufferSize,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            buffer,
+            memory);
+        mapped = static_cast<uint8_t*>(memory.mapped);
+    }
+
+    FrameAllocator::~FrameAllocator()
+    {
+        seDevice.destroyBuffer(buffer, memory);
+    }
+
+    void FrameAllocator::beginFrame(int frameIndex)
+    {
+        assert(frameIndex >= 0 && static_cast<uint32_t>(frameIndex) < frameCount && "Frame index out of range");
+
+        sliceBegin = sliceSize * static_cast<VkDeviceSize>(frameIndex);
+        head = sliceBegin;
+        frameNumber++;
+    }
+
+    FrameAllocator::Allocation FrameAllocator::allocate(VkDeviceSize size)
+    {
+        VkDeviceSize offset = (head + alignment - 1) / alignment * alignment;
+        if (offset + size > sliceBegin + sliceSize)
+        {
+            throw std::runtime_error("frame allocator slice exhausted!");
+        }
+        head = offset + size;
+
+        Allocation allocation;
+        allocation.data = mapped + offset;
+        allocation.offset = static_cast<uint32_t>(offset);
+        return allocation;
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "se_memory_allocator.hpp"
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <cstring>
+
+namespace se
+{
+    class SEDevice;
+
+    // Linear allocator for data that only lives for one frame, like the camera, lights and material parameters.
+    // One persistently mapped buffer is split into a slice per frame in flight, and each frame bump allocates
+    // from its own slice. Descriptors point at getBuffer() as UNIFORM_BUFFER_DYNAMIC or STORAGE_BUFFER_DYNAMIC,
+    // so they are written once and only the offsets change from frame to frame.
+    // Allocate on the main thread only, before any recording thread reads the offsets.
+    class FrameAllocator
+    {
+    public:
+        struct Allocation
+        {
+            void* data = nullptr;
+            uint32_t offset = 0;
+        };
+
+        FrameAllocator(SEDevice& device, uint32_t frameCount, VkDeviceSize sliceSize);
+        ~FrameAllocator();
+
+        FrameAllocator(const FrameAllocator&) = delete;
+        FrameAllocator& operator=(const FrameAllocator&) = delete;
+
+        // Rewinds the frame's slice. Only call once the frame's fence has been waited on, the GPU may
+        // otherwise still be reading what was written there MAX_FRAMES_IN_FLIGHT frames ago.
+        void beginFrame(int frameIndex);
+
+        // Aligned for both uniform and storage dynamic offsets, throws when the frame's slice is exhausted
+        Allocation allocate(VkDeviceSize size);
+
+        template <typename T>
+        uint32_t upload(const T& value)
+        {
+            Allocation allocation = allocate(sizeof(T));
+            std::memcpy(allocation.data, &value, sizeof(T));
+            return allocation.offset;
+        }
+
+        VkBuffer getBuffer() const { return buffer; }
+        // Counts beginFrame calls, lets callers upload something at most once per frame
+        uint64_t getFrameNumber() const { return frameNumber; }
+        VkDeviceSize getSliceSize() const { return sliceSize; }
+        VkDeviceSize getUsed() const { return head - sliceBegin; }
+
+    private:
+        SEDevice& seDevice;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        DeviceAllocation memory;
+        uint8_t* mapped = nullptr;
+
+        uint32_t frameCount;
+        VkDeviceSize sliceSize;
+        VkDeviceSize alignment = 256;
+        VkDeviceSize sliceBegin = 0;
+        VkDeviceSize head = 0;
+        uint64_t frameNumber = 0;
+    };
+}
@@ -1,3 +1,199 @@
 #include "se_gameobject.hpp"
+#include "se_scene.hpp"
+#include "se_memory.hpp"
 
 se::SEGameObject::id_t se::SEGameObject::currentId = 0;
+
+namespace se {
+
+    namespace {
+        // Never destroyed, the scene manager can release objects after this file's statics are gone
+        PoolAllocator& getGameObjectPool()
+        {
+            static PoolAllocator* pool = new PoolAllocator("SEGameObject", sizeof(SEGameObject), 256);
+            return *pool;
+        }
+    }
+
+    void* SEGameObject::operator new(size_t size)
+    {
+        return getGameObjectPool().allocate();
+    }
+
+    void SEGameObject::operator delete(void* block)
+    {
+        getGameObjectPool().deallocate(block);
+    }
+
+    uint32_t SEGameObject::dense() const
+    {
+        return scene->denseIndex(slot);
+    }
+
+    void SEGameObject::onUpdate(float dt)
+    {
+        if (auto& script = getScript()) script->onUpdate(dt);
+    }
+
+    void SEGameObject::onDestroy()
+    {
+        if (auto& script = getScript()) script->onDestroy();
+    }
+
+    const std::string& SEGameObject::getName() const
+    {
+        return scene->names[dense()];
+    }
+
+    void SEGameObject::setName(const std::string& newName)
+    {
+        scene->indexRename(dense(), newName);
+    }
+
+    std::shared_ptr<SEMesh> SEGameObject::getMesh() const
+    {
+        return scene->meshes[dense()];
+    }
+
+    void SEGameObject::setMesh(std::shared_ptr<SEMesh> newMesh)
+    {
+        uint32_t index = dense();
+        scene->meshes[index] = std::move(newMesh);
+        scene->indexComponents(index);
+        scene->markBoundsDirty(index);
+        scene->structureVersion++;
+    }
+
+    std::shared_ptr<SEMaterial> SEGameObject::getMaterial() const
+    {
+        return scene->materials[dense()];
+    }
+
+    void SEGameObject::setMaterial(std::shared_ptr<SEMaterial> newMaterial)
+    {
+        scene->materials[dense()] = std::move(newMaterial);
+        scene->structureVersion++;
+    }
+
+    const glm::mat4& SEGameObject::getTransformMat4() const
+    {
+        return scene->worldMatrices[dense()];
+    }
+
+    const TransformComponent& SEGameObject::getTransform() const
+    {
+        return scene->transforms[dense()];
+    }
+
+    TransformComponent& SEGameObject::getTransform()
+    {
+        scene->markTransformDirty(dense());
+        return scene->transforms[dense()];
+    }
+
+    void SEGameObject::setTransform(const TransformComponent newTransform)
+    {
+        scene->markTransformDirty(dense());
+        scene->transforms[dense()] = newTransform;
+    }
+
+    SEGameObject* SEGameObject::getParent() const
+    {
+        return scene->getParent(scene->getHandle(*this)).get();
+    }
+
+    void SEGameObject::setParent(SEGameObject* parent)
+    {
+        if (parent && parent->scene != scene) {
+            std::cerr << "[GameObject] Parent must belong to the same scene!\n";
+            return;
+        }
+        scene->setParent(scene->getHandle(*this), parent ? parent->scene->getHandle(*parent) : GameObjectHandle());
+    }
+
+    std::vector<SEGameObject*> SEGameObject::getChildren() const
+    {
+        std::vector<SEGameObject*> children;
+        for (auto& child : scene->getChildren(scene->getHandle(*this)))
+            children.push_back(child.get());
+        return children;
+    }
+
+    const Light& SEGameObject::getLight() const
+    {
+        return scene->lights[dense()];
+    }
+
+    Light& SEGameObject::getLight()
+    {
+        uint32_t index = dense();
+        scene->markLightDirty(index);
+        return scene->lights[index];
+    }
+
+    void SEGameObject::setLight(Light newLight)
+    {
+        uint32_t index = dense();
+        scene->lights[index] = newLight;
+        scene->indexLight(index);
+    }
+
+    bool SEGameObject::addTag(const std::string& tag)
+    {
+        return scene->addTag(scene->getHandle(*this), tag);
+    }
+
+    void SEGameObject::removeTag(const std::string& tag)
+    {
+        scene->removeTag(scene->getHandle(*this), tag);
+    }
+
+    bool SEGameObject::hasTag(const std::string& tag) const
+    {
+        return scene->hasTag(scene->getHandle(*this), tag);
+    }
+
+    std::vector<std::string> SEGameObject::getTags() const
+    {
+        return scene->getTags(scene->getHandle(*this));
+    }
+
+    bool SEGameObject::hasLight() const
+    {
+        return scene->lights[dense()].type != LightType::None;
+    }
+
+    bool SEGameObject::isStatic() const
+    {
+        return scene->staticFlags[dense()] != 0;
+    }
+
+    void SEGameObject::setStatic(bool isStatic)
+    {
+        uint32_t index = dense();
+        if (isStatic == (scene->staticFlags[index] != 0))
+            return;
+        scene->staticFlags[index] = isStatic ? 1 : 0;
+        scene->staticVersion++;
+    }
+
+    void SEGameObject::setScript(std::unique_ptr<ScriptComponent> newScript)
+    {
+        uint32_t index = dense();
+        auto& script = scene->scripts[index];
+        scene->indexScript(index, script.get(), newScript.get());
+        script = std::move(newScript);
+
+        // onCreate may create objects and grow the pools, so keep the raw pointer
+        if (auto* created = script.get()) {
+            created->setOwner(this);
+            created->onCreate();
+        }
+    }
+
+    const std::unique_ptr<ScriptComponent>& SEGameObject::getScript() const
+    {
+        return scene->scripts[dense()];
+    }
+
+}
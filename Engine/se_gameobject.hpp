@@ -31,6 +31,13 @@ namespace se
         alignas(4) float intensity;
         glm::vec3 direction; 
         alignas(4) float spotAngle;
+        // Point and spot lights fade out to nothing at this distance, lights are only binned into the clusters it reaches
+        alignas(4) float range = 10.0f;
+        // Spot and point lights get shadow atlas tiles while they last, the first directional light the cascades
+        alignas(4) uint32_t castShadows = 0;
+        // Set by the renderer on the scene's packed copy, the light's first atlas tile or 0 for the cascades, -1 unshadowed
+        alignas(4) int32_t shadowIndex = -1;
+        alignas(4) float padding = 0.0f;
     };
 
     struct TransformComponent
@@ -42,7 +49,7 @@ namespace se
         // Matrix corrsponds to Translate * Ry * Rx * Rz * Scale
         // Rotations correspond to Tait-bryan angles of Y(1), X(2), Z(3)
         // https://en.wikipedia.org/wiki/Euler_angles#Rotation_matrix
-        glm::mat4 mat4()
+        glm::mat4 mat4() const
         {
             const float c3 = glm::cos(rotation.z);
             const float s3 = glm::sin(rotation.z);
@@ -73,116 +80,88 @@ namespace se
         }
     };
 
+    class Scene;
+
+    // Thin facade over the component pools owned by a Scene. The object only knows
+    // its scene and slot, every accessor forwards to the dense arrays in the scene.
+    // References returned by the accessors are invalidated when objects are created
+    // or destroyed in the same scene.
     class SEGameObject
     {
     public:
         using id_t = unsigned int;
 
-        SEGameObject() : id{ currentId++ }, name{ std::string("GameObject_") + std::to_string(currentId) } {}
-
-        SEGameObject(const std::string& name) : id{ currentId++ }, name{ name } {}
-
-        static SEGameObject createGameObject()
-        {
-            return SEGameObject{ currentId++, std::string("GameObject_") + std::to_string(currentId) };
-        }
+        SEGameObject(const SEGameObject&) = delete;
+        SEGameObject& operator=(const SEGameObject&) = delete;
 
-
-        static SEGameObject createGameObject(const std::string& name)
-        {
-            if (name.empty())
-                return SEGameObject{ currentId++, std::string("GameObject_") + std::to_string(currentId) };
-            return SEGameObject{ currentId++, name };
-        }
+        // Facades are recycled through a pool, spawning and despawning never touches the global heap
+        static void* operator new(size_t size);
+        static void operator delete(void* block);
 
         template<typename T, typename... Args>
         void addScript(Args&&... args) {
             static_assert(std::is_base_of<ScriptComponent, T>::value, "Script must inherit from ScriptComponent");
-            script = std::make_unique<T>(std::forward<Args>(args)...);
-            script->setOwner(this);
-            script->onCreate();
-        }
-
-        void onUpdate(float dt) {
-            if (script) script->onUpdate(dt);
-        }
-
-        void onDestroy() {
-            if (script) script->onDestroy();
+            setScript(std::make_unique<T>(std::forward<Args>(args)...));
         }
 
-        //SEGameObject(const SEGameObject &) = delete;
-        //SEGameObject &operator=(const SEGameObject &) = delete;
-        //SEGameObject(SEGameObject &&) = default;
-        //SEGameObject &operator=(SEGameObject &&) = default;
+        void onUpdate(float dt);
+        void onDestroy();
 
-        id_t getId() { return id; }
-        const std::string& getName() const { return name; }
-        void setName(const std::string& newName) { name = newName; }
+        id_t getId() const { return id; }
+        const std::string& getName() const;
+        void setName(const std::string& newName);
 
-        std::shared_ptr<SEMesh> getMesh() const { return mesh; }
-        void setMesh(std::shared_ptr<SEMesh> newMesh)
-        {
-            mesh = newMesh;
-        }
+        std::shared_ptr<SEMesh> getMesh() const;
+        void setMesh(std::shared_ptr<SEMesh> newMesh);
 
-        std::shared_ptr<SEMaterial> getMaterial() const { return material; }
-        void setMaterial(std::shared_ptr<SEMaterial> newMaterial)
-        {
-            material = newMaterial;
-        }
+        std::shared_ptr<SEMaterial> getMaterial() const;
+        void setMaterial(std::shared_ptr<SEMaterial> newMaterial);
 
-        const glm::mat4& getTransformMat4() { return transform.mat4(); }
+        // World matrix as of the last Scene::updateTransforms
+        const glm::mat4& getTransformMat4() const;
 
-        const TransformComponent& getTransform() const { return transform; }
-        TransformComponent& getTransform() { return transform; }
+        const TransformComponent& getTransform() const;
+        // Mutable access marks the transform dirty
+        TransformComponent& getTransform();
+        void setTransform(const TransformComponent newTransform);
 
+        SEGameObject* getParent() const;
+        void setParent(SEGameObject* parent);
+        std::vector<SEGameObject*> getChildren() const;
 
-        void setTransform(const TransformComponent newTransform)
-        {
-            transform = newTransform;
-        }
-
-        const Light& getLight() const { return light; }
-        Light& getLight() { return light; }
+        const Light& getLight() const;
+        Light& getLight();
+        void setLight(Light newLight);
+        bool hasLight() const;
 
-		void setLight(Light newLight)
-		{
-			light = newLight;
-		}
+        // Static objects are expected to stay put, the shadow maps cache them and only redraw them when one changes
+        bool isStatic() const;
+        void setStatic(bool isStatic);
 
-        bool hasLight() const {
-            return light.type != LightType::None;
-        }
+        void setScript(std::unique_ptr<ScriptComponent> newScript);
+        // Read only so the scene's script index can't be bypassed, replace scripts through setScript
+        const std::unique_ptr<ScriptComponent>& getScript() const;
 
-		void setScript(std::unique_ptr<ScriptComponent> newScript)
-		{
-			script = std::move(newScript);
-			if (script) {
-				script->setOwner(this);
-				script->onCreate();
-			}
-		}
+        bool addTag(const std::string& tag);
+        void removeTag(const std::string& tag);
+        bool hasTag(const std::string& tag) const;
+        std::vector<std::string> getTags() const;
 
-		std::unique_ptr <ScriptComponent>& getScript() {
-			return script;
-		}
+        Scene* getScene() const { return scene; }
 
-        id_t id;
+        const id_t id;
 
     private:
-        static id_t currentId;
+        friend class Scene;
 
-        SEGameObject(id_t objId, std::string objName) : id{ objId }, name{ objName } {}
+        static id_t currentId;
 
-        
-        std::string name;
+        SEGameObject(Scene* scene, uint32_t slot) : id{ currentId++ }, scene{ scene }, slot{ slot } {}
 
-        std::shared_ptr<SEMesh> mesh{};
-        std::shared_ptr<SEMaterial> material{};
-        Light light{};
-        TransformComponent transform{};
+        uint32_t dense() const;
 
-        std::unique_ptr<ScriptComponent> script{nullptr};
+        Scene* scene;
+        // Index into the owning scene's slot table
+        uint32_t slot;
     };
 }
@@ -4,7 +4,7 @@
 namespace se {
     SEGameObject* GameObjectHandle::get() const {
         if (scene)
-            return scene->getGameObjectById(id);
+            return scene->resolve(index, generation);
         return nullptr;
     }
 
@@ -13,7 +13,7 @@ namespace se {
             std::cerr << "[GameObjectHandle] Tried to destroy object, but scene is null!\n";
             return;
         }
-        scene->destroyGameObject(id);
+        scene->destroyGameObject(*this);
     }
 
 }
@@ -1,17 +1,21 @@
 #pragma once
+#include <cstdint>
 #include <stdexcept>
 
 namespace se {
     class Scene;
     class SEGameObject;
 
+    // Generational index into the scene slot table. A handle becomes stale once
+    // its object is destroyed, even if the slot gets reused by a new object.
     class GameObjectHandle {
-        int id;
+        uint32_t index;
+        uint32_t generation;
         Scene* scene;
 
     public:
-        GameObjectHandle() : id(-1), scene(nullptr) {}
-        GameObjectHandle(int id, Scene* scene) : id(id), scene(scene) {}
+        GameObjectHandle() : index(0), generation(0), scene(nullptr) {}
+        GameObjectHandle(uint32_t index, uint32_t generation, Scene* scene) : index(index), generation(generation), scene(scene) {}
 
         SEGameObject* get() const;
         void destroy() const;
@@ -30,6 +34,12 @@ namespace se {
             return get() != nullptr;
         }
 
-        int getId() const { return id; }
+        bool operator==(const GameObjectHandle& other) const {
+            return index == other.index && generation == other.generation && scene == other.scene;
+        }
+        bool operator!=(const GameObjectHandle& other) const { return !(*this == other); }
+
+        uint32_t getIndex() const { return index; }
+        uint32_t getGeneration() const { return generation; }
     };
 }
@@ -0,0 +1,263 @@
+#include "se_geometry_arena.hpp"
+#include "se_device.hpp"
+#include "se_swap_chain.hpp"
+#include "se_vertex.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace se
+{
+    GeometryArena::GeometryArena(SEDevice& device, uint32_t vertexCapacity, uint32_t indexCapacity)
+        : seDevice{ device }, vertexCapacity{ vertexCapacity }, indexCapacity{ indexCapacity }
+    {
+        const VkBufferUsageFlags transfer = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        vertexStream.elementSize = sizeof(Vertex);
+        vertexStream.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | transfer;
+        positionStream.elementSize = sizeof(glm::vec3);
+        positionStream.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | transfer;
+        indexStream.elementSize = sizeof(uint32_t);
+        indexStream.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | transfer;
+
+        createStream(vertexStream, vertexCapacity);
+        createStream(positionStream, vertexCapacity);
+        createStream(indexStream, indexCapacity);
+
+        freeVertices[0] = vertexCapacity;
+        freeIndices[0] = indexCapacity;
+    }
+
+    GeometryArena::~GeometryArena()
+    {
+        seDevice.destroyBuffer(vertexStream.buffer, vertexStream.memory);
+        seDevice.destroyBuffer(positionStream.buffer, positionStream.memory);
+        seDevice.destroyBuffer(indexStream.buffer, indexStream.memory);
+    }
+
+    GeometryRange GeometryArena::allocate(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        reclaim();
+
+        GeometryRange range{};
+        range.vertexCount = static_cast<uint32_t>(vertices.size());
+        range.indexCount = static_cast<uint32_t>(indices.size());
+
+        if (range.vertexCount > 0)
+        {
+            if (!takeRange(freeVertices, range.vertexCount, range.firstVertex))
+            {
+                grow({ &vertexStream, &positionStream }, freeVertices, vertexCapacity, range.vertexCount);
+                takeRange(freeVertices, range.vertexCount, range.firstVertex);
+            }
+
+            std::vector<glm::vec3> positions(vertices.size());
+            for (size_t i = 0; i < vertices.size(); i++)
+            {
+                positions[i] = vertices[i].position;
+            }
+
+            upload(vertexStream, range.firstVertex, vertices.data(), sizeof(Vertex) * vertices.size());
+            range.upload = upload(positionStream, range.firstVertex, positions.data(), sizeof(glm::vec3) * positions.size());
+            verticesUsed += range.vertexCount;
+        }
+
+        if (range.indexCount > 0)
+        {
+            if (!takeRange(freeIndices, range.indexCount, range.firstIndex))
+            {
+                grow({ &indexStream }, freeIndices, indexCapacity, range.indexCount);
+                takeRange(freeIndices, range.indexCount, range.firstIndex);
+            }
+
+            range.upload = upload(indexStream, range.firstIndex, indices.data(), sizeof(uint32_t) * indices.size());
+            indicesUsed += range.indexCount;
+        }
+
+        return range;
+    }
+
+    void GeometryArena::free(GeometryRange& range)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Frames in flight may still draw the range, and the transfer queue does not wait for them
+        freedRanges.push_back({ range, seDevice.getFrameAllocator().getFrameNumber() });
+        range = {};
+    }
+
+    void GeometryArena::reclaim()
+    {
+        const uint64_t frameNumber = seDevice.getFrameAllocator().getFrameNumber();
+        auto done = [frameNumber](const FreedRange& freed) {
+            return frameNumber >= freed.frameNumber + SESwapChain::MAX_FRAMES_IN_FLIGHT;
+        };
+
+        for (const FreedRange& freed : freedRanges)
+        {
+            if (!done(freed))
+                continue;
+
+            if (freed.range.vertexCount > 0)
+            {
+                returnRange(freeVertices, freed.range.firstVertex, freed.range.vertexCount);
+                verticesUsed -= freed.range.vertexCount;
+            }
+            if (freed.range.indexCount > 0)
+            {
+                returnRange(freeIndices, freed.range.firstIndex, freed.range.indexCount);
+                indicesUsed -= freed.range.indexCount;
+            }
+        }
+        freedRanges.erase(std::remove_if(freedRanges.begin(), freedRanges.end(), done), freedRanges.end());
+    }
+
+    void GeometryArena::readBack(const GeometryRange& range, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        const VkDeviceSize vertexBytes = sizeof(Vertex) * range.vertexCount;
+        const VkDeviceSize indexBytes = sizeof(uint32_t) * range.indexCount;
+        vertices.resize(range.vertexCount);
+        indices.resize(range.indexCount);
+        if (vertexBytes + indexBytes == 0)
+            return;
+
+        VkBuffer stagingBuffer;
+        DeviceAllocation stagingMemory;
+        seDevice.createBuffer(
+            vertexBytes + indexBytes,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            stagingBuffer,
+            stagingMemory,
+            MemoryAllocator::Strategy::Linear);
+
+        // Single time commands flush the upload manager and take its finished uploads over first
+        VkCommandBuffer commandBuffer = seDevice.beginSingleTimeCommands();
+        if (vertexBytes > 0)
+        {
+            VkBufferCopy region{ vertexStream.elementSize * range.firstVertex, 0, vertexBytes };
+            vkCmdCopyBuffer(commandBuffer, vertexStream.buffer, stagingBuffer, 1, &region);
+        }
+        if (indexBytes > 0)
+        {
+            VkBufferCopy region{ indexStream.elementSize * range.firstIndex, vertexBytes, indexBytes };
+            vkCmdCopyBuffer(commandBuffer, indexStream.buffer, stagingBuffer, 1, &region);
+        }
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+        seDevice.endSingleTimeCommands(commandBuffer);
+
+        const char* mapped = static_cast<const char*>(stagingMemory.mapped);
+        std::memcpy(vertices.data(), mapped, vertexBytes);
+        std::memcpy(indices.data(), mapped + vertexBytes, indexBytes);
+        seDevice.destroyBuffer(stagingBuffer, stagingMemory);
+    }
+
+    void GeometryArena::bind(VkCommandBuffer commandBuffer) const
+    {
+        VkBuffer buffers[] = { vertexStream.buffer };
+        VkDeviceSize offsets[] = { 0 };
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+        vkCmdBindIndexBuffer(commandBuffer, indexStream.buffer, 0, VK_INDEX_TYPE_UINT32);
+    }
+
+    void GeometryArena::bindPositions(VkCommandBuffer commandBuffer) const
+    {
+        VkBuffer buffers[] = { positionStream.buffer };
+        VkDeviceSize offsets[] = { 0 };
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+        vkCmdBindIndexBuffer(commandBuffer, indexStream.buffer, 0, VK_INDEX_TYPE_UINT32);
+    }
+
+    bool GeometryArena::takeRange(FreeList& freeList, uint32_t count, uint32_t& first)
+    {
+        for (auto it = freeList.begin(); it != freeList.end(); ++it)
+        {
+            if (it->second < count)
+                continue;
+
+            first = it->first;
+            const uint32_t rest = it->second - count;
+            freeList.erase(it);
+            if (rest > 0)
+                freeList[first + count] = rest;
+            return true;
+        }
+        return false;
+    }
+
+    void GeometryArena::returnRange(FreeList& freeList, uint32_t first, uint32_t count)
+    {
+        auto next = freeList.lower_bound(first);
+        if (next != freeList.begin())
+        {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == first)
+            {
+                first = previous->first;
+                count += previous->second;
+                freeList.erase(previous);
+            }
+        }
+        if (next != freeList.end() && first + count == next->first)
+        {
+            count += next->second;
+            freeList.erase(next);
+        }
+        freeList[first] = count;
+    }
+
+    void GeometryArena::createStream(Stream& stream, uint32_t capacity)
+    {
+        seDevice.createBuffer(
+            stream.elementSize * capacity,
+            stream.usage,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            stream.buffer,
+            stream.memory);
+    }
+
+    void GeometryArena::grow(std::vector<Stream*> streams, FreeList& freeList, uint32_t& capacity, uint32_t required)
+    {
+        const uint64_t newCapacity = std::max<uint64_t>(2ull * capacity, static_cast<uint64_t>(capacity) + required);
+        if (newCapacity > UINT32_MAX)
+        {
+            throw std::runtime_error("geometry arena exhausted!");
+        }
+
+        // Uploads into the old buffers may not even be submitted yet, an open import's included. Frames in flight
+        // may still read them too.
+        UploadManager& uploadManager = seDevice.getUploadManager();
+        uploadManager.waitIdle();
+        vkDeviceWaitIdle(seDevice.device());
+
+        for (Stream* stream : streams)
+        {
+            Stream grown = *stream;
+            createStream(grown, static_cast<uint32_t>(newCapacity));
+            // The copy's command buffer takes the finished uploads over first, the new buffer is written on the
+            // graphics queue so nothing needs acquiring for it. Whatever is left for the old one is dropped.
+            seDevice.copyBuffer(stream->buffer, grown.buffer, stream->elementSize * capacity);
+            uploadManager.discard(stream->buffer);
+            seDevice.destroyBuffer(stream->buffer, stream->memory);
+            *stream = grown;
+        }
+
+        returnRange(freeList, capacity, static_cast<uint32_t>(newCapacity) - capacity);
+        capacity = static_cast<uint32_t>(newCapacity);
+    }
+
+    uint64_t GeometryArena::upload(const Stream& stream, uint32_t first, const void* data, VkDeviceSize size)
+    {
+        return seDevice.getUploadManager().uploadBuffer(stream.buffer, stream.elementSize * first, data, size);
+    }
+}
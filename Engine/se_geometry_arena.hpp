@@ -0,0 +1,109 @@
+#pragma once
+
+#include "se_memory_allocator.hpp"
+#include "se_upload_manager.hpp"
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace se
+{
+    class SEDevice;
+    struct Vertex;
+
+    // Where a submesh lives in the arena. Indices stay relative to the submesh, draws pass firstVertex as the
+    // vertexOffset and firstIndex as is.
+    struct GeometryRange
+    {
+        uint32_t firstVertex = 0;
+        uint32_t vertexCount = 0;
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+        // Upload ticket, the range can be drawn once the upload manager reports it ready
+        uint64_t upload = 0;
+    };
+
+    // Shared vertex and index buffers for every submesh, so a frame binds them once instead of once per
+    // submesh and indirect draws can cover many submeshes in one call. There is one buffer per vertex format,
+    // the full Vertex and the position only stream of depth passes, both indexed by the same vertex ranges,
+    // and one index buffer. Ranges come from first fit free lists that merge on free, full buffers double,
+    // waiting for the device so nothing still reads the old ones and for the uploads still headed into them.
+    // Uploads go through the upload manager and freed ranges are only reused once the frames in flight that
+    // may still draw them are done.
+    class GeometryArena
+    {
+    public:
+        GeometryArena(SEDevice& device, uint32_t vertexCapacity, uint32_t indexCapacity);
+        ~GeometryArena();
+
+        GeometryArena(const GeometryArena&) = delete;
+        GeometryArena& operator=(const GeometryArena&) = delete;
+
+        // Queues the vertices for both vertex buffers and the indices for the index buffer
+        GeometryRange allocate(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+        // Resets range, the space is reused by later allocations
+        void free(GeometryRange& range);
+
+        // Copies a range back from the GPU once its upload has landed, blocks until it has. For checks, not per frame.
+        void readBack(const GeometryRange& range, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+        // Full vertex buffer at binding 0 and the index buffer
+        void bind(VkCommandBuffer commandBuffer) const;
+        // Position stream at binding 0 and the same index buffer
+        void bindPositions(VkCommandBuffer commandBuffer) const;
+
+        uint32_t getVertexCapacity() const { return vertexCapacity; }
+        uint32_t getIndexCapacity() const { return indexCapacity; }
+        uint32_t getVerticesUsed() const { return verticesUsed; }
+        uint32_t getIndicesUsed() const { return indicesUsed; }
+
+    private:
+        struct Stream
+        {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            DeviceAllocation memory;
+            VkDeviceSize elementSize;
+            VkBufferUsageFlags usage;
+        };
+
+        // Offset to count, sorted so neighbours can merge
+        using FreeList = std::map<uint32_t, uint32_t>;
+
+        // Returns false when no range is big enough
+        static bool takeRange(FreeList& freeList, uint32_t count, uint32_t& first);
+        static void returnRange(FreeList& freeList, uint32_t first, uint32_t count);
+
+        void createStream(Stream& stream, uint32_t capacity);
+        // Replaces the streams with ones holding at least capacity elements, keeping their contents
+        void grow(std::vector<Stream*> streams, FreeList& freeList, uint32_t& capacity, uint32_t required);
+        uint64_t upload(const Stream& stream, uint32_t first, const void* data, VkDeviceSize size);
+        // Returns ranges freed long enough ago to the free lists
+        void reclaim();
+
+        SEDevice& seDevice;
+        Stream vertexStream;
+        Stream positionStream;
+        Stream indexStream;
+
+        FreeList freeVertices;
+        FreeList freeIndices;
+        uint32_t vertexCapacity;
+        uint32_t indexCapacity;
+        uint32_t verticesUsed = 0;
+        uint32_t indicesUsed = 0;
+
+        struct FreedRange
+        {
+            GeometryRange range;
+            uint64_t frameNumber;
+        };
+        std::vector<FreedRange> freedRanges;
+
+        std::mutex mutex;
+    };
+}
@@ -0,0 +1,451 @@
+#include "se_gpu_culling.hpp"
+#include "se_pipeline.hpp"
+#include "se_swap_chain.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace se
+{
+    static_assert(sizeof(AABB) == 6 * sizeof(float), "cullInstances.comp reads bounds as six packed floats");
+
+    GPUCulling::GPUCulling(SEDevice& device) : seDevice{ device }
+    {
+        if (!seDevice.supportsIndirectFirstInstance())
+        {
+            throw std::runtime_error("drawIndirectFirstInstance is not supported!");
+        }
+
+        createDescriptorSetLayout();
+        createPipelineLayout();
+        pipeline = createComputePipeline("shaders/cullInstances.spv");
+        createDescriptorSets();
+    }
+
+    GPUCulling::~GPUCulling()
+    {
+        for (auto& frame : frames)
+        {
+            destroyBuffer(frame.transforms);
+            destroyBuffer(frame.bounds);
+            destroyBuffer(frame.instances);
+            destroyBuffer(frame.visible);
+            destroyBuffer(frame.commands);
+            destroyBuffer(frame.drawCounts);
+            destroyBuffer(frame.retest);
+            destroyBuffer(frame.counters);
+            destroyBuffer(frame.occlusionParams);
+        }
+
+        if (occlusionPipeline != VK_NULL_HANDLE)
+            vkDestroyPipeline(seDevice.device(), occlusionPipeline, nullptr);
+        vkDestroyPipeline(seDevice.device(), pipeline, nullptr);
+        vkDestroyPipelineLayout(seDevice.device(), pipelineLayout, nullptr);
+        vkDestroyDescriptorSetLayout(seDevice.device(), descriptorSetLayout, nullptr);
+    }
+
+    void GPUCulling::createDescriptorSetLayout()
+    {
+        // 0 bounds, 1 instances, 2 draw commands, 3 draw counts, 4 visible instances, 5 retest flags, 6 counters,
+        // 7 occlusion parameters and 8 the depth pyramid. The frustum only pipeline leaves 5 to 8 alone.
+        std::array<VkDescriptorSetLayoutBinding, 9> bindings{};
+        for (uint32_t i = 0; i < bindings.size(); i++)
+        {
+            bindings[i].binding = i;
+            bindings[i].descriptorCount = 1;
+            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+        bindings[7].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        bindings[8].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+
+        if (vkCreateDescriptorSetLayout(seDevice.device(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create culling descriptor set layout!");
+        }
+    }
+
+    void GPUCulling::createPipelineLayout()
+    {
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(CullParams);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+        if (vkCreatePipelineLayout(seDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create culling pipeline layout!");
+        }
+    }
+
+    VkPipeline GPUCulling::createComputePipeline(const std::string& filepath)
+    {
+        auto code = SEPipeline::readFile(filepath);
+
+        VkShaderModuleCreateInfo moduleInfo{};
+        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = code.size();
+        moduleInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+        VkShaderModule shaderModule;
+        if (vkCreateShaderModule(seDevice.device(), &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create culling shader module!");
+        }
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = shaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+
+        VkPipeline computePipeline;
+        VkResult result = vkCreateComputePipelines(seDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &computePipeline);
+        vkDestroyShaderModule(seDevice.device(), shaderModule, nullptr);
+
+        if (result != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create culling pipeline!");
+        }
+        return computePipeline;
+    }
+
+    void GPUCulling::createOcclusionPipeline()
+    {
+        if (occlusionPipeline == VK_NULL_HANDLE)
+            occlusionPipeline = createComputePipeline("shaders/cullOcclusion.spv");
+    }
+
+    void GPUCulling::createDescriptorSets()
+    {
+        frames.resize(SESwapChain::MAX_FRAMES_IN_FLIGHT);
+
+        for (auto& frame : frames)
+        {
+            VkDescriptorSetAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            allocInfo.descriptorPool = seDevice.getDescriptorPool();
+            allocInfo.descriptorSetCount = 1;
+            allocInfo.pSetLayouts = &descriptorSetLayout;
+
+            if (vkAllocateDescriptorSets(seDevice.device(), &allocInfo, &frame.descriptorSet) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate culling descriptor sets!");
+            }
+
+            // Fixed size, so created once and written along with the rest
+            createBuffer(frame.counters, sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+            createBuffer(frame.occlusionParams, sizeof(OcclusionParams), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+            std::memset(frame.counters.mapped, 0, sizeof(uint32_t));
+        }
+    }
+
+    void GPUCulling::updateDescriptorSet(FrameResources& frame)
+    {
+        const std::array<VkBuffer, 8> buffers = {
+            frame.bounds.buffer,
+            frame.instances.buffer,
+            frame.commands.buffer,
+            frame.drawCounts.buffer,
+            frame.visible.buffer,
+            frame.retest.buffer,
+            frame.counters.buffer,
+            frame.occlusionParams.buffer };
+
+        std::array<VkDescriptorBufferInfo, 8> bufferInfos{};
+        std::array<VkWriteDescriptorSet, 8> descriptorWrites{};
+        for (uint32_t i = 0; i < buffers.size(); i++)
+        {
+            bufferInfos[i].buffer = buffers[i];
+            bufferInfos[i].offset = 0;
+            bufferInfos[i].range = VK_WHOLE_SIZE;
+
+            descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrites[i].dstSet = frame.descriptorSet;
+            descriptorWrites[i].dstBinding = i;
+            descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            descriptorWrites[i].descriptorCount = 1;
+            descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+        }
+        descriptorWrites[7].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+        vkUpdateDescriptorSets(seDevice.device(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+    }
+
+    void GPUCulling::createBuffer(Buffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage)
+    {
+        seDevice.createBuffer(
+            size,
+            usage,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            buffer.buffer,
+            buffer.allocation);
+        buffer.mapped = buffer.allocation.mapped;
+    }
+
+    void GPUCulling::destroyBuffer(Buffer& buffer)
+    {
+        if (buffer.buffer == VK_NULL_HANDLE)
+            return;
+
+        seDevice.destroyBuffer(buffer.buffer, buffer.allocation);
+        buffer = Buffer{};
+    }
+
+    bool GPUCulling::reserve(Buffer& buffer, size_t& capacity, size_t count, size_t minCapacity, VkDeviceSize elementSize, VkBufferUsageFlags usage)
+    {
+        if (buffer.buffer != VK_NULL_HANDLE && count <= capacity)
+            return false;
+
+        size_t newCapacity = std::max({ count, capacity * 2, minCapacity });
+        destroyBuffer(buffer);
+        createBuffer(buffer, elementSize * newCapacity, usage);
+        capacity = newCapacity;
+        return true;
+    }
+
+    void GPUCulling::clearBatches()
+    {
+        batches.clear();
+        instances.clear();
+        instanceVersion++;
+    }
+
+    void GPUCulling::addBatch(const GeometryRange& geometry)
+    {
+        batches.push_back({ geometry.indexCount, geometry.firstIndex, static_cast<int32_t>(geometry.firstVertex), static_cast<uint32_t>(instances.size()), 0 });
+    }
+
+    void GPUCulling::addInstance(uint32_t object)
+    {
+        instances.push_back({ object, static_cast<uint32_t>(batches.size() - 1) });
+        batches.back().instanceCount++;
+    }
+
+    bool GPUCulling::prepare(int frameIndex, const Scene& scene)
+    {
+        FrameResources& frame = frames[frameIndex];
+
+        // beginFrame waited on the frame's fence, so these are the GPU's final counts from its last use
+        if (frame.commands.buffer != VK_NULL_HANDLE)
+        {
+            const auto* commands = static_cast<const VkDrawIndexedIndirectCommand*>(frame.commands.mapped);
+            visibleCount = 0;
+            for (size_t b = 0; b < 2 * frame.uploadedBatches; b++)
+                visibleCount += commands[b].instanceCount;
+
+            auto* occluded = static_cast<uint32_t*>(frame.counters.mapped);
+            occludedCount = *occluded;
+            *occluded = 0;
+        }
+
+        // Every buffer shares one capacity per element kind, visible has a slot for every instance
+        const VkBufferUsageFlags storage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        const VkBufferUsageFlags indirect = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+        const size_t objectCount = scene.getObjectCount();
+
+        size_t objectCapacity = frame.objectCapacity;
+        bool reallocated = reserve(frame.transforms, frame.objectCapacity, objectCount, MIN_OBJECT_CAPACITY, sizeof(glm::mat4), storage);
+        reallocated |= reserve(frame.bounds, objectCapacity, objectCount, MIN_OBJECT_CAPACITY, sizeof(AABB), storage);
+
+        size_t instanceCapacity = frame.instanceCapacity;
+        size_t retestCapacity = frame.instanceCapacity;
+        reallocated |= reserve(frame.instances, frame.instanceCapacity, instances.size(), MIN_OBJECT_CAPACITY, sizeof(InstanceRef), storage);
+        reallocated |= reserve(frame.visible, instanceCapacity, instances.size(), MIN_OBJECT_CAPACITY, sizeof(uint32_t), storage);
+        reallocated |= reserve(frame.retest, retestCapacity, instances.size(), MIN_OBJECT_CAPACITY, sizeof(uint32_t), storage);
+
+        // Room for the second phase's commands behind the first's
+        size_t batchCapacity = frame.batchCapacity;
+        reallocated |= reserve(frame.commands, frame.batchCapacity, 2 * batches.size(), MIN_BATCH_CAPACITY, sizeof(VkDrawIndexedIndirectCommand), indirect);
+        reallocated |= reserve(frame.drawCounts, batchCapacity, 2 * batches.size(), MIN_BATCH_CAPACITY, sizeof(uint32_t), indirect);
+
+        // A static scene uploads once per frame in flight and then only resets the counts
+        bool sceneChanged = frame.scene != &scene
+            || frame.structureVersion != scene.getStructureVersion()
+            || frame.transformVersion != scene.getTransformVersion();
+        if (reallocated || sceneChanged)
+        {
+            std::memcpy(frame.transforms.mapped, scene.getWorldMatrices().data(), sizeof(glm::mat4) * objectCount);
+            std::memcpy(frame.bounds.mapped, scene.getWorldBounds().data(), sizeof(AABB) * objectCount);
+            frame.scene = &scene;
+            frame.structureVersion = scene.getStructureVersion();
+            frame.transformVersion = scene.getTransformVersion();
+        }
+
+        if (reallocated || frame.instanceVersion != instanceVersion)
+        {
+            std::memcpy(frame.instances.mapped, instances.data(), sizeof(InstanceRef) * instances.size());
+            frame.instanceVersion = instanceVersion;
+        }
+
+        // The compute pass counts up from zero, firstInstance points each batch at its slice of visible.
+        // The second phase's copies only draw when occlusion culling moves their firstInstance past the first's.
+        auto* commands = static_cast<VkDrawIndexedIndirectCommand*>(frame.commands.mapped);
+        for (size_t b = 0; b < 2 * batches.size(); b++)
+        {
+            const BatchInfo& batch = batches[b % batches.size()];
+            commands[b].indexCount = batch.indexCount;
+            commands[b].instanceCount = 0;
+            commands[b].firstIndex = batch.firstIndex;
+            commands[b].vertexOffset = batch.vertexOffset;
+            commands[b].firstInstance = batch.firstInstance;
+        }
+        std::memset(frame.drawCounts.mapped, 0, sizeof(uint32_t) * 2 * batches.size());
+        frame.uploadedBatches = batches.size();
+
+        if (reallocated)
+            updateDescriptorSet(frame);
+        return reallocated;
+    }
+
+    void GPUCulling::dispatch(VkCommandBuffer commandBuffer, int frameIndex, const Frustum& frustum)
+    {
+        if (instances.empty())
+            return;
+
+        CullParams params{};
+        std::memcpy(params.planes, frustum.planes, sizeof(params.planes));
+        params.instanceCount = static_cast<uint32_t>(instances.size());
+        recordDispatch(commandBuffer, frameIndex, pipeline, params);
+    }
+
+    void GPUCulling::prepareOcclusion(int frameIndex, const HiZPyramid& pyramid, const glm::mat4& viewProjection)
+    {
+        FrameResources& frame = frames[frameIndex];
+
+        // Phase 1 tests with the camera the pyramid was built with, phase 2 with this frame's once it is rebuilt
+        OcclusionParams params{};
+        params.viewProjection[0] = pyramid.getViewProjection();
+        params.viewProjection[1] = viewProjection;
+        params.pyramidSize = glm::ivec2(pyramid.getSize().width, pyramid.getSize().height);
+        params.pyramidLevels = pyramid.getLevelCount();
+        params.pyramidValid = pyramid.isValid() ? 1 : 0;
+        std::memcpy(frame.occlusionParams.mapped, &params, sizeof(params));
+
+        if (frame.pyramidVersion == pyramid.getVersion())
+            return;
+
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.sampler = pyramid.getSampler();
+        imageInfo.imageView = pyramid.getView();
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        VkWriteDescriptorSet descriptorWrite{};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = frame.descriptorSet;
+        descriptorWrite.dstBinding = 8;
+        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.pImageInfo = &imageInfo;
+
+        vkUpdateDescriptorSets(seDevice.device(), 1, &descriptorWrite, 0, nullptr);
+        frame.pyramidVersion = pyramid.getVersion();
+    }
+
+    void GPUCulling::dispatchOcclusion(VkCommandBuffer commandBuffer, int frameIndex, const Frustum& frustum, uint32_t phase)
+    {
+        if (instances.empty())
+            return;
+
+        CullParams params{};
+        std::memcpy(params.planes, frustum.planes, sizeof(params.planes));
+        params.instanceCount = static_cast<uint32_t>(instances.size());
+        params.batchCount = static_cast<uint32_t>(batches.size());
+        params.phase = phase;
+        recordDispatch(commandBuffer, frameIndex, occlusionPipeline, params);
+    }
+
+    void GPUCulling::recordDispatch(VkCommandBuffer commandBuffer, int frameIndex, VkPipeline cullPipeline, const CullParams& params)
+    {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &frames[frameIndex].descriptorSet, 0, nullptr);
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullParams), &params);
+        vkCmdDispatch(commandBuffer, (params.instanceCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+        // Counts and commands feed the indirect draws, visible indices the vertex shader,
+        // and the occlusion retest reads and appends to all of them
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr);
+    }
+
+    void GPUCulling::draw(VkCommandBuffer commandBuffer, int frameIndex, uint32_t batch, bool secondPhase) const
+    {
+        const FrameResources& frame = frames[frameIndex];
+        if (secondPhase)
+            batch += static_cast<uint32_t>(batches.size());
+        const VkDeviceSize commandOffset = sizeof(VkDrawIndexedIndirectCommand) * batch;
+
+        if (auto drawIndexedIndirectCount = seDevice.getDrawIndexedIndirectCount())
+        {
+            drawIndexedIndirectCount(
+                commandBuffer,
+                frame.commands.buffer, commandOffset,
+                frame.drawCounts.buffer, sizeof(uint32_t) * batch,
+                1, sizeof(VkDrawIndexedIndirectCommand));
+        }
+        else
+        {
+            // Without the count a fully culled batch still costs an empty draw
+            vkCmdDrawIndexedIndirect(commandBuffer, frame.commands.buffer, commandOffset, 1, sizeof(VkDrawIndexedIndirectCommand));
+        }
+    }
+
+    uint32_t GPUCulling::drawRange(VkCommandBuffer commandBuffer, int frameIndex, uint32_t firstBatch, uint32_t batchCount, bool secondPhase) const
+    {
+        if (batchCount == 0)
+            return 0;
+
+        if (batchCount == 1 || !seDevice.supportsMultiDrawIndirect())
+        {
+            for (uint32_t b = firstBatch; b < firstBatch + batchCount; b++)
+                draw(commandBuffer, frameIndex, b, secondPhase);
+            return batchCount;
+        }
+
+        // The draw counts are per batch, so a range can't use them, batches nothing survived in draw zero instances
+        const FrameResources& frame = frames[frameIndex];
+        if (secondPhase)
+            firstBatch += static_cast<uint32_t>(batches.size());
+        const uint32_t maxDrawCount = std::max<uint32_t>(1, seDevice.properties.limits.maxDrawIndirectCount);
+
+        uint32_t drawCalls = 0;
+        for (uint32_t offset = 0; offset < batchCount; offset += maxDrawCount)
+        {
+            const uint32_t drawCount = std::min(maxDrawCount, batchCount - offset);
+            vkCmdDrawIndexedIndirect(
+                commandBuffer, frame.commands.buffer,
+                sizeof(VkDrawIndexedIndirectCommand) * (firstBatch + offset),
+                drawCount, sizeof(VkDrawIndexedIndirectCommand));
+            drawCalls++;
+        }
+        return drawCalls;
+    }
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "se_device.hpp"
+#include "se_bounds.hpp"
+#include "se_scene.hpp"
+#include "se_hiz_pyramid.hpp"
+
+// std
+#include <string>
+#include <vector>
+
+namespace se
+{
+    // Frustum culling on the GPU. The scene's world matrices and bounds are copied into per frame storage
+    // buffers, a compute pass tests every instance and compacts the survivors of each batch into its slice
+    // of the visible buffer while counting them into the batch's VkDrawIndexedIndirectCommand.
+    // Each batch is then one indirect count draw, batches nothing survived in are skipped by the GPU.
+    // Every submesh lives in the geometry arena, so consecutive batches can also go out as one multi draw.
+    // With occlusion culling every batch gets a second draw for the instances the second phase let through.
+    class GPUCulling
+    {
+    public:
+        // Throws when the compute shader is missing or the device can't draw indirect from a non zero instance
+        GPUCulling(SEDevice& device);
+        ~GPUCulling();
+
+        GPUCulling(const GPUCulling&) = delete;
+        GPUCulling& operator=(const GPUCulling&) = delete;
+
+        // Draw list, rebuilt by the owner when the scene's structure changes.
+        // A batch is one indexed submesh, instances added after addBatch belong to it.
+        void clearBatches();
+        void addBatch(const GeometryRange& geometry);
+        void addInstance(uint32_t object);
+        size_t getBatchCount() const { return batches.size(); }
+        size_t getInstanceCount() const { return instances.size(); }
+
+        // Uploads whatever changed since the frame's buffers were last written and resets the draw counts.
+        // Returns true when the frame's buffers were reallocated, descriptors pointing at them need rewriting.
+        bool prepare(int frameIndex, const Scene& scene);
+        // Records the culling dispatch and the barrier in front of the indirect draws, outside a render pass
+        void dispatch(VkCommandBuffer commandBuffer, int frameIndex, const Frustum& frustum);
+        // Expects the geometry arena to be bound. secondPhase draws what the occlusion retest added.
+        void draw(VkCommandBuffer commandBuffer, int frameIndex, uint32_t batch, bool secondPhase = false) const;
+        // Draws batchCount batches from firstBatch on, one multi draw when the device has multiDrawIndirect and one
+        // count draw per batch otherwise. Empty batches are left to the GPU. Returns the draw calls recorded.
+        uint32_t drawRange(VkCommandBuffer commandBuffer, int frameIndex, uint32_t firstBatch, uint32_t batchCount, bool secondPhase = false) const;
+
+        // Creates the two phase pipeline on first use, throws when cullOcclusion.spv is missing
+        void createOcclusionPipeline();
+        // Points the frame at the pyramid and the cameras both phases test with, after prepare.
+        // viewProjection is this frame's camera, the one the pyramid is rebuilt with before phase 2.
+        void prepareOcclusion(int frameIndex, const HiZPyramid& pyramid, const glm::mat4& viewProjection);
+        // Phase 1 replaces dispatch and culls against last frame's pyramid. Phase 2 is recorded once the pyramid
+        // was rebuilt from phase 1's depth and retests what phase 1 rejected as occluded. Outside a render pass.
+        void dispatchOcclusion(VkCommandBuffer commandBuffer, int frameIndex, const Frustum& frustum, uint32_t phase);
+
+        // Read by the vertex shader, world matrices by object and object indices by instance
+        VkBuffer getTransformBuffer(int frameIndex) const { return frames[frameIndex].transforms.buffer; }
+        VkBuffer getVisibleBuffer(int frameIndex) const { return frames[frameIndex].visible.buffer; }
+        // Instances that survived culling, read back from the frame's previous use so a few frames late
+        uint32_t getVisibleCount() const { return visibleCount; }
+        // Instances that were in the frustum but behind the depth pyramid, read back the same way
+        uint32_t getOccludedCount() const { return occludedCount; }
+
+    private:
+        struct InstanceRef {
+            uint32_t object;
+            uint32_t batch;
+        };
+
+        struct BatchInfo {
+            uint32_t indexCount;
+            uint32_t firstIndex;
+            int32_t vertexOffset;
+            uint32_t firstInstance;
+            uint32_t instanceCount;
+        };
+
+        // Matches the push constant block of cullInstances.comp and cullOcclusion.comp, the first ignores the rest
+        struct CullParams {
+            glm::vec4 planes[Frustum::Count];
+            uint32_t instanceCount;
+            uint32_t batchCount;
+            uint32_t phase;
+        };
+
+        // Matches the Occlusion block of cullOcclusion.comp
+        struct OcclusionParams {
+            glm::mat4 viewProjection[2];
+            glm::ivec2 pyramidSize;
+            uint32_t pyramidLevels;
+            uint32_t pyramidValid;
+        };
+
+        struct FrameResources {
+            Buffer transforms{};
+            Buffer bounds{};
+            Buffer instances{};
+            Buffer visible{};
+            Buffer commands{};
+            Buffer drawCounts{};
+            Buffer retest{};
+            Buffer counters{};
+            Buffer occlusionParams{};
+            size_t objectCapacity = 0;
+            size_t instanceCapacity = 0;
+            size_t batchCapacity = 0;
+            VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+            // What the buffers currently hold
+            const Scene* scene = nullptr;
+            uint64_t structureVersion = 0;
+            uint64_t transformVersion = 0;
+            uint64_t instanceVersion = 0;
+            size_t uploadedBatches = 0;
+            // Version of the pyramid binding 8 points at, 0 for none
+            uint64_t pyramidVersion = 0;
+        };
+
+        static constexpr uint32_t WORKGROUP_SIZE = 64;
+        static constexpr size_t MIN_OBJECT_CAPACITY = 1024;
+        static constexpr size_t MIN_BATCH_CAPACITY = 64;
+
+        void createDescriptorSetLayout();
+        void createPipelineLayout();
+        VkPipeline createComputePipeline(const std::string& filepath);
+        void createDescriptorSets();
+        void updateDescriptorSet(FrameResources& frame);
+        // Binds the set and records the dispatch plus the barrier in front of whatever reads its results
+        void recordDispatch(VkCommandBuffer commandBuffer, int frameIndex, VkPipeline cullPipeline, const CullParams& params);
+
+        void createBuffer(Buffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage);
+        void destroyBuffer(Buffer& buffer);
+        // Grows to at least count elements, doubling so steady growth only reallocates a few times
+        bool reserve(Buffer& buffer, size_t& capacity, size_t count, size_t minCapacity, VkDeviceSize elementSize, VkBufferUsageFlags usage);
+
+        SEDevice& seDevice;
+        VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkPipeline occlusionPipeline = VK_NULL_HANDLE;
+
+        std::vector<FrameResources> frames;
+        std::vector<InstanceRef> instances;
+        std::vector<BatchInfo> batches;
+        uint64_t instanceVersion = 1;
+        uint32_t visibleCount = 0;
+        uint32_t occludedCount = 0;
+    };
+}
@@ -77,9 +77,8 @@ namespace se
 		// glm::mat4 view;
 		// glm::mat4 proj;
 		// glm::vec3 cameraPos;
-		std::vector<VkBuffer> uniformBuffers = seDevice.getUniformBuffers();
 		VkDescriptorBufferInfo bufferInfo{};
-		bufferInfo.buffer = uniformBuffers[0];
+		bufferInfo.buffer = seDevice.getFrameAllocator().getBuffer();
 		bufferInfo.offset = 0;
 		bufferInfo.range = sizeof(UniformBufferObject);
 
@@ -95,7 +94,7 @@ namespace se
 		descriptorWrites[0].dstSet = descriptorSet;
 		descriptorWrites[0].dstBinding = 0;
 		descriptorWrites[0].dstArrayElement = 0;
-		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		descriptorWrites[0].descriptorCount = 1;
 		descriptorWrites[0].pBufferInfo = &bufferInfo;
 
@@ -120,7 +119,7 @@ namespace se
 		VkDescriptorSetLayoutBinding uboLayoutBinding{};
 		uboLayoutBinding.binding = 0;
 		uboLayoutBinding.descriptorCount = 1;
-		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 		uboLayoutBinding.pImmutableSamplers = nullptr;
 		uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 		bindings.push_back(uboLayoutBinding);
@@ -192,7 +191,7 @@ namespace se
 	void SEHdrToCubemap::convert()
 	{
 		se::SECamera camera{};
-		auto viewerObject = se::SEGameObject::createGameObject();
+		se::TransformComponent viewerTransform{};
 		se::SEOffscreenRenderer* offscreenRenderer = seRenderer.getOffscreenRenderer();
 
 		std::vector<glm::vec3> directions = {
@@ -218,14 +217,14 @@ namespace se
 
 		for (int i = 0; i < 6; i++)
 		{
-			camera.setViewDirection(viewerObject.getTransform().translation, directions[i], upVectors[i]);
+			camera.setViewDirection(viewerTransform.translation, directions[i], upVectors[i]);
 
 			UniformBufferObject ubo{};
 			ubo.proj = camera.getProjection();
 			ubo.view = camera.getView();
-			ubo.cameraPos = viewerObject.getTransform().translation;
+			ubo.cameraPos = viewerTransform.translation;
 
-			seDevice.updateUniformBuffers(ubo);
+			seDevice.updateCameraUniform(ubo);
 			if (auto commandBuffer = seRenderer.beginOffscreenFrame())
 			{
 				seRenderer.beginOffscreenRenderPass(commandBuffer);
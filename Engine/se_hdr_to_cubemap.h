@@ -35,6 +35,7 @@ namespace se
 		{
 			sePipeline->bind(commandBuffer);
 
+			uint32_t cameraOffset = seDevice.getCameraUniformOffset();
 			vkCmdBindDescriptorSets(
 				commandBuffer,
 				VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -42,8 +43,8 @@ namespace se
 				0,
 				1,
 				&descriptorSet,
-				0,
-				nullptr);
+				1,
+				&cameraOffset);
 		}
 		void draw(VkCommandBuffer commandBuffer);
 
@@ -62,7 +63,7 @@ namespace se
 
 		VkImage cubeMapImage;
 		VkImageView cubeMapImageView;
-		VkDeviceMemory cubeMapImageMemory;
+		DeviceAllocation cubeMapImageMemory;
 
 		VkSampler cubeMapSampler;
 
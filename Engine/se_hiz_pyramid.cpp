@@ -0,0 +1,395 @@
+#include "se_hiz_pyramid.hpp"
+#include "se_pipeline.hpp"
+#include "se_swap_chain.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace se
+{
+    namespace
+    {
+        uint32_t previousPowerOfTwo(uint32_t value)
+        {
+            uint32_t result = 1;
+            while (result * 2 <= value)
+                result *= 2;
+            return result;
+        }
+    }
+
+    HiZPyramid::HiZPyramid(SEDevice& device) : seDevice{ device }
+    {
+        // Throws when no candidate fits
+        seDevice.findSupportedFormat({ VK_FORMAT_R32_SFLOAT }, VK_IMAGE_TILING_OPTIMAL,
+            VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+
+        createDescriptorSetLayout();
+        createPipeline();
+        createSampler();
+        createFrameDescriptorSets();
+    }
+
+    HiZPyramid::~HiZPyramid()
+    {
+        destroyImage();
+        vkFreeDescriptorSets(seDevice.device(), seDevice.getDescriptorPool(),
+            static_cast<uint32_t>(frameDescriptorSets.size()), frameDescriptorSets.data());
+
+        vkDestroySampler(seDevice.device(), sampler, nullptr);
+        vkDestroyPipeline(seDevice.device(), pipeline, nullptr);
+        vkDestroyPipelineLayout(seDevice.device(), pipelineLayout, nullptr);
+        vkDestroyDescriptorSetLayout(seDevice.device(), descriptorSetLayout, nullptr);
+    }
+
+    void HiZPyramid::createDescriptorSetLayout()
+    {
+        // 0 the level read, 1 the level written
+        std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+        bindings[0].binding = 0;
+        bindings[0].descriptorCount = 1;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        bindings[1].binding = 1;
+        bindings[1].descriptorCount = 1;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+
+        if (vkCreateDescriptorSetLayout(seDevice.device(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create depth pyramid descriptor set layout!");
+        }
+    }
+
+    void HiZPyramid::createPipeline()
+    {
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(BuildParams);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+        if (vkCreatePipelineLayout(seDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create depth pyramid pipeline layout!");
+        }
+
+        auto code = SEPipeline::readFile("shaders/hiZBuild.spv");
+
+        VkShaderModuleCreateInfo moduleInfo{};
+        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = code.size();
+        moduleInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+        VkShaderModule shaderModule;
+        if (vkCreateShaderModule(seDevice.device(), &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create depth pyramid shader module!");
+        }
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = shaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+
+        VkResult result = vkCreateComputePipelines(seDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+        vkDestroyShaderModule(seDevice.device(), shaderModule, nullptr);
+
+        if (result != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create depth pyramid pipeline!");
+        }
+    }
+
+    void HiZPyramid::createSampler()
+    {
+        // Only read through texelFetch, filtering never applies
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_NEAREST;
+        samplerInfo.minFilter = VK_FILTER_NEAREST;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.minLod = 0.0f;
+        samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+        samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+
+        if (vkCreateSampler(seDevice.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create depth pyramid sampler!");
+        }
+    }
+
+    void HiZPyramid::createFrameDescriptorSets()
+    {
+        frameDescriptorSets.resize(SESwapChain::MAX_FRAMES_IN_FLIGHT);
+        std::vector<VkDescriptorSetLayout> layouts(frameDescriptorSets.size(), descriptorSetLayout);
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = seDevice.getDescriptorPool();
+        allocInfo.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+        allocInfo.pSetLayouts = layouts.data();
+
+        if (vkAllocateDescriptorSets(seDevice.device(), &allocInfo, frameDescriptorSets.data()) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate depth pyramid descriptor sets!");
+        }
+    }
+
+    bool HiZPyramid::prepare(VkExtent2D extent, VkFormat depthFormat)
+    {
+        depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+        if (depthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT || depthFormat == VK_FORMAT_D24_UNORM_S8_UINT)
+            depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+
+        if (image != VK_NULL_HANDLE && extent.width == depthExtent.width && extent.height == depthExtent.height)
+            return false;
+
+        // Earlier frames may still be culling against the old pyramid
+        vkDeviceWaitIdle(seDevice.device());
+        destroyImage();
+        createImage(extent);
+        return true;
+    }
+
+    void HiZPyramid::createImage(VkExtent2D extent)
+    {
+        depthExtent = extent;
+        size.width = previousPowerOfTwo(std::max(extent.width, 1u));
+        size.height = previousPowerOfTwo(std::max(extent.height, 1u));
+
+        uint32_t levelCount = 1;
+        while ((std::max(size.width, size.height) >> levelCount) > 0)
+            levelCount++;
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = size.width;
+        imageInfo.extent.height = size.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = levelCount;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = VK_FORMAT_R32_SFLOAT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        seDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, memory);
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = VK_FORMAT_R32_SFLOAT;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = levelCount;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(seDevice.device(), &viewInfo, nullptr, &view) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create depth pyramid image view!");
+        }
+
+        levelViews.resize(levelCount);
+        for (uint32_t level = 0; level < levelCount; level++)
+        {
+            viewInfo.subresourceRange.baseMipLevel = level;
+            viewInfo.subresourceRange.levelCount = 1;
+            if (vkCreateImageView(seDevice.device(), &viewInfo, nullptr, &levelViews[level]) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create depth pyramid level view!");
+            }
+        }
+
+        levelDescriptorSets.resize(levelCount - 1);
+        if (!levelDescriptorSets.empty())
+        {
+            std::vector<VkDescriptorSetLayout> layouts(levelDescriptorSets.size(), descriptorSetLayout);
+
+            VkDescriptorSetAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            allocInfo.descriptorPool = seDevice.getDescriptorPool();
+            allocInfo.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+            allocInfo.pSetLayouts = layouts.data();
+
+            if (vkAllocateDescriptorSets(seDevice.device(), &allocInfo, levelDescriptorSets.data()) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate depth pyramid descriptor sets!");
+            }
+
+            for (uint32_t level = 1; level < levelCount; level++)
+                writeDescriptorSet(levelDescriptorSets[level - 1], levelViews[level - 1], VK_IMAGE_LAYOUT_GENERAL, levelViews[level]);
+        }
+
+        initialized = false;
+        valid = false;
+        version++;
+    }
+
+    void HiZPyramid::destroyImage()
+    {
+        if (!levelDescriptorSets.empty())
+        {
+            vkFreeDescriptorSets(seDevice.device(), seDevice.getDescriptorPool(),
+                static_cast<uint32_t>(levelDescriptorSets.size()), levelDescriptorSets.data());
+            levelDescriptorSets.clear();
+        }
+
+        for (VkImageView levelView : levelViews)
+            vkDestroyImageView(seDevice.device(), levelView, nullptr);
+        levelViews.clear();
+
+        if (view != VK_NULL_HANDLE)
+            vkDestroyImageView(seDevice.device(), view, nullptr);
+        if (image != VK_NULL_HANDLE)
+            seDevice.destroyImage(image, memory);
+
+        view = VK_NULL_HANDLE;
+    }
+
+    void HiZPyramid::writeDescriptorSet(VkDescriptorSet descriptorSet, VkImageView source, VkImageLayout sourceLayout, VkImageView destination)
+    {
+        VkDescriptorImageInfo sourceInfo{};
+        sourceInfo.sampler = sampler;
+        sourceInfo.imageView = source;
+        sourceInfo.imageLayout = sourceLayout;
+
+        VkDescriptorImageInfo destinationInfo{};
+        destinationInfo.imageView = destination;
+        destinationInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
+        descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[0].dstSet = descriptorSet;
+        descriptorWrites[0].dstBinding = 0;
+        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrites[0].descriptorCount = 1;
+        descriptorWrites[0].pImageInfo = &sourceInfo;
+
+        descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[1].dstSet = descriptorSet;
+        descriptorWrites[1].dstBinding = 1;
+        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        descriptorWrites[1].descriptorCount = 1;
+        descriptorWrites[1].pImageInfo = &destinationInfo;
+
+        vkUpdateDescriptorSets(seDevice.device(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+    }
+
+    void HiZPyramid::build(VkCommandBuffer commandBuffer, int frameIndex, VkImage depthImage, VkImageView depthView, const glm::mat4& buildViewProjection)
+    {
+        // The frame's previous submission is done, so its set is free to point at this frame's depth
+        writeDescriptorSet(frameDescriptorSets[frameIndex], depthView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, levelViews[0]);
+
+        // Depth becomes readable once the draws are done with it. The pyramid's earlier contents were last read by
+        // culling passes, and are thrown away on the first build.
+        std::array<VkImageMemoryBarrier, 2> barriers{};
+        barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        barriers[0].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[0].image = depthImage;
+        barriers[0].subresourceRange = { depthAspect, 0, 1, 0, 1 };
+        barriers[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        barriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[1].oldLayout = initialized ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_UNDEFINED;
+        barriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[1].image = image;
+        barriers[1].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, getLevelCount(), 0, 1 };
+        barriers[1].srcAccessMask = 0;
+        barriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            static_cast<uint32_t>(barriers.size()), barriers.data());
+        initialized = true;
+
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+
+        // Each level reads the one before it, level 0 the depth buffer
+        BuildParams params{};
+        params.sourceSize = glm::ivec2(depthExtent.width, depthExtent.height);
+        for (uint32_t level = 0; level < getLevelCount(); level++)
+        {
+            params.size = glm::ivec2(std::max(size.width >> level, 1u), std::max(size.height >> level, 1u));
+
+            VkDescriptorSet descriptorSet = level == 0 ? frameDescriptorSets[frameIndex] : levelDescriptorSets[level - 1];
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+            vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(BuildParams), &params);
+            vkCmdDispatch(commandBuffer,
+                (params.size.x + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+                (params.size.y + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+                1);
+
+            // The next level and, after the last one, the culling pass read what was just written
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                0,
+                1, &barrier,
+                0, nullptr,
+                0, nullptr);
+
+            params.sourceSize = params.size;
+        }
+
+        // Back to an attachment for the rest of the frame. Also orders the read before the image is next cleared.
+        VkImageMemoryBarrier depthBarrier = barriers[0];
+        depthBarrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        depthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depthBarrier.srcAccessMask = 0;
+        depthBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &depthBarrier);
+
+        viewProjection = buildViewProjection;
+        valid = true;
+    }
+}
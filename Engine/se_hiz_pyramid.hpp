@@ -0,0 +1,85 @@
+#pragma once
+
+#include "se_device.hpp"
+
+// libs
+#include <glm/glm.hpp>
+
+// std
+#include <vector>
+
+namespace se
+{
+    // Depth pyramid for occlusion culling. Level 0 reduces the depth buffer to the power of two below its size,
+    // every level after it halves the one before, and each texel holds the furthest depth under it.
+    // Built by compute from a depth attachment, sampled with texelFetch in VK_IMAGE_LAYOUT_GENERAL.
+    class HiZPyramid
+    {
+    public:
+        // Throws when the shader is missing or R32_SFLOAT can't be a storage image
+        HiZPyramid(SEDevice& device);
+        ~HiZPyramid();
+
+        HiZPyramid(const HiZPyramid&) = delete;
+        HiZPyramid& operator=(const HiZPyramid&) = delete;
+
+        // Recreates the pyramid when the depth extent changed, waiting for the GPU first.
+        // Returns true when it did, descriptors pointing at getView need rewriting and getVersion moves on.
+        bool prepare(VkExtent2D depthExtent, VkFormat depthFormat);
+        // Records the build, outside a render pass. The depth image is in DEPTH_STENCIL_ATTACHMENT_OPTIMAL with the
+        // draws' writes pending and is left that way. viewProjection is the camera the depth was drawn with.
+        void build(VkCommandBuffer commandBuffer, int frameIndex, VkImage depthImage, VkImageView depthView, const glm::mat4& viewProjection);
+        // For frames that didn't build it, the next test would compare against an old scene
+        void invalidate() { valid = false; }
+
+        bool isValid() const { return valid; }
+        uint64_t getVersion() const { return version; }
+        VkImageView getView() const { return view; }
+        VkSampler getSampler() const { return sampler; }
+        VkExtent2D getSize() const { return size; }
+        uint32_t getLevelCount() const { return static_cast<uint32_t>(levelViews.size()); }
+        const glm::mat4& getViewProjection() const { return viewProjection; }
+
+    private:
+        // Matches the push constant block of hiZBuild.comp
+        struct BuildParams {
+            glm::ivec2 sourceSize;
+            glm::ivec2 size;
+        };
+
+        static constexpr uint32_t WORKGROUP_SIZE = 8;
+
+        void createDescriptorSetLayout();
+        void createPipeline();
+        void createSampler();
+        void createFrameDescriptorSets();
+        void createImage(VkExtent2D depthExtent);
+        void destroyImage();
+        void writeDescriptorSet(VkDescriptorSet descriptorSet, VkImageView source, VkImageLayout sourceLayout, VkImageView destination);
+
+        SEDevice& seDevice;
+        VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkSampler sampler = VK_NULL_HANDLE;
+
+        VkImage image = VK_NULL_HANDLE;
+        DeviceAllocation memory;
+        VkImageView view = VK_NULL_HANDLE;
+        std::vector<VkImageView> levelViews;
+        VkExtent2D depthExtent{ 0, 0 };
+        VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+        VkExtent2D size{ 0, 0 };
+        uint64_t version = 0;
+        // Still in VK_IMAGE_LAYOUT_UNDEFINED until the first build
+        bool initialized = false;
+
+        // Level 0 reads the frame's depth attachment, so each frame in flight rewrites its own set.
+        // Every later level reads the one before it and keeps its set until the pyramid is recreated.
+        std::vector<VkDescriptorSet> frameDescriptorSets;
+        std::vector<VkDescriptorSet> levelDescriptorSets;
+
+        bool valid = false;
+        glm::mat4 viewProjection{ 1.0f };
+    };
+}
@@ -0,0 +1,231 @@
+#include "se_job_system.hpp"
+
+#include <algorithm>
+
+namespace se {
+
+    namespace {
+        // Queue the current thread pushes to and pops from first, 0 for threads outside the pool
+        thread_local size_t currentQueue = 0;
+    }
+
+    JobSystem::JobSystem()
+    {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        // The main thread helps while it waits, so leave its core out
+        startWorkers(hardwareThreads > 1 ? hardwareThreads - 1 : 0);
+    }
+
+    JobSystem::~JobSystem()
+    {
+        stopWorkers();
+    }
+
+    JobHandle JobSystem::createJob(std::function<void()> task)
+    {
+        // Jobs and their continuation lists come from the size class pools, parallelFor creates one per chunk every frame
+        auto job = std::allocate_shared<Job>(memory::SizedAllocator<Job>());
+        job->task = std::move(task);
+        return job;
+    }
+
+    void JobSystem::addDependency(const JobHandle& job, const JobHandle& dependency)
+    {
+        std::lock_guard<std::mutex> lock(dependency->continuationMutex);
+        if (dependency->finished.load(std::memory_order_acquire))
+            return;
+
+        job->pendingDependencies.fetch_add(1, std::memory_order_relaxed);
+        dependency->continuations.push_back(job);
+    }
+
+    void JobSystem::submit(const JobHandle& job)
+    {
+        if (job->pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            enqueue(job);
+    }
+
+    void JobSystem::wait(const JobHandle& job)
+    {
+        while (!job->isFinished()) {
+            // Background jobs left over from before the workers were stopped would never run otherwise
+            if (JobHandle next = findJob(currentQueue, workers.empty()))
+                execute(next);
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    JobHandle JobSystem::runBackground(std::function<void()> task)
+    {
+        JobHandle job = createJob(std::move(task));
+        if (workers.empty()) {
+            execute(job);
+            return job;
+        }
+
+        job->pendingDependencies.store(0, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(backgroundQueue.mutex);
+            backgroundQueue.jobs.pushBack(job);
+        }
+        queuedJobs.fetch_add(1, std::memory_order_release);
+
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        sleepCondition.notify_one();
+        return job;
+    }
+
+    void JobSystem::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& task)
+    {
+        if (count == 0)
+            return;
+
+        grainSize = std::max<size_t>(grainSize, 1);
+        if (count <= grainSize || workers.empty()) {
+            task(0, count);
+            return;
+        }
+
+        // Chunks capture a pointer and their begin only, small enough for std::function to store without allocating
+        struct Range {
+            const std::function<void(size_t, size_t)>* task;
+            size_t count;
+            size_t grainSize;
+        } range{ &task, count, grainSize };
+
+        // Everything waits on one join job so the caller only spins on a single handle
+        JobHandle join = createJob([]() {});
+        for (size_t begin = 0; begin < count; begin += grainSize) {
+            JobHandle chunk = createJob([&range, begin]() {
+                (*range.task)(begin, std::min(begin + range.grainSize, range.count));
+            });
+            addDependency(join, chunk);
+            submit(chunk);
+        }
+        submit(join);
+        wait(join);
+    }
+
+    void JobSystem::setWorkerCount(size_t count)
+    {
+        if (count == workers.size())
+            return;
+
+        stopWorkers();
+        startWorkers(count);
+    }
+
+    void JobSystem::startWorkers(size_t count)
+    {
+        queues.clear();
+        for (size_t i = 0; i < count + 1; i++)
+            queues.push_back(std::make_unique<WorkQueue>());
+
+        running.store(true);
+        for (size_t i = 0; i < count; i++)
+            workers.emplace_back(&JobSystem::workerLoop, this, i + 1);
+    }
+
+    void JobSystem::stopWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            running.store(false);
+        }
+        sleepCondition.notify_all();
+
+        for (auto& worker : workers)
+            worker.join();
+        workers.clear();
+    }
+
+    void JobSystem::workerLoop(size_t queueIndex)
+    {
+        currentQueue = queueIndex;
+
+        while (running.load(std::memory_order_relaxed)) {
+            if (JobHandle job = findJob(queueIndex, true)) {
+                execute(job);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepCondition.wait(lock, [this]() {
+                return !running.load(std::memory_order_relaxed) || queuedJobs.load(std::memory_order_acquire) > 0;
+            });
+        }
+    }
+
+    void JobSystem::enqueue(const JobHandle& job)
+    {
+        WorkQueue& queue = *queues[currentQueue < queues.size() ? currentQueue : 0];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.pushBack(job);
+        }
+        queuedJobs.fetch_add(1, std::memory_order_release);
+
+        // Taking the lock orders this against a worker that checked the count but hasn't slept yet
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        sleepCondition.notify_one();
+    }
+
+    JobHandle JobSystem::findJob(size_t queueIndex, bool background)
+    {
+        // Own queue first, newest job while its data is still in cache
+        {
+            WorkQueue& own = *queues[queueIndex];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.jobs.empty()) {
+                JobHandle job = own.jobs.popBack();
+                queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+                return job;
+            }
+        }
+
+        // Then steal the oldest job from everyone else
+        for (size_t i = 1; i < queues.size(); i++) {
+            WorkQueue& victim = *queues[(queueIndex + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.jobs.empty()) {
+                JobHandle job = victim.jobs.popFront();
+                queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+                return job;
+            }
+        }
+
+        // Oldest first, these are independent and whoever asked is waiting longest on the first
+        if (background) {
+            std::lock_guard<std::mutex> lock(backgroundQueue.mutex);
+            if (!backgroundQueue.jobs.empty()) {
+                JobHandle job = backgroundQueue.jobs.popFront();
+                queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+                return job;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void JobSystem::execute(const JobHandle& job)
+    {
+        job->task();
+        job->task = nullptr;
+
+        decltype(job->continuations) ready;
+        {
+            std::lock_guard<std::mutex> lock(job->continuationMutex);
+            job->finished.store(true, std::memory_order_release);
+            ready.swap(job->continuations);
+        }
+
+        for (auto& continuation : ready)
+            submit(continuation);
+    }
+
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "se_memory.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace se {
+
+    class Job {
+    public:
+        bool isFinished() const { return finished.load(std::memory_order_acquire); }
+
+    private:
+        friend class JobSystem;
+
+        std::function<void()> task;
+        // Starts at 1 for the submit itself, so a job never runs before submit() even if its dependencies are done
+        std::atomic<int> pendingDependencies{ 1 };
+        std::atomic<bool> finished{ false };
+        std::mutex continuationMutex;
+        std::vector<std::shared_ptr<Job>, memory::SizedAllocator<std::shared_ptr<Job>>> continuations;
+    };
+
+    using JobHandle = std::shared_ptr<Job>;
+
+    // Engine wide work stealing thread pool. Every worker owns a queue, it pops its own work from the back
+    // and steals from the front of the others when it runs dry. Threads outside the pool share one extra
+    // queue and help execute jobs while they wait, so a pool with zero workers still makes progress. Background jobs
+    // sit in a queue of their own that only idle workers take from.
+    class JobSystem {
+    public:
+        static JobSystem& getInstance() {
+            static JobSystem instance;
+            return instance;
+        }
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        JobHandle createJob(std::function<void()> task);
+        // job won't start until dependency has finished, must be called before job is submitted
+        void addDependency(const JobHandle& job, const JobHandle& dependency);
+        void submit(const JobHandle& job);
+        // Runs other jobs on the calling thread until job has finished
+        void wait(const JobHandle& job);
+
+        JobHandle run(std::function<void()> task) {
+            JobHandle job = createJob(std::move(task));
+            submit(job);
+            return job;
+        }
+
+        // For long work like file decoding that nothing waits on within a frame. Only workers with nothing else to
+        // do pick it up, so wait() and parallelFor never run it inline on a frame's thread. Runs on the calling
+        // thread right away when there are no workers.
+        JobHandle runBackground(std::function<void()> task);
+
+        // Splits [0, count) into chunks of at most grainSize and blocks until every chunk has run
+        void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& task);
+
+        // Worker threads, the calling thread comes on top of these when it waits
+        size_t getWorkerCount() const { return workers.size(); }
+        // Joins the current workers and starts new ones, only call with no jobs in flight
+        void setWorkerCount(size_t count);
+
+    private:
+        // Ring buffer of handles. It doubles when full and never shrinks, so once a frame's fan-out has been seen
+        // pushing and popping stop touching the heap, unlike std::deque which frees and reallocates its blocks.
+        class JobRing {
+        public:
+            JobRing() : slots(initialCapacity) {}
+
+            bool empty() const { return count == 0; }
+
+            void pushBack(const JobHandle& job) {
+                if (count == slots.size())
+                    grow();
+                slots[(head + count) & (slots.size() - 1)] = job;
+                count++;
+            }
+
+            JobHandle popBack() {
+                count--;
+                return std::move(slots[(head + count) & (slots.size() - 1)]);
+            }
+
+            JobHandle popFront() {
+                JobHandle job = std::move(slots[head]);
+                head = (head + 1) & (slots.size() - 1);
+                count--;
+                return job;
+            }
+
+        private:
+            static constexpr size_t initialCapacity = 256;
+
+            void grow() {
+                std::vector<JobHandle> larger(slots.size() * 2);
+                for (size_t i = 0; i < count; i++)
+                    larger[i] = std::move(slots[(head + i) & (slots.size() - 1)]);
+                slots.swap(larger);
+                head = 0;
+            }
+
+            // Power of two so the wrap is a mask
+            std::vector<JobHandle> slots;
+            size_t head = 0;
+            size_t count = 0;
+        };
+
+        struct WorkQueue {
+            std::mutex mutex;
+            JobRing jobs;
+        };
+
+        JobSystem();
+        ~JobSystem();
+
+        void startWorkers(size_t count);
+        void stopWorkers();
+        void workerLoop(size_t queueIndex);
+
+        void enqueue(const JobHandle& job);
+        // background lets it fall back to the background queue once every other queue is empty
+        JobHandle findJob(size_t queueIndex, bool background);
+        void execute(const JobHandle& job);
+
+        // Queue 0 is shared by threads outside the pool, queue i + 1 belongs to worker i
+        std::vector<std::unique_ptr<WorkQueue>> queues;
+        // Served last and only by workers, kept when the workers are restarted
+        WorkQueue backgroundQueue;
+        std::vector<std::thread> workers;
+
+        // Every queued job, background ones included
+        std::atomic<size_t> queuedJobs{ 0 };
+        std::atomic<bool> running{ false };
+        std::mutex sleepMutex;
+        std::condition_variable sleepCondition;
+    };
+
+}
@@ -0,0 +1,202 @@
+#include "se_memory.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    // Constant initialised, so they are usable by allocations made during static initialisation
+    std::atomic<uint64_t> globalAllocations{ 0 };
+    std::atomic<uint64_t> globalFrees{ 0 };
+    std::atomic<uint64_t> globalBytes{ 0 };
+
+    void* countedAlloc(std::size_t size)
+    {
+        globalAllocations.fetch_add(1, std::memory_order_relaxed);
+        globalBytes.fetch_add(size, std::memory_order_relaxed);
+
+        if (size == 0)
+            size = 1;
+
+        while (true) {
+            if (void* block = std::malloc(size))
+                return block;
+
+            std::new_handler handler = std::get_new_handler();
+            if (!handler)
+                return nullptr;
+            handler();
+        }
+    }
+
+    void countedFree(void* block)
+    {
+        if (!block)
+            return;
+        globalFrees.fetch_add(1, std::memory_order_relaxed);
+        std::free(block);
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    if (void* block = countedAlloc(size))
+        return block;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    if (void* block = countedAlloc(size))
+        return block;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+
+void operator delete(void* block) noexcept { countedFree(block); }
+void operator delete[](void* block) noexcept { countedFree(block); }
+void operator delete(void* block, std::size_t) noexcept { countedFree(block); }
+void operator delete[](void* block, std::size_t) noexcept { countedFree(block); }
+void operator delete(void* block, const std::nothrow_t&) noexcept { countedFree(block); }
+void operator delete[](void* block, const std::nothrow_t&) noexcept { countedFree(block); }
+
+namespace se {
+
+    namespace {
+        constexpr size_t BLOCK_ALIGNMENT = alignof(std::max_align_t);
+        constexpr size_t SIZE_CLASS_STEP = 16;
+        constexpr size_t SIZE_CLASS_COUNT = 32;
+
+        // Pools are heap allocated and never destroyed, objects living in them may be released
+        // by other statics (the scene manager) after this translation unit's statics are gone
+        struct PoolRegistry {
+            std::mutex mutex;
+            std::vector<PoolAllocator*> pools;
+        };
+
+        PoolRegistry& getRegistry()
+        {
+            static PoolRegistry* registry = new PoolRegistry();
+            return *registry;
+        }
+
+        PoolAllocator** getSizeClassPools()
+        {
+            static PoolAllocator** pools = []() {
+                auto** created = new PoolAllocator*[SIZE_CLASS_COUNT];
+                for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+                    size_t size = (i + 1) * SIZE_CLASS_STEP;
+                    created[i] = new PoolAllocator("Sized " + std::to_string(size) + "B", size);
+                }
+                return created;
+            }();
+            return pools;
+        }
+    }
+
+    PoolAllocator::PoolAllocator(const std::string& name, size_t blockSize, size_t blocksPerSlab)
+        : name(name), blocksPerSlab(std::max<size_t>(blocksPerSlab, 1))
+    {
+        // Every block has to hold the freelist link and keep the alignment new would give
+        size_t size = std::max(blockSize, sizeof(FreeBlock));
+        this->blockSize = (size + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT;
+
+        auto& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.pools.push_back(this);
+    }
+
+    PoolAllocator::~PoolAllocator()
+    {
+        {
+            auto& registry = getRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.pools.erase(std::remove(registry.pools.begin(), registry.pools.end(), this), registry.pools.end());
+        }
+
+        for (void* slab : slabs)
+            ::operator delete(slab);
+    }
+
+    void* PoolAllocator::allocate()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (!freeList)
+            addSlab();
+
+        FreeBlock* block = freeList;
+        freeList = block->next;
+        liveBlocks++;
+        totalAllocations++;
+        return block;
+    }
+
+    void PoolAllocator::deallocate(void* block)
+    {
+        if (!block)
+            return;
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto* freed = static_cast<FreeBlock*>(block);
+        freed->next = freeList;
+        freeList = freed;
+        liveBlocks--;
+    }
+
+    void PoolAllocator::addSlab()
+    {
+        char* slab = static_cast<char*>(::operator new(blockSize * blocksPerSlab));
+        slabs.push_back(slab);
+
+        // Thread the new blocks in address order so fresh allocations walk the slab forwards
+        for (size_t i = blocksPerSlab; i-- > 0;) {
+            auto* block = reinterpret_cast<FreeBlock*>(slab + i * blockSize);
+            block->next = freeList;
+            freeList = block;
+        }
+    }
+
+    namespace memory {
+
+        AllocationStats getGlobalStats()
+        {
+            AllocationStats stats;
+            stats.allocations = globalAllocations.load(std::memory_order_relaxed);
+            stats.frees = globalFrees.load(std::memory_order_relaxed);
+            stats.bytesAllocated = globalBytes.load(std::memory_order_relaxed);
+            return stats;
+        }
+
+        void* allocateSized(size_t size)
+        {
+            size_t sizeClass = (std::max<size_t>(size, 1) - 1) / SIZE_CLASS_STEP;
+            if (sizeClass >= SIZE_CLASS_COUNT)
+                return ::operator new(size);
+            return getSizeClassPools()[sizeClass]->allocate();
+        }
+
+        void deallocateSized(void* block, size_t size)
+        {
+            size_t sizeClass = (std::max<size_t>(size, 1) - 1) / SIZE_CLASS_STEP;
+            if (sizeClass >= SIZE_CLASS_COUNT) {
+                ::operator delete(block);
+                return;
+            }
+            getSizeClassPools()[sizeClass]->deallocate(block);
+        }
+
+        void forEachPool(const std::function<void(const PoolAllocator&)>& fn)
+        {
+            auto& registry = getRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            for (const PoolAllocator* pool : registry.pools)
+                fn(*pool);
+        }
+    }
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace se {
+
+    // Fixed size blocks carved out of larger slabs, freed blocks go on an intrusive freelist and get
+    // reused before a new slab is requested. Slabs are only returned to the system when the pool dies.
+    class PoolAllocator {
+    public:
+        PoolAllocator(const std::string& name, size_t blockSize, size_t blocksPerSlab = 64);
+        ~PoolAllocator();
+
+        PoolAllocator(const PoolAllocator&) = delete;
+        PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+        void* allocate();
+        void deallocate(void* block);
+
+        const std::string& getName() const { return name; }
+        size_t getBlockSize() const { return blockSize; }
+        size_t getLiveBlocks() const { return liveBlocks; }
+        size_t getCapacity() const { return slabs.size() * blocksPerSlab; }
+        size_t getSlabCount() const { return slabs.size(); }
+        uint64_t getTotalAllocations() const { return totalAllocations; }
+
+    private:
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        void addSlab();
+
+        std::string name;
+        size_t blockSize;
+        size_t blocksPerSlab;
+
+        std::mutex mutex;
+        FreeBlock* freeList = nullptr;
+        std::vector<void*> slabs;
+        size_t liveBlocks = 0;
+        uint64_t totalAllocations = 0;
+    };
+
+    namespace memory {
+
+        struct AllocationStats {
+            uint64_t allocations = 0;
+            uint64_t frees = 0;
+            uint64_t bytesAllocated = 0;
+        };
+
+        // Everything that went through global operator new/delete since startup
+        AllocationStats getGlobalStats();
+
+        // Size class pools for polymorphic objects such as scripts, anything above the largest class
+        // falls back to the global heap. size must match between allocate and deallocate.
+        void* allocateSized(size_t size);
+        void deallocateSized(void* block, size_t size);
+
+        // Every pool that has been created, in creation order
+        void forEachPool(const std::function<void(const PoolAllocator&)>& fn);
+
+        // Standard allocator on top of the size class pools, for small short lived containers and allocate_shared
+        template <typename T>
+        struct SizedAllocator {
+            using value_type = T;
+
+            SizedAllocator() = default;
+            template <typename U>
+            SizedAllocator(const SizedAllocator<U>&) noexcept {}
+
+            T* allocate(size_t count) { return static_cast<T*>(allocateSized(count * sizeof(T))); }
+            void deallocate(T* block, size_t count) { deallocateSized(block, count * sizeof(T)); }
+
+            template <typename U>
+            bool operator==(const SizedAllocator<U>&) const { return true; }
+            template <typename U>
+            bool operator!=(const SizedAllocator<U>&) const { return false; }
+        };
+    }
+
+}
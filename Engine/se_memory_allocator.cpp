@@ -0,0 +1,610 @@
+#include "se_memory_allocator.hpp"
+
+// std
+#include <algorithm>
+#include <stdexcept>
+
+namespace se
+{
+    namespace
+    {
+        constexpr uint32_t NONE = UINT32_MAX;
+
+        uint32_t highestBit(uint64_t value)
+        {
+            uint32_t bit = 0;
+            while (value >>= 1)
+                bit++;
+            return bit;
+        }
+
+        uint32_t lowestBit(uint64_t value)
+        {
+            uint32_t bit = 0;
+            while ((value & 1) == 0)
+            {
+                value >>= 1;
+                bit++;
+            }
+            return bit;
+        }
+
+        VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        double toMegabytes(VkDeviceSize bytes)
+        {
+            return static_cast<double>(bytes) / (1024.0 * 1024.0);
+        }
+    }
+
+    // One VkDeviceMemory and the strategy that carves it up
+    class MemoryBlock
+    {
+    public:
+        virtual ~MemoryBlock() = default;
+
+        // Offset and node for the allocation, false when nothing fits
+        virtual bool allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset, uint32_t& node) = 0;
+        virtual void free(const DeviceAllocation& allocation) = 0;
+        virtual VkDeviceSize getLargestFreeRange() const = 0;
+
+        bool isEmpty() const { return allocationCount == 0; }
+
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        uint8_t* mapped = nullptr;
+        uint32_t pool = 0;
+        bool dedicated = false;
+        uint32_t allocationCount = 0;
+        VkDeviceSize used = 0;
+    };
+
+    namespace
+    {
+        // Two level segregated fit. The first level splits sizes by power of two, the second splits each power of two
+        // into SECOND_LEVEL_COUNT linear steps, and a bitmap per level finds the first non empty list that is large enough.
+        // Every range is a node linked to its physical neighbours so freeing merges in constant time.
+        class TlsfBlock : public MemoryBlock
+        {
+        public:
+            explicit TlsfBlock(VkDeviceSize blockSize)
+            {
+                size = blockSize;
+                for (auto& lists : freeLists)
+                    std::fill(std::begin(lists), std::end(lists), NONE);
+
+                uint32_t node = createNode();
+                nodes[node].offset = 0;
+                nodes[node].size = blockSize;
+                insertFree(node);
+            }
+
+            bool allocate(VkDeviceSize allocationSize, VkDeviceSize alignment, VkDeviceSize& offset, uint32_t& nodeIndex) override
+            {
+                // Room for the worst case padding, so the first node found always fits
+                uint32_t node = findFree(allocationSize + alignment - 1);
+                if (node == NONE)
+                    return false;
+                removeFree(node);
+
+                // Padding in front of the aligned offset becomes a free range of its own
+                VkDeviceSize aligned = alignUp(nodes[node].offset, alignment);
+                if (aligned != nodes[node].offset)
+                {
+                    uint32_t padding = createNode();
+                    nodes[padding].offset = nodes[node].offset;
+                    nodes[padding].size = aligned - nodes[node].offset;
+                    nodes[padding].prevPhysical = nodes[node].prevPhysical;
+                    nodes[padding].nextPhysical = node;
+                    if (nodes[node].prevPhysical != NONE)
+                        nodes[nodes[node].prevPhysical].nextPhysical = padding;
+                    nodes[node].prevPhysical = padding;
+                    nodes[node].offset = aligned;
+                    nodes[node].size -= nodes[padding].size;
+                    insertFree(padding);
+                }
+
+                if (nodes[node].size > allocationSize)
+                {
+                    uint32_t rest = createNode();
+                    nodes[rest].offset = nodes[node].offset + allocationSize;
+                    nodes[rest].size = nodes[node].size - allocationSize;
+                    nodes[rest].prevPhysical = node;
+                    nodes[rest].nextPhysical = nodes[node].nextPhysical;
+                    if (nodes[node].nextPhysical != NONE)
+                        nodes[nodes[node].nextPhysical].prevPhysical = rest;
+                    nodes[node].nextPhysical = rest;
+                    nodes[node].size = allocationSize;
+                    insertFree(rest);
+                }
+
+                offset = nodes[node].offset;
+                nodeIndex = node;
+                allocationCount++;
+                used += allocationSize;
+                return true;
+            }
+
+            void free(const DeviceAllocation& allocation) override
+            {
+                uint32_t node = allocation.node;
+                allocationCount--;
+                used -= nodes[node].size;
+
+                uint32_t next = nodes[node].nextPhysical;
+                if (next != NONE && nodes[next].free)
+                {
+                    removeFree(next);
+                    nodes[node].size += nodes[next].size;
+                    nodes[node].nextPhysical = nodes[next].nextPhysical;
+                    if (nodes[next].nextPhysical != NONE)
+                        nodes[nodes[next].nextPhysical].prevPhysical = node;
+                    releaseNode(next);
+                }
+
+                uint32_t prev = nodes[node].prevPhysical;
+                if (prev != NONE && nodes[prev].free)
+                {
+                    removeFree(prev);
+                    nodes[prev].size += nodes[node].size;
+                    nodes[prev].nextPhysical = nodes[node].nextPhysical;
+                    if (nodes[node].nextPhysical != NONE)
+                        nodes[nodes[node].nextPhysical].prevPhysical = prev;
+                    releaseNode(node);
+                    node = prev;
+                }
+
+                insertFree(node);
+            }
+
+            VkDeviceSize getLargestFreeRange() const override
+            {
+                if (firstLevelBitmap == 0)
+                    return 0;
+
+                uint32_t firstLevel = highestBit(firstLevelBitmap);
+                uint32_t secondLevel = highestBit(secondLevelBitmaps[firstLevel]);
+                VkDeviceSize largest = 0;
+                for (uint32_t node = freeLists[firstLevel][secondLevel]; node != NONE; node = nodes[node].nextFree)
+                    largest = std::max(largest, nodes[node].size);
+                return largest;
+            }
+
+        private:
+            struct Node
+            {
+                VkDeviceSize offset = 0;
+                VkDeviceSize size = 0;
+                uint32_t prevPhysical = NONE;
+                uint32_t nextPhysical = NONE;
+                uint32_t prevFree = NONE;
+                uint32_t nextFree = NONE;
+                bool free = false;
+            };
+
+            static constexpr uint32_t SECOND_LEVEL_BITS = 5;
+            static constexpr uint32_t SECOND_LEVEL_COUNT = 1u << SECOND_LEVEL_BITS;
+            // Sizes below 1 << SMALL_BITS all map to the first level, split into SECOND_LEVEL_COUNT even steps
+            static constexpr uint32_t SMALL_BITS = 8;
+            static constexpr uint32_t FIRST_LEVEL_COUNT = 64 - SMALL_BITS + 1;
+
+            static void mapping(VkDeviceSize rangeSize, uint32_t& firstLevel, uint32_t& secondLevel)
+            {
+                if (rangeSize < (1ull << SMALL_BITS))
+                {
+                    firstLevel = 0;
+                    secondLevel = static_cast<uint32_t>(rangeSize >> (SMALL_BITS - SECOND_LEVEL_BITS));
+                    return;
+                }
+
+                uint32_t bit = highestBit(rangeSize);
+                firstLevel = bit - SMALL_BITS + 1;
+                secondLevel = static_cast<uint32_t>(rangeSize >> (bit - SECOND_LEVEL_BITS)) - SECOND_LEVEL_COUNT;
+            }
+
+            uint32_t findFree(VkDeviceSize rangeSize) const
+            {
+                // Rounded up to the next list, so anything in the list found is large enough
+                if (rangeSize >= (1ull << SMALL_BITS))
+                    rangeSize += (1ull << (highestBit(rangeSize) - SECOND_LEVEL_BITS)) - 1;
+                else
+                    rangeSize += (1ull << (SMALL_BITS - SECOND_LEVEL_BITS)) - 1;
+
+                uint32_t firstLevel, secondLevel;
+                mapping(rangeSize, firstLevel, secondLevel);
+                if (firstLevel >= FIRST_LEVEL_COUNT)
+                    return NONE;
+
+                uint32_t secondLevelMap = secondLevel < SECOND_LEVEL_COUNT ? secondLevelBitmaps[firstLevel] & (~0u << secondLevel) : 0;
+                if (secondLevelMap == 0)
+                {
+                    uint64_t firstLevelMap = firstLevel + 1 < 64 ? firstLevelBitmap & (~0ull << (firstLevel + 1)) : 0;
+                    if (firstLevelMap == 0)
+                        return NONE;
+
+                    firstLevel = lowestBit(firstLevelMap);
+                    secondLevelMap = secondLevelBitmaps[firstLevel];
+                }
+
+                return freeLists[firstLevel][lowestBit(secondLevelMap)];
+            }
+
+            void insertFree(uint32_t node)
+            {
+                uint32_t firstLevel, secondLevel;
+                mapping(nodes[node].size, firstLevel, secondLevel);
+
+                nodes[node].free = true;
+                nodes[node].prevFree = NONE;
+                nodes[node].nextFree = freeLists[firstLevel][secondLevel];
+                if (nodes[node].nextFree != NONE)
+                    nodes[nodes[node].nextFree].prevFree = node;
+                freeLists[firstLevel][secondLevel] = node;
+
+                firstLevelBitmap |= 1ull << firstLevel;
+                secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+            }
+
+            void removeFree(uint32_t node)
+            {
+                uint32_t firstLevel, secondLevel;
+                mapping(nodes[node].size, firstLevel, secondLevel);
+
+                if (nodes[node].prevFree != NONE)
+                    nodes[nodes[node].prevFree].nextFree = nodes[node].nextFree;
+                else
+                    freeLists[firstLevel][secondLevel] = nodes[node].nextFree;
+                if (nodes[node].nextFree != NONE)
+                    nodes[nodes[node].nextFree].prevFree = nodes[node].prevFree;
+                nodes[node].free = false;
+
+                if (freeLists[firstLevel][secondLevel] == NONE)
+                {
+                    secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+                    if (secondLevelBitmaps[firstLevel] == 0)
+                        firstLevelBitmap &= ~(1ull << firstLevel);
+                }
+            }
+
+            uint32_t createNode()
+            {
+                if (!unusedNodes.empty())
+                {
+                    uint32_t node = unusedNodes.back();
+                    unusedNodes.pop_back();
+                    nodes[node] = Node{};
+                    return node;
+                }
+
+                nodes.emplace_back();
+                return static_cast<uint32_t>(nodes.size() - 1);
+            }
+
+            void releaseNode(uint32_t node)
+            {
+                nodes[node].free = false;
+                unusedNodes.push_back(node);
+            }
+
+            std::vector<Node> nodes;
+            std::vector<uint32_t> unusedNodes;
+            uint64_t firstLevelBitmap = 0;
+            uint32_t secondLevelBitmaps[FIRST_LEVEL_COUNT] = {};
+            uint32_t freeLists[FIRST_LEVEL_COUNT][SECOND_LEVEL_COUNT];
+        };
+
+        // Bump allocator. Freeing the allocation at the top moves it back down, freeing the last one rewinds the block.
+        class LinearBlock : public MemoryBlock
+        {
+        public:
+            explicit LinearBlock(VkDeviceSize blockSize)
+            {
+                size = blockSize;
+            }
+
+            bool allocate(VkDeviceSize allocationSize, VkDeviceSize alignment, VkDeviceSize& offset, uint32_t& node) override
+            {
+                VkDeviceSize aligned = alignUp(top, alignment);
+                if (aligned + allocationSize > size)
+                    return false;
+
+                offset = aligned;
+                node = 0;
+                top = aligned + allocationSize;
+                allocationCount++;
+                used += allocationSize;
+                return true;
+            }
+
+            void free(const DeviceAllocation& allocation) override
+            {
+                allocationCount--;
+                used -= allocation.size;
+                if (allocationCount == 0)
+                    top = 0;
+                else if (allocation.offset + allocation.size == top)
+                    top = allocation.offset;
+            }
+
+            VkDeviceSize getLargestFreeRange() const override
+            {
+                return size - top;
+            }
+
+        private:
+            VkDeviceSize top = 0;
+        };
+    }
+
+    struct MemoryAllocator::Pool
+    {
+        uint32_t index = 0;
+        uint32_t memoryType = 0;
+        Strategy strategy = Strategy::TLSF;
+        bool optimalImages = false;
+        std::vector<std::unique_ptr<MemoryBlock>> blocks;
+    };
+
+    MemoryAllocator::MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice) : device{ device }
+    {
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        bufferImageGranularity = std::max<VkDeviceSize>(properties.limits.bufferImageGranularity, 1);
+        nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+
+        pools.resize(memoryProperties.memoryTypeCount * 4);
+    }
+
+    MemoryAllocator::~MemoryAllocator()
+    {
+        // Whatever is still alive goes with its blocks
+        for (auto& pool : pools)
+        {
+            if (!pool)
+                continue;
+
+            for (auto& block : pool->blocks)
+            {
+                if (block->mapped)
+                    vkUnmapMemory(device, block->memory);
+                vkFreeMemory(device, block->memory, nullptr);
+            }
+        }
+    }
+
+    uint32_t MemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+    {
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+        {
+            if ((typeFilter & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+            {
+                return i;
+            }
+        }
+
+        throw std::runtime_error("failed to find suitable memory type!");
+    }
+
+    VkDeviceSize MemoryAllocator::getBlockSize(uint32_t memoryType) const
+    {
+        VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryType].heapIndex].size;
+        return heapSize <= SMALL_HEAP_SIZE ? alignUp(heapSize / 8, 256) : DEFAULT_BLOCK_SIZE;
+    }
+
+    MemoryAllocator::Pool& MemoryAllocator::getPool(uint32_t memoryType, ResourceType resourceType, Strategy strategy)
+    {
+        // Without a granularity to respect, buffers and optimal images share blocks
+        bool optimalImages = resourceType == ResourceType::OptimalImage && bufferImageGranularity > 1;
+        size_t index = memoryType * 4 + (strategy == Strategy::Linear ? 2 : 0) + (optimalImages ? 1 : 0);
+
+        if (!pools[index])
+        {
+            pools[index] = std::make_unique<Pool>();
+            pools[index]->index = static_cast<uint32_t>(index);
+            pools[index]->memoryType = memoryType;
+            pools[index]->strategy = strategy;
+            pools[index]->optimalImages = optimalImages;
+        }
+        return *pools[index];
+    }
+
+    std::unique_ptr<MemoryBlock> MemoryAllocator::createBlock(Pool& pool, VkDeviceSize size, bool dedicated)
+    {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = pool.memoryType;
+
+        VkDeviceMemory memory;
+        if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+            return nullptr;
+
+        std::unique_ptr<MemoryBlock> block;
+        if (dedicated || pool.strategy == Strategy::Linear)
+            block = std::make_unique<LinearBlock>(size);
+        else
+            block = std::make_unique<TlsfBlock>(size);
+
+        block->memory = memory;
+        block->pool = pool.index;
+        block->dedicated = dedicated;
+
+        if (memoryProperties.memoryTypes[pool.memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        {
+            void* data = nullptr;
+            if (vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &data) != VK_SUCCESS)
+            {
+                vkFreeMemory(device, memory, nullptr);
+                throw std::runtime_error("failed to map device memory block!");
+            }
+            block->mapped = static_cast<uint8_t*>(data);
+        }
+        return block;
+    }
+
+    DeviceAllocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties,
+        ResourceType resourceType, Strategy strategy)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        uint32_t memoryType = findMemoryType(requirements.memoryTypeBits, properties);
+        VkDeviceSize size = requirements.size;
+        VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+
+        // Flushes and invalidates work on whole atoms, keep neighbours out of each other's
+        const VkMemoryPropertyFlags typeFlags = memoryProperties.memoryTypes[memoryType].propertyFlags;
+        if ((typeFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+        {
+            alignment = std::max(alignment, nonCoherentAtomSize);
+            size = alignUp(size, nonCoherentAtomSize);
+        }
+
+        Pool& pool = getPool(memoryType, resourceType, strategy);
+        const VkDeviceSize blockSize = getBlockSize(memoryType);
+
+        MemoryBlock* block = nullptr;
+        VkDeviceSize offset = 0;
+        uint32_t node = 0;
+
+        if (size <= blockSize / 2)
+        {
+            for (auto& candidate : pool.blocks)
+            {
+                if (!candidate->dedicated && candidate->allocate(size, alignment, offset, node))
+                {
+                    block = candidate.get();
+                    break;
+                }
+            }
+
+            if (!block)
+            {
+                if (auto created = createBlock(pool, blockSize, false))
+                {
+                    created->allocate(size, alignment, offset, node);
+                    block = created.get();
+                    pool.blocks.push_back(std::move(created));
+                }
+            }
+        }
+
+        // Too large to share a block, or the heap has no room left for a whole one
+        if (!block)
+        {
+            auto created = createBlock(pool, size, true);
+            if (!created)
+            {
+                throw std::runtime_error("failed to allocate device memory!");
+            }
+            created->allocate(size, 1, offset, node);
+            block = created.get();
+            pool.blocks.push_back(std::move(created));
+        }
+
+        DeviceAllocation allocation;
+        allocation.memory = block->memory;
+        allocation.offset = offset;
+        allocation.size = size;
+        allocation.mapped = block->mapped ? block->mapped + offset : nullptr;
+        allocation.block = block;
+        allocation.node = node;
+        return allocation;
+    }
+
+    void MemoryAllocator::free(DeviceAllocation& allocation)
+    {
+        if (!allocation.block)
+            return;
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        MemoryBlock* block = allocation.block;
+        Pool& pool = *pools[block->pool];
+        block->free(allocation);
+        allocation = DeviceAllocation{};
+
+        if (!block->isEmpty())
+            return;
+
+        // One empty shared block stays around so a resource freed and created every frame doesn't hit the driver
+        bool release = block->dedicated || std::any_of(pool.blocks.begin(), pool.blocks.end(),
+            [&](const std::unique_ptr<MemoryBlock>& other) { return other.get() != block && !other->dedicated && other->isEmpty(); });
+        if (!release)
+            return;
+
+        auto it = std::find_if(pool.blocks.begin(), pool.blocks.end(),
+            [&](const std::unique_ptr<MemoryBlock>& candidate) { return candidate.get() == block; });
+        if (block->mapped)
+            vkUnmapMemory(device, block->memory);
+        vkFreeMemory(device, block->memory, nullptr);
+        pool.blocks.erase(it);
+    }
+
+    std::vector<MemoryAllocator::HeapStats> MemoryAllocator::getHeapStats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        std::vector<HeapStats> heaps(memoryProperties.memoryHeapCount);
+        for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+        {
+            heaps[i].heapSize = memoryProperties.memoryHeaps[i].size;
+            heaps[i].flags = memoryProperties.memoryHeaps[i].flags;
+        }
+
+        for (const auto& pool : pools)
+        {
+            if (!pool)
+                continue;
+
+            HeapStats& heap = heaps[memoryProperties.memoryTypes[pool->memoryType].heapIndex];
+            for (const auto& block : pool->blocks)
+            {
+                if (block->dedicated)
+                    heap.dedicatedCount++;
+                else
+                    heap.blockCount++;
+                heap.allocationCount += block->allocationCount;
+                heap.reserved += block->size;
+                heap.used += block->used;
+                if (!block->dedicated)
+                    heap.largestFreeRange = std::max(heap.largestFreeRange, block->getLargestFreeRange());
+            }
+        }
+        return heaps;
+    }
+
+    void MemoryAllocator::dumpStats(std::ostream& out) const
+    {
+        std::vector<HeapStats> heaps = getHeapStats();
+        for (size_t i = 0; i < heaps.size(); i++)
+        {
+            const HeapStats& heap = heaps[i];
+            out << "[MemoryAllocator] heap " << i << ((heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? " (device local)" : "")
+                << ": " << heap.blockCount << " blocks, " << heap.dedicatedCount << " dedicated, "
+                << heap.allocationCount << " allocations, " << toMegabytes(heap.used) << " of "
+                << toMegabytes(heap.reserved) << " MB used, largest free " << toMegabytes(heap.largestFreeRange)
+                << " MB, heap " << toMegabytes(heap.heapSize) << " MB\n";
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& pool : pools)
+        {
+            if (!pool || pool->blocks.empty())
+                continue;
+
+            out << "  type " << pool->memoryType << (pool->strategy == Strategy::Linear ? " linear" : " tlsf")
+                << (pool->optimalImages ? " images" : "") << ":";
+            for (const auto& block : pool->blocks)
+            {
+                out << " [" << toMegabytes(block->used) << "/" << toMegabytes(block->size) << " MB, "
+                    << block->allocationCount << (block->dedicated ? " dedicated]" : "]");
+            }
+            out << "\n";
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace se
+{
+    class MemoryBlock;
+
+    // A range of a VkDeviceMemory handed out by MemoryAllocator, bind the resource at memory + offset
+    struct DeviceAllocation
+    {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        // Points at offset in the block's persistent mapping, null unless the memory is host visible
+        void* mapped = nullptr;
+
+        // Owned by the allocator, only meaningful to it
+        MemoryBlock* block = nullptr;
+        uint32_t node = 0;
+    };
+
+    // Sub-allocates resources from large VkDeviceMemory blocks, so the driver sees a few allocations instead of one
+    // per resource and maxMemoryAllocationCount stops being a limit. Each memory type has its own pools:
+    //  - TLSF, the general purpose one. Two level segregated free lists find a fitting range in constant time and
+    //    freed ranges merge with their free neighbours.
+    //  - Linear, for short lived allocations like staging buffers. Bump allocates and only reuses space once the
+    //    allocations at the top, or all of them, are freed again.
+    // Buffers and linear images are kept in different blocks than optimal images when bufferImageGranularity asks for
+    // it, requests bigger than half a block get a dedicated VkDeviceMemory. Host visible blocks stay mapped.
+    // Thread safe.
+    class MemoryAllocator
+    {
+    public:
+        enum class Strategy
+        {
+            TLSF,
+            Linear
+        };
+
+        // What the memory is bound to, only optimal tiling images are told apart
+        enum class ResourceType
+        {
+            Buffer,
+            LinearImage,
+            OptimalImage
+        };
+
+        MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice);
+        ~MemoryAllocator();
+
+        MemoryAllocator(const MemoryAllocator&) = delete;
+        MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+        // Throws when no memory type matches or the device is out of memory
+        DeviceAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties,
+            ResourceType resourceType, Strategy strategy = Strategy::TLSF);
+        // Resets allocation, freeing an empty one does nothing
+        void free(DeviceAllocation& allocation);
+
+        struct HeapStats
+        {
+            VkDeviceSize heapSize = 0;
+            VkMemoryHeapFlags flags = 0;
+            uint32_t blockCount = 0;
+            uint32_t dedicatedCount = 0;
+            uint32_t allocationCount = 0;
+            // Bytes in VkDeviceMemory allocations, and the part of them handed out
+            VkDeviceSize reserved = 0;
+            VkDeviceSize used = 0;
+            VkDeviceSize largestFreeRange = 0;
+        };
+
+        std::vector<HeapStats> getHeapStats() const;
+        // One line per heap, then one per pool with its blocks
+        void dumpStats(std::ostream& out) const;
+
+    private:
+        struct Pool;
+
+        Pool& getPool(uint32_t memoryType, ResourceType resourceType, Strategy strategy);
+        std::unique_ptr<MemoryBlock> createBlock(Pool& pool, VkDeviceSize size, bool dedicated);
+        VkDeviceSize getBlockSize(uint32_t memoryType) const;
+        uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+        VkDevice device;
+        VkPhysicalDeviceMemoryProperties memoryProperties{};
+        VkDeviceSize bufferImageGranularity = 1;
+        VkDeviceSize nonCoherentAtomSize = 1;
+
+        // By memory type, then by strategy and whether it holds optimal images
+        std::vector<std::unique_ptr<Pool>> pools;
+        mutable std::mutex mutex;
+
+        static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+        // Heaps up to this size, like the 256MB device local host visible window, get an eighth of it per block
+        static constexpr VkDeviceSize SMALL_HEAP_SIZE = 1024ull * 1024 * 1024;
+    };
+}
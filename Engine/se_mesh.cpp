@@ -9,17 +9,35 @@ namespace se
     {
         auto submesh = std::make_unique<SESubMesh>(device, builder);
         seSubmeshes.push_back(std::move(submesh));
+        computeBounds();
     }
 
     SEMesh::SEMesh(SEDevice& device, std::vector<std::unique_ptr<SESubMesh>> submeshes, const std::string& guid, const std::string& name) : seDevice{ device }, Resource(guid, name)
     {
         this->seSubmeshes = std::move(submeshes);
+        computeBounds();
     }
 
     SEMesh::~SEMesh()
     {
     }
 
+    void SEMesh::computeBounds()
+    {
+        for (const auto& submesh : seSubmeshes)
+            bounds.expand(submesh->getBounds());
+
+        if (!bounds.isValid())
+            return;
+
+        boundingSphere.center = bounds.getCenter();
+        for (const auto& submesh : seSubmeshes)
+        {
+            const auto& sphere = submesh->getBoundingSphere();
+            boundingSphere.radius = std::max(boundingSphere.radius, glm::length(sphere.center - boundingSphere.center) + sphere.radius);
+        }
+    }
+
     // Helper function to replace all backslashes with forward slashes
     static void replaceBackslashes(std::string& str)
     {
@@ -205,22 +223,31 @@ namespace se
         */
 
 
-    void SEMesh::draw(
+    uint32_t SEMesh::draw(
         VkCommandBuffer commandBuffer,
-        VkPipelineLayout pipelineLayout,
         std::shared_ptr<SEMaterial> goMaterial,
-        SimplePushConstantData push,
-		int  frameIndex
+		int  frameIndex,
+        uint32_t firstInstance,
+        const uint8_t* submeshVisible
         )
     {
+        uint32_t drawCount = 0;
+
         if (goMaterial)
         {
             goMaterial->update(frameIndex);
             goMaterial->bind(commandBuffer, frameIndex);
         }
 
-        for (auto& submesh : seSubmeshes)
+        for (size_t i = 0; i < seSubmeshes.size(); i++)
         {
+            auto& submesh = seSubmeshes[i];
+            if (submeshVisible && !submeshVisible[i])
+                continue;
+            // Still uploading, drawn from the frame its upload is ready
+            if (!submesh->isReady() || (submesh->hasMaterial() && !submesh->getMaterial()->isReady()))
+                continue;
+
             if (submesh->hasMaterial())
             {
                 submesh->updateMaterial(frameIndex);
@@ -231,17 +258,11 @@ namespace se
                 continue;
 
             submesh->bind(commandBuffer);
-
-            vkCmdPushConstants(
-                commandBuffer,
-                pipelineLayout,
-                VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-                0,
-                sizeof(SimplePushConstantData),
-                &push);
-
-            submesh->draw(commandBuffer);
+            submesh->draw(commandBuffer, 1, firstInstance);
+            drawCount++;
         }
+
+        return drawCount;
     }
 
 
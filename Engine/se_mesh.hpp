@@ -42,6 +42,15 @@ namespace se
 			return seSubmeshes.size();
 		}
 
+		const SESubMesh& getSubMesh(size_t index) const
+		{
+			return *seSubmeshes[index];
+		}
+
+		// Union of the submesh bounds in object space
+		const AABB& getBounds() const { return bounds; }
+		const BoundingSphere& getBoundingSphere() const { return boundingSphere; }
+
         size_t getVerticesCount() const
         {
 			size_t count = 0;
@@ -69,12 +78,20 @@ namespace se
         //void bind(VkCommandBuffer commandBuffer);
         std::vector<std::unique_ptr<SESubMesh>> loadMesh(SEDevice &device, const std::string &path, VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout);
 
-		void draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, std::shared_ptr<SEMaterial> goMaterial, SimplePushConstantData push, int frameIndex);
+		// Draws every submesh as instance firstInstance, the transform is read from the renderer's instance buffer.
+		// submeshVisible, when given, holds one flag per submesh and culled submeshes are skipped.
+		// Returns the number of draw calls recorded.
+		uint32_t draw(VkCommandBuffer commandBuffer, std::shared_ptr<SEMaterial> goMaterial, int frameIndex, uint32_t firstInstance, const uint8_t* submeshVisible = nullptr);
 
     private:
+        void computeBounds();
+
         SEDevice &seDevice;
         //std::shared_ptr<SEMaterial> seMaterial = nullptr;
         std::vector<std::unique_ptr<SESubMesh>> seSubmeshes;
+
+        AABB bounds;
+        BoundingSphere boundingSphere;
     };
 
 } // namespace se
@@ -25,6 +25,10 @@ namespace se
 
         std::vector<std::unique_ptr<SESubMesh>> submeshes;
         std::vector<std::shared_ptr<SEMaterial>> materials;
+
+        // Every submesh of the asset is staged together and submitted once, when the scope ends. Textures follow in
+        // TextureSystem::update, batched with whatever else finished decoding by then.
+        UploadManager::ImportScope importScope(seDevice.getUploadManager());
  
 		if (pScene->HasMeshes())
 		{
@@ -55,43 +59,51 @@ namespace se
                     seMaterial->setRoughness(roughness);
                     seMaterial->setAO(1.0f);
 
+                    // Textures decode on the job system, the material shades with the dummy texture until each one is ready
+                    std::weak_ptr<se::SEMaterial> weakMaterial = seMaterial;
+                    std::string textureGuid = guid + "_texture_" + std::to_string(i);
+                    std::string textureName = name + "_texture_" + std::to_string(i);
+                    auto requestTexture = [&](const aiString& texturePath, void (se::SEMaterial::*setTexture)(std::shared_ptr<se::SETexture>))
+                    {
+                        std::shared_ptr<se::SETexture> placeholder = textureSystem->requestTexture(textureGuid, textureName, base_path + texturePath.C_Str(),
+                            [weakMaterial, setTexture](std::shared_ptr<se::SETexture> texture)
+                            {
+                                if (auto material = weakMaterial.lock())
+                                    ((*material).*setTexture)(texture);
+                            });
+                        ((*seMaterial).*setTexture)(placeholder);
+                    };
+
                     aiString diffuseTexturePath, normalTexturePath, specularTexturePath, roughnessTexturePath, aoTexturePath;
                     if (material->GetTexture(aiTextureType_DIFFUSE, 0, &diffuseTexturePath, nullptr, nullptr, nullptr, nullptr, nullptr) == aiReturn_SUCCESS)
                     {
-                        std::shared_ptr<se::SETexture> diffuseTexture = textureSystem->loadTexture(guid + "_texture_" + std::to_string(i), name + "_texture_" + std::to_string(i), base_path + diffuseTexturePath.C_Str());
-                        seMaterial->setDiffuseTexture(diffuseTexture);
+                        requestTexture(diffuseTexturePath, &se::SEMaterial::setDiffuseTexture);
                     }
                     if (material->GetTexture(aiTextureType_NORMALS, 0, &normalTexturePath, nullptr, nullptr, nullptr, nullptr, nullptr) == aiReturn_SUCCESS)
                     {
-                        std::shared_ptr<se::SETexture> normalTexture = textureSystem->loadTexture(guid + "_texture_" + std::to_string(i), name + "_texture_" + std::to_string(i), base_path + normalTexturePath.C_Str());
-                        seMaterial->setNormalTexture(normalTexture);
+                        requestTexture(normalTexturePath, &se::SEMaterial::setNormalTexture);
                     }
                     
                     if (material->GetTexture(aiTextureType_METALNESS, 0, &specularTexturePath, nullptr, nullptr, nullptr, nullptr, nullptr) == aiReturn_SUCCESS)
                     {
-                        std::shared_ptr<se::SETexture> specularTexture = textureSystem->loadTexture(guid + "_texture_" + std::to_string(i), name + "_texture_" + std::to_string(i), base_path + specularTexturePath.C_Str());
-						seMaterial->setMetallicTexture(specularTexture);
+                        requestTexture(specularTexturePath, &se::SEMaterial::setMetallicTexture);
                     }
                     else if(material->GetTexture(aiTextureType_SPECULAR, 0, &specularTexturePath, nullptr, nullptr, nullptr, nullptr, nullptr) == aiReturn_SUCCESS)
                     {
-                        std::shared_ptr<se::SETexture> specularTexture = textureSystem->loadTexture(guid + "_texture_" + std::to_string(i), name + "_texture_" + std::to_string(i), base_path + specularTexturePath.C_Str());
-                        seMaterial->setMetallicTexture(specularTexture);
+                        requestTexture(specularTexturePath, &se::SEMaterial::setMetallicTexture);
                     }
                     if (material->GetTexture(aiTextureType_DIFFUSE_ROUGHNESS, 0, &roughnessTexturePath, nullptr, nullptr, nullptr, nullptr, nullptr) == aiReturn_SUCCESS)
                     {
-                        std::shared_ptr<se::SETexture> roughnessTexture = textureSystem->loadTexture(guid + "_texture_" + std::to_string(i), name + "_texture_" + std::to_string(i), base_path + roughnessTexturePath.C_Str());
-                        seMaterial->setRoughnessTexture(roughnessTexture);
+                        requestTexture(roughnessTexturePath, &se::SEMaterial::setRoughnessTexture);
                     }
                     else if (material->GetTexture(aiTextureType_SHININESS, 0, &roughnessTexturePath, nullptr, nullptr, nullptr, nullptr, nullptr) == aiReturn_SUCCESS)
                     {
-                        std::shared_ptr<se::SETexture> roughnessTexture = textureSystem->loadTexture(guid + "_texture_" + std::to_string(i), name + "_texture_" + std::to_string(i), base_path + roughnessTexturePath.C_Str());
-						seMaterial->setRoughnessTexture(roughnessTexture);
+                        requestTexture(roughnessTexturePath, &se::SEMaterial::setRoughnessTexture);
                     }
                     
                     if (material->GetTexture(aiTextureType_AMBIENT, 0, &aoTexturePath, nullptr, nullptr, nullptr, nullptr, nullptr) == aiReturn_SUCCESS)
                     {
-                        std::shared_ptr<se::SETexture> aoTexture = textureSystem->loadTexture(guid + "_texture_" + std::to_string(i), name + "_texture_" + std::to_string(i), base_path + aoTexturePath.C_Str());
-						seMaterial->setAOTexture(aoTexture);
+                        requestTexture(aoTexturePath, &se::SEMaterial::setAOTexture);
                     }
                     
 
@@ -131,6 +143,7 @@ namespace se
 			}
 			auto newMesh = std::make_shared<se::SEMesh>(seDevice, std::move(submeshes), guid, name);
 			meshes[guid] = newMesh;
+
 			return newMesh;
 		}
 
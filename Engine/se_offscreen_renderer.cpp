@@ -11,15 +11,12 @@ namespace se
         vkDestroyRenderPass(seDevice.device(), renderPass, nullptr);
 
         vkDestroyImageView(seDevice.device(), colorImageView, nullptr);
-        vkDestroyImage(seDevice.device(), colorImage, nullptr);
-        vkFreeMemory(seDevice.device(), colorImageMemory, nullptr);
+        seDevice.destroyImage(colorImage, colorImageMemory);
 
         vkDestroyImageView(seDevice.device(), depthImageView, nullptr);
-        vkDestroyImage(seDevice.device(), depthImage, nullptr);
-        vkFreeMemory(seDevice.device(), depthImageMemory, nullptr);
+        seDevice.destroyImage(depthImage, depthImageMemory);
 
-        vkDestroyBuffer(seDevice.device(), stagingBuffer, nullptr);
-        vkFreeMemory(seDevice.device(), stagingBufferMemory, nullptr);
+        seDevice.destroyBuffer(stagingBuffer, stagingBufferMemory);
 
         freeCommandBuffers();
     }
@@ -36,15 +33,12 @@ namespace se
         vkDestroyRenderPass(seDevice.device(), renderPass, nullptr);
 
         vkDestroyImageView(seDevice.device(), colorImageView, nullptr);
-        vkDestroyImage(seDevice.device(), colorImage, nullptr);
-        vkFreeMemory(seDevice.device(), colorImageMemory, nullptr);
+        seDevice.destroyImage(colorImage, colorImageMemory);
 
         vkDestroyImageView(seDevice.device(), depthImageView, nullptr);
-        vkDestroyImage(seDevice.device(), depthImage, nullptr);
-        vkFreeMemory(seDevice.device(), depthImageMemory, nullptr);
+        seDevice.destroyImage(depthImage, depthImageMemory);
 
-        vkDestroyBuffer(seDevice.device(), stagingBuffer, nullptr);
-        vkFreeMemory(seDevice.device(), stagingBufferMemory, nullptr);
+        seDevice.destroyBuffer(stagingBuffer, stagingBufferMemory);
 
         freeCommandBuffers();
 
@@ -67,15 +61,12 @@ namespace se
         vkDestroyRenderPass(seDevice.device(), renderPass, nullptr);
 
         vkDestroyImageView(seDevice.device(), colorImageView, nullptr);
-        vkDestroyImage(seDevice.device(), colorImage, nullptr);
-        vkFreeMemory(seDevice.device(), colorImageMemory, nullptr);
+        seDevice.destroyImage(colorImage, colorImageMemory);
 
         vkDestroyImageView(seDevice.device(), depthImageView, nullptr);
-        vkDestroyImage(seDevice.device(), depthImage, nullptr);
-        vkFreeMemory(seDevice.device(), depthImageMemory, nullptr);
+        seDevice.destroyImage(depthImage, depthImageMemory);
 
-        vkDestroyBuffer(seDevice.device(), stagingBuffer, nullptr);
-        vkFreeMemory(seDevice.device(), stagingBufferMemory, nullptr);
+        seDevice.destroyBuffer(stagingBuffer, stagingBufferMemory);
 
         freeCommandBuffers();
 
@@ -254,30 +245,12 @@ namespace se
     void SEOffscreenRenderer::createStagingBuffer() {
         VkDeviceSize bufferSize = width * height * 4; // Assuming 4 bytes per pixel (RGBA8)
 
-        VkBufferCreateInfo bufferInfo{};
-        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        bufferInfo.size = bufferSize;
-        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-        if (vkCreateBuffer(seDevice.device(), &bufferInfo, nullptr, &stagingBuffer) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create staging buffer!");
-        }
-
-        VkMemoryRequirements memRequirements;
-        vkGetBufferMemoryRequirements(seDevice.device(), stagingBuffer, &memRequirements);
-
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = seDevice.findMemoryType(memRequirements.memoryTypeBits,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-        if (vkAllocateMemory(seDevice.device(), &allocInfo, nullptr, &stagingBufferMemory) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to allocate staging buffer memory!");
-        }
-
-        vkBindBufferMemory(seDevice.device(), stagingBuffer, stagingBufferMemory, 0);
+        seDevice.createBuffer(
+            bufferSize,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            stagingBuffer,
+            stagingBufferMemory);
     }
 
 
@@ -36,7 +36,7 @@ namespace se
 		VkImage getDepthImage() { return depthImage; }
 		VkImage getColorImage() { return colorImage; }
 		VkBuffer getStagingBuffer() { return stagingBuffer; }
-		VkDeviceMemory getStagingBufferMemory() { return stagingBufferMemory; }
+		const DeviceAllocation& getStagingBufferMemory() const { return stagingBufferMemory; }
 
 
 	private:
@@ -63,14 +63,14 @@ namespace se
 		VkRenderPass renderPass;
 
 		VkImage depthImage;
-		VkDeviceMemory depthImageMemory;
+		DeviceAllocation depthImageMemory;
 		VkImageView depthImageView;
 		VkImage colorImage;
 		VkImageView colorImageView;
-		VkDeviceMemory colorImageMemory;
+		DeviceAllocation colorImageMemory;
 
 		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
+		DeviceAllocation stagingBufferMemory;
 	
 
 
@@ -1,4 +1,8 @@
 #include "se_pbr.hpp"
+#include "se_render_stats.hpp"
+#include "se_render_settings.hpp"
+#include "se_simd.hpp"
+#include "se_job_system.hpp"
 
 // libs
 #define GLM_FORCE_RADIANS
@@ -7,18 +11,27 @@
 #include <glm/gtc/constants.hpp>
 
 // std
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <chrono>
+#include <iostream>
 #include <stdexcept>
 
 namespace se
 {
     PBR::PBR(SEDevice& device, VkRenderPass renderPass, SECubemap& cubemap)
-        : seDevice{ device }, seCubemap{ cubemap }
+        : seDevice{ device }, seCubemap{ cubemap }, renderPass{ renderPass }
     {
         createGlobalDescriptorSetLayout();
         createMaterialDescriptorSetLayout();
-        createUniformBuffer();
+        createInstanceBuffers();
+        clusteredLighting = std::make_unique<ClusteredLighting>(seDevice);
+        shadowMaps = std::make_unique<ShadowMaps>(seDevice);
+        if (getRenderSettings().clusteredLighting)
+            createClusteredLighting();
+        if (getRenderSettings().shadows)
+            createShadows();
         createDescriptorSets();
         createPipelineLayout();
         createPipeline(renderPass);
@@ -26,6 +39,9 @@ namespace se
 
     PBR::~PBR()
     {
+        for (auto& instanceBuffer : instanceBuffers)
+            seDevice.destroyBuffer(instanceBuffer.buffer, instanceBuffer.allocation);
+
         vkDestroyDescriptorSetLayout(seDevice.device(), globalDescriptorSetLayout, nullptr);
         vkDestroyDescriptorSetLayout(seDevice.device(), materialDescriptorSetLayout, nullptr);
         vkDestroyPipelineLayout(seDevice.device(), pipelineLayout, nullptr);
@@ -33,11 +49,6 @@ namespace se
 
     void PBR::createPipelineLayout()
     {
-        VkPushConstantRange pushConstantRange{};
-        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-        pushConstantRange.offset = 0;
-        pushConstantRange.size = sizeof(SimplePushConstantData);
-
         std::vector<VkDescriptorSetLayout> descriptorSetLayouts = {
         globalDescriptorSetLayout,   // Set 0: Global (UBO)
         materialDescriptorSetLayout  // Set 1: Material (Textures, Properties)
@@ -47,8 +58,8 @@ namespace se
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
         pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-        pipelineLayoutInfo.pushConstantRangeCount = 1;
-        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        pipelineLayoutInfo.pushConstantRangeCount = 0;
+        pipelineLayoutInfo.pPushConstantRanges = nullptr;
         if (vkCreatePipelineLayout(seDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) !=
             VK_SUCCESS)
         {
@@ -104,10 +115,90 @@ namespace se
         VkDescriptorSetLayoutBinding lightsLayoutBinding{};
         lightsLayoutBinding.binding = 3;
         lightsLayoutBinding.descriptorCount = 1;
-        lightsLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        lightsLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         lightsLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
         bindings.push_back(lightsLayoutBinding);
+
+        VkDescriptorSetLayoutBinding instancesLayoutBinding{};
+        instancesLayoutBinding.binding = 4;
+        instancesLayoutBinding.descriptorCount = 1;
+        instancesLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        instancesLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+        bindings.push_back(instancesLayoutBinding);
+
+        VkDescriptorSetLayoutBinding visibleLayoutBinding{};
+        visibleLayoutBinding.binding = 5;
+        visibleLayoutBinding.descriptorCount = 1;
+        visibleLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        visibleLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+        bindings.push_back(visibleLayoutBinding);
+
+        VkDescriptorSetLayoutBinding transformsLayoutBinding{};
+        transformsLayoutBinding.binding = 6;
+        transformsLayoutBinding.descriptorCount = 1;
+        transformsLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        transformsLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+        bindings.push_back(transformsLayoutBinding);
+
+        VkDescriptorSetLayoutBinding clusterParamsLayoutBinding{};
+        clusterParamsLayoutBinding.binding = 7;
+        clusterParamsLayoutBinding.descriptorCount = 1;
+        clusterParamsLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        clusterParamsLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        bindings.push_back(clusterParamsLayoutBinding);
+
+        VkDescriptorSetLayoutBinding lightCountsLayoutBinding{};
+        lightCountsLayoutBinding.binding = 8;
+        lightCountsLayoutBinding.descriptorCount = 1;
+        lightCountsLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        lightCountsLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        bindings.push_back(lightCountsLayoutBinding);
+
+        VkDescriptorSetLayoutBinding lightIndicesLayoutBinding{};
+        lightIndicesLayoutBinding.binding = 9;
+        lightIndicesLayoutBinding.descriptorCount = 1;
+        lightIndicesLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        lightIndicesLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        bindings.push_back(lightIndicesLayoutBinding);
+
+        VkDescriptorSetLayoutBinding cascadeShadowLayoutBinding{};
+        cascadeShadowLayoutBinding.binding = 10;
+        cascadeShadowLayoutBinding.descriptorCount = 1;
+        cascadeShadowLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        cascadeShadowLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        bindings.push_back(cascadeShadowLayoutBinding);
+
+        VkDescriptorSetLayoutBinding atlasShadowLayoutBinding{};
+        atlasShadowLayoutBinding.binding = 11;
+        atlasShadowLayoutBinding.descriptorCount = 1;
+        atlasShadowLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        atlasShadowLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        bindings.push_back(atlasShadowLayoutBinding);
+
+        VkDescriptorSetLayoutBinding shadowParamsLayoutBinding{};
+        shadowParamsLayoutBinding.binding = 12;
+        shadowParamsLayoutBinding.descriptorCount = 1;
+        shadowParamsLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        shadowParamsLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        bindings.push_back(shadowParamsLayoutBinding);
+
+        VkDescriptorSetLayoutBinding cameraLayoutBinding{};
+        cameraLayoutBinding.binding = 13;
+        cameraLayoutBinding.descriptorCount = 1;
+        cameraLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        cameraLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+        bindings.push_back(cameraLayoutBinding);
         
 
         // Descriptor set layout create info
@@ -131,7 +222,7 @@ namespace se
         VkDescriptorSetLayoutBinding uboLayoutBinding{};
         uboLayoutBinding.binding = 0;
         uboLayoutBinding.descriptorCount = 1;
-        uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         uboLayoutBinding.pImmutableSamplers = nullptr;
         uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
         bindings.push_back(uboLayoutBinding);
@@ -140,7 +231,7 @@ namespace se
         VkDescriptorSetLayoutBinding matLayoutBinding{};
         matLayoutBinding.binding = 1;
         matLayoutBinding.descriptorCount = 1;
-        matLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        matLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         matLayoutBinding.pImmutableSamplers = nullptr;
         matLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
         bindings.push_back(matLayoutBinding);
@@ -199,36 +290,48 @@ namespace se
         }
     }
 
-    void PBR::createUniformBuffer()
+    void PBR::createInstanceBuffers()
     {
-        VkDeviceSize bufferSize = sizeof(se::LightUBO);
-
         size_t framesInFlight = SESwapChain::MAX_FRAMES_IN_FLIGHT;
-        lightBuffers.resize(framesInFlight);
-
+        instanceBuffers.resize(framesInFlight);
+        instanceCapacities.resize(framesInFlight, 0);
         for (size_t i = 0; i < framesInFlight; i++)
-        {
-            seDevice.createBuffer(
-                bufferSize,
-                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                lightBuffers[i].buffer,
-                lightBuffers[i].memory);
+            createInstanceBuffer(i, MIN_INSTANCE_CAPACITY);
+    }
 
-            VkResult result = vkMapMemory(seDevice.device(), lightBuffers[i].memory, 0, bufferSize, 0, &lightBuffers[i].mapped);
-            if (result != VK_SUCCESS)
-            {
-                throw std::runtime_error("Failed to map uniform buffer memory!");
-            }
+    void PBR::createInstanceBuffer(size_t frameIndex, size_t capacity)
+    {
+        Buffer& instanceBuffer = instanceBuffers[frameIndex];
+        VkDeviceSize bufferSize = sizeof(InstanceData) * capacity;
 
-        }
+        seDevice.createBuffer(
+            bufferSize,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            instanceBuffer.buffer,
+            instanceBuffer.allocation);
+        instanceBuffer.mapped = instanceBuffer.allocation.mapped;
+
+        instanceCapacities[frameIndex] = capacity;
+    }
+
+    void PBR::reserveInstances(int frameIndex, size_t count)
+    {
+        if (count <= instanceCapacities[frameIndex])
+            return;
+
+        // The frame's previous submission has finished once beginFrame returned, so its buffer can go
+        Buffer& instanceBuffer = instanceBuffers[frameIndex];
+        seDevice.destroyBuffer(instanceBuffer.buffer, instanceBuffer.allocation);
+
+        createInstanceBuffer(frameIndex, std::max(count, instanceCapacities[frameIndex] * 2));
+        updateDescriptorSet(frameIndex);
     }
 
     void PBR::createDescriptorSets()
     {
         size_t framesInFlight = SESwapChain::MAX_FRAMES_IN_FLIGHT;
         descriptorSets.resize(framesInFlight);
-        needUpdate.resize(framesInFlight, false);
 
         for (size_t i = 0; i < framesInFlight; i++)
         {
@@ -255,7 +358,7 @@ namespace se
     void PBR::updateDescriptorSet(size_t frameIndex)
     {
         // Descriptor writes array
-        std::vector<VkWriteDescriptorSet> descriptorWrites(4);
+        std::vector<VkWriteDescriptorSet> descriptorWrites(12);
 
         // Diffuse texture descriptor
         VkDescriptorImageInfo diffuseImageInfo{};
@@ -304,67 +407,812 @@ namespace se
 
         
         VkDescriptorBufferInfo lightBufferInfo{};
-        lightBufferInfo.buffer = lightBuffers[frameIndex].buffer;
+        lightBufferInfo.buffer = clusteredLighting->getLightBuffer(static_cast<int>(frameIndex));
         lightBufferInfo.offset = 0;
-        lightBufferInfo.range = sizeof(LightUBO);
+        lightBufferInfo.range = VK_WHOLE_SIZE;
 
         descriptorWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         descriptorWrites[3].dstSet = descriptorSets[frameIndex];
         descriptorWrites[3].dstBinding = 3;
-        descriptorWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descriptorWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         descriptorWrites[3].descriptorCount = 1;
         descriptorWrites[3].pBufferInfo = &lightBufferInfo;
+
+        VkDescriptorBufferInfo instanceBufferInfo{};
+        instanceBufferInfo.buffer = instanceBuffers[frameIndex].buffer;
+        instanceBufferInfo.offset = 0;
+        instanceBufferInfo.range = VK_WHOLE_SIZE;
+
+        descriptorWrites[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[4].dstSet = descriptorSets[frameIndex];
+        descriptorWrites[4].dstBinding = 4;
+        descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[4].descriptorCount = 1;
+        descriptorWrites[4].pBufferInfo = &instanceBufferInfo;
+
+        // Bound with globalDynamicOffsets[0] as the dynamic offset
+        VkDescriptorBufferInfo clusterParamsInfo{};
+        clusterParamsInfo.buffer = seDevice.getFrameAllocator().getBuffer();
+        clusterParamsInfo.offset = 0;
+        clusterParamsInfo.range = sizeof(ClusterParams);
+
+        descriptorWrites[5].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[5].dstSet = descriptorSets[frameIndex];
+        descriptorWrites[5].dstBinding = 7;
+        descriptorWrites[5].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        descriptorWrites[5].descriptorCount = 1;
+        descriptorWrites[5].pBufferInfo = &clusterParamsInfo;
+
+        VkDescriptorBufferInfo lightCountsInfo{};
+        lightCountsInfo.buffer = clusteredLighting->getLightCountBuffer(static_cast<int>(frameIndex));
+        lightCountsInfo.offset = 0;
+        lightCountsInfo.range = VK_WHOLE_SIZE;
+
+        descriptorWrites[6].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[6].dstSet = descriptorSets[frameIndex];
+        descriptorWrites[6].dstBinding = 8;
+        descriptorWrites[6].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[6].descriptorCount = 1;
+        descriptorWrites[6].pBufferInfo = &lightCountsInfo;
+
+        VkDescriptorBufferInfo lightIndicesInfo{};
+        lightIndicesInfo.buffer = clusteredLighting->getLightIndexBuffer(static_cast<int>(frameIndex));
+        lightIndicesInfo.offset = 0;
+        lightIndicesInfo.range = VK_WHOLE_SIZE;
+
+        descriptorWrites[7].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[7].dstSet = descriptorSets[frameIndex];
+        descriptorWrites[7].dstBinding = 9;
+        descriptorWrites[7].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[7].descriptorCount = 1;
+        descriptorWrites[7].pBufferInfo = &lightIndicesInfo;
+
+        VkDescriptorImageInfo cascadeShadowInfo{};
+        cascadeShadowInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        cascadeShadowInfo.imageView = shadowMaps->getCascadeView();
+        cascadeShadowInfo.sampler = shadowMaps->getSampler();
+
+        descriptorWrites[8].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[8].dstSet = descriptorSets[frameIndex];
+        descriptorWrites[8].dstBinding = 10;
+        descriptorWrites[8].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrites[8].descriptorCount = 1;
+        descriptorWrites[8].pImageInfo = &cascadeShadowInfo;
+
+        VkDescriptorImageInfo atlasShadowInfo{};
+        atlasShadowInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        atlasShadowInfo.imageView = shadowMaps->getAtlasView();
+        atlasShadowInfo.sampler = shadowMaps->getSampler();
+
+        descriptorWrites[9].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[9].dstSet = descriptorSets[frameIndex];
+        descriptorWrites[9].dstBinding = 11;
+        descriptorWrites[9].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrites[9].descriptorCount = 1;
+        descriptorWrites[9].pImageInfo = &atlasShadowInfo;
+
+        // Bound with globalDynamicOffsets[1] as the dynamic offset
+        VkDescriptorBufferInfo shadowParamsInfo{};
+        shadowParamsInfo.buffer = seDevice.getFrameAllocator().getBuffer();
+        shadowParamsInfo.offset = 0;
+        shadowParamsInfo.range = sizeof(ShadowParams);
+
+        descriptorWrites[10].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[10].dstSet = descriptorSets[frameIndex];
+        descriptorWrites[10].dstBinding = 12;
+        descriptorWrites[10].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        descriptorWrites[10].descriptorCount = 1;
+        descriptorWrites[10].pBufferInfo = &shadowParamsInfo;
+
+        // Bound with globalDynamicOffsets[2], the same block the materials bind for pbrVert
+        VkDescriptorBufferInfo cameraInfo{};
+        cameraInfo.buffer = seDevice.getFrameAllocator().getBuffer();
+        cameraInfo.offset = 0;
+        cameraInfo.range = sizeof(UniformBufferObject);
+
+        descriptorWrites[11].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[11].dstSet = descriptorSets[frameIndex];
+        descriptorWrites[11].dstBinding = 13;
+        descriptorWrites[11].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        descriptorWrites[11].descriptorCount = 1;
+        descriptorWrites[11].pBufferInfo = &cameraInfo;
+
+        // Only the indirect pipeline reads these, so they stay unwritten until the GPU path has buffers for this frame
+        VkDescriptorBufferInfo visibleBufferInfo{};
+        VkDescriptorBufferInfo transformBufferInfo{};
+        if (gpuCulling && gpuCulling->getVisibleBuffer(static_cast<int>(frameIndex)) != VK_NULL_HANDLE)
+        {
+            visibleBufferInfo.buffer = gpuCulling->getVisibleBuffer(static_cast<int>(frameIndex));
+            visibleBufferInfo.offset = 0;
+            visibleBufferInfo.range = VK_WHOLE_SIZE;
+
+            transformBufferInfo.buffer = gpuCulling->getTransformBuffer(static_cast<int>(frameIndex));
+            transformBufferInfo.offset = 0;
+            transformBufferInfo.range = VK_WHOLE_SIZE;
+
+            VkWriteDescriptorSet visibleWrite{};
+            visibleWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            visibleWrite.dstSet = descriptorSets[frameIndex];
+            visibleWrite.dstBinding = 5;
+            visibleWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            visibleWrite.descriptorCount = 1;
+            visibleWrite.pBufferInfo = &visibleBufferInfo;
+            descriptorWrites.push_back(visibleWrite);
+
+            VkWriteDescriptorSet transformWrite = visibleWrite;
+            transformWrite.dstBinding = 6;
+            transformWrite.pBufferInfo = &transformBufferInfo;
+            descriptorWrites.push_back(transformWrite);
+        }
         
         // Update only the descriptors that are written (ignoring empty ones)
         vkUpdateDescriptorSets(seDevice.device(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
     }
     
-    void PBR::updateLightsBuffer(int frameIndex, std::vector<Light> lights) {
-        if (!needUpdate[frameIndex]) return;
+    void PBR::updateLightsBuffer(Scene& scene, int frameIndex) {
+        scene.updateLights();
+
+        // Shadow slots go into the packed lights, so they ride along with this frame's dirty ranges
+        const bool lightsChanged = lightScene != &scene || !scene.getDirtyLightRanges().empty();
+        shadowMaps->assignLights(scene, lightsChanged);
+
+        // Static lights leave no dirty ranges, so this is a no-op until something changes
+        if (lightScene != &scene) {
+            lightScene = &scene;
+            clusteredLighting->markAllLightsDirty();
+        }
+        else if (!scene.getDirtyLightRanges().empty()) {
+            clusteredLighting->markLightsDirty(scene.getDirtyLightRanges());
+        }
+        scene.clearDirtyLightRanges();
+
+        const auto& lights = scene.getPackedLights();
+        lightCount = static_cast<uint32_t>(std::min<size_t>(lights.size(), MAX_LIGHTS));
+
+        auto& stats = getRenderStats();
+        stats.lights += lightCount;
+        stats.lightsUploaded += clusteredLighting->uploadLights(frameIndex, lights);
+    }
+
+    void PBR::updateClusters(SERenderer& renderer, VkCommandBuffer commandBuffer, Scene& scene, int frameIndex)
+    {
+        const bool clustered = getRenderSettings().clusteredLighting;
+        ClusterParams params = ClusteredLighting::makeParams(scene.getCamera(), renderer.getSwapChainExtent(), lightCount, clustered);
+        globalDynamicOffsets[0] = seDevice.getFrameAllocator().upload(params);
 
-        LightUBO ubo{};
-        ubo.lightCount = static_cast<int>(lights.size());
-        std::memcpy(ubo.lights, lights.data(), sizeof(Light) * lights.size());
+        if (clustered)
+            clusteredLighting->dispatch(commandBuffer, frameIndex, globalDynamicOffsets[0]);
+    }
 
-        std::memcpy(lightBuffers[frameIndex].mapped, &ubo, sizeof(LightUBO));
+    void PBR::updateShadows(VkCommandBuffer commandBuffer, Scene& scene, int frameIndex)
+    {
+        if (shadowMaps->prepare())
+        {
+            for (size_t i = 0; i < descriptorSets.size(); i++)
+                updateDescriptorSet(i);
+        }
 
-        needUpdate[frameIndex] = false;
+        shadowMaps->render(commandBuffer, frameIndex, scene);
+        globalDynamicOffsets[1] = seDevice.getFrameAllocator().upload(shadowMaps->getParams());
     }
 
     void PBR::renderGameObjects(
+        SERenderer& renderer,
         VkCommandBuffer commandBuffer,
-        const std::list<std::unique_ptr<se::SEGameObject>>& gameObjects,
+        Scene& scene,
         int frameIndex) 
     {
-        
-		std::vector<Light> lights;
-		for (auto& obj : gameObjects)
-		{
-			if (obj->hasLight()) {
-				const auto& transform = obj->getTransform();
-				Light light = obj->getLight();
-                light.direction = transform.rotation;
-                light.position = transform.translation;
-				lights.push_back(light);
-			}
-		}
-		needUpdate[frameIndex] = true;
-        updateLightsBuffer(frameIndex, lights);
-        
-        for (auto& obj : gameObjects)
+        auto recordStart = std::chrono::high_resolution_clock::now();
+
+        prepassActive = getRenderSettings().depthPrepass && createDepthPrepass();
+
+        if (gpuFramePrepared && occlusionFramePrepared)
+        {
+            for (const auto& batch : gpuBatches)
+                batch.material->update(frameIndex);
+
+            // First what last frame's pyramid let through, then what the retest against this frame's depth adds
+            renderer.prepareSecondaryCommandBuffers(2);
+            for (uint32_t phase = 0; phase < 2; phase++)
+            {
+                VkCommandBuffer secondary = renderer.beginSecondaryCommandBuffer(phase);
+                recordIndirectDraws(secondary, frameIndex, phase == 1);
+                renderer.endSecondaryCommandBuffer(secondary);
+            }
+
+            renderer.executeSecondaryCommandBuffers(commandBuffer, 1);
+            renderer.suspendSwapChainRenderPass(commandBuffer);
+            hiZ->build(commandBuffer, frameIndex, renderer.getCurrentDepthImage(), renderer.getCurrentDepthImageView(), cullViewProjection);
+            gpuCulling->dispatchOcclusion(commandBuffer, frameIndex, Frustum(cullViewProjection), 2);
+            renderer.resumeSwapChainRenderPass(commandBuffer);
+            renderer.executeSecondaryCommandBuffers(commandBuffer, 1, 1);
+
+            gpuFramePrepared = false;
+            occlusionFramePrepared = false;
+        }
+        else if (gpuFramePrepared)
+        {
+            for (const auto& batch : gpuBatches)
+                batch.material->update(frameIndex);
+
+            // A handful of batches, not worth splitting
+            renderer.prepareSecondaryCommandBuffers(1);
+            VkCommandBuffer secondary = renderer.beginSecondaryCommandBuffer(0);
+            recordIndirectDraws(secondary, frameIndex, false);
+            renderer.endSecondaryCommandBuffer(secondary);
+            renderer.executeSecondaryCommandBuffers(commandBuffer, 1);
+            gpuFramePrepared = false;
+        }
+        else
+        {
+            cullGameObjects(scene);
+            recordDraws(renderer, commandBuffer, scene, frameIndex);
+        }
+
+        getRenderStats().recordTimeMs += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - recordStart).count();
+    }
+
+    void PBR::prepareFrame(SERenderer& renderer, VkCommandBuffer commandBuffer, Scene& scene, int frameIndex)
+    {
+        globalDynamicOffsets[2] = seDevice.getCameraUniformOffset();
+        // Either can be switched back on from the editor after failing
+        if (getRenderSettings().clusteredLighting)
+            createClusteredLighting();
+        if (getRenderSettings().shadows)
+            createShadows();
+        updateLightsBuffer(scene, frameIndex);
+        updateClusters(renderer, commandBuffer, scene, frameIndex);
+        updateShadows(commandBuffer, scene, frameIndex);
+
+        gpuFramePrepared = false;
+        occlusionFramePrepared = false;
+        if (!getRenderSettings().gpuDriven || !createGpuCulling())
+        {
+            // The CPU path draws straight through, whatever the pyramid holds is out of date by the time it is back
+            if (hiZ)
+                hiZ->invalidate();
+            return;
+        }
+
+        auto prepareStart = std::chrono::high_resolution_clock::now();
+
+        // Submeshes left out while uploading are added once their uploads are ready
+        const uint64_t uploadsReady = seDevice.getUploadManager().getReadyValue();
+        if (gpuScene != &scene || gpuStructureVersion != scene.getStructureVersion()
+            || (gpuPendingUploads && gpuUploadsReady != uploadsReady))
+            rebuildGpuBatches(scene);
+
+        if (gpuCulling->prepare(frameIndex, scene))
+            updateDescriptorSet(frameIndex);
+
+        const SECamera& camera = scene.getCamera();
+        cullViewProjection = camera.getProjection() * camera.getView();
+        if (getRenderSettings().occlusionCulling && createOcclusionCulling())
+        {
+            hiZ->prepare(renderer.getSwapChainExtent(), renderer.getDepthFormat());
+            gpuCulling->prepareOcclusion(frameIndex, *hiZ, cullViewProjection);
+            gpuCulling->dispatchOcclusion(commandBuffer, frameIndex, Frustum(cullViewProjection), 1);
+            occlusionFramePrepared = true;
+        }
+        else
         {
-            auto mesh = obj->getMesh();
-            if (!mesh) continue;
+            if (hiZ)
+                hiZ->invalidate();
+            gpuCulling->dispatch(commandBuffer, frameIndex, Frustum(cullViewProjection));
+        }
+        gpuFramePrepared = true;
 
-            se::SimplePushConstantData push{};
-            push.transform = obj->getTransformMat4();
+        // Visible and occluded counts come back a few frames late, submitted is this frame's
+        auto& stats = getRenderStats();
+        const uint32_t submitted = static_cast<uint32_t>(gpuCulling->getInstanceCount());
+        const uint32_t visible = std::min(gpuCulling->getVisibleCount(), submitted);
+        const uint32_t occluded = std::min(gpuCulling->getOccludedCount(), submitted - visible);
+        stats.objectsSubmitted += submitted;
+        stats.objectsCulled += submitted - visible - occluded;
+        stats.objectsOccluded += occluded;
+        stats.instances += visible;
+        stats.recordTimeMs += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - prepareStart).count();
+    }
 
-            bind(commandBuffer, frameIndex);
+    bool PBR::createGpuCulling()
+    {
+        if (gpuCulling)
+            return true;
 
-            auto material = obj->getMaterial();
-                
-            mesh->draw(commandBuffer, pipelineLayout, material, push, frameIndex);
+        try
+        {
+            PipelineConfigInfo pipelineConfig{};
+            SEPipeline::defaultPipelineConfigInfo(pipelineConfig);
+            pipelineConfig.renderPass = renderPass;
+            pipelineConfig.pipelineLayout = pipelineLayout;
+            indirectPipeline = std::make_unique<SEPipeline>(
+                seDevice,
+                "shaders/pbrIndirectVert.spv",
+                "shaders/pbrFrag.spv",
+                pipelineConfig,
+                VK_SAMPLE_COUNT_1_BIT);
+
+            gpuCulling = std::make_unique<GPUCulling>(seDevice);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "[PBR] GPU driven rendering unavailable: " << e.what() << "\n";
+            indirectPipeline.reset();
+            getRenderSettings().gpuDriven = false;
+            return false;
+        }
+
+        gpuScene = nullptr;
+        return true;
+    }
+
+    bool PBR::createOcclusionCulling()
+    {
+        if (hiZ)
+            return true;
+
+        try
+        {
+            gpuCulling->createOcclusionPipeline();
+            hiZ = std::make_unique<HiZPyramid>(seDevice);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "[PBR] occlusion culling unavailable: " << e.what() << "\n";
+            getRenderSettings().occlusionCulling = false;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool PBR::createClusteredLighting()
+    {
+        if (clusteredLighting->hasPipeline())
+            return true;
+
+        try
+        {
+            clusteredLighting->createPipeline();
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "[PBR] clustered lighting unavailable: " << e.what() << "\n";
+            getRenderSettings().clusteredLighting = false;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool PBR::createShadows()
+    {
+        if (shadowMaps->hasPipeline())
+            return true;
+
+        try
+        {
+            shadowMaps->createPipeline();
         }
+        catch (const std::exception& e)
+        {
+            std::cerr << "[PBR] shadows unavailable: " << e.what() << "\n";
+            getRenderSettings().shadows = false;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool PBR::createDepthPrepass()
+    {
+        if (depthPipeline)
+            return true;
+
+        auto createVariant = [&](const std::string& vertFilepath, const std::string& fragFilepath, bool depthOnly) {
+            PipelineConfigInfo pipelineConfig{};
+            SEPipeline::defaultPipelineConfigInfo(pipelineConfig);
+            pipelineConfig.renderPass = renderPass;
+            pipelineConfig.pipelineLayout = pipelineLayout;
+            if (depthOnly)
+            {
+                // 12 byte position stream in, depth out, the color attachment is left alone
+                pipelineConfig.bindingDescriptions = Vertex::getPositionBindingDescriptions();
+                pipelineConfig.attributeDescriptions = Vertex::getPositionAttributeDescriptions();
+                pipelineConfig.colorBlendAttachment.colorWriteMask = 0;
+            }
+            else
+            {
+                // Only the surface the pre-pass kept gets shaded
+                pipelineConfig.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_EQUAL;
+                pipelineConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+            }
+            return std::make_unique<SEPipeline>(seDevice, vertFilepath, fragFilepath, pipelineConfig, VK_SAMPLE_COUNT_1_BIT);
+        };
+
+        try
+        {
+            // shadowFrag is an empty fragment shader, all the pre-pass needs
+            depthPipeline = createVariant("shaders/pbrDepthVert.spv", "shaders/shadowFrag.spv", true);
+            equalPipeline = createVariant("shaders/pbrVert.spv", "shaders/pbrFrag.spv", false);
+            indirectDepthPipeline = createVariant("shaders/pbrDepthIndirectVert.spv", "shaders/shadowFrag.spv", true);
+            indirectEqualPipeline = createVariant("shaders/pbrIndirectVert.spv", "shaders/pbrFrag.spv", false);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "[PBR] depth pre-pass unavailable: " << e.what() << "\n";
+            depthPipeline.reset();
+            equalPipeline.reset();
+            indirectDepthPipeline.reset();
+            indirectEqualPipeline.reset();
+            getRenderSettings().depthPrepass = false;
+            return false;
+        }
+
+        return true;
+    }
+
+    void PBR::rebuildGpuBatches(Scene& scene)
+    {
+        const auto& meshes = scene.getMeshes();
+        const auto& materials = scene.getMaterials();
+        const size_t count = scene.getObjectCount();
+
+        // Same resolution as recordDraws, minus the depth. The indirect commands are indexed, so are the submeshes.
+        gpuPendingUploads = false;
+        gpuUploadsReady = seDevice.getUploadManager().getReadyValue();
+        drawItems.clear();
+        renderQueue.clear();
+        for (size_t i = 0; i < count; i++)
+        {
+            if (!meshes[i]) continue;
+
+            for (size_t s = 0; s < meshes[i]->getSubMeshCount(); s++)
+            {
+                const SESubMesh& submesh = meshes[i]->getSubMesh(s);
+                SEMaterial* material = submesh.hasMaterial() ? submesh.getMaterial().get() : materials[i].get();
+                if (!material || submesh.getIndicesCount() == 0)
+                    continue;
+                if (!submesh.isReady() || !material->isReady())
+                {
+                    gpuPendingUploads = true;
+                    continue;
+                }
+
+                uint64_t key = RenderQueue::makeKey(
+                    0,
+                    RenderQueue::hashId(material, RenderQueue::MATERIAL_BITS),
+                    RenderQueue::hashId(&submesh, RenderQueue::MESH_BITS),
+                    0.0f);
+
+                renderQueue.push(key, static_cast<uint32_t>(drawItems.size()));
+                drawItems.push_back({ VK_NULL_HANDLE, material, &submesh, static_cast<uint32_t>(i) });
+            }
+        }
+
+        renderQueue.sort();
+
+        gpuBatches.clear();
+        gpuCulling->clearBatches();
+        for (size_t q = 0; q < renderQueue.size(); q++)
+        {
+            const DrawItem& item = drawItems[renderQueue[q]];
+            if (gpuBatches.empty() || gpuBatches.back().material != item.material || gpuBatches.back().submesh != item.submesh)
+            {
+                gpuBatches.push_back({ item.material, item.submesh });
+                gpuCulling->addBatch(item.submesh->getGeometry());
+            }
+            gpuCulling->addInstance(item.object);
+        }
+
+        gpuScene = &scene;
+        gpuStructureVersion = scene.getStructureVersion();
+    }
+
+    void PBR::recordIndirectDraws(VkCommandBuffer commandBuffer, int frameIndex, bool secondPhase)
+    {
+        // Every pipeline shares the layout, so set 0 stays bound from the pre-pass into the shading pass
+        auto& stats = getRenderStats();
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[frameIndex], 3, globalDynamicOffsets);
+        stats.descriptorSetBinds++;
+
+        if (gpuBatches.empty())
+            return;
+
+        // Every submesh is in the geometry arena, the depth only pass draws all batches in one range
+        GeometryArena& geometryArena = seDevice.getGeometryArena();
+        if (prepassActive)
+        {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, indirectDepthPipeline->getPipeline());
+            stats.pipelineBinds++;
+            geometryArena.bindPositions(commandBuffer);
+            stats.vertexBufferBinds++;
+
+            stats.prepassDrawCalls += gpuCulling->drawRange(commandBuffer, frameIndex, 0, static_cast<uint32_t>(gpuBatches.size()), secondPhase);
+        }
+
+        // Materials keep their descriptor sets but every batch goes through the indirect pipeline
+        VkPipeline shadingPipeline = prepassActive ? indirectEqualPipeline->getPipeline() : indirectPipeline->getPipeline();
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, shadingPipeline);
+        stats.pipelineBinds++;
+        geometryArena.bind(commandBuffer);
+        stats.vertexBufferBinds++;
+
+        // Batches are sorted by material, each run of one material is a single range
+        uint32_t runBegin = 0;
+        while (runBegin < gpuBatches.size())
+        {
+            SEMaterial* material = gpuBatches[runBegin].material;
+            uint32_t runEnd = runBegin + 1;
+            while (runEnd < gpuBatches.size() && gpuBatches[runEnd].material == material)
+                runEnd++;
+
+            material->bind(commandBuffer, frameIndex);
+            stats.descriptorSetBinds++;
+            stats.drawCalls += gpuCulling->drawRange(commandBuffer, frameIndex, runBegin, runEnd - runBegin, secondPhase);
+            runBegin = runEnd;
+        }
+    }
+
+    void PBR::recordDraws(SERenderer& renderer, VkCommandBuffer commandBuffer, Scene& scene, int frameIndex)
+    {
+        const auto& worldMatrices = scene.getWorldMatrices();
+        const auto& worldBounds = scene.getWorldBounds();
+        const auto& meshes = scene.getMeshes();
+        const auto& materials = scene.getMaterials();
+        const glm::vec3 cameraPosition = scene.getCamera().getTransform().translation;
+
+        // One item per visible submesh that has something to shade it with, the submesh's own material wins
+        drawItems.clear();
+        renderQueue.clear();
+        for (size_t v = 0; v < visibleObjects.size(); v++)
+        {
+            const uint32_t i = visibleObjects[v];
+            const auto& mesh = meshes[i];
+            const uint8_t* visibleSubmeshes = submeshOffsets[v] == NO_SUBMESH_CULLING ? nullptr : submeshVisible.data() + submeshOffsets[v];
+            const float depth = glm::length(worldBounds[i].getCenter() - cameraPosition) / SORT_DEPTH_RANGE;
+
+            for (size_t s = 0; s < mesh->getSubMeshCount(); s++)
+            {
+                if (visibleSubmeshes && !visibleSubmeshes[s])
+                    continue;
+
+                const SESubMesh& submesh = mesh->getSubMesh(s);
+                SEMaterial* material = submesh.hasMaterial() ? submesh.getMaterial().get() : materials[i].get();
+                if (!material || !submesh.isReady() || !material->isReady())
+                    continue;
+
+                VkPipeline pipeline = material->getPipeline() != VK_NULL_HANDLE ? material->getPipeline() : sePipeline->getPipeline();
+
+                uint64_t key = RenderQueue::makeKey(
+                    RenderQueue::hashId(pipeline, RenderQueue::PIPELINE_BITS),
+                    RenderQueue::hashId(material, RenderQueue::MATERIAL_BITS),
+                    RenderQueue::hashId(&submesh, RenderQueue::MESH_BITS),
+                    depth);
+
+                renderQueue.push(key, static_cast<uint32_t>(drawItems.size()));
+                drawItems.push_back({ pipeline, material, &submesh, i });
+            }
+        }
+
+        renderQueue.sort();
+
+        // Transforms land in the instance buffer in queue order. With instancing every run of equal
+        // (pipeline, material, submesh) becomes one batch, front to back inside the run.
+        const bool instancing = getRenderSettings().instancing;
+        reserveInstances(frameIndex, renderQueue.size());
+        auto* instances = static_cast<InstanceData*>(instanceBuffers[frameIndex].mapped);
+
+        instanceBatches.clear();
+        for (size_t q = 0; q < renderQueue.size(); q++)
+        {
+            const DrawItem& item = drawItems[renderQueue[q]];
+            instances[q].transform = worldMatrices[item.object];
+
+            bool extendsBatch = instancing && !instanceBatches.empty()
+                && instanceBatches.back().pipeline == item.pipeline
+                && instanceBatches.back().material == item.material
+                && instanceBatches.back().submesh == item.submesh;
+            if (!extendsBatch)
+                instanceBatches.push_back({ item.pipeline, item.material, item.submesh, static_cast<uint32_t>(q), 0 });
+            instanceBatches.back().instanceCount++;
+        }
+
+        // Descriptor writes have to happen before the sets are bound, and before any thread records
+        for (const auto& batch : instanceBatches)
+            batch.material->update(frameIndex);
+
+        auto& stats = getRenderStats();
+        stats.drawCalls += static_cast<uint32_t>(instanceBatches.size());
+        stats.instances += static_cast<uint32_t>(renderQueue.size());
+        if (instanceBatches.empty())
+            return;
+
+        auto& jobSystem = JobSystem::getInstance();
+        size_t threads = getRenderSettings().recordThreads;
+        if (threads == 0)
+            threads = jobSystem.getWorkerCount() + 1;
+        const size_t maxChunks = (instanceBatches.size() + MIN_BATCHES_PER_CHUNK - 1) / MIN_BATCHES_PER_CHUNK;
+        const size_t chunkCount = std::max<size_t>(1, std::min(threads, maxChunks));
+
+        // Chunks are contiguous ranges of the sorted batches, so each secondary keeps most of the bind elision.
+        // With the pre-pass every chunk is recorded twice, depth only into the first chunkCount secondaries
+        // and shaded into the ones after them, so all of the depth is down before anything is shaded.
+        const size_t slotCount = prepassActive ? chunkCount * 2 : chunkCount;
+        renderer.prepareSecondaryCommandBuffers(static_cast<uint32_t>(slotCount));
+        chunkStats.assign(slotCount, RenderStats{});
+        auto recordSlot = [&](size_t slot) {
+            const size_t chunk = slot % chunkCount;
+            size_t begin = instanceBatches.size() * chunk / chunkCount;
+            size_t end = instanceBatches.size() * (chunk + 1) / chunkCount;
+            VkCommandBuffer secondary = renderer.beginSecondaryCommandBuffer(static_cast<uint32_t>(slot));
+            if (prepassActive && slot < chunkCount)
+                recordDepthBatches(secondary, frameIndex, begin, end, chunkStats[slot]);
+            else
+                recordBatches(secondary, frameIndex, begin, end, chunkStats[slot]);
+            renderer.endSecondaryCommandBuffer(secondary);
+        };
+
+        if (slotCount == 1)
+        {
+            recordSlot(0);
+        }
+        else
+        {
+            jobSystem.parallelFor(slotCount, 1, [&](size_t begin, size_t end) {
+                for (size_t slot = begin; slot < end; slot++)
+                    recordSlot(slot);
+            });
+        }
+
+        renderer.executeSecondaryCommandBuffers(commandBuffer, static_cast<uint32_t>(slotCount));
+
+        for (const auto& chunk : chunkStats)
+        {
+            stats.pipelineBinds += chunk.pipelineBinds;
+            stats.descriptorSetBinds += chunk.descriptorSetBinds;
+            stats.vertexBufferBinds += chunk.vertexBufferBinds;
+            stats.prepassDrawCalls += chunk.prepassDrawCalls;
+        }
+    }
+
+    void PBR::recordBatches(VkCommandBuffer commandBuffer, int frameIndex, size_t begin, size_t end, RenderStats& stats) const
+    {
+        // Every pipeline shares this layout, so set 0 stays bound across pipeline switches
+        VkPipeline boundPipeline = VK_NULL_HANDLE;
+        const SEMaterial* boundMaterial = nullptr;
+        bool geometryBound = false;
+        bool globalSetBound = false;
+
+        // Batches the pre-pass drew are shaded against its depth, any other pipeline keeps its own depth test
+        const VkPipeline opaquePipeline = sePipeline->getPipeline();
+
+        for (size_t b = begin; b < end; b++)
+        {
+            const InstanceBatch& batch = instanceBatches[b];
+            const VkPipeline pipeline = prepassActive && batch.pipeline == opaquePipeline ? equalPipeline->getPipeline() : batch.pipeline;
+            if (pipeline != boundPipeline)
+            {
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+                boundPipeline = pipeline;
+                stats.pipelineBinds++;
+            }
+            if (!globalSetBound)
+            {
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[frameIndex], 3, globalDynamicOffsets);
+                globalSetBound = true;
+                stats.descriptorSetBinds++;
+            }
+            if (batch.material != boundMaterial)
+            {
+                batch.material->bind(commandBuffer, frameIndex);
+                boundMaterial = batch.material;
+                stats.descriptorSetBinds++;
+            }
+            // Every submesh shares the arena's buffers, draws only differ in their offsets
+            if (!geometryBound)
+            {
+                batch.submesh->bind(commandBuffer);
+                geometryBound = true;
+                stats.vertexBufferBinds++;
+            }
+
+            batch.submesh->draw(commandBuffer, batch.instanceCount, batch.firstInstance);
+        }
+    }
+
+    void PBR::recordDepthBatches(VkCommandBuffer commandBuffer, int frameIndex, size_t begin, size_t end, RenderStats& stats) const
+    {
+        const VkPipeline opaquePipeline = sePipeline->getPipeline();
+        bool pipelineBound = false;
+
+        for (size_t b = begin; b < end; b++)
+        {
+            const InstanceBatch& batch = instanceBatches[b];
+            if (batch.pipeline != opaquePipeline)
+                continue;
+
+            if (!pipelineBound)
+            {
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, depthPipeline->getPipeline());
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[frameIndex], 3, globalDynamicOffsets);
+                batch.submesh->bindPositions(commandBuffer);
+                pipelineBound = true;
+                stats.pipelineBinds++;
+                stats.descriptorSetBinds++;
+                stats.vertexBufferBinds++;
+            }
+
+            batch.submesh->draw(commandBuffer, batch.instanceCount, batch.firstInstance);
+            stats.prepassDrawCalls++;
+        }
+    }
+
+    void PBR::cullGameObjects(Scene& scene)
+    {
+        const auto& worldMatrices = scene.getWorldMatrices();
+        const auto& worldBounds = scene.getWorldBounds();
+        const auto& meshes = scene.getMeshes();
+        const size_t count = scene.getObjectCount();
+
+        const SECamera& camera = scene.getCamera();
+        const Frustum frustum(camera.getProjection() * camera.getView());
+
+        cullCandidates.clear();
+        cullCenters.clear();
+        cullExtents.clear();
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (!meshes[i]) continue;
+
+            // World bounds are kept up to date by the scene alongside its spatial index
+            cullCandidates.push_back(static_cast<uint32_t>(i));
+            cullCenters.push_back(worldBounds[i].getCenter());
+            cullExtents.push_back(worldBounds[i].getExtents());
+        }
+
+        cullVisible.resize(cullCandidates.size());
+        size_t visibleCount = simd::cullBoxes(frustum.planes, cullCenters.data(), cullExtents.data(), cullVisible.data(), cullCandidates.size());
+
+        // Second pass over the submeshes of the objects that survived, single submesh meshes reuse the object test
+        visibleObjects.clear();
+        submeshOffsets.clear();
+        cullCenters.clear();
+        cullExtents.clear();
+
+        for (size_t c = 0; c < cullCandidates.size(); c++)
+        {
+            if (!cullVisible[c]) continue;
+
+            const uint32_t i = cullCandidates[c];
+            const auto& mesh = meshes[i];
+            visibleObjects.push_back(i);
+
+            if (mesh->getSubMeshCount() < 2)
+            {
+                submeshOffsets.push_back(NO_SUBMESH_CULLING);
+                continue;
+            }
+
+            submeshOffsets.push_back(static_cast<uint32_t>(cullCenters.size()));
+            for (size_t s = 0; s < mesh->getSubMeshCount(); s++)
+            {
+                glm::vec3 center, extents;
+                mesh->getSubMesh(s).getBounds().transform(worldMatrices[i], center, extents);
+                cullCenters.push_back(center);
+                cullExtents.push_back(extents);
+            }
+        }
+
+        submeshVisible.resize(cullCenters.size());
+        size_t visibleSubmeshes = simd::cullBoxes(frustum.planes, cullCenters.data(), cullExtents.data(), submeshVisible.data(), cullCenters.size());
+
+        auto& stats = getRenderStats();
+        stats.objectsSubmitted += static_cast<uint32_t>(cullCandidates.size());
+        stats.objectsCulled += static_cast<uint32_t>(cullCandidates.size() - visibleCount);
+        stats.submeshesTested += static_cast<uint32_t>(cullCenters.size());
+        stats.submeshesCulled += static_cast<uint32_t>(cullCenters.size() - visibleSubmeshes);
     }
 
     void PBR::renderCubeMap(VkCommandBuffer commandBuffer)
@@ -2,9 +2,16 @@
 
 #include "se_camera.hpp"
 #include "se_device.hpp"
-#include "se_gameobject.hpp"
+#include "se_scene.hpp"
 #include "se_cubemap.hpp"
 #include "se_pipeline.hpp"
+#include "se_bounds.hpp"
+#include "se_render_queue.hpp"
+#include "se_gpu_culling.hpp"
+#include "se_hiz_pyramid.hpp"
+#include "se_clustered_lighting.hpp"
+#include "se_shadow_maps.hpp"
+#include "se_render_stats.hpp"
 
 // std
 #include <memory>
@@ -12,20 +19,6 @@
 
 namespace se
 {
-	constexpr int MAX_LIGHTS = 100;
-
-    struct alignas(16) LightUBO {
-        alignas(4) int lightCount;
-        alignas(16) glm::vec3 padding;
-        alignas(16) Light lights[MAX_LIGHTS];
-    };
-
-    struct Buffer {
-        VkBuffer buffer;
-        VkDeviceMemory memory;
-        void* mapped;
-    };
-
     class PBR
     {
     public:
@@ -40,37 +33,65 @@ namespace se
 		VkPipelineLayout getPipelineLayout() { return pipelineLayout; }
         VkPipeline getPipeline() { return sePipeline->getPipeline(); }
 
-        void renderGameObjects(VkCommandBuffer commandBuffer, const std::list<std::unique_ptr<se::SEGameObject>>& gameObjects, int frameIndex);
+        // Uploads the lights, bins them into the light clusters and renders the shadow maps that are due, and culls on the GPU while
+        // RenderSettings::gpuDriven is on, renderGameObjects then only records the indirect draws.
+        // Has to be recorded outside the render pass, before renderGameObjects.
+        void prepareFrame(SERenderer& renderer, VkCommandBuffer commandBuffer, Scene& scene, int frameIndex);
+        // Records into the renderer's secondary command buffers and executes them on commandBuffer,
+        // which has to be in the swap chain's scene subpass. With occlusion culling it suspends the render pass between
+        // the two phases' draws and resumes it in the same subpass.
+        void renderGameObjects(SERenderer& renderer, VkCommandBuffer commandBuffer, Scene& scene, int frameIndex);
         void renderCubeMap(VkCommandBuffer commandBuffer);
 
     private:
+        // Frustum culls the scene into visibleObjects, objects first and then the submeshes of visible
+        // multi submesh meshes. Fills the culling part of RenderStats.
+        void cullGameObjects(Scene& scene);
+
+        // Queues the visible submeshes by (pipeline, material, mesh, depth) and batches them, transforms go to the
+        // instance buffer. The batches are split into contiguous chunks recorded in parallel, one secondary each.
+        void recordDraws(SERenderer& renderer, VkCommandBuffer commandBuffer, Scene& scene, int frameIndex);
+        // Records batches [begin, end) in order and skips every bind that matches the state already bound
+        void recordBatches(VkCommandBuffer commandBuffer, int frameIndex, size_t begin, size_t end, RenderStats& stats) const;
+        // Depth only pass over the sePipeline batches in [begin, end), from their position streams and without materials
+        void recordDepthBatches(VkCommandBuffer commandBuffer, int frameIndex, size_t begin, size_t end, RenderStats& stats) const;
+
+        // Creates the pre-pass pipelines and their EQUAL tested shading variants on first use, false if the shaders are missing
+        bool createDepthPrepass();
+        // Create the light binning and shadow pipelines on first use. When the shaders are missing they switch the
+        // setting off, shading then loops over every light and everything is lit.
+        bool createClusteredLighting();
+        bool createShadows();
+
+        // Creates the culling pass and the indirect pipeline on first use, false if either is unavailable
+        bool createGpuCulling();
+        // One batch per (material, submesh), every object using it is an instance. Only depends on the scene's structure.
+        void rebuildGpuBatches(Scene& scene);
+        // Materials have to be updated already. secondPhase records the draws the occlusion retest adds.
+        void recordIndirectDraws(VkCommandBuffer commandBuffer, int frameIndex, bool secondPhase);
+        // Creates the two phase culling pipeline and the depth pyramid on first use, false if either is unavailable
+        bool createOcclusionCulling();
+
+        // Grows the frame's instance buffer geometrically and points its descriptor at the new buffer
+        void reserveInstances(int frameIndex, size_t count);
+        void createInstanceBuffer(size_t frameIndex, size_t capacity);
+
         void createPipelineLayout();
         void createPipeline(VkRenderPass renderPass);
         void createDescriptorSets();
 
         void updateDescriptorSet(size_t frameIndex);
 
-        void updateLightsBuffer(int frameIndex, std::vector<Light> lights);
+        // Copies the scene's packed lights that changed since this frame's buffer was last written
+        void updateLightsBuffer(Scene& scene, int frameIndex);
+        void updateClusters(SERenderer& renderer, VkCommandBuffer commandBuffer, Scene& scene, int frameIndex);
+        // Recreates the maps when their resolution changed and records the shadow passes
+        void updateShadows(VkCommandBuffer commandBuffer, Scene& scene, int frameIndex);
 
         void createGlobalDescriptorSetLayout();
         void createMaterialDescriptorSetLayout();
 
-        void createUniformBuffer();
-
-        void bind(VkCommandBuffer commandBuffer, int frameIndex)
-        {
-            sePipeline->bind(commandBuffer);
-
-            vkCmdBindDescriptorSets(
-                commandBuffer,
-                VK_PIPELINE_BIND_POINT_GRAPHICS,
-                pipelineLayout,
-                0,  // Set 0 (Global UBO)
-                1,
-                &descriptorSets[frameIndex],
-                0,
-                nullptr);
-        }
+        void createInstanceBuffers();
 
         SEDevice& seDevice;
         SECubemap& seCubemap;
@@ -81,9 +102,87 @@ namespace se
         std::unique_ptr<SEPipeline> sePipeline;
         VkPipelineLayout pipelineLayout;
 
-		std::vector<Buffer> lightBuffers;
-        std::vector<bool> needUpdate;
-		
+        // Dynamic offsets of the cluster parameters, set 0 binding 7, the shadow parameters, binding 12,
+        // and the camera block the pre-pass reads, binding 13
+        uint32_t globalDynamicOffsets[3] = {};
+        uint32_t lightCount = 0;
+        // Scene the light buffers mirror
+        const Scene* lightScene = nullptr;
+        std::unique_ptr<ClusteredLighting> clusteredLighting;
+        std::unique_ptr<ShadowMaps> shadowMaps;
+
+        // Culling scratch, kept between frames so the pass does not allocate
+        static constexpr uint32_t NO_SUBMESH_CULLING = UINT32_MAX;
+        std::vector<uint32_t> cullCandidates;
+        std::vector<glm::vec3> cullCenters;
+        std::vector<glm::vec3> cullExtents;
+        std::vector<uint8_t> cullVisible;
+        std::vector<uint32_t> visibleObjects;
+        std::vector<uint32_t> submeshOffsets;
+        std::vector<uint8_t> submeshVisible;
+
+        // Per instance data read by pbrVert through gl_InstanceIndex, set 0 binding 4
+        struct InstanceData {
+            glm::mat4 transform;
+        };
+
+        struct DrawItem {
+            VkPipeline pipeline;
+            SEMaterial* material;
+            const SESubMesh* submesh;
+            uint32_t object;
+        };
+
+        struct InstanceBatch {
+            VkPipeline pipeline;
+            SEMaterial* material;
+            const SESubMesh* submesh;
+            uint32_t firstInstance;
+            uint32_t instanceCount;
+        };
+
+        static constexpr size_t MIN_INSTANCE_CAPACITY = 1024;
+        std::vector<Buffer> instanceBuffers;
+        std::vector<size_t> instanceCapacities;
+        // Camera distance mapped onto the depth bits of the sort key, anything further shares the last bucket
+        static constexpr float SORT_DEPTH_RANGE = 256.0f;
+        RenderQueue renderQueue;
+        std::vector<DrawItem> drawItems;
+        std::vector<InstanceBatch> instanceBatches;
+        // Fewer batches than this per chunk cost more in secondary overhead than the extra thread saves
+        static constexpr size_t MIN_BATCHES_PER_CHUNK = 64;
+        std::vector<RenderStats> chunkStats;
+
+        // GPU driven path, pbrIndirectVert reads set 0 bindings 5 and 6
+        struct GpuBatch {
+            SEMaterial* material;
+            const SESubMesh* submesh;
+        };
+
+        VkRenderPass renderPass;
+        std::unique_ptr<GPUCulling> gpuCulling;
+        std::unique_ptr<SEPipeline> indirectPipeline;
+        std::vector<GpuBatch> gpuBatches;
+        const Scene* gpuScene = nullptr;
+        uint64_t gpuStructureVersion = 0;
+        // Set when the batches left out something still uploading, rebuilt when more uploads are ready
+        bool gpuPendingUploads = false;
+        uint64_t gpuUploadsReady = 0;
+        bool gpuFramePrepared = false;
+        // Occlusion culling, GPU driven path only. Phase 1 was dispatched in prepareFrame, renderGameObjects
+        // rebuilds the pyramid from its depth between the two phases' draws.
+        std::unique_ptr<HiZPyramid> hiZ;
+        bool occlusionFramePrepared = false;
+        glm::mat4 cullViewProjection{ 1.0f };
+
+        // Depth pre-pass. The depth pipelines read positions only, the equal ones are sePipeline and indirectPipeline
+        // with an EQUAL depth test and no depth writes.
+        std::unique_ptr<SEPipeline> depthPipeline;
+        std::unique_ptr<SEPipeline> equalPipeline;
+        std::unique_ptr<SEPipeline> indirectDepthPipeline;
+        std::unique_ptr<SEPipeline> indirectEqualPipeline;
+        // Set for the frame being recorded, recordBatches swaps sePipeline for equalPipeline while it is
+        bool prepassActive = false;
     };
 
 
@@ -46,42 +46,10 @@ namespace se
 		flags.metallic = metallic;
 		flags.roughness = roughness;
 		flags.ao = ao;
-		
 
-		createUniformBuffer();
 		createDescriptorSets();
 	}
 
-	void SEMaterial::createUniformBuffer()
-	{
-		VkDeviceSize bufferSize = sizeof(MaterialFlags);
-
-		// Create the buffer (assuming seDevice.createBuffer handles all buffer creation tasks)
-		seDevice.createBuffer(
-			bufferSize,
-			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-			matBuffer,
-			matBufferMemory);
-
-		// Map the buffer memory
-		VkResult result = vkMapMemory(seDevice.device(), matBufferMemory, 0, bufferSize, 0, &matBufferMapped);
-		if (result != VK_SUCCESS)
-		{
-			throw std::runtime_error("Failed to map uniform buffer memory!");
-		}
-
-		// Copy data to the mapped memory
-		memcpy(matBufferMapped, &flags, sizeof(flags));
-
-		// No need to flush for coherent memory, but if non-coherent memory is used:
-		// VkMappedMemoryRange memoryRange{};
-		// memoryRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-		// memoryRange.memory = matBufferMemory;
-		// memoryRange.offset = 0;
-		// memoryRange.size = VK_WHOLE_SIZE;
-		// vkFlushMappedMemoryRanges(seDevice.device(), 1, &memoryRange);
-	}
 	void SEMaterial::createDescriptorSets()
 	{
 		size_t framesInFlight = SESwapChain::MAX_FRAMES_IN_FLIGHT;
@@ -113,16 +81,14 @@ namespace se
 
     void SEMaterial::updateDescriptorSet(size_t frameIndex)
     {
-        memcpy(matBufferMapped, &flags, sizeof(flags));
-
-        std::vector<VkBuffer> uniformBuffers = seDevice.getUniformBuffers();
+        // Both blocks are bound with dynamic offsets into the frame allocator, see bind()
         VkDescriptorBufferInfo bufferInfo{};
-        bufferInfo.buffer = uniformBuffers[frameIndex];
+        bufferInfo.buffer = seDevice.getFrameAllocator().getBuffer();
         bufferInfo.offset = 0;
         bufferInfo.range = sizeof(UniformBufferObject);
 
         VkDescriptorBufferInfo matBufferInfo{};
-        matBufferInfo.buffer = matBuffer;
+        matBufferInfo.buffer = seDevice.getFrameAllocator().getBuffer();
         matBufferInfo.offset = 0;
         matBufferInfo.range = sizeof(MaterialFlags);
 
@@ -179,7 +145,7 @@ namespace se
         descriptorWrites[0].dstSet = descriptorSets[frameIndex];
         descriptorWrites[0].dstBinding = 0;
         descriptorWrites[0].dstArrayElement = 0;
-        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         descriptorWrites[0].descriptorCount = 1;
         descriptorWrites[0].pBufferInfo = &bufferInfo;
 
@@ -188,7 +154,7 @@ namespace se
         descriptorWrites[1].dstSet = descriptorSets[frameIndex];
         descriptorWrites[1].dstBinding = 1;
         descriptorWrites[1].dstArrayElement = 0;
-        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         descriptorWrites[1].descriptorCount = 1;
         descriptorWrites[1].pBufferInfo = &matBufferInfo;
 
@@ -11,11 +11,6 @@
 
 namespace se
 {
-	struct SimplePushConstantData
-	{
-		glm::mat4 transform{1.f};
-	};
-	
 	class SEMaterial : public SEMaterialBase, public Resource
 	{
 
@@ -59,8 +54,11 @@ namespace se
 		SEMaterial(const SEMaterial &) = delete;
 		SEMaterial &operator=(const SEMaterial &) = delete;
 
+		// Expects update(frameIndex) to have run this frame, it places the parameters in the frame allocator
 		void bind(VkCommandBuffer commandBuffer, int frameIndex) override
 		{
+			// Dynamic offsets go in binding order, camera then material parameters
+			uint32_t dynamicOffsets[] = { seDevice.getCameraUniformOffset(), flagsOffset };
 			vkCmdBindDescriptorSets(
 				commandBuffer,
 				VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -68,8 +66,8 @@ namespace se
 				1,  // Set 1 (Material Textures)
 				1,
 				&descriptorSets[frameIndex],
-				0,
-				nullptr);
+				2,
+				dynamicOffsets);
 		}
 
 		Type getType() const override { return Type::PBR; }
@@ -115,6 +113,17 @@ namespace se
 			return flags.ao;
 		}
 
+		// False while one of its textures is still uploading
+		bool isReady() const
+		{
+			for (const auto* texture : { &diffuseTexture, &normalTexture, &metallicTexture, &roughnessTexture, &aoTexture })
+			{
+				if (texture->has_value() && texture->value() && !texture->value()->isReady())
+					return false;
+			}
+			return !dummyTexture || dummyTexture->isReady();
+		}
+
 		std::shared_ptr<SETexture> getDiffuseTexture() const
 		{
 			return diffuseTexture.value_or(dummyTexture);
@@ -206,10 +215,17 @@ namespace se
 				updateDescriptorSet(frameIndex);
 				needUpdate[frameIndex] = false;
 			}
+
+			// Once per frame, however many batches use the material
+			FrameAllocator& frameAllocator = seDevice.getFrameAllocator();
+			if (flagsFrame != frameAllocator.getFrameNumber())
+			{
+				flagsOffset = frameAllocator.upload(flags);
+				flagsFrame = frameAllocator.getFrameNumber();
+			}
 		}
 
 	private:
-		void createUniformBuffer();
 		void createDescriptorSets();
 
 		void updateDescriptorSet(size_t frameIndex);
@@ -225,9 +241,9 @@ namespace se
 
 		MaterialFlags flags{};
 
-		VkBuffer matBuffer;
-		VkDeviceMemory matBufferMemory;
-		void *matBufferMapped;
+		// Where this frame's copy of flags lives in the device's frame allocator
+		uint32_t flagsOffset = 0;
+		uint64_t flagsFrame = UINT64_MAX;
 
 		std::shared_ptr<se::SETexture> dummyTexture;
 
@@ -97,6 +97,9 @@ namespace se
         configInfo.dynamicStateInfo.dynamicStateCount =
             static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
         configInfo.dynamicStateInfo.flags = 0;
+
+        configInfo.bindingDescriptions = Vertex::getBindingDescriptions();
+        configInfo.attributeDescriptions = Vertex::getAttributeDescriptions();
     }
 
     static std::vector<char> readFile(const std::string &filepath)
@@ -168,6 +171,25 @@ namespace se
         return attributeDescriptions;
     }
 
+    std::vector<VkVertexInputBindingDescription> Vertex::getPositionBindingDescriptions()
+    {
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+        bindingDescriptions[0].binding = 0;
+        bindingDescriptions[0].stride = sizeof(glm::vec3);
+        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        return bindingDescriptions;
+    }
+
+    std::vector<VkVertexInputAttributeDescription> Vertex::getPositionAttributeDescriptions()
+    {
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions(1);
+        attributeDescriptions[0].binding = 0;
+        attributeDescriptions[0].location = 0;
+        attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+        attributeDescriptions[0].offset = 0;
+        return attributeDescriptions;
+    }
+
     void SEPipeline::createGraphicsPipeline(
         const std::string &vertFilepath,
         const std::string &fragFilepath,
@@ -202,8 +224,8 @@ namespace se
         shaderStages[1].pNext = nullptr;
         shaderStages[1].pSpecializationInfo = nullptr;
 
-        auto bindingDescriptions = Vertex::getBindingDescriptions();
-        auto attributeDescriptions = Vertex::getAttributeDescriptions();
+        const auto& bindingDescriptions = configInfo.bindingDescriptions;
+        const auto& attributeDescriptions = configInfo.attributeDescriptions;
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
         vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
         vertexInputInfo.vertexAttributeDescriptionCount =
@@ -26,6 +26,9 @@ namespace se
         VkPipelineColorBlendStateCreateInfo colorBlendInfo;
         VkPipelineDepthStencilStateCreateInfo depthStencilInfo;
         std::vector<VkDynamicState> dynamicStateEnables;
+        // Full Vertex by default, Vertex::getPositionBindingDescriptions for the position only stream
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
         VkPipelineDynamicStateCreateInfo dynamicStateInfo;
         VkPipelineLayout pipelineLayout = nullptr;
         VkRenderPass renderPass = nullptr;
@@ -50,11 +53,9 @@ namespace se
 		VkPipeline getPipeline() const { return graphicsPipeline; }
 
         static void defaultPipelineConfigInfo(PipelineConfigInfo &configInfo);
-
-
-    private:
         static std::vector<char> readFile(const std::string &filepath);
 
+    private:
         void createGraphicsPipeline(
             const std::string &vertFilepath,
             const std::string &fragFilepath,
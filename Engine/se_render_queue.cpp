@@ -0,0 +1,95 @@
+#include "se_render_queue.hpp"
+
+#include <algorithm>
+
+namespace se {
+
+    namespace {
+        // Below this a comparison sort beats building the histograms
+        constexpr size_t RADIX_THRESHOLD = 256;
+        constexpr int RADIX_BITS = 8;
+        constexpr int RADIX_BUCKETS = 1 << RADIX_BITS;
+        constexpr int RADIX_PASSES = 64 / RADIX_BITS;
+
+        static_assert(RenderQueue::PIPELINE_BITS + RenderQueue::MATERIAL_BITS + RenderQueue::MESH_BITS + RenderQueue::DEPTH_BITS == 64,
+            "sort key fields have to fill 64 bits");
+
+        uint64_t field(uint32_t value, int bits)
+        {
+            return static_cast<uint64_t>(value) & ((uint64_t{ 1 } << bits) - 1);
+        }
+    }
+
+    uint64_t RenderQueue::makeKey(uint32_t pipeline, uint32_t material, uint32_t mesh, float depth)
+    {
+        const uint32_t maxDepth = (1u << DEPTH_BITS) - 1;
+        float clamped = std::min(std::max(depth, 0.0f), 1.0f);
+        uint32_t depthBucket = static_cast<uint32_t>(clamped * static_cast<float>(maxDepth));
+
+        uint64_t key = field(pipeline, PIPELINE_BITS);
+        key = (key << MATERIAL_BITS) | field(material, MATERIAL_BITS);
+        key = (key << MESH_BITS) | field(mesh, MESH_BITS);
+        key = (key << DEPTH_BITS) | field(depthBucket, DEPTH_BITS);
+        return key;
+    }
+
+    uint32_t RenderQueue::hashId(const void* pointer, int bits)
+    {
+        // Fibonacci hashing, the top bits of the product are the well mixed ones
+        uint64_t value = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pointer));
+        return static_cast<uint32_t>((value * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+    }
+
+    void RenderQueue::reserve(size_t count)
+    {
+        entries.reserve(count);
+        scratch.reserve(count);
+    }
+
+    void RenderQueue::sort()
+    {
+        const size_t count = entries.size();
+        if (count < RADIX_THRESHOLD) {
+            std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+            return;
+        }
+
+        // LSD radix sort, all histograms are gathered in a single pass over the keys
+        uint32_t histograms[RADIX_PASSES][RADIX_BUCKETS] = {};
+        for (const Entry& entry : entries) {
+            for (int pass = 0; pass < RADIX_PASSES; pass++)
+                histograms[pass][(entry.key >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+        }
+
+        scratch.resize(count);
+        Entry* source = entries.data();
+        Entry* destination = scratch.data();
+
+        for (int pass = 0; pass < RADIX_PASSES; pass++) {
+            const int shift = pass * RADIX_BITS;
+            uint32_t* histogram = histograms[pass];
+
+            // Every key has the same digit here, e.g. a single pipeline, so the pass changes nothing
+            if (histogram[(source[0].key >> shift) & (RADIX_BUCKETS - 1)] == count)
+                continue;
+
+            uint32_t offset = 0;
+            for (int bucket = 0; bucket < RADIX_BUCKETS; bucket++) {
+                uint32_t bucketCount = histogram[bucket];
+                histogram[bucket] = offset;
+                offset += bucketCount;
+            }
+
+            for (size_t i = 0; i < count; i++) {
+                uint32_t bucket = static_cast<uint32_t>((source[i].key >> shift) & (RADIX_BUCKETS - 1));
+                destination[histogram[bucket]++] = source[i];
+            }
+
+            std::swap(source, destination);
+        }
+
+        if (source != entries.data())
+            entries.swap(scratch);
+    }
+
+}
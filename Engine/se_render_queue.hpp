@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace se {
+
+    // Draw submissions ordered by a packed 64-bit key so draws sharing state end up next to each other.
+    // Keys are radix sorted every frame, items are whatever index the renderer wants back in sorted order.
+    class RenderQueue {
+    public:
+        // Field widths from the most significant end: pipeline, material, mesh, then the depth bucket
+        static constexpr int PIPELINE_BITS = 6;
+        static constexpr int MATERIAL_BITS = 18;
+        static constexpr int MESH_BITS = 24;
+        static constexpr int DEPTH_BITS = 16;
+
+        // depth is normalized to [0, 1], nearer first. Ids wider than their field are folded with hashId.
+        static uint64_t makeKey(uint32_t pipeline, uint32_t material, uint32_t mesh, float depth);
+
+        // Pointer to an id of the given width. Equal pointers give equal ids, a collision only costs extra binds
+        // since the renderer compares the real state when emitting.
+        static uint32_t hashId(const void* pointer, int bits);
+
+        void clear() { entries.clear(); }
+        void reserve(size_t count);
+        void push(uint64_t key, uint32_t item) { entries.push_back({ key, item }); }
+
+        // Stable, equal keys keep their push order
+        void sort();
+
+        size_t size() const { return entries.size(); }
+        bool empty() const { return entries.empty(); }
+        uint32_t operator[](size_t i) const { return entries[i].item; }
+        uint64_t getKey(size_t i) const { return entries[i].key; }
+
+    private:
+        struct Entry {
+            uint64_t key;
+            uint32_t item;
+        };
+
+        std::vector<Entry> entries;
+        std::vector<Entry> scratch;
+    };
+
+}
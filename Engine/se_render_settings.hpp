@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+namespace se
+{
+    constexpr uint32_t SHADOW_CASCADE_COUNT = 4;
+
+    // Renderer switches flipped at runtime by the editor and the benchmarks
+    struct RenderSettings
+    {
+        // Queued draws sharing pipeline, material and submesh are merged into one instanced call,
+        // off records one draw per submesh (binds are still skipped when the state matches)
+        bool instancing = true;
+        // Frustum culling in a compute pass feeding indirect draws, the CPU no longer walks the objects.
+        // Switched back off if the device or the shaders don't support it.
+        bool gpuDriven = false;
+        // Threads recording the scene's secondary command buffers, 0 uses every job system thread
+        uint32_t recordThreads = 0;
+        // Lights are binned into a froxel grid by a compute pass and each fragment only shades its cluster's lights,
+        // off shades every light for every fragment
+        bool clusteredLighting = true;
+        // Opaque PBR geometry is drawn depth only from its position stream first, the shading pass then tests EQUAL
+        // without writing depth so every pixel is shaded once
+        bool depthPrepass = false;
+        // Two phase occlusion culling against a depth pyramid, only applies while gpuDriven is on. Draws what last
+        // frame's pyramid let through, rebuilds the pyramid from that depth and draws what a retest against it adds.
+        bool occlusionCulling = false;
+
+        // Cascaded shadow maps for the first shadow casting directional light, atlas tiles for spot and point lights.
+        // Changing a resolution recreates the maps, which waits for the GPU to go idle.
+        bool shadows = true;
+        uint32_t shadowCascadeResolution = 2048;
+        uint32_t shadowAtlasResolution = 4096;
+        // Frames between redraws of the dynamic casters, 1 is every frame. Static casters are cached either way.
+        uint32_t shadowCascadeUpdateInterval[SHADOW_CASCADE_COUNT] = { 1, 1, 2, 4 };
+        uint32_t shadowAtlasUpdateInterval = 1;
+        // View distance the cascades cover, capped at the camera's far plane
+        float shadowDistance = 60.0f;
+    };
+
+    inline RenderSettings& getRenderSettings()
+    {
+        static RenderSettings settings;
+        return settings;
+    }
+}
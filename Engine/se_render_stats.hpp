@@ -0,0 +1,49 @@
+#pragma once
+
+#include "se_render_settings.hpp"
+
+#include <cstdint>
+
+namespace se
+{
+    // Counters filled by the renderers while recording a frame, reset at the start of each frame
+    struct RenderStats
+    {
+        uint32_t objectsSubmitted = 0;
+        uint32_t objectsCulled = 0;
+        // In the frustum but hidden behind the depth pyramid, not included in objectsCulled
+        uint32_t objectsOccluded = 0;
+        uint32_t submeshesTested = 0;
+        uint32_t submeshesCulled = 0;
+        uint32_t drawCalls = 0;
+        // Depth only draws of the pre-pass, not included in drawCalls
+        uint32_t prepassDrawCalls = 0;
+        uint32_t instances = 0;
+        uint32_t pipelineBinds = 0;
+        uint32_t descriptorSetBinds = 0;
+        uint32_t vertexBufferBinds = 0;
+        // CPU time spent culling, batching and recording the scene's draws
+        float recordTimeMs = 0.0f;
+        // GPU time of the swap chain's scene subpass, read back from this frame slot's previous use.
+        // Stays 0 when the device has no timestamps.
+        float sceneGpuTimeMs = 0.0f;
+        uint32_t lights = 0;
+        uint32_t lightsUploaded = 0;
+        // Shadow passes, GPU times are read back like sceneGpuTimeMs. A cascade that wasn't updated costs nothing.
+        float shadowCascadeGpuMs[SHADOW_CASCADE_COUNT] = {};
+        float shadowCascadeRecordMs[SHADOW_CASCADE_COUNT] = {};
+        float shadowAtlasGpuMs = 0.0f;
+        float shadowAtlasRecordMs = 0.0f;
+        // Cascades and atlas tiles whose cached static casters were redrawn
+        uint32_t shadowStaticRedraws = 0;
+        uint32_t shadowCasters = 0;
+
+        void reset() { *this = RenderStats{}; }
+    };
+
+    inline RenderStats& getRenderStats()
+    {
+        static RenderStats stats;
+        return stats;
+    }
+}
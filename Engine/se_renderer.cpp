@@ -1,4 +1,5 @@
 #include "se_renderer.hpp"
+#include "se_render_stats.hpp"
 
 #include <array>
 #include <cassert>
@@ -13,9 +14,16 @@ namespace se
         offscreenRenderer = std::make_unique<SEOffscreenRenderer>(seDevice);
         recreateSwapChain();
         createCommandBuffers();
+        createTimestampQueries();
     }
 
-    SERenderer::~SERenderer() { freeCommandBuffers(); }
+    SERenderer::~SERenderer()
+    {
+        freeCommandBuffers();
+        destroySecondaryCommandPools();
+        if (timestampQueryPool != VK_NULL_HANDLE)
+            vkDestroyQueryPool(seDevice.device(), timestampQueryPool, nullptr);
+    }
 
     void SERenderer::recreateSwapChain()
     {
@@ -70,6 +78,126 @@ namespace se
         commandBuffers.clear();
     }
 
+    void SERenderer::createTimestampQueries()
+    {
+        if (!seDevice.properties.limits.timestampComputeAndGraphics)
+            return;
+
+        VkQueryPoolCreateInfo queryPoolInfo{};
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = SESwapChain::MAX_FRAMES_IN_FLIGHT * 2;
+
+        if (vkCreateQueryPool(seDevice.device(), &queryPoolInfo, nullptr, &timestampQueryPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create timestamp query pool!");
+        }
+        timestampsWritten.resize(SESwapChain::MAX_FRAMES_IN_FLIGHT, false);
+    }
+
+    void SERenderer::destroySecondaryCommandPools()
+    {
+        // Destroying a pool frees its command buffers
+        for (auto& framePools : secondaryCommandPools)
+        {
+            for (VkCommandPool pool : framePools)
+                vkDestroyCommandPool(seDevice.device(), pool, nullptr);
+        }
+        secondaryCommandPools.clear();
+        secondaryCommandBuffers.clear();
+    }
+
+    void SERenderer::prepareSecondaryCommandBuffers(uint32_t count)
+    {
+        assert(isFrameStarted && "Can't prepare secondary command buffers when frame not in progress");
+
+        if (secondaryCommandPools.empty())
+        {
+            secondaryCommandPools.resize(SESwapChain::MAX_FRAMES_IN_FLIGHT);
+            secondaryCommandBuffers.resize(SESwapChain::MAX_FRAMES_IN_FLIGHT);
+        }
+
+        const int frame = getFrameIndex();
+        auto& framePools = secondaryCommandPools[frame];
+        auto& frameBuffers = secondaryCommandBuffers[frame];
+
+        while (framePools.size() < count)
+        {
+            VkCommandPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+            poolInfo.queueFamilyIndex = seDevice.findPhysicalQueueFamilies().graphicsFamily.value();
+            // Reset as a whole at the start of the frame, so the buffers don't need individual resets
+            poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+            VkCommandPool pool;
+            if (vkCreateCommandPool(seDevice.device(), &poolInfo, nullptr, &pool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create secondary command pool!");
+            }
+
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandPool = pool;
+            allocInfo.commandBufferCount = 1;
+
+            VkCommandBuffer commandBuffer;
+            if (vkAllocateCommandBuffers(seDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS)
+            {
+                vkDestroyCommandPool(seDevice.device(), pool, nullptr);
+                throw std::runtime_error("failed to allocate secondary command buffer!");
+            }
+
+            framePools.push_back(pool);
+            frameBuffers.push_back(commandBuffer);
+        }
+    }
+
+    VkCommandBuffer SERenderer::beginSecondaryCommandBuffer(uint32_t slot)
+    {
+        assert(isFrameStarted && "Can't begin secondary command buffer when frame not in progress");
+        assert(slot < secondaryCommandBuffers[getFrameIndex()].size() && "Secondary command buffer slot not prepared");
+
+        VkCommandBuffer commandBuffer = secondaryCommandBuffers[getFrameIndex()][slot];
+
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = seSwapChain->getRenderPass();
+        inheritanceInfo.subpass = SESwapChain::SCENE_SUBPASS;
+        inheritanceInfo.framebuffer = seSwapChain->getFrameBuffer(currentImageIndex);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to begin recording secondary command buffer!");
+        }
+
+        // Dynamic state isn't inherited from the primary
+        setViewportAndScissor(commandBuffer);
+        return commandBuffer;
+    }
+
+    void SERenderer::endSecondaryCommandBuffer(VkCommandBuffer commandBuffer)
+    {
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to record secondary command buffer!");
+        }
+    }
+
+    void SERenderer::executeSecondaryCommandBuffers(VkCommandBuffer commandBuffer, uint32_t count, uint32_t firstSlot)
+    {
+        assert(firstSlot + count <= secondaryCommandBuffers[getFrameIndex()].size() && "Executing unprepared secondary command buffers");
+        if (count == 0)
+            return;
+
+        vkCmdExecuteCommands(commandBuffer, count, secondaryCommandBuffers[getFrameIndex()].data() + firstSlot);
+    }
+
     VkCommandBuffer SERenderer::beginFrame()
     {
         assert(!isFrameStarted && "Can't call beginFrame while already in progress");
@@ -88,6 +216,15 @@ namespace se
 
         isFrameStarted = true;
 
+        // acquireNextImage waited on this frame's fence, so nothing recorded from its pools is still pending
+        // and the GPU is done reading its slice of the frame allocator
+        if (!secondaryCommandPools.empty())
+        {
+            for (VkCommandPool pool : secondaryCommandPools[getFrameIndex()])
+                vkResetCommandPool(seDevice.device(), pool, 0);
+        }
+        seDevice.getFrameAllocator().beginFrame(getFrameIndex());
+
         auto commandBuffer = getCurrentCommandBuffer();
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -96,6 +233,11 @@ namespace se
         {
             throw std::runtime_error("failed to begin recording command buffer!");
         }
+
+        // Uploads queued since the last frame start copying now, finished ones become drawable in this one
+        UploadManager& uploadManager = seDevice.getUploadManager();
+        uploadManager.flush();
+        uploadManager.recordAcquires(commandBuffer);
         return commandBuffer;
     }
 
@@ -144,8 +286,72 @@ namespace se
         renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         renderPassInfo.pClearValues = clearValues.data();
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        if (timestampQueryPool != VK_NULL_HANDLE)
+        {
+            // beginFrame waited on this slot's fence, so its previous timestamps are available
+            const uint32_t firstQuery = static_cast<uint32_t>(getFrameIndex()) * 2;
+            uint64_t timestamps[2] = {};
+            if (timestampsWritten[getFrameIndex()] &&
+                vkGetQueryPoolResults(seDevice.device(), timestampQueryPool, firstQuery, 2, sizeof(timestamps), timestamps,
+                    sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+            {
+                getRenderStats().sceneGpuTimeMs = static_cast<float>(
+                    static_cast<double>(timestamps[1] - timestamps[0]) * seDevice.properties.limits.timestampPeriod * 1e-6);
+            }
+
+            vkCmdResetQueryPool(commandBuffer, timestampQueryPool, firstQuery, 2);
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, firstQuery);
+            timestampsWritten[getFrameIndex()] = true;
+        }
+
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    }
+
+    void SERenderer::suspendSwapChainRenderPass(VkCommandBuffer commandBuffer)
+    {
+        assert(isFrameStarted && "Can't call suspendSwapChainRenderPass if frame is not in progress");
+        assert(
+            commandBuffer == getCurrentCommandBuffer() &&
+            "Can't suspend render pass on command buffer from a different frame");
+
+        // A render pass can only end from its last subpass, the overlay one stays empty
+        vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdEndRenderPass(commandBuffer);
+    }
+
+    void SERenderer::resumeSwapChainRenderPass(VkCommandBuffer commandBuffer)
+    {
+        assert(isFrameStarted && "Can't call resumeSwapChainRenderPass if frame is not in progress");
+        assert(
+            commandBuffer == getCurrentCommandBuffer() &&
+            "Can't resume render pass on command buffer from a different frame");
 
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = seSwapChain->getResumeRenderPass();
+        renderPassInfo.framebuffer = seSwapChain->getFrameBuffer(currentImageIndex);
+        renderPassInfo.renderArea.offset = { 0, 0 };
+        renderPassInfo.renderArea.extent = seSwapChain->getSwapChainExtent();
+
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    }
+
+    void SERenderer::nextSwapChainSubpass(VkCommandBuffer commandBuffer)
+    {
+        assert(isFrameStarted && "Can't call nextSwapChainSubpass if frame is not in progress");
+        assert(
+            commandBuffer == getCurrentCommandBuffer() &&
+            "Can't change subpass on command buffer from a different frame");
+
+        vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
+        if (timestampQueryPool != VK_NULL_HANDLE)
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, static_cast<uint32_t>(getFrameIndex()) * 2 + 1);
+        // Executing secondaries leaves the primary's dynamic state undefined
+        setViewportAndScissor(commandBuffer);
+    }
+
+    void SERenderer::setViewportAndScissor(VkCommandBuffer commandBuffer)
+    {
         VkViewport viewport{};
         viewport.x = 0.0f;
         viewport.y = 0.0f;
@@ -22,6 +22,8 @@ namespace se
 
     VkRenderPass getSwapChainRenderPass() const { return seSwapChain->getRenderPass(); }
     float getAspectRatio() const { return seSwapChain->extentAspectRatio(); }
+    VkExtent2D getSwapChainExtent() const { return seSwapChain->getSwapChainExtent(); }
+    VkFormat getDepthFormat() const { return seSwapChain->getSwapChainDepthFormat(); }
     bool isFrameInProgress() const { return isFrameStarted; }
 
     VkCommandBuffer getCurrentCommandBuffer() const
@@ -30,6 +32,10 @@ namespace se
       return commandBuffers[seSwapChain->getCurrentFrame()];
     }
 
+    // Depth attachment of the image being rendered, only valid while a frame is in progress
+    VkImage getCurrentDepthImage() const { return seSwapChain->getDepthImage(static_cast<int>(currentImageIndex)); }
+    VkImageView getCurrentDepthImageView() const { return seSwapChain->getDepthImageView(static_cast<int>(currentImageIndex)); }
+
     int getFrameIndex() const
     {
       assert(isFrameStarted && "Cannot get frame index when frame not in progress");
@@ -41,9 +47,26 @@ namespace se
 
     VkCommandBuffer beginFrame();
     void endFrame();
+    // Starts in the scene subpass, which only takes secondary command buffers
     void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+    // Ends the render pass from the scene subpass so compute work can read what was drawn so far,
+    // resumeSwapChainRenderPass then continues in the scene subpass with color and depth loaded.
+    // Depth is left in DEPTH_STENCIL_ATTACHMENT_OPTIMAL and has to be back in it before resuming.
+    void suspendSwapChainRenderPass(VkCommandBuffer commandBuffer);
+    void resumeSwapChainRenderPass(VkCommandBuffer commandBuffer);
+    // Moves on to the overlay subpass, recorded inline on the primary
+    void nextSwapChainSubpass(VkCommandBuffer commandBuffer);
     void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
+    // Secondary command buffers for the scene subpass. Slot i has its own pool per frame in flight, so
+    // different threads can record different slots at once. Pools are reset when their frame begins.
+    // Call prepareSecondaryCommandBuffers on the main thread before handing slots out.
+    void prepareSecondaryCommandBuffers(uint32_t count);
+    VkCommandBuffer beginSecondaryCommandBuffer(uint32_t slot);
+    void endSecondaryCommandBuffer(VkCommandBuffer commandBuffer);
+    // Executes slots [firstSlot, firstSlot + count)
+    void executeSecondaryCommandBuffers(VkCommandBuffer commandBuffer, uint32_t count, uint32_t firstSlot = 0);
+
     VkCommandBuffer beginOffscreenFrame();
     void endOffscreenFrame();
 
@@ -53,15 +76,25 @@ namespace se
   private:
     void createCommandBuffers();
     void freeCommandBuffers();
+    void destroySecondaryCommandPools();
+    void createTimestampQueries();
     void recreateSwapChain();
+    void setViewportAndScissor(VkCommandBuffer commandBuffer);
 
     SEWindow &seWindow;
     SEDevice &seDevice;
     std::unique_ptr<SESwapChain> seSwapChain;
     std::vector<VkCommandBuffer> commandBuffers;
+    // Indexed [frame][slot]
+    std::vector<std::vector<VkCommandPool>> secondaryCommandPools;
+    std::vector<std::vector<VkCommandBuffer>> secondaryCommandBuffers;
 
     std::unique_ptr<SEOffscreenRenderer> offscreenRenderer;
 
+    // Two timestamps per frame in flight around the scene subpass, null without timestamp support
+    VkQueryPool timestampQueryPool = VK_NULL_HANDLE;
+    std::vector<bool> timestampsWritten;
+
     uint32_t currentImageIndex;
     bool isFrameStarted{ false };
     bool isOffscreenFrameStarted{ false };
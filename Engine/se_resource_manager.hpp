@@ -80,6 +80,11 @@ public:
 		return textureSystem->getTextures();
 	}
 
+	se::TextureSystem* getTextureSystem() const
+	{
+		return textureSystem.get();
+	}
+
 	void setMaterialSystem(std::shared_ptr<se::MaterialSystem> materialSystem)  
 	{  
 		if (textureSystem == nullptr)
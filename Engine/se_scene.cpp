@@ -0,0 +1,813 @@
+#include "se_scene.hpp"
+#include "se_simd.hpp"
+#include "se_job_system.hpp"
+
+#include <functional>
+
+namespace se {
+
+    void Scene::destroyGameObjects(const GameObjectHandle* handles, size_t count)
+    {
+        // Collect every subtree first, removing objects reshuffles the dense arrays
+        std::vector<uint8_t>& doomed = destroyMarks;
+        std::vector<uint32_t>& doomedDense = destroyDense;
+        std::vector<uint32_t>& subtree = destroySubtree;
+        // Marks are all clear between calls, only new dense slots need zeroing
+        if (doomed.size() < gameObjects.size())
+            doomed.resize(gameObjects.size(), 0);
+        doomedDense.clear();
+
+        for (size_t h = 0; h < count; h++) {
+            const GameObjectHandle& handle = handles[h];
+            if (!isValid(handle) || doomed[slots[handle.getIndex()].dense])
+                continue;
+
+            detachFromParent(handle.getIndex());
+
+            subtree.assign(1, handle.getIndex());
+            for (size_t i = 0; i < subtree.size(); i++) {
+                uint32_t dense = slots[subtree[i]].dense;
+                // Already collected through an earlier handle, together with its children
+                if (doomed[dense])
+                    continue;
+                doomed[dense] = 1;
+                doomedDense.push_back(dense);
+
+                uint32_t child = hierarchy[dense].firstChild;
+                while (child != INVALID_INDEX) {
+                    subtree.push_back(child);
+                    child = hierarchy[slots[child].dense].nextSibling;
+                }
+            }
+        }
+
+        // Clear only what was marked, so a call costs the size of the subtrees and not of the scene
+        for (uint32_t dense : doomedDense)
+            doomed[dense] = 0;
+
+        // Removing from the back means the element swapped into a hole is never one still waiting to go
+        std::sort(doomedDense.begin(), doomedDense.end(), std::greater<uint32_t>());
+        for (uint32_t dense : doomedDense) {
+            uint32_t slot = denseToSlot[dense];
+            removeDense(dense);
+            releaseSlot(slot);
+        }
+    }
+
+    GameObjectHandle Scene::deferCreateGameObject(GameObjectDesc desc)
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+
+        uint32_t index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            // Growing slots here would race with handle lookups on other threads
+            index = static_cast<uint32_t>(slots.size()) + reservedSlotCount++;
+        }
+
+        uint32_t generation = index < slots.size() ? slots[index].generation : 1;
+        pendingCreates.push_back({ index, std::move(desc) });
+        return GameObjectHandle(index, generation, this);
+    }
+
+    void Scene::deferDestroyGameObject(const GameObjectHandle& handle)
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+        pendingDestroys.push_back(handle);
+    }
+
+    void Scene::deferSetParent(const GameObjectHandle& child, const GameObjectHandle& parent)
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+        pendingParents.emplace_back(child, parent);
+    }
+
+    void Scene::applyDeferredCommands()
+    {
+        auto& creates = applyingCreates;
+        auto& destroys = applyingDestroys;
+        auto& parents = applyingParents;
+        {
+            std::lock_guard<std::mutex> lock(commandMutex);
+            creates.swap(pendingCreates);
+            destroys.swap(pendingDestroys);
+            parents.swap(pendingParents);
+        }
+
+        if (creates.empty() && destroys.empty() && parents.empty())
+            return;
+
+        materializeReservedSlots();
+
+        if (!creates.empty()) {
+            // Grow every pool once for the whole batch, geometrically so repeated batches stay amortised
+            size_t needed = gameObjects.size() + creates.size();
+            if (needed > gameObjects.capacity())
+                reserveGameObjects(std::max(needed, gameObjects.capacity() * 2));
+
+            for (auto& create : creates) {
+                insertIntoPools(create.slot, create.desc.name);
+
+                uint32_t dense = slots[create.slot].dense;
+                transforms[dense] = create.desc.transform;
+                lights[dense] = create.desc.light;
+                staticFlags[dense] = create.desc.isStatic ? 1 : 0;
+                meshes[dense] = std::move(create.desc.mesh);
+                materials[dense] = std::move(create.desc.material);
+                indexComponents(dense);
+            }
+
+            // Parents may be other objects from the same batch, so link once they all exist
+            for (auto& create : creates) {
+                if (create.desc.parent)
+                    setParent(GameObjectHandle(create.slot, slots[create.slot].generation, this), create.desc.parent);
+            }
+        }
+
+        for (auto& link : parents)
+            setParent(link.first, link.second);
+
+        if (!destroys.empty())
+            destroyGameObjects(destroys.data(), destroys.size());
+
+        creates.clear();
+        destroys.clear();
+        parents.clear();
+    }
+
+    void Scene::discardDeferredCommands()
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+
+        // Reserved slots go back to the free list with a new generation so their handles stay dead
+        materializeReservedSlots();
+        for (auto& create : pendingCreates)
+            releaseSlot(create.slot);
+
+        pendingCreates.clear();
+        pendingDestroys.clear();
+        pendingParents.clear();
+    }
+
+    void Scene::reserveGameObjects(size_t count)
+    {
+        gameObjects.reserve(count);
+        denseToSlot.reserve(count);
+        names.reserve(count);
+        transforms.reserve(count);
+        lights.reserve(count);
+        meshes.reserve(count);
+        materials.reserve(count);
+        scripts.reserve(count);
+        localMatrices.reserve(count);
+        worldMatrices.reserve(count);
+        worldBounds.reserve(count);
+        spatialProxies.reserve(count);
+        spatialTree.reserve(count);
+        transformDirty.reserve(count);
+        lightDirty.reserve(count);
+        staticFlags.reserve(count);
+        hierarchy.reserve(count);
+        namePositions.reserve(count);
+        tagMasks.reserve(count);
+        creationHandles.reserve(count);
+    }
+
+    Scene::GameObjectView Scene::findByName(const std::string& objName) const
+    {
+        auto it = nameIndex.find(objName);
+        if (it == nameIndex.end())
+            return GameObjectView();
+        return GameObjectView(this, it->second);
+    }
+
+    Scene::GameObjectView Scene::findByTag(const std::string& tag) const
+    {
+        int tagId = findTag(tag);
+        if (tagId < 0)
+            return GameObjectView();
+        return GameObjectView(this, tagIndex[tagId].members);
+    }
+
+    Scene::GameObjectView Scene::findWithMesh() const
+    {
+        return GameObjectView(this, meshIndex.members);
+    }
+
+    Scene::GameObjectView Scene::findWithLight()
+    {
+        updateLights();
+        return GameObjectView(this, lightIndex.members);
+    }
+
+    Scene::GameObjectView Scene::findWithScript(std::type_index scriptType) const
+    {
+        auto it = scriptIndex.find(scriptType);
+        if (it == scriptIndex.end())
+            return GameObjectView();
+        return GameObjectView(this, it->second.members);
+    }
+
+    bool Scene::addTag(const GameObjectHandle& obj, const std::string& tag)
+    {
+        if (!isValid(obj))
+            return false;
+
+        int tagId = findTag(tag);
+        if (tagId < 0) {
+            if (tagNames.size() >= MAX_TAGS) {
+                std::cerr << "[Scene] Too many tags, cannot add " << tag << "!\n";
+                return false;
+            }
+            tagId = static_cast<int>(tagNames.size());
+            tagNames.push_back(tag);
+            tagIndex.emplace_back();
+        }
+
+        tagMasks[slots[obj.getIndex()].dense] |= 1u << tagId;
+        tagIndex[tagId].insert(obj.getIndex());
+        return true;
+    }
+
+    void Scene::removeTag(const GameObjectHandle& obj, const std::string& tag)
+    {
+        int tagId = findTag(tag);
+        if (!isValid(obj) || tagId < 0)
+            return;
+
+        tagMasks[slots[obj.getIndex()].dense] &= ~(1u << tagId);
+        tagIndex[tagId].erase(obj.getIndex());
+    }
+
+    bool Scene::hasTag(const GameObjectHandle& obj, const std::string& tag) const
+    {
+        int tagId = findTag(tag);
+        return isValid(obj) && tagId >= 0 && (tagMasks[slots[obj.getIndex()].dense] & (1u << tagId)) != 0;
+    }
+
+    std::vector<std::string> Scene::getTags(const GameObjectHandle& obj) const
+    {
+        std::vector<std::string> tags;
+        if (!isValid(obj))
+            return tags;
+
+        uint32_t mask = tagMasks[slots[obj.getIndex()].dense];
+        for (size_t tagId = 0; tagId < tagNames.size(); tagId++) {
+            if (mask & (1u << tagId))
+                tags.push_back(tagNames[tagId]);
+        }
+        return tags;
+    }
+
+    int Scene::findTag(const std::string& tag) const
+    {
+        for (size_t i = 0; i < tagNames.size(); i++) {
+            if (tagNames[i] == tag)
+                return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    void Scene::indexInsert(uint32_t dense)
+    {
+        auto& bucket = nameIndex[names[dense]];
+        namePositions[dense] = static_cast<uint32_t>(bucket.size());
+        bucket.push_back(denseToSlot[dense]);
+    }
+
+    void Scene::indexRemove(uint32_t dense)
+    {
+        uint32_t slot = denseToSlot[dense];
+
+        eraseFromNameIndex(dense);
+
+        for (size_t tagId = 0; tagId < tagIndex.size(); tagId++) {
+            if (tagMasks[dense] & (1u << tagId))
+                tagIndex[tagId].erase(slot);
+        }
+
+        meshIndex.erase(slot);
+        eraseLight(slot);
+        if (const ScriptComponent* script = scripts[dense].get())
+            scriptIndex[std::type_index(typeid(*script))].erase(slot);
+    }
+
+    void Scene::indexRename(uint32_t dense, const std::string& newName)
+    {
+        if (names[dense] == newName)
+            return;
+
+        eraseFromNameIndex(dense);
+        names[dense] = newName;
+        indexInsert(dense);
+    }
+
+    void Scene::eraseFromNameIndex(uint32_t dense)
+    {
+        auto it = nameIndex.find(names[dense]);
+        if (it == nameIndex.end())
+            return;
+
+        auto& bucket = it->second;
+        uint32_t position = namePositions[dense];
+        uint32_t moved = bucket.back();
+        bucket[position] = moved;
+        namePositions[slots[moved].dense] = position;
+        bucket.pop_back();
+
+        // Unique names would otherwise grow the index forever
+        if (bucket.empty() && nameIndex.size() > 2 * gameObjects.size() + 64)
+            nameIndex.erase(it);
+    }
+
+    void Scene::indexComponents(uint32_t dense)
+    {
+        uint32_t slot = denseToSlot[dense];
+
+        if (meshes[dense])
+            meshIndex.insert(slot);
+        else
+            meshIndex.erase(slot);
+
+        indexLight(dense);
+    }
+
+    void Scene::indexLight(uint32_t dense)
+    {
+        uint32_t slot = denseToSlot[dense];
+        if (lights[dense].type == LightType::None) {
+            eraseLight(slot);
+            return;
+        }
+
+        if (!lightIndex.contains(slot)) {
+            lightIndex.insert(slot);
+            packedLights.emplace_back();
+        }
+        packLight(dense);
+    }
+
+    void Scene::eraseLight(uint32_t slot)
+    {
+        if (!lightIndex.contains(slot))
+            return;
+
+        // SlotSet::erase moves the last member into the hole, the packed array follows it
+        uint32_t position = lightIndex.positions[slot];
+        lightIndex.erase(slot);
+        packedLights[position] = packedLights.back();
+        packedLights.pop_back();
+        if (position < packedLights.size())
+            markLightRangeDirty(position);
+    }
+
+    void Scene::packLight(uint32_t dense)
+    {
+        uint32_t position = lightIndex.positions[denseToSlot[dense]];
+        Light& light = packedLights[position];
+        // The shadow index belongs to the renderer, it follows the light through repacks and moves
+        int32_t shadowIndex = light.shadowIndex;
+        light = lights[dense];
+        light.shadowIndex = shadowIndex;
+        // Lights shine along the object's +z, the way the camera looks
+        const glm::vec3 forward(worldMatrices[dense][2]);
+        const float length = glm::length(forward);
+        light.direction = length > 0.0f ? forward / length : glm::vec3(0.0f, 0.0f, 1.0f);
+        light.position = glm::vec3(worldMatrices[dense][3]);
+        markLightRangeDirty(position);
+    }
+
+    void Scene::markLightRangeDirty(uint32_t position)
+    {
+        if (!dirtyLightRanges.empty()) {
+            LightRange& last = dirtyLightRanges.back();
+            if (position >= last.begin && position <= last.end) {
+                last.end = std::max(last.end, position + 1);
+                return;
+            }
+        }
+
+        if (dirtyLightRanges.size() == MAX_DIRTY_LIGHT_RANGES) {
+            LightRange merged{ position, position + 1 };
+            for (const LightRange& range : dirtyLightRanges) {
+                merged.begin = std::min(merged.begin, range.begin);
+                merged.end = std::max(merged.end, range.end);
+            }
+            dirtyLightRanges.assign(1, merged);
+            return;
+        }
+
+        dirtyLightRanges.push_back({ position, position + 1 });
+    }
+
+    void Scene::setLightShadow(uint32_t position, int32_t shadowIndex)
+    {
+        if (packedLights[position].shadowIndex == shadowIndex)
+            return;
+        packedLights[position].shadowIndex = shadowIndex;
+        markLightRangeDirty(position);
+    }
+
+    std::vector<Light>& Scene::editLights()
+    {
+        std::fill(lightDirty.begin(), lightDirty.end(), 1);
+        anyLightDirty = true;
+        return lights;
+    }
+
+    void Scene::updateLights()
+    {
+        if (!anyLightDirty.exchange(false))
+            return;
+
+        for (uint32_t dense = 0; dense < lightDirty.size(); dense++) {
+            if (lightDirty[dense]) {
+                indexLight(dense);
+                lightDirty[dense] = 0;
+            }
+        }
+    }
+
+    void Scene::indexScript(uint32_t dense, const ScriptComponent* oldScript, const ScriptComponent* newScript)
+    {
+        uint32_t slot = denseToSlot[dense];
+        if (oldScript)
+            scriptIndex[std::type_index(typeid(*oldScript))].erase(slot);
+        if (newScript)
+            scriptIndex[std::type_index(typeid(*newScript))].insert(slot);
+    }
+
+    void Scene::clearIndices()
+    {
+        nameIndex.clear();
+        tagNames.clear();
+        tagIndex.clear();
+        meshIndex.clear();
+        lightIndex.clear();
+        scriptIndex.clear();
+        anyLightDirty = false;
+        packedLights.clear();
+        dirtyLightRanges.clear();
+    }
+
+    bool Scene::setParent(const GameObjectHandle& child, const GameObjectHandle& parent)
+    {
+        if (!isValid(child))
+            return false;
+
+        uint32_t childSlot = child.getIndex();
+        bool attach = isValid(parent);
+
+        if (attach) {
+            for (uint32_t slot = parent.getIndex(); slot != INVALID_INDEX; slot = hierarchy[slots[slot].dense].parent) {
+                if (slot == childSlot) {
+                    std::cerr << "[Scene] Cannot parent an object to itself or one of its children!\n";
+                    return false;
+                }
+            }
+        }
+
+        detachFromParent(childSlot);
+
+        if (attach) {
+            auto& node = hierarchy[slots[childSlot].dense];
+            auto& parentNode = hierarchy[slots[parent.getIndex()].dense];
+
+            node.parent = parent.getIndex();
+            node.nextSibling = parentNode.firstChild;
+            if (parentNode.firstChild != INVALID_INDEX)
+                hierarchy[slots[parentNode.firstChild].dense].prevSibling = childSlot;
+            parentNode.firstChild = childSlot;
+        }
+
+        markTransformDirty(slots[childSlot].dense);
+        return true;
+    }
+
+    GameObjectHandle Scene::getParent(const GameObjectHandle& child) const
+    {
+        if (!isValid(child))
+            return GameObjectHandle();
+
+        uint32_t parent = hierarchy[slots[child.getIndex()].dense].parent;
+        if (parent == INVALID_INDEX)
+            return GameObjectHandle();
+
+        return GameObjectHandle(parent, slots[parent].generation, const_cast<Scene*>(this));
+    }
+
+    std::vector<GameObjectHandle> Scene::getChildren(const GameObjectHandle& obj) const
+    {
+        std::vector<GameObjectHandle> children;
+        if (!isValid(obj))
+            return children;
+
+        uint32_t child = hierarchy[slots[obj.getIndex()].dense].firstChild;
+        while (child != INVALID_INDEX) {
+            children.emplace_back(child, slots[child].generation, const_cast<Scene*>(this));
+            child = hierarchy[slots[child].dense].nextSibling;
+        }
+        return children;
+    }
+
+    void Scene::onUpdate(float dt)
+    {
+        parallelScripts.clear();
+        for (auto& script : scripts) {
+            if (script && script->getAccess() == ScriptAccess::OwnerOnly)
+                parallelScripts.push_back(script.get());
+        }
+
+        // Nothing structural can happen while these run, shared scripts only start after the join
+        JobSystem::getInstance().parallelFor(parallelScripts.size(), 64, [this, dt](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                parallelScripts[i]->onUpdate(dt);
+        });
+
+        // Creation order, through handles since shared scripts may create and destroy objects directly.
+        // Objects created here start updating next frame.
+        sharedScriptObjects.clear();
+        const std::vector<uint32_t>& order = getCreationOrder();
+        for (size_t i = 0; i < order.size(); i++) {
+            if (scripts[order[i]] && scripts[order[i]]->getAccess() == ScriptAccess::Shared)
+                sharedScriptObjects.push_back(creationHandles[i]);
+        }
+        for (const GameObjectHandle& handle : sharedScriptObjects) {
+            if (!isValid(handle))
+                continue;
+            auto* script = scripts[slots[handle.getIndex()].dense].get();
+            if (script && script->getAccess() == ScriptAccess::Shared)
+                script->onUpdate(dt);
+        }
+
+        applyDeferredCommands();
+        updateTransforms();
+        updateLights();
+    }
+
+    const std::vector<uint32_t>& Scene::getCreationOrder()
+    {
+        if (creationOrderVersion != structureVersion) {
+            creationHandles.erase(
+                std::remove_if(creationHandles.begin(), creationHandles.end(), [this](const GameObjectHandle& handle) { return !isValid(handle); }),
+                creationHandles.end());
+
+            creationOrder.resize(creationHandles.size());
+            for (size_t i = 0; i < creationHandles.size(); i++)
+                creationOrder[i] = slots[creationHandles[i].getIndex()].dense;
+            creationOrderVersion = structureVersion;
+        }
+        return creationOrder;
+    }
+
+    std::vector<TransformComponent>& Scene::editTransforms()
+    {
+        for (uint32_t dense = 0; dense < transforms.size(); dense++)
+            markTransformDirty(dense);
+        return transforms;
+    }
+
+    void Scene::updateTransforms()
+    {
+        // Nothing moved since the last update, static scenes stop here
+        const uint32_t queued = dirtyTransformCount.load(std::memory_order_relaxed);
+        if (queued == 0)
+            return;
+
+        size_t count = transforms.size();
+
+        // A reused slot can be queued twice, the first entry takes the object
+        dirtyScratch.clear();
+        for (uint32_t i = 0; i < queued; i++) {
+            uint32_t dense = slots[dirtyTransformSlots[i]].dense;
+            if (dense == INVALID_INDEX || !transformDirty[dense] || (transformDirty[dense] & TRANSFORM_GATHERED))
+                continue;
+            transformDirty[dense] |= TRANSFORM_GATHERED;
+            dirtyScratch.push_back(dense);
+        }
+
+        // Mostly dirty, recomposing everything in place beats the gather and scatter
+        if (dirtyScratch.size() * 2 > count) {
+            simd::composeTransforms(transforms.data(), localMatrices.data(), count);
+        }
+        else {
+            transformScratch.clear();
+            for (uint32_t dense : dirtyScratch) {
+                if (transformDirty[dense] & TRANSFORM_LOCAL_DIRTY)
+                    transformScratch.push_back(transforms[dense]);
+            }
+            matrixScratch.resize(transformScratch.size());
+
+            simd::composeTransforms(transformScratch.data(), matrixScratch.data(), transformScratch.size());
+
+            size_t next = 0;
+            for (uint32_t dense : dirtyScratch) {
+                if (transformDirty[dense] & TRANSFORM_LOCAL_DIRTY)
+                    localMatrices[dense] = matrixScratch[next++];
+            }
+        }
+
+        // Walks start at dirty objects with no dirty ancestor, everything else dirty is somewhere below one
+        levelScratch.clear();
+        for (uint32_t dense : dirtyScratch) {
+            bool covered = false;
+            for (uint32_t slot = hierarchy[dense].parent; slot != INVALID_INDEX && !covered; slot = hierarchy[slots[slot].dense].parent)
+                covered = (transformDirty[slots[slot].dense] & TRANSFORM_GATHERED) != 0;
+            if (!covered)
+                levelScratch.push_back(dense);
+        }
+
+        // Each step goes one level further down from every root. Parents are either clean or were done in the
+        // step before, so a step is one batch.
+        movedScratch.clear();
+        while (!levelScratch.empty()) {
+            lhsScratch.clear();
+            rhsScratch.clear();
+            outScratch.clear();
+            nextLevelScratch.clear();
+
+            for (uint32_t dense : levelScratch) {
+                uint32_t parent = hierarchy[dense].parent;
+                if (parent == INVALID_INDEX) {
+                    worldMatrices[dense] = localMatrices[dense];
+                }
+                else {
+                    lhsScratch.push_back(&worldMatrices[slots[parent].dense]);
+                    rhsScratch.push_back(&localMatrices[dense]);
+                    outScratch.push_back(&worldMatrices[dense]);
+                }
+                movedScratch.push_back(dense);
+
+                for (uint32_t child = hierarchy[dense].firstChild; child != INVALID_INDEX; child = hierarchy[slots[child].dense].nextSibling)
+                    nextLevelScratch.push_back(slots[child].dense);
+            }
+
+            simd::multiplyMatrices(lhsScratch.data(), rhsScratch.data(), outScratch.data(), outScratch.size());
+            levelScratch.swap(nextLevelScratch);
+        }
+
+        updateSpatialIndex();
+
+        // Every queued object was gathered and every gathered one lies in a walked subtree
+        for (uint32_t dense : movedScratch)
+            transformDirty[dense] = 0;
+        dirtyTransformCount.store(0, std::memory_order_relaxed);
+    }
+
+    void Scene::detachFromParent(uint32_t slot)
+    {
+        auto& node = hierarchy[slots[slot].dense];
+        if (node.parent == INVALID_INDEX)
+            return;
+
+        if (node.prevSibling != INVALID_INDEX)
+            hierarchy[slots[node.prevSibling].dense].nextSibling = node.nextSibling;
+        else
+            hierarchy[slots[node.parent].dense].firstChild = node.nextSibling;
+
+        if (node.nextSibling != INVALID_INDEX)
+            hierarchy[slots[node.nextSibling].dense].prevSibling = node.prevSibling;
+
+        node.parent = INVALID_INDEX;
+        node.prevSibling = INVALID_INDEX;
+        node.nextSibling = INVALID_INDEX;
+    }
+
+    void Scene::updateSpatialIndex()
+    {
+        bool anyMoved = false;
+        bool staticMoved = false;
+        for (uint32_t dense : movedScratch) {
+            anyMoved = true;
+
+            const glm::mat4& world = worldMatrices[dense];
+            if (meshes[dense]) {
+                glm::vec3 center, extents;
+                meshes[dense]->getBounds().transform(world, center, extents);
+                worldBounds[dense] = AABB::fromCenterExtents(center, extents);
+            }
+            else {
+                worldBounds[dense] = AABB::fromCenterExtents(glm::vec3(world[3]), glm::vec3(0.0f));
+            }
+
+            if (spatialProxies[dense] == AABBTree::NULL_NODE)
+                spatialProxies[dense] = spatialTree.createProxy(worldBounds[dense], denseToSlot[dense]);
+            else
+                spatialTree.moveProxy(spatialProxies[dense], worldBounds[dense]);
+
+            if (lightIndex.contains(denseToSlot[dense]))
+                packLight(dense);
+            staticMoved |= staticFlags[dense] != 0;
+        }
+
+        if (anyMoved)
+            transformVersion++;
+        if (staticMoved)
+            staticVersion++;
+    }
+
+    bool Scene::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RaycastHit& hit) const
+    {
+        float length = glm::length(direction);
+        if (length == 0.0f)
+            return false;
+        const glm::vec3 dir = direction / length;
+        const glm::vec3 inverseDirection = 1.0f / dir;
+
+        int32_t closest = AABBTree::NULL_NODE;
+        float closestDistance = maxDistance;
+
+        // Leaves are fat, the exact test against the object's bounds decides the hit
+        spatialTree.raycast(origin, dir, maxDistance, [&](int32_t proxyId, float currentMax) {
+            uint32_t dense = slots[spatialTree.getUserData(proxyId)].dense;
+            float distance;
+            if (worldBounds[dense].intersectsRay(origin, inverseDirection, currentMax, distance) && distance < closestDistance) {
+                closest = proxyId;
+                closestDistance = distance;
+                return distance;
+            }
+            return currentMax;
+        });
+
+        if (closest == AABBTree::NULL_NODE)
+            return false;
+
+        hit.object = handleFromProxy(closest);
+        hit.distance = closestDistance;
+        hit.point = origin + dir * closestDistance;
+        return true;
+    }
+
+    size_t Scene::overlapBox(const AABB& box, std::vector<GameObjectHandle>& out) const
+    {
+        out.clear();
+        spatialTree.query(box, [&](int32_t proxyId) {
+            uint32_t dense = slots[spatialTree.getUserData(proxyId)].dense;
+            if (worldBounds[dense].overlaps(box))
+                out.push_back(handleFromProxy(proxyId));
+            return true;
+        });
+        return out.size();
+    }
+
+    size_t Scene::overlapSphere(const glm::vec3& center, float radius, std::vector<GameObjectHandle>& out) const
+    {
+        out.clear();
+        const AABB box = AABB::fromCenterExtents(center, glm::vec3(radius));
+        const float radiusSquared = radius * radius;
+
+        spatialTree.query(box, [&](int32_t proxyId) {
+            uint32_t dense = slots[spatialTree.getUserData(proxyId)].dense;
+            if (worldBounds[dense].distanceSquared(center) <= radiusSquared)
+                out.push_back(handleFromProxy(proxyId));
+            return true;
+        });
+        return out.size();
+    }
+
+    size_t Scene::overlapBoxDense(const AABB& box, std::vector<uint32_t>& out) const
+    {
+        out.clear();
+        spatialTree.query(box, [&](int32_t proxyId) {
+            uint32_t dense = slots[spatialTree.getUserData(proxyId)].dense;
+            if (worldBounds[dense].overlaps(box))
+                out.push_back(dense);
+            return true;
+        });
+        return out.size();
+    }
+
+    size_t Scene::findNearest(const glm::vec3& point, size_t k, std::vector<GameObjectHandle>& out) const
+    {
+        out.clear();
+        if (k == 0)
+            return 0;
+
+        auto distanceTo = [&](const GameObjectHandle& handle) {
+            return worldBounds[slots[handle.getIndex()].dense].distanceSquared(point);
+        };
+
+        // out stays sorted nearest first, k is expected to be small so insertion is a linear shift
+        spatialTree.nearest(point, FLT_MAX, [&](int32_t proxyId) {
+            GameObjectHandle candidate = handleFromProxy(proxyId);
+            float distance = distanceTo(candidate);
+
+            if (out.size() < k || distance < distanceTo(out.back())) {
+                if (out.size() == k)
+                    out.pop_back();
+                auto position = std::find_if(out.begin(), out.end(), [&](const GameObjectHandle& other) {
+                    return distance < distanceTo(other);
+                });
+                out.insert(position, candidate);
+            }
+
+            return out.size() < k ? FLT_MAX : distanceTo(out.back());
+        });
+
+        return out.size();
+    }
+
+}
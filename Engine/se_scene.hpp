@@ -2,83 +2,593 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
 #include "se_camera.hpp"
 #include "se_gameobject.hpp"
 #include "se_gameobject_handle.hpp"
+#include "se_aabb_tree.hpp"
 
 namespace se {
+    // Initial state for an object created through the deferred command buffer
+    struct GameObjectDesc {
+        std::string name;
+        TransformComponent transform{};
+        std::shared_ptr<SEMesh> mesh{};
+        std::shared_ptr<SEMaterial> material{};
+        Light light{};
+        bool isStatic = false;
+        GameObjectHandle parent{};
+    };
+
+    // Half open range of positions in the scene's packed light array
+    struct LightRange {
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    struct RaycastHit {
+        GameObjectHandle object;
+        float distance = 0.0f;
+        glm::vec3 point{ 0.0f };
+    };
+
     class Scene {
     public:
         Scene(const std::string& name) : name(name) {}
 
+        Scene(const Scene&) = delete;
+        Scene& operator=(const Scene&) = delete;
+
         GameObjectHandle createGameObject(const std::string& name) {
-            auto obj = std::make_unique<SEGameObject>(name);
-            int id = obj->id;
-            gameObjects.push_back(std::move(obj));
-            return GameObjectHandle(id, this);
+            return insertGameObject(name);
         }
 
         SEGameObject& createGameObjectRef(const std::string& name) {
-            auto obj = std::make_unique<SEGameObject>(name);
-            auto& ref = *obj;
-            gameObjects.push_back(std::move(obj));
-            return *gameObjects.back();
+            return *insertGameObject(name);
         }
 
+        // First object with this name, constant time through the name index
         GameObjectHandle getGameObjectByName(const std::string& objName) {
-            for (auto& obj : gameObjects) {
-                if (obj && obj->getName() == objName)
-                    return GameObjectHandle(obj->id, this);
-            }
-            return GameObjectHandle();
+            GameObjectView found = findByName(objName);
+            return found.empty() ? GameObjectHandle() : found.getHandle(0);
         }
 
-        SEGameObject* getGameObjectById(int id) {
-            for (auto& obj : gameObjects) {
-                if (obj && obj->id == id)
-                    return obj.get();
-            }
-            return nullptr;
+        GameObjectHandle getHandle(const SEGameObject& obj) {
+            return GameObjectHandle(obj.slot, slots[obj.slot].generation, this);
         }
 
-        void destroyGameObject(int id)
-        {
-            for (auto it = gameObjects.begin(); it != gameObjects.end(); ++it) {
-                if (*it && (*it)->id == id) {
-                    gameObjects.erase(it);
-                    break;
-                }
-            }
+        // Constant time lookup, returns nullptr if the slot was destroyed or reused since the handle was made
+        SEGameObject* resolve(uint32_t index, uint32_t generation) const {
+            if (index >= slots.size() || slots[index].generation != generation || slots[index].dense == INVALID_INDEX)
+                return nullptr;
+            return gameObjects[slots[index].dense].get();
         }
 
-        void onUpdate(float dt) {
-            for (auto& obj : gameObjects) {
-                if (!obj) {
-                    std::cerr << "[Scene] Null object in gameObjects!\n";
-                    continue;
-                }
-                obj->onUpdate(dt);
-            }
+        // Destroys the object together with all of its children
+        void destroyGameObject(const GameObjectHandle& handle) {
+            destroyGameObjects(&handle, 1);
         }
+        // Batched form, overlapping subtrees and stale handles are fine
+        void destroyGameObjects(const GameObjectHandle* handles, size_t count);
+
+        // OwnerOnly scripts are fanned out over the job system first, then the shared ones run serially.
+        // Deferred commands recorded by either are applied once both are done.
+        void onUpdate(float dt);
+
+        // Structural changes recorded while scripts run and applied together at the next sync point.
+        // Safe to call from parallel scripts, nothing in the pools moves until applyDeferredCommands.
+        // The returned handle is reserved right away but only resolves once the create is applied.
+        GameObjectHandle deferCreateGameObject(GameObjectDesc desc);
+        void deferDestroyGameObject(const GameObjectHandle& handle);
+        void deferSetParent(const GameObjectHandle& child, const GameObjectHandle& parent);
+        // Sync point, main thread only. Creates go first so later commands can refer to them.
+        void applyDeferredCommands();
+
+        // Grows every pool up front, e.g. before spawning a known number of objects
+        void reserveGameObjects(size_t count);
+
+        // Parent a child under another object, an invalid parent handle detaches it.
+        // The child's transform is kept as a local transform relative to the new parent.
+        bool setParent(const GameObjectHandle& child, const GameObjectHandle& parent);
+        GameObjectHandle getParent(const GameObjectHandle& child) const;
+        std::vector<GameObjectHandle> getChildren(const GameObjectHandle& obj) const;
+
+        // Recomputes local matrices of dirty transforms and world matrices of dirty subtrees
+        void updateTransforms();
+        // Main thread only, folds lights edited through a mutable reference into the index and the packed array
+        void updateLights();
 
         void onDestroy() {
-            for (auto& obj : gameObjects) {
-                obj->onDestroy();
+            discardDeferredCommands();
+
+            for (auto& script : scripts) {
+                if (script) script->onDestroy();
             }
+
+            for (uint32_t slot : denseToSlot)
+                releaseSlot(slot);
+
+            localMatrices.clear();
+            worldMatrices.clear();
+            worldBounds.clear();
+            spatialProxies.clear();
+            spatialTree.clear();
+            transformDirty.clear();
+            lightDirty.clear();
+            staticFlags.clear();
+            hierarchy.clear();
+            dirtyTransformCount = 0;
+            structureVersion++;
+            staticVersion++;
+
+            scripts.clear();
             gameObjects.clear();
+            names.clear();
+            transforms.clear();
+            lights.clear();
+            meshes.clear();
+            materials.clear();
+            denseToSlot.clear();
+            namePositions.clear();
+            tagMasks.clear();
+            clearIndices();
         }
 
+        // Objects matching a query, borrowed straight from the scene's indices so iterating allocates nothing.
+        // Invalidated by the next create, destroy or index change, copy the handles out to keep them longer.
+        class GameObjectView {
+        public:
+            class Iterator {
+            public:
+                Iterator(const Scene* scene, const uint32_t* slot) : scene{ scene }, slot{ slot } {}
+
+                SEGameObject& operator*() const { return *scene->gameObjects[scene->slots[*slot].dense]; }
+                SEGameObject* operator->() const { return scene->gameObjects[scene->slots[*slot].dense].get(); }
+                Iterator& operator++() { ++slot; return *this; }
+                bool operator==(const Iterator& other) const { return slot == other.slot; }
+                bool operator!=(const Iterator& other) const { return slot != other.slot; }
+
+            private:
+                const Scene* scene;
+                const uint32_t* slot;
+            };
+
+            GameObjectView() = default;
+
+            Iterator begin() const { return Iterator(scene, first); }
+            Iterator end() const { return Iterator(scene, last); }
+            size_t size() const { return static_cast<size_t>(last - first); }
+            bool empty() const { return first == last; }
+
+            SEGameObject& operator[](size_t i) const { return *scene->gameObjects[scene->slots[first[i]].dense]; }
+            GameObjectHandle getHandle(size_t i) const {
+                return GameObjectHandle(first[i], scene->slots[first[i]].generation, const_cast<Scene*>(scene));
+            }
+
+        private:
+            friend class Scene;
+
+            GameObjectView(const Scene* scene, const std::vector<uint32_t>& slotList)
+                : scene{ scene }, first{ slotList.data() }, last{ slotList.data() + slotList.size() } {}
+
+            const Scene* scene = nullptr;
+            const uint32_t* first = nullptr;
+            const uint32_t* last = nullptr;
+        };
+
+        GameObjectView findByName(const std::string& objName) const;
+        GameObjectView findByTag(const std::string& tag) const;
+        GameObjectView findWithMesh() const;
+        // Main thread only, first calls updateLights
+        GameObjectView findWithLight();
+        GameObjectView findWithScript(std::type_index scriptType) const;
+        template<typename T>
+        GameObjectView findWithScript() const { return findWithScript(std::type_index(typeid(T))); }
+
+        // Spatial queries over world bounds, the mesh AABB or just the position for objects without a mesh.
+        // They see the transforms as of the last updateTransforms and only read, so parallel scripts may use them.
+        // Results go into out, which is cleared first.
+        bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RaycastHit& hit) const;
+        size_t overlapBox(const AABB& box, std::vector<GameObjectHandle>& out) const;
+        size_t overlapSphere(const glm::vec3& center, float radius, std::vector<GameObjectHandle>& out) const;
+        // Up to k objects ordered nearest first
+        size_t findNearest(const glm::vec3& point, size_t k, std::vector<GameObjectHandle>& out) const;
+        // overlapBox returning dense indices, for renderers reading the pools directly
+        size_t overlapBoxDense(const AABB& box, std::vector<uint32_t>& out) const;
+
+        // Free form labels, at most MAX_TAGS distinct tags per scene
+        bool addTag(const GameObjectHandle& obj, const std::string& tag);
+        void removeTag(const GameObjectHandle& obj, const std::string& tag);
+        bool hasTag(const GameObjectHandle& obj, const std::string& tag) const;
+        std::vector<std::string> getTags(const GameObjectHandle& obj) const;
+
         // Add methods to find objects, manage camera, etc.
         SECamera& getCamera() { return camera; }
         const std::string& getName() const { return name; }
-        std::list<std::unique_ptr<SEGameObject>>& getGameObjects() { return gameObjects; }
+        // Dense order, which is unspecified: destroying an object moves the last one into its place
+        const std::vector<std::unique_ptr<SEGameObject>>& getGameObjects() const { return gameObjects; }
+        // Dense indices in creation order, stable across destroys. Shared scripts update in this order and the
+        // editor lists objects by it. Rebuilt after structural changes, valid until the next one.
+        const std::vector<uint32_t>& getCreationOrder();
+
+        // Dense component pools, every array is indexed by the same dense index
+        size_t getObjectCount() const { return gameObjects.size(); }
+        const std::vector<TransformComponent>& getTransforms() const { return transforms; }
+        // Bulk write access, marks every transform dirty
+        std::vector<TransformComponent>& editTransforms();
+        const std::vector<glm::mat4>& getWorldMatrices() const { return worldMatrices; }
+        const std::vector<AABB>& getWorldBounds() const { return worldBounds; }
+        const AABBTree& getSpatialTree() const { return spatialTree; }
+        const std::vector<Light>& getLights() const { return lights; }
+        // Bulk write access, every light is repacked on the next updateLights
+        std::vector<Light>& editLights();
+
+        // Every light in the scene with world space position and direction, in findWithLight order.
+        // Kept up to date by light edits and transform updates, so static lights cost nothing per frame.
+        const std::vector<Light>& getPackedLights() const { return packedLights; }
+        // Packed positions rewritten since the consumer last cleared them. Removing a light moves the last one
+        // into its hole, which marks the hole, so a consumer copying these ranges stays in sync.
+        const std::vector<LightRange>& getDirtyLightRanges() const { return dirtyLightRanges; }
+        void clearDirtyLightRanges() { dirtyLightRanges.clear(); }
+        // Renderer side shadow assignment on the packed copy, marks the light dirty when it changes
+        void setLightShadow(uint32_t position, int32_t shadowIndex);
+        const std::vector<std::shared_ptr<SEMesh>>& getMeshes() const { return meshes; }
+        const std::vector<std::shared_ptr<SEMaterial>>& getMaterials() const { return materials; }
+        const std::vector<uint8_t>& getStaticFlags() const { return staticFlags; }
 
+        // Change counters for renderers that keep their own copy of the pools. The structure version moves
+        // when objects come and go or swap mesh or material, the transform version when world matrices change.
+        uint64_t getStructureVersion() const { return structureVersion; }
+        uint64_t getTransformVersion() const { return transformVersion; }
+        // Moves when a static object comes, goes, moves, swaps mesh or changes its static flag
+        uint64_t getStaticVersion() const { return staticVersion; }
+
+        static constexpr size_t MAX_TAGS = 32;
 
     private:
+        friend class SEGameObject;
+
+        static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+        // Any flag set means the object's slot is in dirtyTransformSlots
+        static constexpr uint8_t TRANSFORM_LOCAL_DIRTY = 1;
+        static constexpr uint8_t TRANSFORM_WORLD_DIRTY = 2;
+        // Only inside updateTransforms, the object was taken off the queue
+        static constexpr uint8_t TRANSFORM_GATHERED = 4;
+        // Past this many ranges they are collapsed into one covering them all
+        static constexpr size_t MAX_DIRTY_LIGHT_RANGES = 32;
+
+        struct Slot {
+            uint32_t dense = INVALID_INDEX;
+            uint32_t generation = 1;
+        };
+
+        // Intrusive child list, every link is a slot index
+        struct HierarchyComponent {
+            uint32_t parent = INVALID_INDEX;
+            uint32_t firstChild = INVALID_INDEX;
+            uint32_t nextSibling = INVALID_INDEX;
+            uint32_t prevSibling = INVALID_INDEX;
+        };
+
+        // Sparse set over slot indices, constant time insert, erase and membership.
+        // members is what the query views iterate.
+        struct SlotSet {
+            std::vector<uint32_t> members;
+            std::vector<uint32_t> positions;
+
+            bool contains(uint32_t slot) const {
+                return slot < positions.size() && positions[slot] != INVALID_INDEX;
+            }
+
+            void insert(uint32_t slot) {
+                if (contains(slot))
+                    return;
+                if (slot >= positions.size())
+                    positions.resize(slot + 1, INVALID_INDEX);
+                positions[slot] = static_cast<uint32_t>(members.size());
+                members.push_back(slot);
+            }
+
+            void erase(uint32_t slot) {
+                if (!contains(slot))
+                    return;
+                uint32_t position = positions[slot];
+                uint32_t moved = members.back();
+                members[position] = moved;
+                positions[moved] = position;
+                members.pop_back();
+                positions[slot] = INVALID_INDEX;
+            }
+
+            void clear() {
+                members.clear();
+                positions.clear();
+            }
+        };
+
+        uint32_t denseIndex(uint32_t slot) const { return slots[slot].dense; }
+
+        // Index maintenance, called from the pool and facade mutators
+        void indexInsert(uint32_t dense);
+        void indexRemove(uint32_t dense);
+        void indexRename(uint32_t dense, const std::string& newName);
+        void eraseFromNameIndex(uint32_t dense);
+        void indexComponents(uint32_t dense);
+        void indexScript(uint32_t dense, const ScriptComponent* oldScript, const ScriptComponent* newScript);
+        int findTag(const std::string& tag) const;
+        void clearIndices();
+
+        // Light registry, keeps packedLights parallel to lightIndex.members
+        void indexLight(uint32_t dense);
+        void eraseLight(uint32_t slot);
+        void packLight(uint32_t dense);
+        void markLightRangeDirty(uint32_t position);
+
+        // Parallel scripts may hand out light references, so the shared flag is only written when it changes
+        void markLightDirty(uint32_t dense) {
+            lightDirty[dense] = 1;
+            if (!anyLightDirty.load(std::memory_order_relaxed))
+                anyLightDirty.store(true, std::memory_order_relaxed);
+        }
+
+        // Parallel scripts mark their own owners, each object's flags are only written by one thread
+        void markTransformDirty(uint32_t dense) {
+            if (!transformDirty[dense])
+                queueTransform(dense);
+            transformDirty[dense] |= TRANSFORM_LOCAL_DIRTY;
+        }
+
+        // The mesh changed, so the world bounds have to be rebuilt even if the transform didn't move
+        void markBoundsDirty(uint32_t dense) {
+            if (!transformDirty[dense])
+                queueTransform(dense);
+            transformDirty[dense] |= TRANSFORM_WORLD_DIRTY;
+        }
+
+        // insertIntoPools keeps room for every live object, so this never reallocates under parallel scripts
+        void queueTransform(uint32_t dense) {
+            uint32_t at = dirtyTransformCount.fetch_add(1, std::memory_order_relaxed);
+            dirtyTransformSlots[at] = denseToSlot[dense];
+        }
+
+        // Recomputes world bounds of movedScratch and moves their tree proxies
+        void updateSpatialIndex();
+
+        GameObjectHandle handleFromProxy(int32_t proxyId) const {
+            uint32_t slot = spatialTree.getUserData(proxyId);
+            return GameObjectHandle(slot, slots[slot].generation, const_cast<Scene*>(this));
+        }
+
+        bool isValid(const GameObjectHandle& handle) const {
+            return resolve(handle.getIndex(), handle.getGeneration()) != nullptr;
+        }
+
+        void detachFromParent(uint32_t slot);
+
+        void discardDeferredCommands();
+
+        // Fresh slots reserved by deferCreateGameObject only exist once the table is grown to cover them
+        void materializeReservedSlots() {
+            if (reservedSlotCount == 0)
+                return;
+            slots.resize(slots.size() + reservedSlotCount);
+            reservedSlotCount = 0;
+        }
+
+        GameObjectHandle insertGameObject(const std::string& objName) {
+            materializeReservedSlots();
+
+            uint32_t index;
+            if (!freeSlots.empty()) {
+                index = freeSlots.back();
+                freeSlots.pop_back();
+            }
+            else {
+                index = static_cast<uint32_t>(slots.size());
+                slots.emplace_back();
+            }
+
+            insertIntoPools(index, objName);
+            return GameObjectHandle(index, slots[index].generation, this);
+        }
+
+        void insertIntoPools(uint32_t index, const std::string& objName) {
+            slots[index].dense = static_cast<uint32_t>(gameObjects.size());
+            denseToSlot.push_back(index);
+            gameObjects.push_back(std::unique_ptr<SEGameObject>(new SEGameObject(this, index)));
+            names.push_back(objName);
+            transforms.emplace_back();
+            lights.emplace_back();
+            meshes.emplace_back();
+            materials.emplace_back();
+            scripts.emplace_back();
+            localMatrices.emplace_back(1.0f);
+            worldMatrices.emplace_back(1.0f);
+            worldBounds.emplace_back();
+            spatialProxies.push_back(AABBTree::NULL_NODE);
+            transformDirty.push_back(0);
+            lightDirty.push_back(0);
+            staticFlags.push_back(0);
+            hierarchy.emplace_back();
+            namePositions.push_back(INVALID_INDEX);
+            tagMasks.push_back(0);
+            creationHandles.emplace_back(index, slots[index].generation, this);
+            structureVersion++;
+
+            // Every live object can queue itself once before the next update
+            const size_t queueSize = dirtyTransformCount.load(std::memory_order_relaxed) + gameObjects.size();
+            if (dirtyTransformSlots.size() < queueSize)
+                dirtyTransformSlots.resize(queueSize * 2);
+            markTransformDirty(slots[index].dense);
+
+            indexInsert(slots[index].dense);
+        }
+
+        // Swap the last element into the hole so the pools stay packed
+        void removeDense(uint32_t dense) {
+            indexRemove(dense);
+            if (spatialProxies[dense] != AABBTree::NULL_NODE)
+                spatialTree.destroyProxy(spatialProxies[dense]);
+            if (staticFlags[dense])
+                staticVersion++;
+
+            uint32_t last = static_cast<uint32_t>(gameObjects.size() - 1);
+            if (dense != last) {
+                gameObjects[dense] = std::move(gameObjects[last]);
+                names[dense] = std::move(names[last]);
+                transforms[dense] = transforms[last];
+                lights[dense] = lights[last];
+                meshes[dense] = std::move(meshes[last]);
+                materials[dense] = std::move(materials[last]);
+                scripts[dense] = std::move(scripts[last]);
+                localMatrices[dense] = localMatrices[last];
+                worldMatrices[dense] = worldMatrices[last];
+                worldBounds[dense] = worldBounds[last];
+                spatialProxies[dense] = spatialProxies[last];
+                transformDirty[dense] = transformDirty[last];
+                lightDirty[dense] = lightDirty[last];
+                staticFlags[dense] = staticFlags[last];
+                hierarchy[dense] = hierarchy[last];
+                namePositions[dense] = namePositions[last];
+                tagMasks[dense] = tagMasks[last];
+                denseToSlot[dense] = denseToSlot[last];
+                slots[denseToSlot[dense]].dense = dense;
+            }
+
+            gameObjects.pop_back();
+            names.pop_back();
+            transforms.pop_back();
+            lights.pop_back();
+            meshes.pop_back();
+            materials.pop_back();
+            scripts.pop_back();
+            localMatrices.pop_back();
+            worldMatrices.pop_back();
+            worldBounds.pop_back();
+            spatialProxies.pop_back();
+            transformDirty.pop_back();
+            lightDirty.pop_back();
+            staticFlags.pop_back();
+            hierarchy.pop_back();
+            namePositions.pop_back();
+            tagMasks.pop_back();
+            denseToSlot.pop_back();
+
+            structureVersion++;
+        }
+
+        void releaseSlot(uint32_t index) {
+            Slot& slot = slots[index];
+            slot.dense = INVALID_INDEX;
+            // generation 0 is reserved for the null handle
+            if (++slot.generation == 0)
+                slot.generation = 1;
+            freeSlots.push_back(index);
+        }
+
         std::string name;
         se::SECamera camera{};
-        std::list<std::unique_ptr<SEGameObject>> gameObjects;
 
+        std::vector<Slot> slots;
+        std::vector<uint32_t> freeSlots;
+
+        std::vector<std::unique_ptr<SEGameObject>> gameObjects;
+        std::vector<uint32_t> denseToSlot;
+        std::vector<std::string> names;
+        std::vector<TransformComponent> transforms;
+        std::vector<Light> lights;
+        std::vector<std::shared_ptr<SEMesh>> meshes;
+        std::vector<std::shared_ptr<SEMaterial>> materials;
+        std::vector<std::unique_ptr<ScriptComponent>> scripts;
+        std::vector<glm::mat4> localMatrices;
+        std::vector<glm::mat4> worldMatrices;
+        std::vector<uint8_t> transformDirty;
+        std::vector<uint8_t> lightDirty;
+        std::vector<uint8_t> staticFlags;
+        std::vector<HierarchyComponent> hierarchy;
+        std::vector<AABB> worldBounds;
+        std::vector<int32_t> spatialProxies;
+
+        // Leaves carry slot indices, which stay put while dense indices get swapped around
+        AABBTree spatialTree;
+
+        // Position of each object inside its name bucket, and a bit per tag it carries
+        std::vector<uint32_t> namePositions;
+        std::vector<uint32_t> tagMasks;
+
+        // Every object in creation order, destroyed ones are dropped when creationOrder is rebuilt
+        std::vector<GameObjectHandle> creationHandles;
+        std::vector<uint32_t> creationOrder;
+        uint64_t creationOrderVersion = UINT64_MAX;
+
+        // Query indices. Name buckets hold slot indices and are kept when they empty out,
+        // so respawning objects under a name that was seen before doesn't allocate. Empty buckets
+        // are dropped once they outnumber the live objects, a new name allocates its node and bucket.
+        std::unordered_map<std::string, std::vector<uint32_t>> nameIndex;
+        std::vector<std::string> tagNames;
+        std::vector<SlotSet> tagIndex;
+        SlotSet meshIndex;
+        SlotSet lightIndex;
+        std::unordered_map<std::type_index, SlotSet> scriptIndex;
+        std::atomic<bool> anyLightDirty{ false };
+
+        // Packed by lightIndex position, see getPackedLights
+        std::vector<Light> packedLights;
+        std::vector<LightRange> dirtyLightRanges;
+
+        // Slots of the objects whose transformDirty went from clear to set since the last update, in the first
+        // dirtyTransformCount entries. Entries of objects destroyed since are skipped.
+        std::vector<uint32_t> dirtyTransformSlots;
+        std::atomic<uint32_t> dirtyTransformCount{ 0 };
+        uint64_t structureVersion = 0;
+        uint64_t transformVersion = 0;
+        uint64_t staticVersion = 0;
+
+        struct DeferredCreate {
+            uint32_t slot;
+            GameObjectDesc desc;
+        };
+
+        // Deferred command buffer, everything below is guarded by commandMutex
+        std::mutex commandMutex;
+        std::vector<DeferredCreate> pendingCreates;
+        std::vector<GameObjectHandle> pendingDestroys;
+        std::vector<std::pair<GameObjectHandle, GameObjectHandle>> pendingParents;
+        // Fresh slot indices handed out past the end of slots
+        uint32_t reservedSlotCount = 0;
+
+        // Swapped with the pending lists while applying so both keep their capacity between frames
+        std::vector<DeferredCreate> applyingCreates;
+        std::vector<GameObjectHandle> applyingDestroys;
+        std::vector<std::pair<GameObjectHandle, GameObjectHandle>> applyingParents;
+
+        // Scratch for destroyGameObjects, destroyMarks is all zero outside of it
+        std::vector<uint8_t> destroyMarks;
+        std::vector<uint32_t> destroyDense;
+        std::vector<uint32_t> destroySubtree;
+
+        // Scripts that asked to run on the job system this frame
+        std::vector<ScriptComponent*> parallelScripts;
+        std::vector<GameObjectHandle> sharedScriptObjects;
+
+        // Scratch for the batched kernels in updateTransforms, kept to avoid reallocating every frame
+        std::vector<uint32_t> dirtyScratch;
+        std::vector<TransformComponent> transformScratch;
+        std::vector<glm::mat4> matrixScratch;
+        std::vector<const glm::mat4*> lhsScratch;
+        std::vector<const glm::mat4*> rhsScratch;
+        std::vector<glm::mat4*> outScratch;
+        // Breadth first walk down from the dirty roots, and everything it recomputed
+        std::vector<uint32_t> levelScratch;
+        std::vector<uint32_t> nextLevelScratch;
+        std::vector<uint32_t> movedScratch;
     };
 
 } // namespace se
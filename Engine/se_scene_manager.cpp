@@ -47,6 +47,14 @@ bool se::SceneManager::saveScene(const std::string& sceneName, const std::string
         jgo["transform"]["rotation"] = { t.rotation.x, t.rotation.y, t.rotation.z };
         jgo["transform"]["scale"] = { t.scale.x, t.scale.y, t.scale.z };
 
+        if (go->isStatic())
+            jgo["static"] = true;
+
+        // Parent
+        if (auto* parent = go->getParent()) {
+            jgo["parent"] = parent->getId();
+        }
+
         // Mesh
         if (auto mesh = go->getMesh()) {
             jgo["mesh"] = mesh->getGUID();
@@ -65,6 +73,8 @@ bool se::SceneManager::saveScene(const std::string& sceneName, const std::string
             jgo["light"]["type"] = l.type;
             jgo["light"]["color"] = { l.color.r, l.color.g, l.color.b };
             jgo["light"]["intensity"] = l.intensity;
+            jgo["light"]["range"] = l.range;
+            jgo["light"]["castShadows"] = l.castShadows != 0;
         }
 
         // Script
@@ -72,6 +82,11 @@ bool se::SceneManager::saveScene(const std::string& sceneName, const std::string
             jgo["script"] = script->getName();
         }
 
+        // Tags
+        auto tags = go->getTags();
+        if (!tags.empty())
+            jgo["tags"] = tags;
+
         jscene["scene"]["gameObjects"].push_back(jgo);
     }
 
@@ -265,8 +280,11 @@ bool se::SceneManager::loadScene(const std::string& filePath, const std::string&
     }
 
     // --- Create game objects ---
+    std::unordered_map<SEGameObject::id_t, SEGameObject*> loadedObjects;
     for (const auto& jgo : sceneData["gameObjects"]) {
         auto& go = scene.createGameObjectRef(jgo["name"]);
+        if (jgo.contains("id"))
+            loadedObjects[jgo["id"].get<SEGameObject::id_t>()] = &go;
 
         // Transform
         if (jgo.contains("transform")) {
@@ -279,6 +297,9 @@ bool se::SceneManager::loadScene(const std::string& filePath, const std::string&
             t.scale = { scale[0], scale[1], scale[2] };
         }
 
+        if (jgo.contains("static"))
+            go.setStatic(jgo["static"].get<bool>());
+
         // Mesh
         if (jgo.contains("mesh")) {
             std::string meshGuid = jgo["mesh"];
@@ -301,6 +322,10 @@ bool se::SceneManager::loadScene(const std::string& filePath, const std::string&
             auto& color = jlight["color"];
             l.color = { color[0], color[1], color[2] };
             l.intensity = jlight["intensity"];
+            if (jlight.contains("range"))
+                l.range = jlight["range"];
+            if (jlight.contains("castShadows"))
+                l.castShadows = jlight["castShadows"].get<bool>() ? 1 : 0;
             go.setLight(l);
         }
 
@@ -312,6 +337,22 @@ bool se::SceneManager::loadScene(const std::string& filePath, const std::string&
             if(script)
                 go.setScript(std::move(script));
         }
+
+        // Tags
+        if (jgo.contains("tags")) {
+            for (const auto& tag : jgo["tags"])
+                go.addTag(tag.get<std::string>());
+        }
+    }
+
+    // --- Link parents once every object exists ---
+    for (const auto& jgo : sceneData["gameObjects"]) {
+        if (!jgo.contains("parent") || !jgo.contains("id")) continue;
+
+        auto child = loadedObjects.find(jgo["id"].get<SEGameObject::id_t>());
+        auto parent = loadedObjects.find(jgo["parent"].get<SEGameObject::id_t>());
+        if (child != loadedObjects.end() && parent != loadedObjects.end())
+            child->second->setParent(parent->second);
     }
 
     return true;
@@ -2,18 +2,35 @@
 
 #include <memory>
 
+#include "se_memory.hpp"
+
 namespace se {
 
     class SEGameObject;
 
+    // What a script touches in onUpdate, decides whether Scene may run it on the job system
+    enum class ScriptAccess {
+        // Anything, including creating or destroying objects. Runs serially on the main thread.
+        Shared,
+        // Only its owner's components and its own members. Runs in parallel with other OwnerOnly scripts.
+        OwnerOnly
+    };
+
     class ScriptComponent {
     public:
         virtual ~ScriptComponent() = default;
 
+        // Every script type lives in the size class pool matching its sizeof, so attaching and
+        // removing scripts recycles blocks instead of going to the global heap
+        static void* operator new(size_t size) { return memory::allocateSized(size); }
+        static void operator delete(void* block, size_t size) { memory::deallocateSized(block, size); }
+
         virtual void onCreate() {}
         virtual void onUpdate(float deltaTime) {}
         virtual void onDestroy() {}
 
+        virtual ScriptAccess getAccess() const { return ScriptAccess::Shared; }
+
         void setOwner(SEGameObject* gameObject) { owner = gameObject; }
 
         virtual std::string getName() const = 0;
@@ -25,6 +25,7 @@ namespace se
         return nullptr;
     }
 
+    // Instances come out of ScriptComponent's size class pools, so the factory never hits the global heap
     template<typename T>
     bool registerScript(const std::string& name) {
         getScriptRegistry()[name] = []() -> std::unique_ptr<ScriptComponent> {
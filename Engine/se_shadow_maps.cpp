@@ -0,0 +1,1016 @@
+#include "se_shadow_maps.hpp"
+#include "se_mesh.hpp"
+#include "se_render_stats.hpp"
+#include "se_swap_chain.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace se
+{
+    static_assert(sizeof(ShadowParams) % 16 == 0, "pbrFrag.frag reads ShadowParams as a std140 block");
+
+    namespace
+    {
+        // Practical split scheme, blend between logarithmic and uniform splits
+        constexpr float SPLIT_LAMBDA = 0.75f;
+        constexpr float CASCADE_DEPTH_BIAS = 0.0005f;
+        constexpr float ATLAS_DEPTH_BIAS = 0.0001f;
+
+        void transitionShadowImage(
+            VkCommandBuffer commandBuffer, VkImage image, uint32_t baseLayer, uint32_t layerCount,
+            VkImageLayout oldLayout, VkImageLayout newLayout,
+            VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+            VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+        {
+            VkImageMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.oldLayout = oldLayout;
+            barrier.newLayout = newLayout;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = image;
+            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+            barrier.subresourceRange.baseMipLevel = 0;
+            barrier.subresourceRange.levelCount = 1;
+            barrier.subresourceRange.baseArrayLayer = baseLayer;
+            barrier.subresourceRange.layerCount = layerCount;
+            barrier.srcAccessMask = srcAccess;
+            barrier.dstAccessMask = dstAccess;
+
+            vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        }
+
+        const VkPipelineStageFlags DEPTH_STAGES = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        const VkAccessFlags DEPTH_ACCESS = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+        double millisecondsSince(std::chrono::high_resolution_clock::time_point start)
+        {
+            return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+    }
+
+    ShadowMaps::ShadowMaps(SEDevice& device) : seDevice{ device }
+    {
+        createRenderPass();
+        createPipelineLayout();
+        createSampler();
+        createFrameResources();
+        createQueryPool();
+        createTargets();
+    }
+
+    ShadowMaps::~ShadowMaps()
+    {
+        destroyTargets();
+
+        for (auto& frame : frames)
+        {
+            if (frame.instances.buffer == VK_NULL_HANDLE)
+                continue;
+            seDevice.destroyBuffer(frame.instances.buffer, frame.instances.allocation);
+        }
+
+        if (timestampQueryPool != VK_NULL_HANDLE)
+            vkDestroyQueryPool(seDevice.device(), timestampQueryPool, nullptr);
+
+        vkDestroySampler(seDevice.device(), sampler, nullptr);
+        pipeline.reset();
+        vkDestroyPipelineLayout(seDevice.device(), pipelineLayout, nullptr);
+        vkDestroyDescriptorSetLayout(seDevice.device(), descriptorSetLayout, nullptr);
+        vkDestroyRenderPass(seDevice.device(), renderPass, nullptr);
+    }
+
+    void ShadowMaps::createRenderPass()
+    {
+        // Loads and stores, the cached copy or the previous contents are what the pass draws on top of
+        VkAttachmentDescription depthAttachment{};
+        depthAttachment.format = SHADOW_FORMAT;
+        depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentReference depthRef{};
+        depthRef.attachment = 0;
+        depthRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.pDepthStencilAttachment = &depthRef;
+
+        VkRenderPassCreateInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = 1;
+        renderPassInfo.pAttachments = &depthAttachment;
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+
+        if (vkCreateRenderPass(seDevice.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create shadow render pass!");
+        }
+    }
+
+    void ShadowMaps::createPipelineLayout()
+    {
+        // 0 caster world matrices by instance
+        VkDescriptorSetLayoutBinding binding{};
+        binding.binding = 0;
+        binding.descriptorCount = 1;
+        binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = 1;
+        layoutInfo.pBindings = &binding;
+
+        if (vkCreateDescriptorSetLayout(seDevice.device(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create shadow descriptor set layout!");
+        }
+
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(glm::mat4);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+        if (vkCreatePipelineLayout(seDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create shadow pipeline layout!");
+        }
+    }
+
+    void ShadowMaps::createPipeline()
+    {
+        PipelineConfigInfo pipelineConfig{};
+        SEPipeline::defaultPipelineConfigInfo(pipelineConfig);
+        pipelineConfig.renderPass = renderPass;
+        pipelineConfig.pipelineLayout = pipelineLayout;
+        pipelineConfig.bindingDescriptions = Vertex::getPositionBindingDescriptions();
+        pipelineConfig.attributeDescriptions = Vertex::getPositionAttributeDescriptions();
+        // Depth only
+        pipelineConfig.colorBlendInfo.attachmentCount = 0;
+        pipelineConfig.colorBlendInfo.pAttachments = nullptr;
+        // Slope scaled bias against acne on surfaces facing away from the light
+        pipelineConfig.rasterizationInfo.depthBiasEnable = VK_TRUE;
+        pipelineConfig.rasterizationInfo.depthBiasConstantFactor = 1.25f;
+        pipelineConfig.rasterizationInfo.depthBiasSlopeFactor = 1.75f;
+        pipelineConfig.rasterizationInfo.depthBiasClamp = 0.0f;
+
+        pipeline = std::make_unique<SEPipeline>(
+            seDevice,
+            "shaders/shadowVert.spv",
+            "shaders/shadowFrag.spv",
+            pipelineConfig,
+            VK_SAMPLE_COUNT_1_BIT);
+    }
+
+    void ShadowMaps::createSampler()
+    {
+        // Hardware comparison with bilinear filtering gives 2x2 PCF per tap, outside the map is lit
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_LINEAR;
+        samplerInfo.minFilter = VK_FILTER_LINEAR;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+        samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+        samplerInfo.compareEnable = VK_TRUE;
+        samplerInfo.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+        samplerInfo.minLod = 0.0f;
+        samplerInfo.maxLod = 0.0f;
+        samplerInfo.maxAnisotropy = 1.0f;
+
+        if (vkCreateSampler(seDevice.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create shadow sampler!");
+        }
+    }
+
+    void ShadowMaps::createFrameResources()
+    {
+        frames.resize(SESwapChain::MAX_FRAMES_IN_FLIGHT);
+
+        for (auto& frame : frames)
+        {
+            VkDescriptorSetAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            allocInfo.descriptorPool = seDevice.getDescriptorPool();
+            allocInfo.descriptorSetCount = 1;
+            allocInfo.pSetLayouts = &descriptorSetLayout;
+
+            if (vkAllocateDescriptorSets(seDevice.device(), &allocInfo, &frame.descriptorSet) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate shadow descriptor sets!");
+            }
+
+            reserveInstances(frame, MIN_INSTANCE_CAPACITY);
+        }
+    }
+
+    void ShadowMaps::createQueryPool()
+    {
+        if (!seDevice.properties.limits.timestampComputeAndGraphics)
+            return;
+
+        VkQueryPoolCreateInfo queryPoolInfo{};
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = QUERIES_PER_FRAME * SESwapChain::MAX_FRAMES_IN_FLIGHT;
+
+        if (vkCreateQueryPool(seDevice.device(), &queryPoolInfo, nullptr, &timestampQueryPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create shadow timestamp query pool!");
+        }
+    }
+
+    void ShadowMaps::createTargets()
+    {
+        const RenderSettings& settings = getRenderSettings();
+        createTarget(cascades, settings.shadowCascadeResolution, SHADOW_CASCADE_COUNT, VK_IMAGE_VIEW_TYPE_2D_ARRAY);
+        createTarget(atlas, settings.shadowAtlasResolution, 1, VK_IMAGE_VIEW_TYPE_2D);
+
+        // Everything starts cleared to the far plane, cached copies rest as copy sources and sampled maps as shader inputs
+        VkCommandBuffer commandBuffer = seDevice.beginSingleTimeCommands();
+        for (ShadowTarget* target : { &cascades, &atlas })
+        {
+            VkClearDepthStencilValue clearValue{ 1.0f, 0 };
+            VkImageSubresourceRange range{ VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, target->layers };
+
+            for (ShadowImage* image : { &target->cached, &target->sampled })
+            {
+                transitionShadowImage(commandBuffer, image->image, 0, target->layers,
+                    VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+                vkCmdClearDepthStencilImage(commandBuffer, image->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearValue, 1, &range);
+            }
+
+            transitionShadowImage(commandBuffer, target->cached.image, 0, target->layers,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+            transitionShadowImage(commandBuffer, target->sampled.image, 0, target->layers,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+        }
+        seDevice.endSingleTimeCommands(commandBuffer);
+
+        for (auto& state : cascadeStates)
+            state.valid = false;
+        for (auto& state : tileStates)
+            state.valid = false;
+    }
+
+    void ShadowMaps::destroyTargets()
+    {
+        for (ShadowTarget* target : { &cascades, &atlas })
+        {
+            if (target->sampledView != VK_NULL_HANDLE)
+                vkDestroyImageView(seDevice.device(), target->sampledView, nullptr);
+            destroyImage(target->cached);
+            destroyImage(target->sampled);
+            *target = ShadowTarget{};
+        }
+    }
+
+    void ShadowMaps::createTarget(ShadowTarget& target, uint32_t resolution, uint32_t layers, VkImageViewType sampledViewType)
+    {
+        target.resolution = resolution;
+        target.layers = layers;
+
+        for (ShadowImage* image : { &target.cached, &target.sampled })
+        {
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.format = SHADOW_FORMAT;
+            imageInfo.extent = { resolution, resolution, 1 };
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = layers;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+            if (image == &target.sampled)
+                imageInfo.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+            seDevice.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image->image, image->memory);
+
+            image->layerViews.resize(layers);
+            image->framebuffers.resize(layers);
+            for (uint32_t layer = 0; layer < layers; layer++)
+            {
+                VkImageViewCreateInfo viewInfo{};
+                viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+                viewInfo.image = image->image;
+                viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+                viewInfo.format = SHADOW_FORMAT;
+                viewInfo.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, layer, 1 };
+
+                if (vkCreateImageView(seDevice.device(), &viewInfo, nullptr, &image->layerViews[layer]) != VK_SUCCESS)
+                {
+                    throw std::runtime_error("failed to create shadow map view!");
+                }
+
+                VkFramebufferCreateInfo framebufferInfo{};
+                framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+                framebufferInfo.renderPass = renderPass;
+                framebufferInfo.attachmentCount = 1;
+                framebufferInfo.pAttachments = &image->layerViews[layer];
+                framebufferInfo.width = resolution;
+                framebufferInfo.height = resolution;
+                framebufferInfo.layers = 1;
+
+                if (vkCreateFramebuffer(seDevice.device(), &framebufferInfo, nullptr, &image->framebuffers[layer]) != VK_SUCCESS)
+                {
+                    throw std::runtime_error("failed to create shadow framebuffer!");
+                }
+            }
+        }
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = target.sampled.image;
+        viewInfo.viewType = sampledViewType;
+        viewInfo.format = SHADOW_FORMAT;
+        viewInfo.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, layers };
+
+        if (vkCreateImageView(seDevice.device(), &viewInfo, nullptr, &target.sampledView) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create shadow map view!");
+        }
+    }
+
+    void ShadowMaps::destroyImage(ShadowImage& image)
+    {
+        for (VkFramebuffer framebuffer : image.framebuffers)
+            vkDestroyFramebuffer(seDevice.device(), framebuffer, nullptr);
+        for (VkImageView view : image.layerViews)
+            vkDestroyImageView(seDevice.device(), view, nullptr);
+        if (image.image != VK_NULL_HANDLE)
+            seDevice.destroyImage(image.image, image.memory);
+        image = ShadowImage{};
+    }
+
+    void ShadowMaps::reserveInstances(FrameResources& frame, size_t count)
+    {
+        if (frame.instances.buffer != VK_NULL_HANDLE && count <= frame.instanceCapacity)
+            return;
+
+        // The slot's previous submission is done once beginFrame returned, nothing reads the old buffer anymore
+        if (frame.instances.buffer != VK_NULL_HANDLE)
+        {
+            seDevice.destroyBuffer(frame.instances.buffer, frame.instances.allocation);
+            frame.instances = Buffer{};
+        }
+
+        size_t capacity = std::max({ count, frame.instanceCapacity * 2, MIN_INSTANCE_CAPACITY });
+        seDevice.createBuffer(
+            sizeof(glm::mat4) * capacity,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            frame.instances.buffer,
+            frame.instances.allocation);
+        frame.instances.mapped = frame.instances.allocation.mapped;
+        frame.instanceCapacity = capacity;
+
+        VkDescriptorBufferInfo bufferInfo{};
+        bufferInfo.buffer = frame.instances.buffer;
+        bufferInfo.offset = 0;
+        bufferInfo.range = VK_WHOLE_SIZE;
+
+        VkWriteDescriptorSet descriptorWrite{};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = frame.descriptorSet;
+        descriptorWrite.dstBinding = 0;
+        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.pBufferInfo = &bufferInfo;
+
+        vkUpdateDescriptorSets(seDevice.device(), 1, &descriptorWrite, 0, nullptr);
+    }
+
+    void ShadowMaps::readTimestamps(int frameIndex)
+    {
+        FrameResources& frame = frames[frameIndex];
+        if (timestampQueryPool == VK_NULL_HANDLE || frame.timestampsWritten == 0)
+            return;
+
+        // The frame's fence was waited on, only passes that were recorded last time have results
+        RenderStats& stats = getRenderStats();
+        const double tickMs = seDevice.properties.limits.timestampPeriod * 1e-6;
+        for (uint32_t pass = 0; pass <= SHADOW_CASCADE_COUNT; pass++)
+        {
+            if ((frame.timestampsWritten & (1u << pass)) == 0)
+                continue;
+
+            uint64_t timestamps[2] = {};
+            VkResult result = vkGetQueryPoolResults(
+                seDevice.device(), timestampQueryPool,
+                frameIndex * QUERIES_PER_FRAME + pass * 2, 2,
+                sizeof(timestamps), timestamps, sizeof(uint64_t),
+                VK_QUERY_RESULT_64_BIT);
+            if (result != VK_SUCCESS)
+                continue;
+
+            const double ms = static_cast<double>(timestamps[1] - timestamps[0]) * tickMs;
+            if (pass < SHADOW_CASCADE_COUNT)
+                stats.shadowCascadeGpuMs[pass] = static_cast<float>(ms);
+            else
+                stats.shadowAtlasGpuMs = static_cast<float>(ms);
+        }
+        frame.timestampsWritten = 0;
+    }
+
+    void ShadowMaps::assignLights(Scene& scene, bool lightsChanged)
+    {
+        const bool enabled = getRenderSettings().shadows;
+        if (!lightsChanged && enabled == assignedEnabled && &scene == assignedScene)
+            return;
+
+        assignedScene = &scene;
+        assignedEnabled = enabled;
+        cascadeLight = NO_LIGHT;
+        localShadows.clear();
+
+        // Lights past the tile budget go without, in registry order
+        uint32_t usedTiles = 0;
+        const auto& lights = scene.getPackedLights();
+        for (uint32_t i = 0; i < lights.size(); i++)
+        {
+            const Light& light = lights[i];
+            int32_t shadowIndex = -1;
+
+            if (enabled && light.castShadows)
+            {
+                if (light.type == LightType::Directional)
+                {
+                    if (cascadeLight == NO_LIGHT)
+                    {
+                        cascadeLight = i;
+                        shadowIndex = 0;
+                    }
+                }
+                else if (light.type == LightType::Spot || light.type == LightType::Point)
+                {
+                    const uint32_t tileCount = light.type == LightType::Point ? POINT_FACES : 1;
+                    if (usedTiles + tileCount <= MAX_SHADOW_TILES)
+                    {
+                        localShadows.push_back({ i, usedTiles, tileCount });
+                        shadowIndex = static_cast<int32_t>(usedTiles);
+                        usedTiles += tileCount;
+                    }
+                }
+            }
+
+            scene.setLightShadow(i, shadowIndex);
+        }
+    }
+
+    bool ShadowMaps::prepare()
+    {
+        const RenderSettings& settings = getRenderSettings();
+        if (settings.shadowCascadeResolution == cascades.resolution && settings.shadowAtlasResolution == atlas.resolution)
+            return false;
+
+        // Frames in flight may still sample the old maps
+        vkDeviceWaitIdle(seDevice.device());
+        destroyTargets();
+        createTargets();
+        return true;
+    }
+
+    bool ShadowMaps::fitCascade(uint32_t cascade, const SECamera& camera, const glm::vec3& lightDirection, float splitNear, float splitFar, uint64_t staticVersion)
+    {
+        const glm::mat4 inverseProjection = glm::inverse(camera.getProjection());
+        const glm::mat4 inverseView = glm::inverse(camera.getView());
+
+        // Corners of the slice, view space depth is linear along each corner ray of the frustum
+        glm::vec3 corners[8];
+        for (int i = 0; i < 4; i++)
+        {
+            glm::vec2 ndc((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f);
+            glm::vec4 nearCorner = inverseProjection * glm::vec4(ndc, 0.0f, 1.0f);
+            glm::vec4 farCorner = inverseProjection * glm::vec4(ndc, 1.0f, 1.0f);
+            glm::vec3 a = glm::vec3(nearCorner) / nearCorner.w;
+            glm::vec3 b = glm::vec3(farCorner) / farCorner.w;
+
+            const float depthA = std::abs(a.z);
+            const float depthB = std::abs(b.z);
+            auto atDepth = [&](float depth) { return a + (b - a) * ((depth - depthA) / (depthB - depthA)); };
+
+            corners[i] = glm::vec3(inverseView * glm::vec4(atDepth(splitNear), 1.0f));
+            corners[i + 4] = glm::vec3(inverseView * glm::vec4(atDepth(splitFar), 1.0f));
+        }
+
+        glm::vec3 center(0.0f);
+        for (const auto& corner : corners)
+            center += corner;
+        center /= 8.0f;
+
+        float radius = 0.0f;
+        for (const auto& corner : corners)
+            radius = std::max(radius, glm::length(corner - center));
+
+        // A bounding sphere keeps the window's size fixed as the camera turns, rounding keeps float noise out of it.
+        // The margin lets the center snap to a coarse grid and still cover the whole slice.
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+        const float halfExtent = radius * 1.25f;
+        const float texel = 2.0f * halfExtent / static_cast<float>(cascades.resolution);
+        const float snap = std::max(1.0f, std::floor(radius * 0.25f / texel)) * texel;
+
+        const glm::vec3 up = std::abs(lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        const glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), lightDirection, up);
+        glm::vec3 lightCenter = glm::vec3(lightView * glm::vec4(center, 1.0f));
+        lightCenter = glm::floor(lightCenter / snap) * snap;
+
+        CascadeState& state = cascadeStates[cascade];
+        if (state.valid
+            && state.lightDirection == lightDirection
+            && state.center == lightCenter
+            && state.halfExtent == halfExtent
+            && state.staticVersion == staticVersion)
+            return false;
+
+        state.lightDirection = lightDirection;
+        state.center = lightCenter;
+        state.halfExtent = halfExtent;
+        state.staticVersion = staticVersion;
+        state.valid = true;
+
+        // Light space looks down -z, the box reaches back towards the light for casters outside the slice
+        const float nearDepth = -(lightCenter.z + halfExtent + CASCADE_CASTER_REACH);
+        const float farDepth = -(lightCenter.z - halfExtent);
+        state.viewProjection = glm::ortho(
+            lightCenter.x - halfExtent, lightCenter.x + halfExtent,
+            lightCenter.y - halfExtent, lightCenter.y + halfExtent,
+            nearDepth, farDepth) * lightView;
+
+        const glm::mat4 inverseLightView = glm::inverse(lightView);
+        state.casterBounds = AABB{};
+        for (int i = 0; i < 8; i++)
+        {
+            glm::vec3 corner(
+                lightCenter.x + ((i & 1) ? halfExtent : -halfExtent),
+                lightCenter.y + ((i & 2) ? halfExtent : -halfExtent),
+                (i & 4) ? lightCenter.z + halfExtent + CASCADE_CASTER_REACH : lightCenter.z - halfExtent);
+            state.casterBounds.expand(glm::vec3(inverseLightView * glm::vec4(corner, 1.0f)));
+        }
+        return true;
+    }
+
+    glm::mat4 ShadowMaps::tileViewProjection(const Light& light, uint32_t face) const
+    {
+        const float farPlane = std::max(light.range, LOCAL_NEAR_PLANE * 2.0f);
+
+        if (light.type == LightType::Spot)
+        {
+            const float fov = glm::clamp(2.0f * glm::radians(light.spotAngle), glm::radians(1.0f), glm::radians(170.0f));
+            const glm::vec3 up = std::abs(light.direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+            return glm::perspective(fov, 1.0f, LOCAL_NEAR_PLANE, farPlane)
+                * glm::lookAt(light.position, light.position + light.direction, up);
+        }
+
+        // +x, -x, +y, -y, +z, -z, pbrFrag.frag picks the face by the major axis
+        static const glm::vec3 faceDirections[POINT_FACES] = {
+            { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f },
+            { 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f },
+            { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f } };
+        static const glm::vec3 faceUps[POINT_FACES] = {
+            { 0.0f, -1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f },
+            { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f },
+            { 0.0f, -1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f } };
+
+        return glm::perspective(glm::radians(90.0f), 1.0f, LOCAL_NEAR_PLANE, farPlane)
+            * glm::lookAt(light.position, light.position + faceDirections[face], faceUps[face]);
+    }
+
+    bool ShadowMaps::tileStale(uint32_t tile, const Light& light, uint64_t staticVersion) const
+    {
+        const TileState& state = tileStates[tile];
+        return !state.valid
+            || state.type != light.type
+            || state.position != light.position
+            || state.range != light.range
+            || state.staticVersion != staticVersion
+            || (light.type == LightType::Spot && (state.direction != light.direction || state.spotAngle != light.spotAngle));
+    }
+
+    VkRect2D ShadowMaps::tileRect(uint32_t tile) const
+    {
+        const uint32_t tileSize = atlas.resolution / ATLAS_TILES_PER_ROW;
+        VkRect2D rect{};
+        rect.offset = { static_cast<int32_t>((tile % ATLAS_TILES_PER_ROW) * tileSize), static_cast<int32_t>((tile / ATLAS_TILES_PER_ROW) * tileSize) };
+        rect.extent = { tileSize, tileSize };
+        return rect;
+    }
+
+    void ShadowMaps::gatherCasters(const Scene& scene, const AABB& box, const glm::mat4& viewProjection, bool staticCasters, ShadowPass& pass)
+    {
+        pass.firstBatch = static_cast<uint32_t>(batches.size());
+
+        scene.overlapBoxDense(box, candidates);
+        const Frustum frustum(viewProjection);
+        const auto& meshes = scene.getMeshes();
+        const auto& bounds = scene.getWorldBounds();
+        const auto& staticFlags = scene.getStaticFlags();
+
+        casterScratch.clear();
+        for (uint32_t dense : candidates)
+        {
+            if (!meshes[dense] || (staticFlags[dense] != 0) != staticCasters)
+                continue;
+            if (!frustum.intersects(bounds[dense].getCenter(), bounds[dense].getExtents()))
+                continue;
+            casterScratch.emplace_back(meshes[dense].get(), dense);
+        }
+
+        // One instanced draw per mesh
+        std::sort(casterScratch.begin(), casterScratch.end());
+        for (size_t i = 0; i < casterScratch.size();)
+        {
+            CasterBatch batch{ casterScratch[i].first, static_cast<uint32_t>(instanceObjects.size()), 0 };
+            for (; i < casterScratch.size() && casterScratch[i].first == batch.mesh; i++)
+            {
+                instanceObjects.push_back(casterScratch[i].second);
+                batch.instanceCount++;
+            }
+            batches.push_back(batch);
+        }
+
+        pass.batchCount = static_cast<uint32_t>(batches.size()) - pass.firstBatch;
+    }
+
+    void ShadowMaps::drawPass(VkCommandBuffer commandBuffer, const ShadowPass& pass)
+    {
+        VkViewport viewport{};
+        viewport.x = static_cast<float>(pass.rect.offset.x);
+        viewport.y = static_cast<float>(pass.rect.offset.y);
+        viewport.width = static_cast<float>(pass.rect.extent.width);
+        viewport.height = static_cast<float>(pass.rect.extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &pass.rect);
+
+        vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &pass.viewProjection);
+        seDevice.getGeometryArena().bindPositions(commandBuffer);
+
+        for (uint32_t b = pass.firstBatch; b < pass.firstBatch + pass.batchCount; b++)
+        {
+            const CasterBatch& batch = batches[b];
+            for (size_t s = 0; s < batch.mesh->getSubMeshCount(); s++)
+            {
+                const SESubMesh& submesh = batch.mesh->getSubMesh(s);
+                if (submesh.isReady())
+                    submesh.draw(commandBuffer, batch.instanceCount, batch.firstInstance);
+            }
+        }
+    }
+
+    void ShadowMaps::beginPass(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, uint32_t resolution)
+    {
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = renderPass;
+        renderPassInfo.framebuffer = framebuffer;
+        renderPassInfo.renderArea.offset = { 0, 0 };
+        renderPassInfo.renderArea.extent = { resolution, resolution };
+
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    }
+
+    void ShadowMaps::clearRect(VkCommandBuffer commandBuffer, const VkRect2D& rect)
+    {
+        VkClearAttachment clearAttachment{};
+        clearAttachment.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+        clearAttachment.clearValue.depthStencil = { 1.0f, 0 };
+
+        VkClearRect clearRect{};
+        clearRect.rect = rect;
+        clearRect.baseArrayLayer = 0;
+        clearRect.layerCount = 1;
+
+        vkCmdClearAttachments(commandBuffer, 1, &clearAttachment, 1, &clearRect);
+    }
+
+    void ShadowMaps::recordCascade(VkCommandBuffer commandBuffer, uint32_t cascade, const ShadowPass* staticPass, const ShadowPass& dynamicPass)
+    {
+        const uint32_t resolution = cascades.resolution;
+
+        if (staticPass)
+        {
+            transitionShadowImage(commandBuffer, cascades.cached.image, cascade, 1,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                DEPTH_STAGES, DEPTH_ACCESS);
+
+            beginPass(commandBuffer, cascades.cached.framebuffers[cascade], resolution);
+            clearRect(commandBuffer, staticPass->rect);
+            drawPass(commandBuffer, *staticPass);
+            vkCmdEndRenderPass(commandBuffer);
+
+            transitionShadowImage(commandBuffer, cascades.cached.image, cascade, 1,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                DEPTH_STAGES, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+        }
+
+        transitionShadowImage(commandBuffer, cascades.sampled.image, cascade, 1,
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+        VkImageCopy region{};
+        region.srcSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, cascade, 1 };
+        region.dstSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, cascade, 1 };
+        region.extent = { resolution, resolution, 1 };
+        vkCmdCopyImage(
+            commandBuffer,
+            cascades.cached.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            cascades.sampled.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            1, &region);
+
+        transitionShadowImage(commandBuffer, cascades.sampled.image, cascade, 1,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+            DEPTH_STAGES, DEPTH_ACCESS);
+
+        beginPass(commandBuffer, cascades.sampled.framebuffers[cascade], resolution);
+        drawPass(commandBuffer, dynamicPass);
+        vkCmdEndRenderPass(commandBuffer);
+
+        transitionShadowImage(commandBuffer, cascades.sampled.image, cascade, 1,
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+            DEPTH_STAGES, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    }
+
+    void ShadowMaps::recordAtlas(VkCommandBuffer commandBuffer, const std::vector<ShadowPass>& staticPasses, const std::vector<ShadowPass>& dynamicPasses)
+    {
+        const uint32_t resolution = atlas.resolution;
+
+        if (!staticPasses.empty())
+        {
+            transitionShadowImage(commandBuffer, atlas.cached.image, 0, 1,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                DEPTH_STAGES, DEPTH_ACCESS);
+
+            beginPass(commandBuffer, atlas.cached.framebuffers[0], resolution);
+            for (const ShadowPass& pass : staticPasses)
+            {
+                clearRect(commandBuffer, pass.rect);
+                drawPass(commandBuffer, pass);
+            }
+            vkCmdEndRenderPass(commandBuffer);
+
+            transitionShadowImage(commandBuffer, atlas.cached.image, 0, 1,
+                VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                DEPTH_STAGES, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+        }
+
+        // Tiles that aren't due keep their previous contents, the layout change preserves them
+        transitionShadowImage(commandBuffer, atlas.sampled.image, 0, 1,
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+        std::vector<VkImageCopy> regions(dynamicPasses.size());
+        for (size_t i = 0; i < dynamicPasses.size(); i++)
+        {
+            const VkRect2D& rect = dynamicPasses[i].rect;
+            regions[i].srcSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1 };
+            regions[i].dstSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1 };
+            regions[i].srcOffset = { rect.offset.x, rect.offset.y, 0 };
+            regions[i].dstOffset = { rect.offset.x, rect.offset.y, 0 };
+            regions[i].extent = { rect.extent.width, rect.extent.height, 1 };
+        }
+        vkCmdCopyImage(
+            commandBuffer,
+            atlas.cached.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            atlas.sampled.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            static_cast<uint32_t>(regions.size()), regions.data());
+
+        transitionShadowImage(commandBuffer, atlas.sampled.image, 0, 1,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+            DEPTH_STAGES, DEPTH_ACCESS);
+
+        beginPass(commandBuffer, atlas.sampled.framebuffers[0], resolution);
+        for (const ShadowPass& pass : dynamicPasses)
+            drawPass(commandBuffer, pass);
+        vkCmdEndRenderPass(commandBuffer);
+
+        transitionShadowImage(commandBuffer, atlas.sampled.image, 0, 1,
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+            DEPTH_STAGES, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    }
+
+    void ShadowMaps::render(VkCommandBuffer commandBuffer, int frameIndex, Scene& scene)
+    {
+        using clock = std::chrono::high_resolution_clock;
+
+        readTimestamps(frameIndex);
+
+        const RenderSettings& settings = getRenderSettings();
+        params.info = glm::uvec4(0);
+        if (!settings.shadows)
+            return;
+
+        RenderStats& stats = getRenderStats();
+        FrameResources& frame = frames[frameIndex];
+        const auto& lights = scene.getPackedLights();
+        // Finished uploads can add static casters, cached maps redraw when the ready value moves
+        const uint64_t staticVersion = scene.getStaticVersion() + seDevice.getUploadManager().getReadyValue();
+        frameCounter++;
+
+        params.info.y = 1;
+        params.bias = glm::vec4(CASCADE_DEPTH_BIAS, ATLAS_DEPTH_BIAS, 0.5f / static_cast<float>(atlas.resolution), 0.0f);
+
+        instanceObjects.clear();
+        batches.clear();
+
+        // Cascades
+        ShadowPass cascadeStatic[SHADOW_CASCADE_COUNT]{};
+        ShadowPass cascadeDynamic[SHADOW_CASCADE_COUNT]{};
+        bool cascadeDue[SHADOW_CASCADE_COUNT] = {};
+        bool cascadeStale[SHADOW_CASCADE_COUNT] = {};
+        double cascadeMs[SHADOW_CASCADE_COUNT] = {};
+
+        if (cascadeLight < lights.size() && lights[cascadeLight].type == LightType::Directional)
+        {
+            const SECamera& camera = scene.getCamera();
+            const float nearPlane = camera.getNear();
+            const float farPlane = std::max(std::min(settings.shadowDistance, camera.getFar()), nearPlane * 2.0f);
+            const glm::vec3 lightDirection = lights[cascadeLight].direction;
+            const VkRect2D fullRect{ { 0, 0 }, { cascades.resolution, cascades.resolution } };
+
+            params.info.x = SHADOW_CASCADE_COUNT;
+            float splitNear = nearPlane;
+            for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+            {
+                auto start = clock::now();
+
+                const float ratio = static_cast<float>(i + 1) / SHADOW_CASCADE_COUNT;
+                const float logSplit = nearPlane * std::pow(farPlane / nearPlane, ratio);
+                const float uniformSplit = nearPlane + (farPlane - nearPlane) * ratio;
+                const float splitFar = SPLIT_LAMBDA * logSplit + (1.0f - SPLIT_LAMBDA) * uniformSplit;
+                params.cascadeSplits[i] = splitFar;
+
+                cascadeStale[i] = fitCascade(i, camera, lightDirection, splitNear, splitFar, staticVersion);
+                splitNear = splitFar;
+
+                const CascadeState& state = cascadeStates[i];
+                const uint32_t interval = std::max(settings.shadowCascadeUpdateInterval[i], 1u);
+                cascadeDue[i] = cascadeStale[i] || (frameCounter + i) % interval == 0;
+                params.cascadeViewProjection[i] = state.viewProjection;
+
+                if (cascadeDue[i])
+                {
+                    if (cascadeStale[i])
+                    {
+                        cascadeStatic[i] = { state.viewProjection, fullRect };
+                        gatherCasters(scene, state.casterBounds, state.viewProjection, true, cascadeStatic[i]);
+                    }
+                    cascadeDynamic[i] = { state.viewProjection, fullRect };
+                    gatherCasters(scene, state.casterBounds, state.viewProjection, false, cascadeDynamic[i]);
+                }
+                cascadeMs[i] = millisecondsSince(start);
+            }
+        }
+
+        // Atlas tiles
+        auto atlasStart = clock::now();
+        staticTilePasses.clear();
+        dynamicTilePasses.clear();
+        const uint32_t atlasInterval = std::max(settings.shadowAtlasUpdateInterval, 1u);
+        const float tileScale = 1.0f / ATLAS_TILES_PER_ROW;
+
+        for (const LocalShadow& local : localShadows)
+        {
+            if (local.light >= lights.size())
+                continue;
+
+            const Light& light = lights[local.light];
+            const bool stale = tileStale(local.firstTile, light, staticVersion);
+            const bool due = stale || (frameCounter + local.firstTile) % atlasInterval == 0;
+            const AABB box = AABB::fromCenterExtents(light.position, glm::vec3(light.range));
+
+            for (uint32_t face = 0; face < local.tileCount; face++)
+            {
+                const uint32_t tile = local.firstTile + face;
+                const glm::mat4 viewProjection = tileViewProjection(light, face);
+                params.tiles[tile].viewProjection = viewProjection;
+                params.tiles[tile].rect = glm::vec4(
+                    (tile % ATLAS_TILES_PER_ROW) * tileScale, (tile / ATLAS_TILES_PER_ROW) * tileScale, tileScale, tileScale);
+
+                if (!due)
+                    continue;
+
+                if (stale)
+                {
+                    ShadowPass pass{ viewProjection, tileRect(tile) };
+                    gatherCasters(scene, box, viewProjection, true, pass);
+                    staticTilePasses.push_back(pass);
+                }
+                ShadowPass pass{ viewProjection, tileRect(tile) };
+                gatherCasters(scene, box, viewProjection, false, pass);
+                dynamicTilePasses.push_back(pass);
+            }
+
+            if (stale)
+            {
+                TileState& state = tileStates[local.firstTile];
+                state.position = light.position;
+                state.direction = light.direction;
+                state.range = light.range;
+                state.spotAngle = light.spotAngle;
+                state.type = light.type;
+                state.staticVersion = staticVersion;
+                state.valid = true;
+            }
+        }
+        double atlasMs = millisecondsSince(atlasStart);
+
+        // Every pass of the frame reads its world matrices from the one buffer
+        reserveInstances(frame, instanceObjects.size());
+        const auto& worldMatrices = scene.getWorldMatrices();
+        auto* instances = static_cast<glm::mat4*>(frame.instances.mapped);
+        for (size_t i = 0; i < instanceObjects.size(); i++)
+            instances[i] = worldMatrices[instanceObjects[i]];
+
+        const uint32_t firstQuery = frameIndex * QUERIES_PER_FRAME;
+        if (timestampQueryPool != VK_NULL_HANDLE)
+            vkCmdResetQueryPool(commandBuffer, timestampQueryPool, firstQuery, QUERIES_PER_FRAME);
+
+        pipeline->bind(commandBuffer);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frame.descriptorSet, 0, nullptr);
+
+        for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+        {
+            if (!cascadeDue[i])
+                continue;
+
+            auto start = clock::now();
+            if (timestampQueryPool != VK_NULL_HANDLE)
+                vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, firstQuery + i * 2);
+
+            recordCascade(commandBuffer, i, cascadeStale[i] ? &cascadeStatic[i] : nullptr, cascadeDynamic[i]);
+
+            if (timestampQueryPool != VK_NULL_HANDLE)
+            {
+                vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, firstQuery + i * 2 + 1);
+                frame.timestampsWritten |= 1u << i;
+            }
+
+            stats.shadowCascadeRecordMs[i] = static_cast<float>(cascadeMs[i] + millisecondsSince(start));
+            if (cascadeStale[i])
+                stats.shadowStaticRedraws++;
+        }
+
+        if (!dynamicTilePasses.empty())
+        {
+            auto start = clock::now();
+            const uint32_t atlasQuery = firstQuery + SHADOW_CASCADE_COUNT * 2;
+            if (timestampQueryPool != VK_NULL_HANDLE)
+                vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, atlasQuery);
+
+            recordAtlas(commandBuffer, staticTilePasses, dynamicTilePasses);
+
+            if (timestampQueryPool != VK_NULL_HANDLE)
+            {
+                vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, atlasQuery + 1);
+                frame.timestampsWritten |= 1u << SHADOW_CASCADE_COUNT;
+            }
+
+            atlasMs += millisecondsSince(start);
+            stats.shadowStaticRedraws += static_cast<uint32_t>(staticTilePasses.size());
+        }
+        stats.shadowAtlasRecordMs = static_cast<float>(atlasMs);
+        stats.shadowCasters += static_cast<uint32_t>(instanceObjects.size());
+    }
+}
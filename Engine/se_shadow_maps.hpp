@@ -0,0 +1,207 @@
+#pragma once
+
+#include "se_device.hpp"
+#include "se_pipeline.hpp"
+#include "se_scene.hpp"
+#include "se_render_settings.hpp"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace se
+{
+    constexpr uint32_t MAX_SHADOW_TILES = 64;
+
+    struct ShadowTile
+    {
+        glm::mat4 viewProjection;
+        glm::vec4 rect;         // xy offset, zw size, in atlas uv
+    };
+
+    // Matches the SHADOWS block of pbrFrag.frag
+    struct ShadowParams
+    {
+        glm::mat4 cascadeViewProjection[SHADOW_CASCADE_COUNT];
+        glm::vec4 cascadeSplits;    // view depth each cascade ends at
+        glm::vec4 bias;             // x cascade depth bias, y atlas depth bias, z half an atlas texel in uv
+        glm::uvec4 info;            // x cascades in use, y 1 when shadows are on
+        ShadowTile tiles[MAX_SHADOW_TILES];
+    };
+
+    // Shadow maps for the Light components. The first shadow casting directional light gets SHADOW_CASCADE_COUNT
+    // cascades in a layered depth image, spot lights one tile and point lights six cube face tiles of a depth atlas.
+    //
+    // Every cascade and tile keeps its static casters in a cached copy that is only redrawn when a static object
+    // changes, when the light moves or when the cascade's window has to follow the camera. The window is snapped to a
+    // grid a quarter of its size wide, so a moving camera only redraws it every few meters. Each update copies the
+    // cached depth into the sampled map and draws the dynamic casters on top, on the interval from RenderSettings.
+    class ShadowMaps
+    {
+    public:
+        // Maps, buffers and layouts only, the depth pipeline comes from createPipeline
+        ShadowMaps(SEDevice& device);
+        ~ShadowMaps();
+
+        ShadowMaps(const ShadowMaps&) = delete;
+        ShadowMaps& operator=(const ShadowMaps&) = delete;
+
+        // Throws when the shaders are missing, render needs it
+        void createPipeline();
+        bool hasPipeline() const { return pipeline != nullptr; }
+
+        // Hands out the cascades and atlas tiles and writes the result into the scene's packed lights.
+        // Does nothing unless the lights changed or shadows were switched on or off.
+        void assignLights(Scene& scene, bool lightsChanged);
+        // Recreates the maps after a resolution setting changed, waiting for the GPU first.
+        // Returns true when it did, descriptors pointing at the old maps need rewriting.
+        bool prepare();
+        // Records every shadow pass that is due, outside a render pass. Fills getParams and the shadow stats.
+        void render(VkCommandBuffer commandBuffer, int frameIndex, Scene& scene);
+
+        const ShadowParams& getParams() const { return params; }
+        VkSampler getSampler() const { return sampler; }
+        // Sampled as sampler2DArrayShadow and sampler2DShadow, in VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+        VkImageView getCascadeView() const { return cascades.sampledView; }
+        VkImageView getAtlasView() const { return atlas.sampledView; }
+
+    private:
+        // Cached static casters in one image, sampled map in the other. Attachment views are per layer.
+        struct ShadowImage {
+            VkImage image = VK_NULL_HANDLE;
+            DeviceAllocation memory;
+            std::vector<VkImageView> layerViews;
+            std::vector<VkFramebuffer> framebuffers;
+        };
+
+        struct ShadowTarget {
+            ShadowImage cached;
+            ShadowImage sampled;
+            VkImageView sampledView = VK_NULL_HANDLE;
+            uint32_t resolution = 0;
+            uint32_t layers = 0;
+        };
+
+        // What a cascade's maps currently hold
+        struct CascadeState {
+            glm::mat4 viewProjection{ 1.0f };
+            glm::vec3 lightDirection{ 0.0f };
+            glm::vec3 center{ 0.0f };
+            float halfExtent = 0.0f;
+            uint64_t staticVersion = 0;
+            bool valid = false;
+            // World space box the casters are gathered from
+            AABB casterBounds;
+        };
+
+        // What a tile's cached static casters were drawn for
+        struct TileState {
+            glm::vec3 position{ 0.0f };
+            glm::vec3 direction{ 0.0f };
+            float range = 0.0f;
+            float spotAngle = 0.0f;
+            LightType type = LightType::None;
+            uint64_t staticVersion = 0;
+            bool valid = false;
+        };
+
+        struct LocalShadow {
+            uint32_t light;
+            uint32_t firstTile;
+            uint32_t tileCount;
+        };
+
+        struct CasterBatch {
+            const SEMesh* mesh;
+            uint32_t firstInstance;
+            uint32_t instanceCount;
+        };
+
+        // One render of a cascade layer or an atlas tile
+        struct ShadowPass {
+            glm::mat4 viewProjection;
+            VkRect2D rect;
+            uint32_t firstBatch;
+            uint32_t batchCount;
+        };
+
+        struct FrameResources {
+            Buffer instances{};
+            size_t instanceCapacity = 0;
+            VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+            // Bit per query pair written in this slot's last use, cascades first and the atlas last
+            uint32_t timestampsWritten = 0;
+        };
+
+        static constexpr uint32_t NO_LIGHT = UINT32_MAX;
+        static constexpr uint32_t ATLAS_TILES_PER_ROW = 8;
+        static constexpr uint32_t POINT_FACES = 6;
+        // A begin and end timestamp for each cascade and the atlas
+        static constexpr uint32_t QUERIES_PER_FRAME = 2 * (SHADOW_CASCADE_COUNT + 1);
+        static constexpr size_t MIN_INSTANCE_CAPACITY = 1024;
+        // Casters up to this far behind a cascade, towards the light, still land in it
+        static constexpr float CASCADE_CASTER_REACH = 50.0f;
+        static constexpr float LOCAL_NEAR_PLANE = 0.05f;
+        static constexpr VkFormat SHADOW_FORMAT = VK_FORMAT_D32_SFLOAT;
+
+        void createRenderPass();
+        void createPipelineLayout();
+        void createSampler();
+        void createFrameResources();
+        void createQueryPool();
+        void createTargets();
+        void destroyTargets();
+        void createTarget(ShadowTarget& target, uint32_t resolution, uint32_t layers, VkImageViewType sampledViewType);
+        void destroyImage(ShadowImage& image);
+
+        void reserveInstances(FrameResources& frame, size_t count);
+        void readTimestamps(int frameIndex);
+
+        // Fits cascade i around its slice of the camera frustum, true when its cached static casters are stale
+        bool fitCascade(uint32_t cascade, const SECamera& camera, const glm::vec3& lightDirection, float splitNear, float splitFar, uint64_t staticVersion);
+        glm::mat4 tileViewProjection(const Light& light, uint32_t face) const;
+        bool tileStale(uint32_t tile, const Light& light, uint64_t staticVersion) const;
+
+        // Culls against the pass's frustum within box and appends the casters grouped by mesh
+        void gatherCasters(const Scene& scene, const AABB& box, const glm::mat4& viewProjection, bool staticCasters, ShadowPass& pass);
+        void drawPass(VkCommandBuffer commandBuffer, const ShadowPass& pass);
+        void beginPass(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, uint32_t resolution);
+        void clearRect(VkCommandBuffer commandBuffer, const VkRect2D& rect);
+
+        void recordCascade(VkCommandBuffer commandBuffer, uint32_t cascade, const ShadowPass* staticPass, const ShadowPass& dynamicPass);
+        void recordAtlas(VkCommandBuffer commandBuffer, const std::vector<ShadowPass>& staticPasses, const std::vector<ShadowPass>& dynamicPasses);
+        VkRect2D tileRect(uint32_t tile) const;
+
+        SEDevice& seDevice;
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        std::unique_ptr<SEPipeline> pipeline;
+        VkSampler sampler = VK_NULL_HANDLE;
+        VkQueryPool timestampQueryPool = VK_NULL_HANDLE;
+
+        ShadowTarget cascades;
+        ShadowTarget atlas;
+        std::vector<FrameResources> frames;
+
+        ShadowParams params{};
+        uint64_t frameCounter = 0;
+
+        // Assignment, rebuilt by assignLights
+        const Scene* assignedScene = nullptr;
+        bool assignedEnabled = false;
+        uint32_t cascadeLight = NO_LIGHT;
+        std::vector<LocalShadow> localShadows;
+
+        CascadeState cascadeStates[SHADOW_CASCADE_COUNT];
+        TileState tileStates[MAX_SHADOW_TILES];
+
+        // Scratch kept between frames
+        std::vector<uint32_t> candidates;
+        std::vector<std::pair<const SEMesh*, uint32_t>> casterScratch;
+        std::vector<uint32_t> instanceObjects;
+        std::vector<CasterBatch> batches;
+        std::vector<ShadowPass> staticTilePasses;
+        std::vector<ShadowPass> dynamicTilePasses;
+    };
+}
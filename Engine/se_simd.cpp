@@ -0,0 +1,680 @@
+#include "se_simd.hpp"
+#include "se_gameobject.hpp"
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SE_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SE_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define SE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define SE_SIMD_X86 0
+#endif
+
+namespace se
+{
+namespace simd
+{
+    static_assert(sizeof(TransformComponent) == 9 * sizeof(float), "kernels expect translation, scale, rotation packed as 9 floats");
+    static_assert(sizeof(glm::mat4) == 16 * sizeof(float), "kernels expect a tightly packed column major mat4");
+
+    namespace
+    {
+        constexpr int TRANSLATION = 0;
+        constexpr int SCALE = 3;
+        constexpr int ROTATION = 6;
+        constexpr int STRIDE = 9;
+
+        // Cephes sinf/cosf constants, same reduction and polynomials as the usual sse_mathfun port
+        constexpr float FOUR_OVER_PI = 1.27323954473516f;
+        constexpr float DP1 = -0.78515625f;
+        constexpr float DP2 = -2.4187564849853515625e-4f;
+        constexpr float DP3 = -3.77489497744594108e-8f;
+        constexpr float SIN_P0 = -1.9515295891e-4f;
+        constexpr float SIN_P1 = 8.3321608736e-3f;
+        constexpr float SIN_P2 = -1.6666654611e-1f;
+        constexpr float COS_P0 = 2.443315711809948e-5f;
+        constexpr float COS_P1 = -1.388731625493765e-3f;
+        constexpr float COS_P2 = 4.166664568298827e-2f;
+
+#if SE_SIMD_X86
+        void cpuid(int info[4], int leaf, int subleaf)
+        {
+#if defined(_MSC_VER)
+            __cpuidex(info, leaf, subleaf);
+#else
+            unsigned int a, b, c, d;
+            __cpuid_count(leaf, subleaf, a, b, c, d);
+            info[0] = static_cast<int>(a);
+            info[1] = static_cast<int>(b);
+            info[2] = static_cast<int>(c);
+            info[3] = static_cast<int>(d);
+#endif
+        }
+
+        uint64_t xgetbv0()
+        {
+#if defined(_MSC_VER)
+            return _xgetbv(0);
+#else
+            uint32_t eax, edx;
+            __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+            return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+        }
+#endif
+
+        Level detectLevel()
+        {
+#if SE_SIMD_X86
+            int info[4];
+            cpuid(info, 0, 0);
+            int maxLeaf = info[0];
+
+            cpuid(info, 1, 0);
+            bool sse2 = (info[3] & (1 << 26)) != 0;
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            bool avx = (info[2] & (1 << 28)) != 0;
+
+            bool avx2 = false;
+            if (maxLeaf >= 7) {
+                cpuid(info, 7, 0);
+                avx2 = (info[1] & (1 << 5)) != 0;
+            }
+
+            // The OS has to save the ymm registers too
+            if (osxsave && avx && avx2 && (xgetbv0() & 0x6) == 0x6)
+                return Level::AVX2;
+            if (sse2)
+                return Level::SSE;
+#endif
+            return Level::Scalar;
+        }
+
+        const Level supportedLevel = detectLevel();
+        Level activeLevel = supportedLevel;
+
+        // ---------------------------------------------------------------- scalar
+
+        void composeScalar(const TransformComponent* transforms, glm::mat4* out, size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+                out[i] = transforms[i].mat4();
+        }
+
+        void multiplyScalar(const glm::mat4* lhs, const glm::mat4* rhs, glm::mat4* out, size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+                out[i] = lhs[i] * rhs[i];
+        }
+
+        constexpr int PLANE_COUNT = 6;
+
+        // Plane normals with their absolute values, so every kernel reads the same precomputed data
+        struct CullPlanes {
+            float nx[PLANE_COUNT], ny[PLANE_COUNT], nz[PLANE_COUNT], d[PLANE_COUNT];
+            float ax[PLANE_COUNT], ay[PLANE_COUNT], az[PLANE_COUNT];
+        };
+
+        CullPlanes prepareCullPlanes(const glm::vec4* planes)
+        {
+            CullPlanes prepared;
+            for (int p = 0; p < PLANE_COUNT; p++) {
+                prepared.nx[p] = planes[p].x;
+                prepared.ny[p] = planes[p].y;
+                prepared.nz[p] = planes[p].z;
+                prepared.d[p] = planes[p].w;
+                prepared.ax[p] = std::fabs(planes[p].x);
+                prepared.ay[p] = std::fabs(planes[p].y);
+                prepared.az[p] = std::fabs(planes[p].z);
+            }
+            return prepared;
+        }
+
+        size_t cullScalar(const CullPlanes& planes, const glm::vec3* centers, const glm::vec3* extents, uint8_t* visible, size_t count)
+        {
+            size_t visibleCount = 0;
+            for (size_t i = 0; i < count; i++) {
+                const glm::vec3& c = centers[i];
+                const glm::vec3& e = extents[i];
+                bool inside = true;
+                for (int p = 0; p < PLANE_COUNT && inside; p++) {
+                    float distance = planes.nx[p] * c.x + planes.ny[p] * c.y + planes.nz[p] * c.z + planes.d[p];
+                    float radius = planes.ax[p] * e.x + planes.ay[p] * e.y + planes.az[p] * e.z;
+                    inside = !(distance + radius < 0.0f);
+                }
+                visible[i] = inside ? 1 : 0;
+                visibleCount += visible[i];
+            }
+            return visibleCount;
+        }
+
+        // Writes one byte per bit of mask, returns the number of set bits
+        inline size_t storeMask(int mask, uint8_t* visible, int width)
+        {
+            size_t visibleCount = 0;
+            for (int j = 0; j < width; j++) {
+                visible[j] = static_cast<uint8_t>((mask >> j) & 1);
+                visibleCount += visible[j];
+            }
+            return visibleCount;
+        }
+
+#if SE_SIMD_X86
+        // ---------------------------------------------------------------- SSE
+
+        inline void sincos4(__m128 x, __m128& s, __m128& c)
+        {
+            const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000)));
+
+            __m128 sinSign = _mm_and_ps(x, signMask);
+            x = _mm_andnot_ps(signMask, x);
+
+            // Octant j, rounded up to even
+            __m128i j = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(FOUR_OVER_PI)));
+            j = _mm_add_epi32(j, _mm_set1_epi32(1));
+            j = _mm_and_si128(j, _mm_set1_epi32(~1));
+            __m128 y = _mm_cvtepi32_ps(j);
+
+            __m128 swapSinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29));
+            __m128 polyMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), _mm_setzero_si128()));
+            __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(j, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+            sinSign = _mm_xor_ps(sinSign, swapSinSign);
+
+            // Extended precision x - j * pi / 4
+            x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP1)));
+            x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP2)));
+            x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(DP3)));
+            __m128 z = _mm_mul_ps(x, x);
+
+            __m128 cosPoly = _mm_set1_ps(COS_P0);
+            cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(COS_P1));
+            cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(COS_P2));
+            cosPoly = _mm_mul_ps(_mm_mul_ps(cosPoly, z), z);
+            cosPoly = _mm_sub_ps(cosPoly, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+            cosPoly = _mm_add_ps(cosPoly, _mm_set1_ps(1.0f));
+
+            __m128 sinPoly = _mm_set1_ps(SIN_P0);
+            sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(SIN_P1));
+            sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(SIN_P2));
+            sinPoly = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinPoly, z), x), x);
+
+            __m128 sinResult = _mm_or_ps(_mm_and_ps(polyMask, sinPoly), _mm_andnot_ps(polyMask, cosPoly));
+            __m128 cosResult = _mm_or_ps(_mm_and_ps(polyMask, cosPoly), _mm_andnot_ps(polyMask, sinPoly));
+
+            s = _mm_xor_ps(sinResult, sinSign);
+            c = _mm_xor_ps(cosResult, cosSign);
+        }
+
+        inline __m128 loadLane4(const float* f, int member)
+        {
+            return _mm_setr_ps(f[member], f[STRIDE + member], f[2 * STRIDE + member], f[3 * STRIDE + member]);
+        }
+
+        // x/y/z/w hold one matrix column for 4 objects, written out as column `column` of each
+        inline void storeColumn4(__m128 x, __m128 y, __m128 z, __m128 w, glm::mat4* out, int column)
+        {
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            _mm_storeu_ps(&out[0][column][0], x);
+            _mm_storeu_ps(&out[1][column][0], y);
+            _mm_storeu_ps(&out[2][column][0], z);
+            _mm_storeu_ps(&out[3][column][0], w);
+        }
+
+        void compose4(const TransformComponent* transforms, glm::mat4* out)
+        {
+            const float* f = reinterpret_cast<const float*>(transforms);
+
+            __m128 s1, c1, s2, c2, s3, c3;
+            sincos4(loadLane4(f, ROTATION + 1), s1, c1);
+            sincos4(loadLane4(f, ROTATION + 0), s2, c2);
+            sincos4(loadLane4(f, ROTATION + 2), s3, c3);
+
+            __m128 sx = loadLane4(f, SCALE + 0);
+            __m128 sy = loadLane4(f, SCALE + 1);
+            __m128 sz = loadLane4(f, SCALE + 2);
+            __m128 zero = _mm_setzero_ps();
+
+            __m128 s1s2 = _mm_mul_ps(s1, s2);
+            __m128 c1s2 = _mm_mul_ps(c1, s2);
+
+            storeColumn4(
+                _mm_mul_ps(sx, _mm_add_ps(_mm_mul_ps(c1, c3), _mm_mul_ps(s1s2, s3))),
+                _mm_mul_ps(sx, _mm_mul_ps(c2, s3)),
+                _mm_mul_ps(sx, _mm_sub_ps(_mm_mul_ps(c1s2, s3), _mm_mul_ps(c3, s1))),
+                zero, out, 0);
+
+            storeColumn4(
+                _mm_mul_ps(sy, _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(c3, s1), s2), _mm_mul_ps(c1, s3))),
+                _mm_mul_ps(sy, _mm_mul_ps(c2, c3)),
+                _mm_mul_ps(sy, _mm_add_ps(_mm_mul_ps(_mm_mul_ps(c1, c3), s2), _mm_mul_ps(s1, s3))),
+                zero, out, 1);
+
+            storeColumn4(
+                _mm_mul_ps(sz, _mm_mul_ps(c2, s1)),
+                _mm_mul_ps(sz, _mm_sub_ps(zero, s2)),
+                _mm_mul_ps(sz, _mm_mul_ps(c1, c2)),
+                zero, out, 2);
+
+            storeColumn4(
+                loadLane4(f, TRANSLATION + 0),
+                loadLane4(f, TRANSLATION + 1),
+                loadLane4(f, TRANSLATION + 2),
+                _mm_set1_ps(1.0f), out, 3);
+        }
+
+        // Same summation order as glm's operator* so results match the scalar path
+        inline void multiply1(const float* a, const float* b, float* out)
+        {
+            __m128 a0 = _mm_loadu_ps(a + 0);
+            __m128 a1 = _mm_loadu_ps(a + 4);
+            __m128 a2 = _mm_loadu_ps(a + 8);
+            __m128 a3 = _mm_loadu_ps(a + 12);
+
+            for (int j = 0; j < 4; j++) {
+                __m128 bj = _mm_loadu_ps(b + 4 * j);
+                __m128 r = _mm_mul_ps(a0, _mm_shuffle_ps(bj, bj, _MM_SHUFFLE(0, 0, 0, 0)));
+                r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_shuffle_ps(bj, bj, _MM_SHUFFLE(1, 1, 1, 1))));
+                r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_shuffle_ps(bj, bj, _MM_SHUFFLE(2, 2, 2, 2))));
+                r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_shuffle_ps(bj, bj, _MM_SHUFFLE(3, 3, 3, 3))));
+                _mm_storeu_ps(out + 4 * j, r);
+            }
+        }
+
+        inline void transformPoint1(__m128 m0, __m128 m1, __m128 m2, __m128 m3, const glm::vec3& p, glm::vec4& out)
+        {
+            __m128 r = _mm_mul_ps(m0, _mm_set1_ps(p.x));
+            r = _mm_add_ps(r, _mm_mul_ps(m1, _mm_set1_ps(p.y)));
+            r = _mm_add_ps(r, _mm_mul_ps(m2, _mm_set1_ps(p.z)));
+            r = _mm_add_ps(r, m3);
+            _mm_storeu_ps(&out[0], r);
+        }
+
+        inline __m128 loadVec3Lane4(const glm::vec3* v, int member)
+        {
+            const float* f = &v[0][0];
+            return _mm_setr_ps(f[member], f[3 + member], f[6 + member], f[9 + member]);
+        }
+
+        // Bit j of the result is set when box j is at least partly inside every plane
+        inline int cull4(const CullPlanes& planes, const glm::vec3* centers, const glm::vec3* extents)
+        {
+            __m128 cx = loadVec3Lane4(centers, 0), cy = loadVec3Lane4(centers, 1), cz = loadVec3Lane4(centers, 2);
+            __m128 ex = loadVec3Lane4(extents, 0), ey = loadVec3Lane4(extents, 1), ez = loadVec3Lane4(extents, 2);
+            __m128 outside = _mm_setzero_ps();
+            const __m128 zero = _mm_setzero_ps();
+
+            for (int p = 0; p < PLANE_COUNT; p++) {
+                __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.nx[p]), cx), _mm_mul_ps(_mm_set1_ps(planes.ny[p]), cy)),
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.nz[p]), cz), _mm_set1_ps(planes.d[p])));
+                __m128 radius = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.ax[p]), ex), _mm_mul_ps(_mm_set1_ps(planes.ay[p]), ey)),
+                    _mm_mul_ps(_mm_set1_ps(planes.az[p]), ez));
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+            }
+            return ~_mm_movemask_ps(outside) & 0xF;
+        }
+
+        // ---------------------------------------------------------------- AVX2
+
+        SE_TARGET_AVX2 inline void sincos8(__m256 x, __m256& s, __m256& c)
+        {
+            const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(0x80000000)));
+
+            __m256 sinSign = _mm256_and_ps(x, signMask);
+            x = _mm256_andnot_ps(signMask, x);
+
+            __m256i j = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(FOUR_OVER_PI)));
+            j = _mm256_add_epi32(j, _mm256_set1_epi32(1));
+            j = _mm256_and_si256(j, _mm256_set1_epi32(~1));
+            __m256 y = _mm256_cvtepi32_ps(j);
+
+            __m256 swapSinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(j, _mm256_set1_epi32(4)), 29));
+            __m256 polyMask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(j, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+            __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_andnot_si256(_mm256_sub_epi32(j, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+            sinSign = _mm256_xor_ps(sinSign, swapSinSign);
+
+            x = _mm256_add_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(DP1)));
+            x = _mm256_add_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(DP2)));
+            x = _mm256_add_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(DP3)));
+            __m256 z = _mm256_mul_ps(x, x);
+
+            __m256 cosPoly = _mm256_set1_ps(COS_P0);
+            cosPoly = _mm256_add_ps(_mm256_mul_ps(cosPoly, z), _mm256_set1_ps(COS_P1));
+            cosPoly = _mm256_add_ps(_mm256_mul_ps(cosPoly, z), _mm256_set1_ps(COS_P2));
+            cosPoly = _mm256_mul_ps(_mm256_mul_ps(cosPoly, z), z);
+            cosPoly = _mm256_sub_ps(cosPoly, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+            cosPoly = _mm256_add_ps(cosPoly, _mm256_set1_ps(1.0f));
+
+            __m256 sinPoly = _mm256_set1_ps(SIN_P0);
+            sinPoly = _mm256_add_ps(_mm256_mul_ps(sinPoly, z), _mm256_set1_ps(SIN_P1));
+            sinPoly = _mm256_add_ps(_mm256_mul_ps(sinPoly, z), _mm256_set1_ps(SIN_P2));
+            sinPoly = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(sinPoly, z), x), x);
+
+            __m256 sinResult = _mm256_blendv_ps(cosPoly, sinPoly, polyMask);
+            __m256 cosResult = _mm256_blendv_ps(sinPoly, cosPoly, polyMask);
+
+            s = _mm256_xor_ps(sinResult, sinSign);
+            c = _mm256_xor_ps(cosResult, cosSign);
+        }
+
+        SE_TARGET_AVX2 inline __m256 loadLane8(const float* f, int member)
+        {
+            const __m256i offsets = _mm256_setr_epi32(0, STRIDE, 2 * STRIDE, 3 * STRIDE, 4 * STRIDE, 5 * STRIDE, 6 * STRIDE, 7 * STRIDE);
+            return _mm256_i32gather_ps(f + member, offsets, 4);
+        }
+
+        // Transposes within each 128 bit half, objects 0-3 land in the low half and 4-7 in the high half
+        SE_TARGET_AVX2 inline void storeColumn8(__m256 x, __m256 y, __m256 z, __m256 w, glm::mat4* out, int column)
+        {
+            __m256 t0 = _mm256_unpacklo_ps(x, y);
+            __m256 t1 = _mm256_unpackhi_ps(x, y);
+            __m256 t2 = _mm256_unpacklo_ps(z, w);
+            __m256 t3 = _mm256_unpackhi_ps(z, w);
+
+            __m256 r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+            __m256 r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+            __m256 r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+            __m256 r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+
+            _mm_storeu_ps(&out[0][column][0], _mm256_castps256_ps128(r0));
+            _mm_storeu_ps(&out[1][column][0], _mm256_castps256_ps128(r1));
+            _mm_storeu_ps(&out[2][column][0], _mm256_castps256_ps128(r2));
+            _mm_storeu_ps(&out[3][column][0], _mm256_castps256_ps128(r3));
+            _mm_storeu_ps(&out[4][column][0], _mm256_extractf128_ps(r0, 1));
+            _mm_storeu_ps(&out[5][column][0], _mm256_extractf128_ps(r1, 1));
+            _mm_storeu_ps(&out[6][column][0], _mm256_extractf128_ps(r2, 1));
+            _mm_storeu_ps(&out[7][column][0], _mm256_extractf128_ps(r3, 1));
+        }
+
+        SE_TARGET_AVX2 void compose8(const TransformComponent* transforms, glm::mat4* out)
+        {
+            const float* f = reinterpret_cast<const float*>(transforms);
+
+            __m256 s1, c1, s2, c2, s3, c3;
+            sincos8(loadLane8(f, ROTATION + 1), s1, c1);
+            sincos8(loadLane8(f, ROTATION + 0), s2, c2);
+            sincos8(loadLane8(f, ROTATION + 2), s3, c3);
+
+            __m256 sx = loadLane8(f, SCALE + 0);
+            __m256 sy = loadLane8(f, SCALE + 1);
+            __m256 sz = loadLane8(f, SCALE + 2);
+            __m256 zero = _mm256_setzero_ps();
+
+            __m256 s1s2 = _mm256_mul_ps(s1, s2);
+            __m256 c1s2 = _mm256_mul_ps(c1, s2);
+
+            storeColumn8(
+                _mm256_mul_ps(sx, _mm256_add_ps(_mm256_mul_ps(c1, c3), _mm256_mul_ps(s1s2, s3))),
+                _mm256_mul_ps(sx, _mm256_mul_ps(c2, s3)),
+                _mm256_mul_ps(sx, _mm256_sub_ps(_mm256_mul_ps(c1s2, s3), _mm256_mul_ps(c3, s1))),
+                zero, out, 0);
+
+            storeColumn8(
+                _mm256_mul_ps(sy, _mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(c3, s1), s2), _mm256_mul_ps(c1, s3))),
+                _mm256_mul_ps(sy, _mm256_mul_ps(c2, c3)),
+                _mm256_mul_ps(sy, _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(c1, c3), s2), _mm256_mul_ps(s1, s3))),
+                zero, out, 1);
+
+            storeColumn8(
+                _mm256_mul_ps(sz, _mm256_mul_ps(c2, s1)),
+                _mm256_mul_ps(sz, _mm256_sub_ps(zero, s2)),
+                _mm256_mul_ps(sz, _mm256_mul_ps(c1, c2)),
+                zero, out, 2);
+
+            storeColumn8(
+                loadLane8(f, TRANSLATION + 0),
+                loadLane8(f, TRANSLATION + 1),
+                loadLane8(f, TRANSLATION + 2),
+                _mm256_set1_ps(1.0f), out, 3);
+        }
+
+        SE_TARGET_AVX2 inline __m256 loadPair(const float* lo, const float* hi)
+        {
+            return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(lo)), _mm_loadu_ps(hi), 1);
+        }
+
+        // Two independent products at once, one per 128 bit half
+        SE_TARGET_AVX2 inline void multiply2(const float* a0, const float* b0, float* out0, const float* a1, const float* b1, float* out1)
+        {
+            __m256 c0 = loadPair(a0 + 0, a1 + 0);
+            __m256 c1 = loadPair(a0 + 4, a1 + 4);
+            __m256 c2 = loadPair(a0 + 8, a1 + 8);
+            __m256 c3 = loadPair(a0 + 12, a1 + 12);
+
+            __m256 r[4];
+            for (int j = 0; j < 4; j++) {
+                __m256 bj = loadPair(b0 + 4 * j, b1 + 4 * j);
+                __m256 v = _mm256_mul_ps(c0, _mm256_shuffle_ps(bj, bj, _MM_SHUFFLE(0, 0, 0, 0)));
+                v = _mm256_add_ps(v, _mm256_mul_ps(c1, _mm256_shuffle_ps(bj, bj, _MM_SHUFFLE(1, 1, 1, 1))));
+                v = _mm256_add_ps(v, _mm256_mul_ps(c2, _mm256_shuffle_ps(bj, bj, _MM_SHUFFLE(2, 2, 2, 2))));
+                v = _mm256_add_ps(v, _mm256_mul_ps(c3, _mm256_shuffle_ps(bj, bj, _MM_SHUFFLE(3, 3, 3, 3))));
+                r[j] = v;
+            }
+
+            // Store after all loads in case an output aliases an input
+            for (int j = 0; j < 4; j++) {
+                _mm_storeu_ps(out0 + 4 * j, _mm256_castps256_ps128(r[j]));
+                _mm_storeu_ps(out1 + 4 * j, _mm256_extractf128_ps(r[j], 1));
+            }
+        }
+
+        SE_TARGET_AVX2 void multiplyAVX2(const glm::mat4* const* lhs, const glm::mat4* const* rhs, glm::mat4* const* out, size_t count)
+        {
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                multiply2(&(*lhs[i])[0][0], &(*rhs[i])[0][0], &(*out[i])[0][0],
+                    &(*lhs[i + 1])[0][0], &(*rhs[i + 1])[0][0], &(*out[i + 1])[0][0]);
+            }
+            for (; i < count; i++)
+                multiply1(&(*lhs[i])[0][0], &(*rhs[i])[0][0], &(*out[i])[0][0]);
+        }
+
+        SE_TARGET_AVX2 void multiplyAVX2(const glm::mat4* lhs, const glm::mat4* rhs, glm::mat4* out, size_t count)
+        {
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                multiply2(&lhs[i][0][0], &rhs[i][0][0], &out[i][0][0],
+                    &lhs[i + 1][0][0], &rhs[i + 1][0][0], &out[i + 1][0][0]);
+            }
+            for (; i < count; i++)
+                multiply1(&lhs[i][0][0], &rhs[i][0][0], &out[i][0][0]);
+        }
+
+        SE_TARGET_AVX2 void multiplySharedAVX2(const glm::mat4& lhs, const glm::mat4* rhs, glm::mat4* out, size_t count)
+        {
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2)
+                multiply2(&lhs[0][0], &rhs[i][0][0], &out[i][0][0], &lhs[0][0], &rhs[i + 1][0][0], &out[i + 1][0][0]);
+            for (; i < count; i++)
+                multiply1(&lhs[0][0], &rhs[i][0][0], &out[i][0][0]);
+        }
+
+        SE_TARGET_AVX2 void transformPointsAVX2(const glm::mat4& matrix, const glm::vec3* points, glm::vec4* out, size_t count)
+        {
+            __m256 m0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&matrix[0][0]));
+            __m256 m1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&matrix[1][0]));
+            __m256 m2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&matrix[2][0]));
+            __m256 m3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&matrix[3][0]));
+
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                const glm::vec3& p0 = points[i];
+                const glm::vec3& p1 = points[i + 1];
+                __m256 r = _mm256_mul_ps(m0, _mm256_setr_ps(p0.x, p0.x, p0.x, p0.x, p1.x, p1.x, p1.x, p1.x));
+                r = _mm256_add_ps(r, _mm256_mul_ps(m1, _mm256_setr_ps(p0.y, p0.y, p0.y, p0.y, p1.y, p1.y, p1.y, p1.y)));
+                r = _mm256_add_ps(r, _mm256_mul_ps(m2, _mm256_setr_ps(p0.z, p0.z, p0.z, p0.z, p1.z, p1.z, p1.z, p1.z)));
+                r = _mm256_add_ps(r, m3);
+                _mm256_storeu_ps(&out[i][0], r);
+            }
+            for (; i < count; i++) {
+                transformPoint1(_mm256_castps256_ps128(m0), _mm256_castps256_ps128(m1),
+                    _mm256_castps256_ps128(m2), _mm256_castps256_ps128(m3), points[i], out[i]);
+            }
+        }
+
+        SE_TARGET_AVX2 inline __m256 loadVec3Lane8(const glm::vec3* v, int member)
+        {
+            const __m256i offsets = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+            return _mm256_i32gather_ps(&v[0][0] + member, offsets, 4);
+        }
+
+        SE_TARGET_AVX2 inline int cull8(const CullPlanes& planes, const glm::vec3* centers, const glm::vec3* extents)
+        {
+            __m256 cx = loadVec3Lane8(centers, 0), cy = loadVec3Lane8(centers, 1), cz = loadVec3Lane8(centers, 2);
+            __m256 ex = loadVec3Lane8(extents, 0), ey = loadVec3Lane8(extents, 1), ez = loadVec3Lane8(extents, 2);
+            __m256 outside = _mm256_setzero_ps();
+            const __m256 zero = _mm256_setzero_ps();
+
+            for (int p = 0; p < PLANE_COUNT; p++) {
+                __m256 distance = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.nx[p]), cx), _mm256_mul_ps(_mm256_set1_ps(planes.ny[p]), cy)),
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.nz[p]), cz), _mm256_set1_ps(planes.d[p])));
+                __m256 radius = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.ax[p]), ex), _mm256_mul_ps(_mm256_set1_ps(planes.ay[p]), ey)),
+                    _mm256_mul_ps(_mm256_set1_ps(planes.az[p]), ez));
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LT_OQ));
+            }
+            return ~_mm256_movemask_ps(outside) & 0xFF;
+        }
+#endif
+    }
+
+    Level getSupportedLevel()
+    {
+        return supportedLevel;
+    }
+
+    Level getLevel()
+    {
+        return activeLevel;
+    }
+
+    void setLevel(Level level)
+    {
+        activeLevel = static_cast<int>(level) > static_cast<int>(supportedLevel) ? supportedLevel : level;
+    }
+
+    const char* getLevelName(Level level)
+    {
+        switch (level) {
+        case Level::SSE: return "SSE";
+        case Level::AVX2: return "AVX2";
+        default: return "Scalar";
+        }
+    }
+
+    void composeTransforms(const TransformComponent* transforms, glm::mat4* out, size_t count)
+    {
+        size_t i = 0;
+#if SE_SIMD_X86
+        if (activeLevel == Level::AVX2) {
+            for (; i + 8 <= count; i += 8)
+                compose8(transforms + i, out + i);
+        }
+        if (activeLevel != Level::Scalar) {
+            for (; i + 4 <= count; i += 4)
+                compose4(transforms + i, out + i);
+        }
+#endif
+        composeScalar(transforms + i, out + i, count - i);
+    }
+
+    void multiplyMatrices(const glm::mat4* lhs, const glm::mat4* rhs, glm::mat4* out, size_t count)
+    {
+#if SE_SIMD_X86
+        if (activeLevel == Level::AVX2) {
+            multiplyAVX2(lhs, rhs, out, count);
+            return;
+        }
+        if (activeLevel == Level::SSE) {
+            for (size_t i = 0; i < count; i++)
+                multiply1(&lhs[i][0][0], &rhs[i][0][0], &out[i][0][0]);
+            return;
+        }
+#endif
+        multiplyScalar(lhs, rhs, out, count);
+    }
+
+    void multiplyMatrices(const glm::mat4* const* lhs, const glm::mat4* const* rhs, glm::mat4* const* out, size_t count)
+    {
+#if SE_SIMD_X86
+        if (activeLevel == Level::AVX2) {
+            multiplyAVX2(lhs, rhs, out, count);
+            return;
+        }
+        if (activeLevel == Level::SSE) {
+            for (size_t i = 0; i < count; i++)
+                multiply1(&(*lhs[i])[0][0], &(*rhs[i])[0][0], &(*out[i])[0][0]);
+            return;
+        }
+#endif
+        for (size_t i = 0; i < count; i++)
+            *out[i] = *lhs[i] * *rhs[i];
+    }
+
+    void multiplyMatrices(const glm::mat4& lhs, const glm::mat4* rhs, glm::mat4* out, size_t count)
+    {
+#if SE_SIMD_X86
+        if (activeLevel == Level::AVX2) {
+            multiplySharedAVX2(lhs, rhs, out, count);
+            return;
+        }
+        if (activeLevel == Level::SSE) {
+            for (size_t i = 0; i < count; i++)
+                multiply1(&lhs[0][0], &rhs[i][0][0], &out[i][0][0]);
+            return;
+        }
+#endif
+        for (size_t i = 0; i < count; i++)
+            out[i] = lhs * rhs[i];
+    }
+
+    void transformPoints(const glm::mat4& matrix, const glm::vec3* points, glm::vec4* out, size_t count)
+    {
+#if SE_SIMD_X86
+        if (activeLevel == Level::AVX2) {
+            transformPointsAVX2(matrix, points, out, count);
+            return;
+        }
+        if (activeLevel == Level::SSE) {
+            __m128 m0 = _mm_loadu_ps(&matrix[0][0]);
+            __m128 m1 = _mm_loadu_ps(&matrix[1][0]);
+            __m128 m2 = _mm_loadu_ps(&matrix[2][0]);
+            __m128 m3 = _mm_loadu_ps(&matrix[3][0]);
+            for (size_t i = 0; i < count; i++)
+                transformPoint1(m0, m1, m2, m3, points[i], out[i]);
+            return;
+        }
+#endif
+        for (size_t i = 0; i < count; i++)
+            out[i] = matrix * glm::vec4(points[i], 1.0f);
+    }
+
+    size_t cullBoxes(const glm::vec4* planes, const glm::vec3* centers, const glm::vec3* extents, uint8_t* visible, size_t count)
+    {
+        const CullPlanes prepared = prepareCullPlanes(planes);
+        size_t visibleCount = 0;
+        size_t i = 0;
+#if SE_SIMD_X86
+        if (activeLevel == Level::AVX2) {
+            for (; i + 8 <= count; i += 8)
+                visibleCount += storeMask(cull8(prepared, centers + i, extents + i), visible + i, 8);
+        }
+        if (activeLevel != Level::Scalar) {
+            for (; i + 4 <= count; i += 4)
+                visibleCount += storeMask(cull4(prepared, centers + i, extents + i), visible + i, 4);
+        }
+#endif
+        return visibleCount + cullScalar(prepared, centers + i, extents + i, visible + i, count - i);
+    }
+}
+}
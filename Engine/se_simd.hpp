@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace se
+{
+    struct TransformComponent;
+
+    // Batched transform kernels with SSE (4 wide) and AVX2 (8 wide) paths.
+    // The instruction set is picked once at startup from cpuid, glm is the scalar fallback.
+    namespace simd
+    {
+        enum class Level {
+            Scalar = 0,
+            SSE = 1,
+            AVX2 = 2
+        };
+
+        Level getSupportedLevel();
+        Level getLevel();
+        // Forces a lower level, mainly for benchmarks. Clamped to what the cpu supports.
+        void setLevel(Level level);
+        const char* getLevelName(Level level);
+
+        // out[i] = transforms[i].mat4(), Tait-Bryan YXZ like TransformComponent
+        void composeTransforms(const TransformComponent* transforms, glm::mat4* out, size_t count);
+
+        // out[i] = lhs[i] * rhs[i]
+        void multiplyMatrices(const glm::mat4* lhs, const glm::mat4* rhs, glm::mat4* out, size_t count);
+        // Gathered form used by hierarchy propagation, *out[i] = *lhs[i] * *rhs[i]
+        void multiplyMatrices(const glm::mat4* const* lhs, const glm::mat4* const* rhs, glm::mat4* const* out, size_t count);
+        // out[i] = lhs * rhs[i], e.g. view projection times world matrices
+        void multiplyMatrices(const glm::mat4& lhs, const glm::mat4* rhs, glm::mat4* out, size_t count);
+
+        // out[i] = matrix * vec4(points[i], 1), e.g. world positions into clip space for culling
+        void transformPoints(const glm::mat4& matrix, const glm::vec3* points, glm::vec4* out, size_t count);
+
+        // Tests boxes given as center and half extents against 6 normalized planes with inward normals
+        // (Frustum::planes). visible[i] is set to 1 or 0, returns how many boxes are visible.
+        size_t cullBoxes(const glm::vec4* planes, const glm::vec3* centers, const glm::vec3* extents, uint8_t* visible, size_t count);
+    }
+}
@@ -3,6 +3,7 @@
 #include "se_device.hpp"
 #include "se_vertex.hpp"
 #include "se_pbr_material.hpp"
+#include "se_bounds.hpp"
 
 // std
 #include <vector>
@@ -10,6 +11,7 @@
 
 namespace se
 {
+    // A range of the device's geometry arena plus the material it is shaded with
     class SESubMesh
     {
     public:
@@ -24,6 +26,7 @@ namespace se
         ~SESubMesh();
 
         bool hasMaterial() const { return seMaterial != nullptr; }
+        const std::shared_ptr<SEMaterial>& getMaterial() const { return seMaterial; }
         void bindMaterial(VkCommandBuffer commandBuffer, int frameIndex) const { seMaterial->bind(commandBuffer, frameIndex); }
 
         void updateMaterial(int frameIndex) { seMaterial->update(frameIndex); }
@@ -32,14 +35,23 @@ namespace se
 
 		size_t getVerticesCount() const
 		{
-			return vertexCount;
+			return geometry.vertexCount;
 		}
 
         size_t getIndicesCount() const
         {
-            return indexCount;
+            return geometry.indexCount;
         }
 
+        // Where the submesh's vertices and indices start in the arena's buffers
+        const GeometryRange& getGeometry() const { return geometry; }
+        // False while the geometry is still uploading, nothing may draw the submesh until then
+        bool isReady() const { return seDevice.getUploadManager().isReady(geometry.upload); }
+
+        // Object space bounds, computed from the builder vertices at creation
+        const AABB& getBounds() const { return bounds; }
+        const BoundingSphere& getBoundingSphere() const { return boundingSphere; }
+
         VkPipelineLayout getPipelineLayout() const
 		{
 			if (hasMaterial())
@@ -52,23 +64,21 @@ namespace se
         SESubMesh(const SESubMesh &) = delete;
         SESubMesh &operator=(const SESubMesh &) = delete;
 
-        void bind(VkCommandBuffer commandBuffer);
-        void draw(VkCommandBuffer commandBuffer);
+        // Binds the arena's buffers, every submesh shares them so one bind covers any number of draws
+        void bind(VkCommandBuffer commandBuffer) const;
+        // Binds the position only stream, 12 bytes a vertex instead of the full Vertex, with the same index buffer
+        void bindPositions(VkCommandBuffer commandBuffer) const;
+        void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0) const;
 
     private:
-        void createVertexBuffers(const std::vector<Vertex> &vertices);
-        void createIndexBuffers(const std::vector<uint32_t> &indices);
+        void computeBounds(const std::vector<Vertex> &vertices);
 
         SEDevice &seDevice;
         std::shared_ptr<SEMaterial> seMaterial = nullptr;
-        VkBuffer vertexBuffer;
-        VkDeviceMemory vertexBufferMemory;
-        uint32_t vertexCount;
-
-        bool hasIndexBuffer = false;
-        VkBuffer indexBuffer;
-        VkDeviceMemory indexBufferMemory;
-        uint32_t indexCount;
+        GeometryRange geometry;
+
+        AABB bounds;
+        BoundingSphere boundingSphere;
     };
 
 } // namespace se
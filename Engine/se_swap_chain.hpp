@@ -17,6 +17,9 @@ namespace se
   {
   public:
     static constexpr int MAX_FRAMES_IN_FLIGHT = 3;
+    // The scene subpass only takes secondary command buffers, the cubemap and ImGui draw inline in the overlay subpass
+    static constexpr uint32_t SCENE_SUBPASS = 0;
+    static constexpr uint32_t OVERLAY_SUBPASS = 1;
 
     SESwapChain(SEDevice &deviceRef, VkExtent2D windowExtent);
     SESwapChain(
@@ -30,9 +33,16 @@ namespace se
 	size_t getCurrentFrame() const { return currentFrame; }
     VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
     VkRenderPass getRenderPass() { return renderPass; }
+    // Compatible with getRenderPass but loads color and depth, for picking the frame back up after compute
+    // work between the scene's draws. Expects color in PRESENT_SRC and depth in DEPTH_STENCIL_ATTACHMENT_OPTIMAL.
+    VkRenderPass getResumeRenderPass() { return resumeRenderPass; }
     VkImageView getImageView(int index) { return swapChainImageViews[index]; }
+    // Stored at the end of the render pass and sampleable, the view only covers the depth aspect
+    VkImage getDepthImage(int index) { return depthImages[index]; }
+    VkImageView getDepthImageView(int index) { return depthImageViews[index]; }
     size_t imageCount() { return swapChainImages.size(); }
     VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
+    VkFormat getSwapChainDepthFormat() { return swapChainDepthFormat; }
     VkExtent2D getSwapChainExtent() { return swapChainExtent; }
     VkDescriptorSetLayout getDescriptorSetLayout() { return descriptorSetLayout; }
     uint32_t width() { return swapChainExtent.width; }
@@ -76,10 +86,11 @@ namespace se
 
     std::vector<VkFramebuffer> swapChainFramebuffers;
     VkRenderPass renderPass;
+    VkRenderPass resumeRenderPass;
     VkDescriptorSetLayout descriptorSetLayout;
 
     std::vector<VkImage> depthImages;
-    std::vector<VkDeviceMemory> depthImageMemorys;
+    std::vector<DeviceAllocation> depthImageMemorys;
     std::vector<VkImageView> depthImageViews;
     std::vector<VkImage> swapChainImages;
     std::vector<VkImageView> swapChainImageViews;
@@ -20,6 +20,8 @@ namespace se
 		VkImageView getTextureImageView() { return textureImageView; }
 		VkImageLayout getTextureImageLayout() { return textureImageLayout; }
 		VkDescriptorSet getTextureDescriptorSet() { return textureDescriptorSet; }
+		// False until the upload and mip chain are done, sample a fallback until then
+		bool isReady() const { return seDevice.getUploadManager().isReady(upload); }
 
 	private:
 		SEDevice &seDevice;
@@ -27,22 +29,20 @@ namespace se
 
 		uint32_t mipLevels;
 		VkImage textureImage;
-		VkDeviceMemory textureImageMemory;
+		DeviceAllocation textureImageMemory;
 		VkImageView textureImageView;
 		VkImageLayout textureImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 		VkSampler textureSampler;
 
 		VkDescriptorSet textureDescriptorSet;
+		uint64_t upload = 0;
 
 		void createTextureImage(stbi_uc* pixels, int width, int height);
-		void generateMipmaps(VkImage image, VkFormat imageFormat, int32_t texWidth, int32_t texHeight, uint32_t mipLevels);
 		VkSampleCountFlagBits getMaxUsableSampleCount();
 		void createTextureImageView();
 		void createTextureSampler();
 		VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels);
-		void createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &imageMemory);
+		void createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage &image, DeviceAllocation &imageMemory);
 		void createTextureDescriptorSet();
-		void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels);
-		void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
 	};
 }
\ No newline at end of file
@@ -12,6 +12,12 @@ namespace se
 
 	TextureSystem::~TextureSystem()
 	{
+		for (auto& [path, request] : pending)
+		{
+			JobSystem::getInstance().wait(request->decodeJob);
+			if (request->pixels)
+				stbi_image_free(request->pixels);
+		}
 	}
 	std::shared_ptr<se::SETexture> TextureSystem::loadTexture(const std::string guid, const std::string& name, const std::string& path)
 	{
@@ -31,5 +37,81 @@ namespace se
 
 		return texture;
 	}
-	
-}
\ No newline at end of file
+
+	std::shared_ptr<se::SETexture> TextureSystem::requestTexture(const std::string& guid, const std::string& name, const std::string& path,
+		std::function<void(std::shared_ptr<se::SETexture>)> onReady)
+	{
+		auto it = pending.find(path);
+		if (it != pending.end())
+		{
+			it->second->consumers.push_back(std::move(onReady));
+			return dummyTexture;
+		}
+
+		auto request = std::make_shared<PendingTexture>();
+		request->guid = guid;
+		request->name = name;
+		request->path = path;
+		request->consumers.push_back(std::move(onReady));
+
+		// stbi_load keeps no shared state, the job owns a reference so the request outlives it. In the background
+		// so a frame's wait or parallelFor never ends up decoding on the main thread.
+		request->decodeJob = JobSystem::getInstance().runBackground([request]() {
+			int texChannels;
+			request->pixels = stbi_load(request->path.c_str(), &request->width, &request->height, &texChannels, STBI_rgb_alpha);
+		});
+
+		pending.insert({ path, request });
+		return dummyTexture;
+	}
+
+	void TextureSystem::update()
+	{
+		if (pending.empty())
+			return;
+
+		UploadManager::ImportScope importScope(seDevice.getUploadManager());
+
+		for (auto it = pending.begin(); it != pending.end();)
+		{
+			PendingTexture& request = *it->second;
+			if (!request.texture)
+			{
+				if (!request.decodeJob->isFinished())
+				{
+					++it;
+					continue;
+				}
+				if (!request.pixels)
+				{
+					// Materials keep the dummy texture
+					std::cerr << "[TextureSystem] Failed to load texture image: " << request.path << "\n";
+					it = pending.erase(it);
+					continue;
+				}
+
+				// Takes the pixels and frees them
+				request.texture = std::make_shared<se::SETexture>(seDevice, request.guid, request.name, request.pixels, request.width, request.height);
+				request.pixels = nullptr;
+				textures.insert({ request.guid, request.texture });
+			}
+
+			if (!request.texture->isReady())
+			{
+				++it;
+				continue;
+			}
+
+			for (auto& consumer : request.consumers)
+				consumer(request.texture);
+			it = pending.erase(it);
+		}
+	}
+
+	void TextureSystem::finishDecoding()
+	{
+		for (auto& [path, request] : pending)
+			JobSystem::getInstance().wait(request->decodeJob);
+		update();
+	}
+}
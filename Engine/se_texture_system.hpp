@@ -7,8 +7,11 @@
 #include <memory>  
 
 #include "se_device.hpp"
+#include "se_job_system.hpp"
 #include "se_texture.hpp"
 
+#include <functional>
+
 namespace se
 {
 	class TextureSystem
@@ -30,13 +33,46 @@ namespace se
 			return dummyTexture;
 		}
 
+		se::SEDevice& getDevice() const
+		{
+			return seDevice;
+		}
+
 		std::shared_ptr<se::SETexture> loadTexture(const std::string guid, const std::string& name, const std::string& path);
 
+		// Decodes the image on a background job and returns the dummy texture right away. update() calls onReady with
+		// the real texture once it is decoded and uploaded. Requests for a path that is already in flight share
+		// its decode.
+		std::shared_ptr<se::SETexture> requestTexture(const std::string& guid, const std::string& name, const std::string& path,
+			std::function<void(std::shared_ptr<se::SETexture>)> onReady);
+		// Creates the textures whose decode finished, in one upload batch, and hands over the ones that are ready.
+		// Call once a frame before the frame begins.
+		void update();
+		// Blocks until every request is decoded and its texture created, uploads may still be in flight
+		void finishDecoding();
+		size_t getPendingCount() const { return pending.size(); }
+
 	private:
+		struct PendingTexture
+		{
+			std::string guid;
+			std::string name;
+			std::string path;
+			JobHandle decodeJob;
+			// Written by the decode job, read once it has finished
+			stbi_uc* pixels = nullptr;
+			int width = 0;
+			int height = 0;
+			std::shared_ptr<se::SETexture> texture;
+			std::vector<std::function<void(std::shared_ptr<se::SETexture>)>> consumers;
+		};
+
 		se::SEDevice& seDevice;
 		std::shared_ptr<se::SETexture> dummyTexture;
 
 		std::unordered_map<std::string, std::shared_ptr<se::SETexture>> textures;
+		// Requests by path, until their texture is ready
+		std::unordered_map<std::string, std::shared_ptr<PendingTexture>> pending;
 
 	};
 } // namespace se
\ No newline at end of file
@@ -0,0 +1,626 @@
+#include "se_upload_manager.hpp"
+#include "se_device.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace se
+{
+    UploadManager::UploadManager(SEDevice& device, VkQueue transferQueue, uint32_t transferFamily, uint32_t graphicsFamily, bool timelineSemaphores)
+        : seDevice{ device }, queue{ transferQueue }, transferFamily{ transferFamily }, graphicsFamily{ graphicsFamily },
+        ownershipTransfer{ transferFamily != graphicsFamily }
+    {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = transferFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        if (vkCreateCommandPool(seDevice.device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create upload command pool!");
+        }
+
+        if (timelineSemaphores)
+        {
+            VkSemaphoreTypeCreateInfo typeInfo{};
+            typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+            typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+            typeInfo.initialValue = 0;
+
+            VkSemaphoreCreateInfo semaphoreInfo{};
+            semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            semaphoreInfo.pNext = &typeInfo;
+
+            if (vkCreateSemaphore(seDevice.device(), &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create upload semaphore!");
+            }
+        }
+
+        copyAlignment = std::max<VkDeviceSize>(16, seDevice.properties.limits.optimalBufferCopyOffsetAlignment);
+
+        seDevice.createBuffer(
+            RING_SIZE,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            ring.buffer,
+            ring.memory);
+    }
+
+    UploadManager::~UploadManager()
+    {
+        waitFor(submittedValue);
+        retire(submittedValue);
+
+        for (StagingBuffer& staging : openBatch.overflow)
+            seDevice.destroyBuffer(staging.buffer, staging.memory);
+        seDevice.destroyBuffer(ring.buffer, ring.memory);
+
+        vkDestroySemaphore(seDevice.device(), semaphore, nullptr);
+        vkDestroyCommandPool(seDevice.device(), commandPool, nullptr);
+    }
+
+    uint64_t UploadManager::uploadBuffer(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        VkBuffer stagingBuffer;
+        VkDeviceSize stagingOffset;
+        stage(data, size, stagingBuffer, stagingOffset);
+        beginBatch();
+
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = stagingOffset;
+        copyRegion.dstOffset = offset;
+        copyRegion.size = size;
+        vkCmdCopyBuffer(openBatch.commandBuffer, stagingBuffer, buffer, 1, &copyRegion);
+
+        if (ownershipTransfer)
+        {
+            // Released here, recordAcquires acquires the range on the graphics queue
+            VkBufferMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = 0;
+            barrier.srcQueueFamilyIndex = transferFamily;
+            barrier.dstQueueFamilyIndex = graphicsFamily;
+            barrier.buffer = buffer;
+            barrier.offset = offset;
+            barrier.size = size;
+            vkCmdPipelineBarrier(
+                openBatch.commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                0,
+                0, nullptr,
+                1, &barrier,
+                0, nullptr);
+        }
+
+        openBatch.buffers.push_back({ buffer, offset, size });
+        bytesUploaded += size;
+        return submittedValue + 1;
+    }
+
+    uint64_t UploadManager::uploadImage(VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels, const void* pixels, VkDeviceSize size)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        VkBuffer stagingBuffer;
+        VkDeviceSize stagingOffset;
+        stage(pixels, size, stagingBuffer, stagingOffset);
+        beginBatch();
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = mipLevels;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        vkCmdPipelineBarrier(
+            openBatch.commandBuffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &barrier);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = stagingOffset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = { width, height, 1 };
+        vkCmdCopyBufferToImage(openBatch.commandBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        if (!ownershipTransfer)
+        {
+            // The batch runs on a graphics capable queue, so the chain is finished in the same submission
+            recordMipmaps(openBatch.commandBuffer, { image, width, height, mipLevels });
+        }
+        else
+        {
+            // Every level moves over in TRANSFER_DST_OPTIMAL, the graphics queue blits the rest of the chain
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = 0;
+            barrier.srcQueueFamilyIndex = transferFamily;
+            barrier.dstQueueFamilyIndex = graphicsFamily;
+            vkCmdPipelineBarrier(
+                openBatch.commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                0,
+                0, nullptr,
+                0, nullptr,
+                1, &barrier);
+        }
+
+        openBatch.images.push_back({ image, width, height, mipLevels });
+        bytesUploaded += size;
+        return submittedValue + 1;
+    }
+
+    void UploadManager::discard(VkImage image)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto matches = [image](const ImageAcquire& acquire) { return acquire.image == image; };
+        bool inFlight = std::any_of(openBatch.images.begin(), openBatch.images.end(), matches);
+        for (const Batch& batch : submitted)
+            inFlight = inFlight || std::any_of(batch.images.begin(), batch.images.end(), matches);
+
+        if (inFlight)
+        {
+            flushLocked();
+            waitFor(submittedValue);
+            retire(getCompletedValue());
+        }
+
+        pendingImages.erase(std::remove_if(pendingImages.begin(), pendingImages.end(), matches), pendingImages.end());
+    }
+
+    void UploadManager::discard(VkBuffer buffer)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto matches = [buffer](const BufferAcquire& acquire) { return acquire.buffer == buffer; };
+        bool inFlight = std::any_of(openBatch.buffers.begin(), openBatch.buffers.end(), matches);
+        for (const Batch& batch : submitted)
+            inFlight = inFlight || std::any_of(batch.buffers.begin(), batch.buffers.end(), matches);
+
+        if (inFlight)
+        {
+            flushLocked();
+            waitFor(submittedValue);
+            retire(getCompletedValue());
+        }
+
+        pendingBuffers.erase(std::remove_if(pendingBuffers.begin(), pendingBuffers.end(), matches), pendingBuffers.end());
+    }
+
+    void UploadManager::beginImport()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Whatever was queued before goes on its own, the import's batch holds only the asset
+        if (importDepth++ == 0)
+            flushLocked();
+    }
+
+    uint64_t UploadManager::endImport()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (--importDepth > 0)
+            return submittedValue + 1;
+
+        flushLocked();
+        return submittedValue;
+    }
+
+    void UploadManager::flush()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (importDepth == 0)
+            flushLocked();
+    }
+
+    void UploadManager::recordAcquires(VkCommandBuffer commandBuffer)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        retire(getCompletedValue());
+
+        if (!pendingBuffers.empty())
+        {
+            const VkAccessFlags readers = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT
+                | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+            const VkPipelineStageFlags readerStages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
+                | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+            if (ownershipTransfer)
+            {
+                std::vector<VkBufferMemoryBarrier> barriers(pendingBuffers.size());
+                for (size_t i = 0; i < pendingBuffers.size(); i++)
+                {
+                    barriers[i].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                    barriers[i].srcAccessMask = 0;
+                    barriers[i].dstAccessMask = readers;
+                    barriers[i].srcQueueFamilyIndex = transferFamily;
+                    barriers[i].dstQueueFamilyIndex = graphicsFamily;
+                    barriers[i].buffer = pendingBuffers[i].buffer;
+                    barriers[i].offset = pendingBuffers[i].offset;
+                    barriers[i].size = pendingBuffers[i].size;
+                }
+                vkCmdPipelineBarrier(
+                    commandBuffer,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    readerStages,
+                    0,
+                    0, nullptr,
+                    static_cast<uint32_t>(barriers.size()), barriers.data(),
+                    0, nullptr);
+            }
+            else
+            {
+                VkMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = readers;
+                vkCmdPipelineBarrier(
+                    commandBuffer,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    readerStages,
+                    0,
+                    1, &barrier,
+                    0, nullptr,
+                    0, nullptr);
+            }
+        }
+
+        // Without a family change the batch already left its images in SHADER_READ_ONLY_OPTIMAL
+        if (ownershipTransfer && !pendingImages.empty())
+        {
+            std::vector<VkImageMemoryBarrier> barriers(pendingImages.size());
+            for (size_t i = 0; i < pendingImages.size(); i++)
+            {
+                barriers[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                barriers[i].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+                barriers[i].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+                barriers[i].srcAccessMask = 0;
+                barriers[i].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+                barriers[i].srcQueueFamilyIndex = transferFamily;
+                barriers[i].dstQueueFamilyIndex = graphicsFamily;
+                barriers[i].image = pendingImages[i].image;
+                barriers[i].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                barriers[i].subresourceRange.baseMipLevel = 0;
+                barriers[i].subresourceRange.levelCount = pendingImages[i].mipLevels;
+                barriers[i].subresourceRange.baseArrayLayer = 0;
+                barriers[i].subresourceRange.layerCount = 1;
+            }
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                0,
+                0, nullptr,
+                0, nullptr,
+                static_cast<uint32_t>(barriers.size()), barriers.data());
+
+            for (const ImageAcquire& image : pendingImages)
+                recordMipmaps(commandBuffer, image);
+        }
+
+        pendingBuffers.clear();
+        pendingImages.clear();
+        readyValue.store(retiredValue, std::memory_order_relaxed);
+    }
+
+    void UploadManager::waitIdle()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        flushLocked();
+        waitFor(submittedValue);
+        retire(getCompletedValue());
+    }
+
+    void UploadManager::stage(const void* data, VkDeviceSize size, VkBuffer& buffer, VkDeviceSize& offset)
+    {
+        if (importDepth > 0)
+        {
+            stageImport(data, size, buffer, offset);
+            return;
+        }
+
+        // Anything over half the ring would keep it from overlapping batches, it gets a buffer of its own
+        if (size > RING_SIZE / 2)
+        {
+            StagingBuffer staging;
+            seDevice.createBuffer(
+                size,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                staging.buffer,
+                staging.memory,
+                MemoryAllocator::Strategy::Linear);
+            std::memcpy(staging.memory.mapped, data, static_cast<size_t>(size));
+
+            buffer = staging.buffer;
+            offset = 0;
+            openBatch.overflow.push_back(staging);
+            return;
+        }
+
+        // A full ring waits for the oldest batch, the only time an upload blocks
+        while (!allocateRing(size, offset))
+        {
+            flushLocked();
+            if (submitted.empty())
+            {
+                throw std::runtime_error("upload ring exhausted!");
+            }
+            waitFor(submitted.front().value);
+            retire(getCompletedValue());
+        }
+
+        std::memcpy(static_cast<uint8_t*>(ring.memory.mapped) + offset, data, static_cast<size_t>(size));
+        buffer = ring.buffer;
+    }
+
+    void UploadManager::stageImport(const void* data, VkDeviceSize size, VkBuffer& buffer, VkDeviceSize& offset)
+    {
+        // Imports never wait for the ring, the arena grows a chunk at a time instead
+        offset = (importHead + copyAlignment - 1) / copyAlignment * copyAlignment;
+        if (importChunkSize == 0 || offset + size > importChunkSize)
+        {
+            StagingBuffer chunk;
+            importChunkSize = std::max(size, IMPORT_CHUNK_SIZE);
+            seDevice.createBuffer(
+                importChunkSize,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                chunk.buffer,
+                chunk.memory,
+                MemoryAllocator::Strategy::Linear);
+            openBatch.overflow.push_back(chunk);
+            offset = 0;
+        }
+
+        const StagingBuffer& chunk = openBatch.overflow.back();
+        std::memcpy(static_cast<uint8_t*>(chunk.memory.mapped) + offset, data, static_cast<size_t>(size));
+        buffer = chunk.buffer;
+        importHead = offset + size;
+    }
+
+    bool UploadManager::allocateRing(VkDeviceSize size, VkDeviceSize& offset)
+    {
+        if (ringUsed == 0)
+            ringHead = 0;
+
+        // Batches retire in order, so the used bytes always end at the head
+        VkDeviceSize aligned = (ringHead + copyAlignment - 1) / copyAlignment * copyAlignment;
+        VkDeviceSize padding = aligned - ringHead;
+        if (aligned + size > RING_SIZE)
+        {
+            aligned = 0;
+            padding = RING_SIZE - ringHead;
+        }
+        if (ringUsed + padding + size > RING_SIZE)
+            return false;
+
+        offset = aligned;
+        ringHead = aligned + size;
+        ringUsed += padding + size;
+        openBatch.ringBytes += padding + size;
+        return true;
+    }
+
+    void UploadManager::beginBatch()
+    {
+        if (openBatch.commandBuffer != VK_NULL_HANDLE)
+            return;
+
+        if (!freeCommandBuffers.empty())
+        {
+            openBatch.commandBuffer = freeCommandBuffers.back();
+            freeCommandBuffers.pop_back();
+        }
+        else
+        {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = commandPool;
+            allocInfo.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(seDevice.device(), &allocInfo, &openBatch.commandBuffer) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to allocate upload command buffer!");
+            }
+        }
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(openBatch.commandBuffer, &beginInfo);
+    }
+
+    void UploadManager::flushLocked()
+    {
+        if (openBatch.commandBuffer == VK_NULL_HANDLE)
+            return;
+
+        vkEndCommandBuffer(openBatch.commandBuffer);
+        openBatch.value = ++submittedValue;
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &openBatch.commandBuffer;
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        if (semaphore != VK_NULL_HANDLE)
+        {
+            timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            timelineInfo.signalSemaphoreValueCount = 1;
+            timelineInfo.pSignalSemaphoreValues = &openBatch.value;
+            submitInfo.pNext = &timelineInfo;
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &semaphore;
+        }
+
+        if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to submit upload batch!");
+        }
+        batchesSubmitted++;
+
+        submitted.push_back(std::move(openBatch));
+        openBatch = Batch{};
+        importChunkSize = 0;
+        importHead = 0;
+
+        if (semaphore == VK_NULL_HANDLE)
+        {
+            vkQueueWaitIdle(queue);
+            retire(submittedValue);
+        }
+    }
+
+    void UploadManager::waitFor(uint64_t value)
+    {
+        if (semaphore == VK_NULL_HANDLE || value == 0)
+            return;
+
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &semaphore;
+        waitInfo.pValues = &value;
+        vkWaitSemaphores(seDevice.device(), &waitInfo, UINT64_MAX);
+    }
+
+    uint64_t UploadManager::getCompletedValue() const
+    {
+        if (semaphore == VK_NULL_HANDLE)
+            return retiredValue;
+
+        uint64_t value = 0;
+        vkGetSemaphoreCounterValue(seDevice.device(), semaphore, &value);
+        return value;
+    }
+
+    void UploadManager::retire(uint64_t value)
+    {
+        while (!submitted.empty() && submitted.front().value <= value)
+        {
+            Batch& batch = submitted.front();
+            pendingBuffers.insert(pendingBuffers.end(), batch.buffers.begin(), batch.buffers.end());
+            pendingImages.insert(pendingImages.end(), batch.images.begin(), batch.images.end());
+
+            for (StagingBuffer& staging : batch.overflow)
+                seDevice.destroyBuffer(staging.buffer, staging.memory);
+
+            ringUsed -= batch.ringBytes;
+            freeCommandBuffers.push_back(batch.commandBuffer);
+            retiredValue = batch.value;
+            submitted.pop_front();
+        }
+    }
+
+    void UploadManager::recordMipmaps(VkCommandBuffer commandBuffer, const ImageAcquire& image) const
+    {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.image = image.image;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.subresourceRange.levelCount = 1;
+
+        int32_t mipWidth = static_cast<int32_t>(image.width);
+        int32_t mipHeight = static_cast<int32_t>(image.height);
+
+        for (uint32_t i = 1; i < image.mipLevels; i++)
+        {
+            barrier.subresourceRange.baseMipLevel = i - 1;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+            vkCmdPipelineBarrier(commandBuffer,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                                 0, nullptr,
+                                 0, nullptr,
+                                 1, &barrier);
+
+            VkImageBlit blit{};
+            blit.srcOffsets[0] = {0, 0, 0};
+            blit.srcOffsets[1] = {mipWidth, mipHeight, 1};
+            blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            blit.srcSubresource.mipLevel = i - 1;
+            blit.srcSubresource.baseArrayLayer = 0;
+            blit.srcSubresource.layerCount = 1;
+            blit.dstOffsets[0] = {0, 0, 0};
+            blit.dstOffsets[1] = {mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1};
+            blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            blit.dstSubresource.mipLevel = i;
+            blit.dstSubresource.baseArrayLayer = 0;
+            blit.dstSubresource.layerCount = 1;
+
+            vkCmdBlitImage(commandBuffer,
+                           image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           1, &blit,
+                           VK_FILTER_LINEAR);
+
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+            vkCmdPipelineBarrier(commandBuffer,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                                 0, nullptr,
+                                 0, nullptr,
+                                 1, &barrier);
+
+            if (mipWidth > 1)
+                mipWidth /= 2;
+            if (mipHeight > 1)
+                mipHeight /= 2;
+        }
+
+        barrier.subresourceRange.baseMipLevel = image.mipLevels - 1;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                             0, nullptr,
+                             0, nullptr,
+                             1, &barrier);
+    }
+}
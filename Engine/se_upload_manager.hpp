@@ -0,0 +1,162 @@
+#pragma once
+
+#include "se_memory_allocator.hpp"
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace se
+{
+    class SEDevice;
+
+    // Copies data into device local buffers and images without stalling the caller. Uploads are staged in a
+    // persistently mapped ring, recorded into one open batch and submitted together, on a dedicated transfer queue
+    // when the GPU has one. A timeline semaphore counts the finished batches.
+    // The graphics queue takes finished uploads over in recordAcquires at the start of a frame. Mip chains need a
+    // graphics queue, so they are blitted there when the transfer queue is from another family, and in the batch
+    // itself otherwise. Each upload returns a ticket, only draw with what it wrote once isReady says so. Without
+    // timeline semaphores every flush waits for its batch.
+    class UploadManager
+    {
+    public:
+        // transferQueue may be the graphics queue, transferFamily is then the graphics family
+        UploadManager(SEDevice& device, VkQueue transferQueue, uint32_t transferFamily, uint32_t graphicsFamily, bool timelineSemaphores);
+        ~UploadManager();
+
+        UploadManager(const UploadManager&) = delete;
+        UploadManager& operator=(const UploadManager&) = delete;
+
+        // Copies size bytes to offset in buffer, the buffer is read as vertex, index, uniform or storage data after
+        uint64_t uploadBuffer(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size);
+        // Fills level 0 of a colour image in VK_IMAGE_LAYOUT_UNDEFINED with tightly packed pixels. The other levels are
+        // blitted from it and every level ends up in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL.
+        uint64_t uploadImage(VkImage image, uint32_t width, uint32_t height, uint32_t mipLevels, const void* pixels, VkDeviceSize size);
+        // For images destroyed before they were ready, waits for their transfer and drops their graphics side
+        void discard(VkImage image);
+        // The same for buffers, for ones replaced after their contents were copied elsewhere
+        void discard(VkBuffer buffer);
+
+        // Uploads between beginImport and endImport go out as one batch staged in an arena of their own, so an asset
+        // import is a single submission however many submeshes and textures it has. Imports nest, flush waits for
+        // the outermost to end.
+        void beginImport();
+        // Submits the import's batch and returns a ticket that is ready once everything it uploaded is
+        uint64_t endImport();
+
+        // Submits the open batch, nothing to do when it is empty or an import is open
+        void flush();
+        // Records the graphics queue's side of every finished batch, outside a render pass. Commands recorded after it
+        // may use those uploads, and the submit has to wait on getSemaphore() for getReadyValue().
+        void recordAcquires(VkCommandBuffer commandBuffer);
+        // Flushes and blocks until every transfer finished, the next recordAcquires takes all of them over
+        void waitIdle();
+
+        bool isReady(uint64_t ticket) const { return ticket <= readyValue.load(std::memory_order_relaxed); }
+        // Only grows, caches of what was drawable can compare it to notice new uploads
+        uint64_t getReadyValue() const { return readyValue.load(std::memory_order_relaxed); }
+        // Null without timeline semaphores
+        VkSemaphore getSemaphore() const { return semaphore; }
+
+        uint64_t getBytesUploaded() const { return bytesUploaded; }
+        uint32_t getBatchesSubmitted() const { return batchesSubmitted; }
+
+        // Keeps an import open for its lifetime
+        class ImportScope
+        {
+        public:
+            explicit ImportScope(UploadManager& uploadManager) : uploadManager{ uploadManager } { uploadManager.beginImport(); }
+            ~ImportScope() { uploadManager.endImport(); }
+
+            ImportScope(const ImportScope&) = delete;
+            ImportScope& operator=(const ImportScope&) = delete;
+
+        private:
+            UploadManager& uploadManager;
+        };
+
+    private:
+        struct BufferAcquire {
+            VkBuffer buffer;
+            VkDeviceSize offset;
+            VkDeviceSize size;
+        };
+
+        struct ImageAcquire {
+            VkImage image;
+            uint32_t width;
+            uint32_t height;
+            uint32_t mipLevels;
+        };
+
+        struct StagingBuffer {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            DeviceAllocation memory;
+        };
+
+        struct Batch {
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            uint64_t value = 0;
+            // Ring bytes the batch holds, wrap padding included
+            VkDeviceSize ringBytes = 0;
+            // Uploads too big for the ring, freed with the batch
+            std::vector<StagingBuffer> overflow;
+            std::vector<BufferAcquire> buffers;
+            std::vector<ImageAcquire> images;
+        };
+
+        static constexpr VkDeviceSize RING_SIZE = 64ull * 1024 * 1024;
+        // Imports stage in chunks of at least this size, freed with their batch
+        static constexpr VkDeviceSize IMPORT_CHUNK_SIZE = 64ull * 1024 * 1024;
+
+        // Stages size bytes in the ring, or in an overflow buffer, and returns where
+        void stage(const void* data, VkDeviceSize size, VkBuffer& buffer, VkDeviceSize& offset);
+        bool allocateRing(VkDeviceSize size, VkDeviceSize& offset);
+        void stageImport(const void* data, VkDeviceSize size, VkBuffer& buffer, VkDeviceSize& offset);
+        void beginBatch();
+        void flushLocked();
+        void waitFor(uint64_t value);
+        // Moves the graphics side of batches finished by value to the pending lists and recycles them
+        void retire(uint64_t value);
+        uint64_t getCompletedValue() const;
+
+        void recordMipmaps(VkCommandBuffer commandBuffer, const ImageAcquire& image) const;
+
+        SEDevice& seDevice;
+        VkQueue queue;
+        uint32_t transferFamily;
+        uint32_t graphicsFamily;
+        // Ownership moves between families, the same family only needs barriers
+        bool ownershipTransfer;
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        VkSemaphore semaphore = VK_NULL_HANDLE;
+
+        StagingBuffer ring;
+        VkDeviceSize ringHead = 0;
+        VkDeviceSize ringUsed = 0;
+        VkDeviceSize copyAlignment = 16;
+
+        Batch openBatch;
+        uint32_t importDepth = 0;
+        // The open import chunk is the open batch's last overflow buffer, none while the size is 0
+        VkDeviceSize importChunkSize = 0;
+        VkDeviceSize importHead = 0;
+        std::deque<Batch> submitted;
+        std::vector<VkCommandBuffer> freeCommandBuffers;
+        uint64_t submittedValue = 0;
+        uint64_t retiredValue = 0;
+        std::vector<BufferAcquire> pendingBuffers;
+        std::vector<ImageAcquire> pendingImages;
+        std::atomic<uint64_t> readyValue{ 0 };
+
+        uint64_t bytesUploaded = 0;
+        uint32_t batchesSubmitted = 0;
+
+        mutable std::mutex mutex;
+    };
+}
@@ -18,6 +18,9 @@ namespace se
 
 		static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
 		static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+		// Tightly packed positions, the stream SESubMesh::bindPositions binds for depth only passes
+		static std::vector<VkVertexInputBindingDescription> getPositionBindingDescriptions();
+		static std::vector<VkVertexInputAttributeDescription> getPositionAttributeDescriptions();
 		
 
 		bool operator==(const Vertex &other) const
@@ -0,0 +1,28 @@
+#version 450
+
+// Same block as the material set's binding 0, the pre-pass binds no material
+layout(set = 0, binding = 13) uniform UBO {
+    mat4 view;
+    mat4 proj;
+    vec3 cameraPos;
+} ubo;
+
+layout(std430, set = 0, binding = 5) readonly buffer Visible {
+    uint visible[];
+} visibleBuffer;
+
+layout(std430, set = 0, binding = 6) readonly buffer Transforms {
+    mat4 transforms[];
+} transformBuffer;
+
+// Position only stream, see SESubMesh::bindPositions
+layout(location = 0) in vec3 inPosition;
+
+// Has to match pbrIndirectVert bit for bit, the shading pass tests EQUAL against this depth
+invariant gl_Position;
+
+void main() {
+    mat4 model = transformBuffer.transforms[visibleBuffer.visible[gl_InstanceIndex]];
+    vec4 worldPosition = model * vec4(inPosition, 1.0);
+    gl_Position = ubo.proj * ubo.view * worldPosition;
+}
@@ -0,0 +1,28 @@
+#version 450
+
+// Same block as the material set's binding 0, the pre-pass binds no material
+layout(set = 0, binding = 13) uniform UBO {
+    mat4 view;
+    mat4 proj;
+    vec3 cameraPos;
+} ubo;
+
+struct InstanceData {
+    mat4 transform;  // Model matrix
+};
+
+layout(std430, set = 0, binding = 4) readonly buffer Instances {
+    InstanceData instances[];
+} instanceBuffer;
+
+// Position only stream, see SESubMesh::bindPositions
+layout(location = 0) in vec3 inPosition;
+
+// Has to match pbrVert bit for bit, the shading pass tests EQUAL against this depth
+invariant gl_Position;
+
+void main() {
+    mat4 model = instanceBuffer.instances[gl_InstanceIndex].transform;
+    vec4 worldPosition = model * vec4(inPosition, 1.0);
+    gl_Position = ubo.proj * ubo.view * worldPosition;
+}
@@ -1,9 +1,5 @@
 #version 450
 
-layout(push_constant) uniform PushConstants {
-    mat4 transform;
-} pushConstants;
-
 layout(set = 1, binding = 0) uniform UBO {
     mat4 view;
     mat4 proj;
@@ -46,13 +42,51 @@ struct Light {
     float intensity; // intensity of the light
     vec3 direction; // xyz: direction, w: spotAngle
     float spotAngle; // angle of the spot light
+    float range;     // point and spot lights fade out to nothing here
+    uint castShadows;
+    int shadowIndex; // 0 for the cascades, first atlas tile for spot and point lights, -1 without a shadow
+    float _pad0;
+};
+
+layout(std430, set = 0, binding = 3) readonly buffer LIGHTS {
+    Light lights[];
+} lightBuffer;
+
+layout(std140, set = 0, binding = 7) uniform CLUSTERS {
+    mat4 view;
+    mat4 inverseProjection;
+    uvec4 gridSize;     // xyz clusters, w 0 shades every light
+    vec4 screen;        // xy framebuffer size, zw tile size
+    vec4 depth;         // x near, y far, zw log depth to slice scale and bias
+    uvec4 lights;       // x light count, y max lights per cluster
+} clusters;
+
+layout(std430, set = 0, binding = 8) readonly buffer LIGHT_COUNTS {
+    uint lightCounts[];
+};
+
+layout(std430, set = 0, binding = 9) readonly buffer LIGHT_INDICES {
+    uint lightIndices[];
+};
+
+layout(set = 0, binding = 10) uniform sampler2DArrayShadow cascadeShadowMap;
+layout(set = 0, binding = 11) uniform sampler2DShadow atlasShadowMap;
+
+const int SHADOW_CASCADE_COUNT = 4;
+const int MAX_SHADOW_TILES = 64;
+
+struct ShadowTile {
+    mat4 viewProjection;
+    vec4 rect;          // xy offset, zw size, in atlas uv
 };
 
-layout(std140, set = 0, binding = 3) uniform LIGHTS {
-    int lightCount;
-    vec3 _pad0;         // pad to 16 bytes
-    Light lights[100];
-} uboL;
+layout(std140, set = 0, binding = 12) uniform SHADOWS {
+    mat4 cascadeViewProjection[SHADOW_CASCADE_COUNT];
+    vec4 cascadeSplits; // view depth each cascade ends at
+    vec4 bias;          // x cascade depth bias, y atlas depth bias, z half an atlas texel in uv
+    uvec4 info;         // x cascades in use, y 1 when shadows are on
+    ShadowTile tiles[MAX_SHADOW_TILES];
+} shadows;
 
 layout(location = 0) in vec3 WorldPos;
 layout(location = 1) in vec2 TexCoords;
@@ -124,6 +158,120 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness)
     return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
 }
 
+uint clusterIndex()
+{
+    float viewDepth = max((clusters.view * vec4(WorldPos, 1.0)).z, clusters.depth.x);
+    uint slice = uint(clamp(log(viewDepth) * clusters.depth.z + clusters.depth.w, 0.0, float(clusters.gridSize.z - 1)));
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / clusters.screen.zw), clusters.gridSize.xy - 1);
+    return tile.x + clusters.gridSize.x * (tile.y + clusters.gridSize.y * slice);
+}
+
+float cascadeShadow()
+{
+    float viewDepth = (clusters.view * vec4(WorldPos, 1.0)).z;
+    uint cascade = 0;
+    while (cascade < shadows.info.x && viewDepth > shadows.cascadeSplits[cascade])
+        cascade++;
+    if (cascade >= shadows.info.x)
+        return 1.0;
+
+    vec4 clip = shadows.cascadeViewProjection[cascade] * vec4(WorldPos, 1.0);
+    vec3 coords = clip.xyz / clip.w;
+    return texture(cascadeShadowMap, vec4(coords.xy * 0.5 + 0.5, float(cascade), coords.z - shadows.bias.x));
+}
+
+float tileShadow(int tile)
+{
+    ShadowTile shadowTile = shadows.tiles[tile];
+    vec4 clip = shadowTile.viewProjection * vec4(WorldPos, 1.0);
+    vec3 coords = clip.xyz / clip.w;
+    if (clip.w <= 0.0 || coords.z > 1.0)
+        return 1.0;
+
+    // clamped half a texel inside so filtering never reads the neighbouring tile
+    vec2 uv = clamp(coords.xy * 0.5 + 0.5, shadows.bias.zz / shadowTile.rect.zw, 1.0 - shadows.bias.zz / shadowTile.rect.zw);
+    return texture(atlasShadowMap, vec3(shadowTile.rect.xy + uv * shadowTile.rect.zw, coords.z - shadows.bias.y));
+}
+
+float lightShadow(Light light)
+{
+    if (shadows.info.y == 0 || light.shadowIndex < 0)
+        return 1.0;
+    if (light.type == LightType_Directional)
+        return cascadeShadow();
+    if (light.type == LightType_Spot)
+        return tileShadow(light.shadowIndex);
+
+    // point lights have a tile per cube face, +x -x +y -y +z -z
+    vec3 toFragment = WorldPos - light.position;
+    vec3 axis = abs(toFragment);
+    int face;
+    if (axis.x >= axis.y && axis.x >= axis.z)
+        face = toFragment.x > 0.0 ? 0 : 1;
+    else if (axis.y >= axis.z)
+        face = toFragment.y > 0.0 ? 2 : 3;
+    else
+        face = toFragment.z > 0.0 ? 4 : 5;
+    return tileShadow(light.shadowIndex + face);
+}
+
+vec3 shadeLight(Light light, vec3 N, vec3 V, vec3 F0, vec3 albedo, float metallic, float roughness)
+{
+    // calculate per-light radiance
+    vec3 L;
+    float attenuation = 1.0;
+    if (light.type == LightType_Directional)
+    {
+        // direction is where the light shines to
+        L = -normalize(light.direction);
+    }
+    else
+    {
+        L = normalize(light.position - WorldPos);
+        float distance = length(light.position - WorldPos);
+        //float attenuation = 1.0 / (distance * distance);
+        attenuation = 1.0 / log(distance + 1.0);
+        // windowed so the light really ends at its range, which is what the clusters were built from
+        float window = clamp(1.0 - pow(distance / light.range, 4.0), 0.0, 1.0);
+        attenuation *= window * window;
+
+        if (light.type == LightType_Spot)
+        {
+            // spotAngle is the half angle of the cone in degrees, the last tenth of it fades out
+            float outer = cos(radians(light.spotAngle));
+            float inner = cos(radians(light.spotAngle * 0.9));
+            attenuation *= smoothstep(outer, inner, dot(-L, normalize(light.direction)));
+        }
+    }
+    vec3 H = normalize(V + L);
+    vec3 radiance = light.color.xyz * attenuation * light.intensity * lightShadow(light);
+
+    // Cook-Torrance BRDF
+    float NDF = DistributionGGX(N, H, roughness);   
+    float G   = GeometrySmith(N, V, L, roughness);      
+    vec3 F    = fresnelSchlick(max(dot(H, V), 0.0), F0);
+       
+    vec3 numerator    = NDF * G * F; 
+    float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001; // + 0.0001 to prevent divide by zero
+    vec3 specular = numerator / denominator;
+    
+    // kS is equal to Fresnel
+    vec3 kS = F;
+    // for energy conservation, the diffuse and specular light can't
+    // be above 1.0 (unless the surface emits light); to preserve this
+    // relationship the diffuse component (kD) should equal 1.0 - kS.
+    vec3 kD = vec3(1.0) - kS;
+    // multiply kD by the inverse metalness such that only non-metals 
+    // have diffuse lighting, or a linear blend if partly metal (pure metals
+    // have no diffuse light).
+    kD *= 1.0 - metallic;	  
+
+    // scale light by NdotL
+    float NdotL = max(dot(N, L), 0.0);        
+
+    // outgoing radiance, note that we already multiplied the BRDF by the Fresnel (kS) so we won't multiply by kS again
+    return (kD * albedo / PI + specular) * radiance * NdotL;
+}
 
 void main()
 {	
@@ -161,42 +309,19 @@ void main()
     vec3 Lo = vec3(0.0);
     
     
-    for(int i = 0; i < uboL.lightCount; ++i) 
+    if (clusters.gridSize.w != 0)
     {
-        // calculate per-light radiance
-        vec3 L = normalize(uboL.lights[i].position - WorldPos);
-        vec3 H = normalize(V + L);
-        float distance = length(uboL.lights[i].position - WorldPos);
-        //float attenuation = 1.0 / (distance * distance);
-        float attenuation = 1.0 / log(distance + 1.0);
-        vec3 radiance = uboL.lights[i].color.xyz * attenuation * uboL.lights[i].intensity;
-
-        // Cook-Torrance BRDF
-        float NDF = DistributionGGX(N, H, roughness);   
-        float G   = GeometrySmith(N, V, L, roughness);      
-        vec3 F    = fresnelSchlick(max(dot(H, V), 0.0), F0);
-           
-        vec3 numerator    = NDF * G * F; 
-        float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001; // + 0.0001 to prevent divide by zero
-        vec3 specular = numerator / denominator;
-        
-        // kS is equal to Fresnel
-        vec3 kS = F;
-        // for energy conservation, the diffuse and specular light can't
-        // be above 1.0 (unless the surface emits light); to preserve this
-        // relationship the diffuse component (kD) should equal 1.0 - kS.
-        vec3 kD = vec3(1.0) - kS;
-        // multiply kD by the inverse metalness such that only non-metals 
-        // have diffuse lighting, or a linear blend if partly metal (pure metals
-        // have no diffuse light).
-        kD *= 1.0 - metallic;	  
-
-        // scale light by NdotL
-        float NdotL = max(dot(N, L), 0.0);        
-
-        // add to outgoing radiance Lo
-        Lo += (kD * albedo / PI + specular) * radiance * NdotL;  // note that we already multiplied the BRDF by the Fresnel (kS) so we won't multiply by kS again
-    }   
+        uint cluster = clusterIndex();
+        uint count = lightCounts[cluster];
+        uint firstIndex = cluster * clusters.lights.y;
+        for (uint i = 0; i < count; ++i)
+            Lo += shadeLight(lightBuffer.lights[lightIndices[firstIndex + i]], N, V, F0, albedo, metallic, roughness);
+    }
+    else
+    {
+        for (uint i = 0; i < clusters.lights.x; ++i)
+            Lo += shadeLight(lightBuffer.lights[i], N, V, F0, albedo, metallic, roughness);
+    }
     
     // ambient lighting (note that the next IBL tutorial will replace 
     // this ambient lighting with environment lighting).
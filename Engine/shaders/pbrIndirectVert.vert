@@ -0,0 +1,47 @@
+#version 450
+
+layout(set = 1, binding = 0) uniform UBO {
+    mat4 view;
+    mat4 proj;
+    vec3 cameraPos;
+} ubo;
+
+// Object indices compacted by cullInstances.comp, each batch reads its slice through firstInstance
+layout(std430, set = 0, binding = 5) readonly buffer Visible {
+    uint visible[];
+} visibleBuffer;
+
+// World matrices by object index
+layout(std430, set = 0, binding = 6) readonly buffer Transforms {
+    mat4 transforms[];
+} transformBuffer;
+
+layout(location = 0) in vec3 inPosition;   // Vertex position
+layout(location = 1) in vec3 inNormal;     // Vertex normal
+layout(location = 2) in vec2 inTexCoord;   // Vertex texture coordinates
+
+layout(location = 0) out vec3 fragPosition;  // Fragment position (world space)
+layout(location = 1) out vec2 fragTexCoord;  // Texture coordinates
+layout(location = 2) out vec3 fragNormal;    // Normal (world space)
+layout(location = 3) out vec3 viewDir;       // View direction (world space)
+
+// pbrDepthVert computes the same position for the depth pre-pass, the EQUAL depth test needs the bits to match
+invariant gl_Position;
+
+void main() {
+    mat4 model = transformBuffer.transforms[visibleBuffer.visible[gl_InstanceIndex]];
+
+    // World space position
+    vec4 worldPosition = model * vec4(inPosition, 1.0);
+    fragPosition = worldPosition.xyz;
+
+    // Texture coordinates passthrough
+    fragTexCoord = inTexCoord;
+
+    // Normal in world space
+    mat3 normalMatrix = transpose(inverse(mat3(model)));
+    fragNormal = normalize(normalMatrix * inNormal);
+
+    // Final position in clip space
+    gl_Position = ubo.proj * ubo.view * worldPosition;
+}
@@ -6,9 +6,14 @@ layout(set = 1, binding = 0) uniform UBO {
     vec3 cameraPos;
 } ubo;
 
-layout(push_constant) uniform PushConstants {
+struct InstanceData {
     mat4 transform;  // Model matrix
-} pushConstants;
+};
+
+// One entry per drawn instance, batches index it through firstInstance
+layout(std430, set = 0, binding = 4) readonly buffer Instances {
+    InstanceData instances[];
+} instanceBuffer;
 
 layout(location = 0) in vec3 inPosition;   // Vertex position
 layout(location = 1) in vec3 inNormal;     // Vertex normal
@@ -19,16 +24,21 @@ layout(location = 1) out vec2 fragTexCoord;  // Texture coordinates
 layout(location = 2) out vec3 fragNormal;    // Normal (world space)
 layout(location = 3) out vec3 viewDir;       // View direction (world space)
 
+// pbrDepthVert computes the same position for the depth pre-pass, the EQUAL depth test needs the bits to match
+invariant gl_Position;
+
 void main() {
+    mat4 model = instanceBuffer.instances[gl_InstanceIndex].transform;
+
     // World space position
-    vec4 worldPosition = pushConstants.transform * vec4(inPosition, 1.0);
+    vec4 worldPosition = model * vec4(inPosition, 1.0);
     fragPosition = worldPosition.xyz;
 
     // Texture coordinates passthrough
     fragTexCoord = inTexCoord;
 
     // Normal in world space
-    mat3 normalMatrix = transpose(inverse(mat3(pushConstants.transform)));
+    mat3 normalMatrix = transpose(inverse(mat3(model)));
     fragNormal = normalize(normalMatrix * inNormal);
 
     // Final position in clip space
@@ -0,0 +1,5 @@
+#version 450
+
+// Depth only, the shadow render pass has no color attachment
+void main() {
+}
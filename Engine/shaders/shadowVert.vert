@@ -0,0 +1,16 @@
+#version 450
+
+layout(push_constant) uniform PushConstants {
+    mat4 viewProjection;  // Cascade or atlas tile being drawn
+} pushConstants;
+
+// World matrices of the pass's casters, batches index it through firstInstance
+layout(std430, set = 0, binding = 0) readonly buffer Instances {
+    mat4 transforms[];
+} instanceBuffer;
+
+layout(location = 0) in vec3 inPosition;
+
+void main() {
+    gl_Position = pushConstants.viewProjection * instanceBuffer.transforms[gl_InstanceIndex] * vec4(inPosition, 1.0);
+}